@@ -32,6 +32,7 @@
 
 #include "refpersys.hh"
 
+#include <linux/futex.h>
 
 extern "C" const char rps_agenda_gitid[];
 const char rps_agenda_gitid[]= RPS_GITID;
@@ -46,7 +47,9 @@ double Rps_Agenda::agenda_timeout;
 std::recursive_mutex Rps_Agenda::agenda_mtx_;
 std::condition_variable_any Rps_Agenda::agenda_changed_condvar_;
 
-std::deque<Rps_ObjectRef> Rps_Agenda::agenda_fifo_[Rps_Agenda::AgPrio__Last];
+Rps_TaskletQueue Rps_Agenda::agenda_queue_[Rps_Agenda::AgPrio__Last];
+std::atomic<uint32_t> Rps_Agenda::agenda_parked_mask_;
+std::atomic<uint32_t> Rps_Agenda::agenda_park_word_[RPS_NBJOBS_MAX+2];
 
 std::atomic<unsigned long>  Rps_Agenda::agenda_add_counter_;
 std::atomic<bool> Rps_Agenda::agenda_is_running_;
@@ -58,6 +61,228 @@ Rps_Agenda::agenda_work_thread_state_[RPS_NBJOBS_MAX+2];
 std::atomic<bool> Rps_Agenda::agenda_needs_garbcoll_;
 std::atomic<uint64_t> Rps_Agenda::agenda_cumulw_gc_;
 std::atomic<Rps_CallFrame*> Rps_Agenda::agenda_work_gc_callframe_[RPS_NBJOBS_MAX+2];
+std::atomic<uint64_t> Rps_Agenda::agenda_state_nanosec_[RPS_NBJOBS_MAX+2][Rps_Agenda::WthrAg__Last];
+double Rps_Agenda::agenda_state_since_[RPS_NBJOBS_MAX+2];
+Rps_Agenda::workthread_state_en Rps_Agenda::agenda_accounted_state_[RPS_NBJOBS_MAX+2];
+std::atomic<unsigned long> Rps_Agenda::agenda_gc_count_;
+std::atomic<uint64_t> Rps_Agenda::agenda_gc_stall_nanosec_;
+std::atomic<uint32_t> Rps_Agenda::agenda_safepoint_epoch_;
+std::atomic<int> Rps_Agenda::agenda_nb_workers_;
+std::atomic<int> Rps_Agenda::agenda_gc_arrived_;
+std::atomic<int> Rps_Agenda::agenda_gc_leader_;
+std::atomic<const void*> Rps_Agenda::agenda_worker_stack_top_[RPS_NBJOBS_MAX+2];
+std::atomic<const void*> Rps_Agenda::agenda_worker_stack_low_[RPS_NBJOBS_MAX+2];
+std::atomic<uint64_t> Rps_Agenda::agenda_tts_nanosec_;
+std::atomic<uint64_t> Rps_Agenda::agenda_tts_max_nanosec_;
+thread_local int Rps_Agenda::agenda_thread_index_;
+thread_local int Rps_Agenda::agenda_nosafepoint_depth_;
+/// monotonic time when some worker first entered the pending
+/// collection, or 0.0
+static std::atomic<double> rps_agenda_gc_request_time;
+
+static_assert(RPS_NBJOBS_MAX+2 <= 32, "agenda_parked_mask_ is too small");
+
+Rps_TaskletQueue::segment_st::segment_st(uint64_t id)
+  : sg_id(id), sg_next(nullptr), sg_retired_next(nullptr)
+{
+  for (unsigned ix=0; ix<segment_size; ix++)
+    sg_slots[ix].store(nullptr, std::memory_order_relaxed);
+} // end Rps_TaskletQueue::segment_st::segment_st
+
+Rps_TaskletQueue::Rps_TaskletQueue()
+  : tq_pushidx(0), tq_popidx(0), tq_headseg(nullptr), tq_tailseg(nullptr),
+    tq_active(0), tq_retired(nullptr)
+{
+  segment_st* seg = new segment_st(0);
+  tq_headseg.store(seg);
+  tq_tailseg.store(seg);
+} // end Rps_TaskletQueue::Rps_TaskletQueue
+
+Rps_TaskletQueue::~Rps_TaskletQueue()
+{
+  for (segment_st* seg = tq_retired.exchange(nullptr); seg; )
+    {
+      segment_st* next = seg->sg_retired_next;
+      delete seg;
+      seg = next;
+    }
+  for (segment_st* seg = tq_headseg.exchange(nullptr); seg; )
+    {
+      segment_st* next = seg->sg_next.load();
+      delete seg;
+      seg = next;
+    }
+} // end Rps_TaskletQueue::~Rps_TaskletQueue
+
+/// the segment of some id, from an earlier one; missing segments
+/// are appended, the first appending thread wins
+Rps_TaskletQueue::segment_st*
+Rps_TaskletQueue::find_segment(segment_st*seg, uint64_t id)
+{
+  RPS_ASSERT(seg && seg->sg_id <= id);
+  while (seg->sg_id < id)
+    {
+      segment_st* next = seg->sg_next.load();
+      if (!next)
+        {
+          segment_st* fresh = new segment_st(seg->sg_id+1);
+          if (seg->sg_next.compare_exchange_strong(next, fresh))
+            next = fresh;
+          else
+            delete fresh;
+        }
+      seg = next;
+    }
+  return seg;
+} // end Rps_TaskletQueue::find_segment
+
+/// Every retired segment was reachable only by operations already in
+/// progress when it was retired. Whoever leaves the queue last, after
+/// taking the retired list, can free it.
+void
+Rps_TaskletQueue::leave(void) const
+{
+  segment_st* retired = nullptr;
+  if (tq_retired.load(std::memory_order_relaxed))
+    retired = tq_retired.exchange(nullptr);
+  if (tq_active.fetch_sub(1) == 1)
+    {
+      while (retired)
+        {
+          segment_st* next = retired->sg_retired_next;
+          delete retired;
+          retired = next;
+        }
+    }
+  else if (retired)
+    {
+      segment_st* last = retired;
+      while (last->sg_retired_next)
+        last = last->sg_retired_next;
+      segment_st* old = tq_retired.load();
+      do
+        last->sg_retired_next = old;
+      while (!tq_retired.compare_exchange_weak(old, retired));
+    }
+} // end Rps_TaskletQueue::leave
+
+/// called once every index of segment id has been taken by poppers;
+/// the head, then the tail, only move forward
+void
+Rps_TaskletQueue::retire_through(uint64_t id)
+{
+  segment_st* head = tq_headseg.load();
+  while (head->sg_id <= id)
+    {
+      segment_st* next = find_segment(head, head->sg_id+1);
+      if (tq_headseg.compare_exchange_strong(head, next))
+        {
+          segment_st* old = tq_retired.load();
+          do
+            head->sg_retired_next = old;
+          while (!tq_retired.compare_exchange_weak(old, head));
+          head = next;
+        }
+    }
+  segment_st* tail = tq_tailseg.load();
+  while (tail->sg_id < head->sg_id
+         && !tq_tailseg.compare_exchange_weak(tail, head))
+    continue;
+} // end Rps_TaskletQueue::retire_through
+
+void
+Rps_TaskletQueue::push(Rps_ObjectZone*obz)
+{
+  RPS_ASSERT(obz != nullptr && obz != taken_slot && obz != removed_slot);
+  enter();
+  for (;;)
+    {
+      segment_st* tail = tq_tailseg.load();
+      uint64_t idx = tq_pushidx.fetch_add(1);
+      uint64_t id = idx / segment_size;
+      /// that segment has been consumed, so the slot is spoiled
+      if (id < tail->sg_id)
+        continue;
+      segment_st* seg = find_segment(tail, id);
+      while (tail->sg_id < id
+             && !tq_tailseg.compare_exchange_weak(tail, seg))
+        continue;
+      Rps_ObjectZone* expected = nullptr;
+      if (seg->sg_slots[idx % segment_size].compare_exchange_strong(expected, obz))
+        break;
+    }
+  leave();
+} // end Rps_TaskletQueue::push
+
+Rps_ObjectZone*
+Rps_TaskletQueue::pop(void)
+{
+  Rps_ObjectZone* res = nullptr;
+  enter();
+  while (!res && tq_popidx.load() < tq_pushidx.load())
+    {
+      segment_st* head = tq_headseg.load();
+      uint64_t idx = tq_popidx.fetch_add(1);
+      uint64_t id = idx / segment_size;
+      if (RPS_LIKELY(id >= head->sg_id))
+        {
+          segment_st* seg = find_segment(head, id);
+          /// a pusher not yet there will take another index
+          Rps_ObjectZone* got = seg->sg_slots[idx % segment_size].exchange(taken_slot);
+          if (got && got != removed_slot)
+            res = got;
+        }
+      if (idx % segment_size == segment_size-1)
+        retire_through(id);
+    }
+  leave();
+  return res;
+} // end Rps_TaskletQueue::pop
+
+void
+Rps_TaskletQueue::for_each(const std::function<void(Rps_ObjectZone*)>&fun) const
+{
+  enter();
+  segment_st* seg = tq_headseg.load();
+  uint64_t idx = std::max(tq_popidx.load(), seg->sg_id*segment_size);
+  uint64_t endidx = tq_pushidx.load();
+  for (; idx < endidx; idx++)
+    {
+      seg = find_segment(seg, idx / segment_size);
+      Rps_ObjectZone* obz = seg->sg_slots[idx % segment_size].load();
+      if (obz && obz != taken_slot && obz != removed_slot)
+        fun(obz);
+    }
+  leave();
+} // end Rps_TaskletQueue::for_each
+
+size_t
+Rps_TaskletQueue::remove_if(const std::function<bool(Rps_ObjectZone*)>&pred)
+{
+  size_t nbremoved = 0;
+  enter();
+  segment_st* seg = tq_headseg.load();
+  uint64_t idx = std::max(tq_popidx.load(), seg->sg_id*segment_size);
+  uint64_t endidx = tq_pushidx.load();
+  for (; idx < endidx; idx++)
+    {
+      seg = find_segment(seg, idx / segment_size);
+      auto& slot = seg->sg_slots[idx % segment_size];
+      Rps_ObjectZone* obz = slot.load();
+      if (obz && obz != taken_slot && obz != removed_slot && pred(obz)
+          && slot.compare_exchange_strong(obz, removed_slot))
+        nbremoved++;
+    }
+  leave();
+  return nbremoved;
+} // end Rps_TaskletQueue::remove_if
+
+static inline long
+rps_agenda_futex(std::atomic<uint32_t>*word, int op, uint32_t val,
+                 const struct timespec*ts)
+{
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, val, ts, nullptr, 0);
+} // end rps_agenda_futex
 
 void
 Rps_Agenda::initialize(void)
@@ -77,61 +302,42 @@ Rps_Agenda::initialize(void)
 void
 Rps_Agenda::gc_mark(Rps_GarbageCollector&gc)
 {
-  std::lock_guard<std::recursive_mutex> gu(agenda_mtx_);
   for (int ix=AgPrio_Low; ix<AgPrio__Last; ix++)
-    {
-      auto& curfifo = agenda_fifo_[ix];
-      for (auto it: curfifo)
-        {
-          Rps_ObjectRef ob = *it;
-          if (ob)
-            ob->gc_mark(gc);
-        }
-    }
+    agenda_queue_[ix].for_each([&](Rps_ObjectZone*obz)
+  {
+    gc.mark_obj(obz);
+  });
 } // end Rps_Agenda::gc_mark
 
 void
 Rps_Agenda::dump_scan_agenda(Rps_Dumper*du)
 {
   RPS_ASSERT (du != nullptr);
-  std::lock_guard<std::recursive_mutex> gu(agenda_mtx_);
   for (int ix=AgPrio_Low; ix<AgPrio__Last; ix++)
-    {
-      auto& curfifo = agenda_fifo_[ix];
-      for (auto it: curfifo)
-        {
-          Rps_ObjectRef ob = *it;
-          if (ob)
-            rps_dump_scan_object(du, ob);
-        };
-    }
+    agenda_queue_[ix].for_each([=](Rps_ObjectZone*obz)
+  {
+    rps_dump_scan_object(du, Rps_ObjectRef(obz));
+  });
 } // end Rps_Agenda::dump_scan_agenda
 
 void
 Rps_Agenda::dump_json_agenda(Rps_Dumper*du, Json::Value&jv)
 {
   RPS_ASSERT (du != nullptr);
-  std::lock_guard<std::recursive_mutex> gu(agenda_mtx_);
   jv["payload"] = "agenda";
   for (int ix=AgPrio_Low; ix<AgPrio__Last; ix++)
     {
-      auto& curfifo = agenda_fifo_[ix];
       const char*prioname = agenda_priority_names[ix];
       RPS_ASSERT(prioname != nullptr);
-      if (!curfifo.empty())
-        {
-          Json::Value jseq(Json::arrayValue);
-          for (auto it: curfifo)
-            {
-              Rps_ObjectRef ob = *it;
-              if (ob && rps_is_dumpable_objref(du, ob))
-                {
-                  Json::Value job = rps_dump_json_objectref(du, ob);
-                  jseq.append(job);
-                }
-            };
-          jv[prioname] = jseq;
-        }
+      Json::Value jseq(Json::arrayValue);
+      agenda_queue_[ix].for_each([&](Rps_ObjectZone*obz)
+      {
+        Rps_ObjectRef ob(obz);
+        if (rps_is_dumpable_objref(du, ob))
+          jseq.append(rps_dump_json_objectref(du, ob));
+      });
+      if (jseq.size() > 0)
+        jv[prioname] = jseq;
     }
 } // end Rps_Agenda::dump_json_agenda
 
@@ -145,31 +351,130 @@ Rps_Agenda::add_tasklet(agenda_prio_en prio, Rps_ObjectRef obtasklet)
     return;
   if ((int)prio < (int)AgPrio_Low || (int)prio >= AgPrio__Last)
     return;
-  std::lock_guard<std::recursive_mutex> gu(agenda_mtx_);
-  agenda_fifo_[prio].push_back(obtasklet);
+  double obsoltime = 0.0;
+  {
+    auto payltasklet = obztask->get_dynamic_payload<Rps_PayloadTasklet>();
+    if (payltasklet)
+      obsoltime = payltasklet->tasklet_obsoltime;
+  }
+  if (obsoltime > 0.0 && obsoltime < rps_wallclock_real_time())
+    {
+      RPS_DEBUG_LOG(EVENT_LOOP, "add_tasklet ignoring obsolete tasklet " << obtasklet);
+      return;
+    }
+  agenda_queue_[prio].push(obztask);
   agenda_add_counter_.fetch_add(1);
-  Rps_Agenda::agenda_changed_condvar_.notify_all();
+  wake_one_worker();
+  /// so the obsolete tasklet won't stay in the agenda while no
+  /// worker is fetching
+  if (obsoltime > 0.0)
+    rps_event_loop_timer_wheel().add_obsolescence_deadline(obsoltime);
 } // end Rps_Agenda::add_tasklet
 
+bool
+Rps_Agenda::tasklet_is_obsolete(Rps_ObjectRef obtasklet, double now)
+{
+  if (!obtasklet)
+    return false;
+  auto payltasklet = obtasklet->get_dynamic_payload<Rps_PayloadTasklet>();
+  if (!payltasklet)
+    return false;
+  return payltasklet->tasklet_obsoltime > 0.0
+         && payltasklet->tasklet_obsoltime < now;
+} // end Rps_Agenda::tasklet_is_obsolete
+
+/// called by the timer wheel on obsolescence deadlines
+void
+Rps_Agenda::remove_obsolete_tasklets(double now)
+{
+  for (int prio = (int)AgPrio_Low; prio < (int)AgPrio__Last; prio++)
+    {
+      size_t nbremoved = agenda_queue_[prio].remove_if([=](Rps_ObjectZone*obz)
+      {
+        return tasklet_is_obsolete(Rps_ObjectRef(obz), now);
+      });
+      if (nbremoved > 0)
+        RPS_DEBUG_LOG(EVENT_LOOP, "remove_obsolete_tasklets removed "
+                      << nbremoved << " "
+                      << agenda_priority_names[prio] << " tasklets");
+    }
+} // end Rps_Agenda::remove_obsolete_tasklets
+
 
 ///// fetch a runnable tasklet from the agenda and remove it from there...
 Rps_ObjectRef
 Rps_Agenda::fetch_tasklet_to_run(void)
 {
-  Rps_ObjectRef res;
-  std::lock_guard<std::recursive_mutex> gu(agenda_mtx_);
+  double now = rps_wallclock_real_time();
   for (int prio = (int)AgPrio_High; prio >= (int)AgPrio_Low; prio--)
     {
-      auto& curfifo = agenda_fifo_[agenda_prio_en(prio)];
-      if (curfifo.empty())
-        continue;
-      res = curfifo.front();
-      curfifo.pop_front();
-      return res;
+      auto& curqueue = agenda_queue_[agenda_prio_en(prio)];
+      while (Rps_ObjectZone*obz = curqueue.pop())
+        {
+          /// obsolete tasklets are not run, even before their deadline
+          /// has been handled by the timer wheel
+          if (!tasklet_is_obsolete(Rps_ObjectRef(obz), now))
+            return Rps_ObjectRef(obz);
+        }
     }
   return nullptr;
 } // end Rps_Agenda::fetch_tasklet_to_run
 
+/// The futex word of the parked worker is set before its bit in
+/// agenda_parked_mask_, and the queues are checked after, so a
+/// tasklet added meanwhile either is seen or wakes it up.
+void
+Rps_Agenda::park_worker(int ix, long timeoutmillisec)
+{
+  RPS_ASSERT(ix>0 && ix<=RPS_NBJOBS_MAX);
+  uint32_t bit = 1u << ix;
+  agenda_park_word_[ix].store(0);
+  agenda_parked_mask_.fetch_or(bit);
+  bool queued = false;
+  for (int prio = (int)AgPrio_Low; prio < (int)AgPrio__Last && !queued; prio++)
+    queued = !agenda_queue_[prio].seems_empty();
+  if (!queued && agenda_is_running_.load() && !agenda_needs_garbcoll_.load())
+    {
+      struct timespec ts = {};
+      ts.tv_sec = timeoutmillisec / 1000;
+      ts.tv_nsec = (timeoutmillisec % 1000) * 1000000;
+      (void) rps_agenda_futex(&agenda_park_word_[ix], FUTEX_WAIT_PRIVATE, 0, &ts);
+    }
+  agenda_parked_mask_.fetch_and(~bit);
+} // end Rps_Agenda::park_worker
+
+void
+Rps_Agenda::wake_one_worker(void)
+{
+  uint32_t mask = agenda_parked_mask_.load();
+  while (mask)
+    {
+      int ix = __builtin_ctz(mask);
+      uint32_t bit = 1u << ix;
+      uint32_t oldmask = agenda_parked_mask_.fetch_and(~bit);
+      if (oldmask & bit)
+        {
+          agenda_park_word_[ix].store(1);
+          (void) rps_agenda_futex(&agenda_park_word_[ix], FUTEX_WAKE_PRIVATE, 1, nullptr);
+          return;
+        }
+      mask = oldmask & ~bit;
+    }
+} // end Rps_Agenda::wake_one_worker
+
+void
+Rps_Agenda::wake_all_workers(void)
+{
+  uint32_t mask = agenda_parked_mask_.exchange(0);
+  while (mask)
+    {
+      int ix = __builtin_ctz(mask);
+      mask &= mask-1;
+      agenda_park_word_[ix].store(1);
+      (void) rps_agenda_futex(&agenda_park_word_[ix], FUTEX_WAKE_PRIVATE, 1, nullptr);
+    }
+} // end Rps_Agenda::wake_all_workers
+
 /// the below function is the body of worker threads running the agenda
 void
 Rps_Agenda::run_agenda_worker(int ix)
@@ -182,6 +487,9 @@ Rps_Agenda::run_agenda_worker(int ix)
   memset (pthname, 0, sizeof(pthname));
   snprintf(pthname, sizeof(pthname), "rps-agw#%hd", (short) ix);
   pthread_setname_np(pthread_self(), pthname);
+  /// from now on, this thread stops at safepoints
+  agenda_worker_stack_top_[ix].store(__builtin_frame_address(0));
+  agenda_thread_index_ = ix;
   RPS_LOCALFRAME(RPS_ROOT_OB(_1aGtWm38Vw701jDhZn), //the_agenda,
                  RPS_NULL_CALL_FRAME, // no caller frame
                  Rps_ObjectRef obtasklet;
@@ -194,7 +502,7 @@ Rps_Agenda::run_agenda_worker(int ix)
   {Rps_Value((intptr_t)ix)});
   _.set_state_value(_f.descrval);
   long count = 0;
-  agenda_work_thread_state_[ix].store(WthrAg_Idle);
+  set_worker_state(ix, WthrAg_Idle);
   // wait for this thread to be in agenda_thread_array_
   {
     /// we sleep a different amount of time to help ensure other threads do
@@ -222,153 +530,285 @@ Rps_Agenda::run_agenda_worker(int ix)
   ////
   while (agenda_is_running_.load())
     {
-      if (Rps_Agenda::agenda_cumulw_gc_.load() + Rps_Agenda::agenda_gc_threshold
-          > Rps_QuasiZone::cumulative_allocated_wordcount())
-        {
-          Rps_Agenda::agenda_needs_garbcoll_.store(true);
-          std::this_thread::sleep_for(1ms/2);
-        }
+      if (!Rps_Agenda::agenda_needs_garbcoll_.load()
+          && Rps_GcPacer::should_collect(Rps_Agenda::agenda_cumulw_gc_.load()))
+        Rps_Agenda::request_garbage_collection();
+      /// the safepoint between tasklets
       if (Rps_Agenda::agenda_needs_garbcoll_.load())
         Rps_Agenda::do_garbage_collect(ix, &_);
-      else
-        try
-          {
-            count++;
-            switch (agenda_work_thread_state_[ix].load())
-              {
-              case WthrAg_Idle:
-              case WthrAg_Run:
-              {
-                _f.obtasklet = Rps_Agenda::fetch_tasklet_to_run();
-                Rps_PayloadTasklet*taskpayl = nullptr;
-                if (_f.obtasklet)
-                  {
-                    taskpayl = _f.obtasklet->get_dynamic_payload<Rps_PayloadTasklet>();
-                    if (taskpayl && taskpayl->owner() == _f.obtasklet)
-                      _f.clostodo = taskpayl->todo_closure();
-                    if (_f.clostodo)
-                      {
-                        Rps_Agenda::agenda_work_thread_state_[ix].store(WthrAg_Run);
-                        _f.clostodo.apply1(&_, _f.obtasklet);
-                      }
-                  }
-                else   // no tasklet, we wait for changes in agenda
-                  {
-                    Rps_Agenda::agenda_work_thread_state_[ix].store(WthrAg_Idle);
-                    Rps_Agenda::agenda_changed_condvar_.wait_for(agenda_mtx_, 500ms+ix*10ms);
-                  }
-              }
-              break;
-              case WthrAg_GC:
-              {
-                std::this_thread::sleep_for(1ms);
-                Rps_Agenda::agenda_changed_condvar_.notify_all();
-              }
-              break;
-              case WthrAg_EndGC:
-              {
-                agenda_work_thread_state_[ix].store(WthrAg_Idle);
-                Rps_Agenda::agenda_changed_condvar_.notify_all();
-                // so on the next loop, the worker thread will try to fetch and run a tasklet
-              }
-              break;
-              default:
-                break;
-              };      // end switch agenda_work_thread_state_[ix].load()
-          } /// ending try...
-        catch (std::exception& exc)
-          {
-            RPS_WARNOUT("run_agenda_worker " << pthname
-                        << " got exception " << exc.what()
-                        << " count#" << count
-                        << " for tasklet " << _f.obtasklet
-                        << " doing " << _f.clostodo);
-            Rps_Agenda::agenda_work_thread_state_[ix].store(WthrAg_Idle);
-          }
+      try
+        {
+          count++;
+          /// between tasklets, with no lock held, we help the lazy
+          /// sweep of the previous garbage collection
+          if (RPS_UNLIKELY(Rps_QuasiZone::is_sweeping()))
+            {
+              agenda_nosafepoint_depth_++;
+              Rps_QuasiZone::sweep_some_chunks(1);
+              agenda_nosafepoint_depth_--;
+            }
+          _f.obtasklet = Rps_Agenda::fetch_tasklet_to_run();
+          _f.clostodo = nullptr;
+          Rps_PayloadTasklet*taskpayl = nullptr;
+          if (_f.obtasklet)
+            {
+              taskpayl = _f.obtasklet->get_dynamic_payload<Rps_PayloadTasklet>();
+              if (taskpayl && taskpayl->owner() == _f.obtasklet)
+                _f.clostodo = taskpayl->todo_closure();
+              if (_f.clostodo)
+                {
+                  Rps_Agenda::set_worker_state(ix, WthrAg_Run);
+                  _f.clostodo.apply1(&_, _f.obtasklet);
+                  Rps_Agenda::set_worker_state(ix, WthrAg_Idle);
+                }
+            }
+          else   // no tasklet, we park till one is added
+            {
+              Rps_Agenda::set_worker_state(ix, WthrAg_Idle);
+              if (!Rps_QuasiZone::is_sweeping())
+                Rps_Agenda::park_worker(ix, 500+ix*10);
+            }
+        } /// ending try...
+      catch (std::exception& exc)
+        {
+          RPS_WARNOUT("run_agenda_worker " << pthname
+                      << " got exception " << exc.what()
+                      << " count#" << count
+                      << " for tasklet " << _f.obtasklet
+                      << " doing " << _f.clostodo);
+          Rps_Agenda::set_worker_state(ix, WthrAg_Idle);
+        }
     };        // end while (agenda_is_running_.load())
+  Rps_Agenda::leave_safepoints(ix);
   Rps_Agenda::agenda_changed_condvar_.notify_all();
-  Rps_Agenda::agenda_work_thread_state_[ix].store(WthrAg__None);
+  Rps_Agenda::set_worker_state(ix, WthrAg__None);
 } // end Rps_Agenda::run_agenda_worker
 
+void
+Rps_Agenda::set_worker_state(int ix, workthread_state_en st)
+{
+  RPS_ASSERT(ix>0 && ix<=RPS_NBJOBS_MAX);
+  double now = rps_monotonic_real_time();
+  workthread_state_en prevst = agenda_accounted_state_[ix];
+  if (prevst > WthrAg__None && prevst < WthrAg__Last)
+    agenda_state_nanosec_[ix][prevst]
+    .fetch_add((uint64_t)((now - agenda_state_since_[ix])*1.0e9));
+  agenda_state_since_[ix] = now;
+  agenda_accounted_state_[ix] = st;
+  agenda_work_thread_state_[ix].store(st);
+} // end Rps_Agenda::set_worker_state
+
+double
+Rps_Agenda::worker_state_seconds(int ix, workthread_state_en st)
+{
+  if (ix<=0 || ix>RPS_NBJOBS_MAX || st<=WthrAg__None || st>=WthrAg__Last)
+    return 0.0;
+  return 1.0e-9 * agenda_state_nanosec_[ix][st].load();
+} // end Rps_Agenda::worker_state_seconds
+
+
+void
+Rps_Agenda::request_garbage_collection(void)
+{
+  bool noreq = false;
+  if (!agenda_needs_garbcoll_.compare_exchange_strong(noreq, true))
+    return;
+  rps_agenda_gc_request_time.store(rps_monotonic_real_time());
+  /// parked workers should reach their safepoint
+  wake_all_workers();
+} // end Rps_Agenda::request_garbage_collection
+
+void
+Rps_Agenda::stop_at_safepoint(void)
+{
+  int ix = agenda_thread_index_;
+  /// other threads, and worker threads already collecting or in
+  /// the lazy sweep, don't stop
+  if (ix <= 0 || agenda_nosafepoint_depth_ > 0)
+    return;
+  Rps_CallFrame*topframe = Rps_ProtoCallFrame::thread_top_frame();
+  if (!topframe)
+    return;
+  do_garbage_collect(ix, topframe);
+} // end Rps_Agenda::stop_at_safepoint
+
+bool
+Rps_Agenda::is_locked_by_stopped_worker(const Rps_ObjectMutex&mtx)
+{
+  if (!agenda_needs_garbcoll_.load())
+    return false;
+  int ownix = mtx.owning_worker();
+  if (ownix <= 0 || ownix > RPS_NBJOBS_MAX)
+    return false;
+  return agenda_work_gc_callframe_[ownix].load() != nullptr;
+} // end Rps_Agenda::is_locked_by_stopped_worker
+
+/// an address below the frame of its caller, so below the registers
+/// spilled there
+static __attribute__((noinline)) const void*
+rps_agenda_stack_low_address(void)
+{
+  return __builtin_frame_address(0);
+} // end rps_agenda_stack_low_address
 
-//// Do garbage collection from agenda worker threads. The actual GC
-//// is running when ix == 1, so in the first worker thread. Other
-//// worker threads are idle and waiting....
+//// Do garbage collection from agenda worker threads, at some
+//// safepoint. The call frames of the worker thread, and the zones
+//// guessed from its C++ stack, are GC roots. The last worker thread
+//// reaching the barrier does the actual collection, the other ones
+//// wait without spinning and help it to mark.
 void
 Rps_Agenda::do_garbage_collect(int ix, Rps_CallFrame*callframe)
 {
-  RPS_ASSERT(ix>=0 && ix<=RPS_NBJOBS_MAX);
+  RPS_ASSERT(ix>0 && ix<=RPS_NBJOBS_MAX);
+  RPS_ASSERT(callframe != nullptr);
   RPS_ASSERT(agenda_work_gc_callframe_[ix].load() == nullptr);
-  agenda_work_thread_state_[ix].store(Rps_Agenda::WthrAg_GC);
+  /// every worker thread is stopped while the barrier is complete, so
+  /// the epoch cannot change between these two loads
+  uint32_t epoch = agenda_safepoint_epoch_.load();
+  if (!agenda_needs_garbcoll_.load())
+    return;
+  agenda_nosafepoint_depth_++;
+  workthread_state_en prevstate = agenda_accounted_state_[ix];
+  set_worker_state(ix, WthrAg_GC);
+  /// zones kept only in callee-saved registers of our callers are
+  /// spilled into our frame, which is above the scanned low address
+  __builtin_unwind_init();
+  agenda_worker_stack_low_[ix].store(rps_agenda_stack_low_address());
   agenda_work_gc_callframe_[ix].store(callframe);
-  using namespace std::chrono_literals;
-  std::this_thread::sleep_for(1ms/8);
-  Rps_Agenda::agenda_changed_condvar_.notify_all();
-  std::this_thread::sleep_for(1ms/16);
-  /// at this point, we should wait for every other worker thread to be in WthrAg_GC state....
-  bool every_worker_is_gc = false;
-  {
-    constexpr int maxwaitloop = 32;
-    int loopcnt=0;
-    while (!every_worker_is_gc)
-      {
-        std::unique_lock<std::recursive_mutex> ulock(agenda_mtx_);
-        agenda_changed_condvar_.wait_for(ulock, 50ms+ix*10ms, [=,&every_worker_is_gc]
+  int nbarrived = agenda_gc_arrived_.fetch_add(1) + 1;
+  int noleader = 0;
+  if (nbarrived >= agenda_nb_workers_.load()
+      && agenda_gc_leader_.compare_exchange_strong(noleader, ix))
+    collect_at_safepoint(ix, epoch);
+  else
+    {
+      /// wait till marking starts, help it, then wait till released
+      bool helped = false;
+      for (;;)
         {
-          for (int wix=1; wix<rps_nbjobs; wix++)
+          uint32_t curepoch = agenda_safepoint_epoch_.load();
+          if (curepoch - epoch >= 2)
+            break;
+          if (curepoch != epoch && !helped)
             {
-              std::thread*curthr = agenda_thread_array_[wix].load();
-              if (!curthr)
-                continue;
-              if (agenda_work_thread_state_[wix].load() != Rps_Agenda::WthrAg_GC)
-                return false;
-            };
-          every_worker_is_gc = true;
-          return true;
-        });
-        if (loopcnt++ > maxwaitloop) /// should never happen!
-          RPS_FATALOUT("Rps_Agenda::do_garbage_collect ix=" << ix
-                       << " callframe=" << Rps_ShowCallFrame(callframe)
-                       << " timed out waiting for other worker threads to GC");
-      }
+              Rps_GarbageCollector::help_marking(ix);
+              helped = true;
+              continue;
+            }
+          (void) rps_agenda_futex(&agenda_safepoint_epoch_, FUTEX_WAIT_PRIVATE,
+                                  curepoch, nullptr);
+        }
+    }
+  agenda_work_gc_callframe_[ix].store(nullptr);
+  agenda_worker_stack_low_[ix].store(nullptr);
+  set_worker_state(ix, prevstate);
+  agenda_nosafepoint_depth_--;
+} // end of Rps_Agenda::do_garbage_collect
+
+/// Every worker thread taking part in the barrier is stopped, so the
+/// GC is permitted to scan their call stacks.  A collection in the
+/// middle of a tasklet may be a major one, so old zones kept only in
+/// C++ locals are found by scanning conservatively the C++ stack of
+/// each stopped worker, from its stack top to the low address of its
+/// do_garbage_collect frame.  We don't hold
+/// agenda_mtx_ during the collection, since marking the agenda
+/// payload locks it from any marking thread.
+void
+Rps_Agenda::collect_at_safepoint(int ix, uint32_t epoch)
+{
+  RPS_ASSERT(agenda_gc_leader_.load() == ix);
+  {
+    uint64_t tts = (uint64_t)((rps_monotonic_real_time()
+                               - rps_agenda_gc_request_time.load())*1.0e9);
+    agenda_tts_nanosec_.fetch_add(tts);
+    uint64_t oldmax = agenda_tts_max_nanosec_.load();
+    while (tts > oldmax
+           && !agenda_tts_max_nanosec_.compare_exchange_weak(oldmax, tts))
+      continue;
   }
-  RPS_ASSERT(every_worker_is_gc);
-  /// At this point, we do know that every worker thread is in garbage
-  /// collection state, so is NOT running, don't change the call
-  /// stack, so is NOT ALLOCATING.... The GC is then permitted to scan
-  /// the call stacks in agenda_work_gc_callframe_ ... The first
-  /// worker thread is doing the actual GC work.
-  if (ix==1)
-    {
-      std::unique_lock<std::recursive_mutex> ulock(agenda_mtx_);
-      std::function<void(Rps_GarbageCollector*)> gcfun([&](Rps_GarbageCollector*gc)
+  std::function<void(Rps_GarbageCollector*)> gcfun([&](Rps_GarbageCollector*gc)
+  {
+    /// marking has started, the stopped worker threads may help
+    agenda_safepoint_epoch_.store(epoch+1);
+    (void) rps_agenda_futex(&agenda_safepoint_epoch_, FUTEX_WAKE_PRIVATE,
+                            INT_MAX, nullptr);
+    std::vector<Rps_QuasiZone*> largezones = Rps_QuasiZone::large_zones();
+    for (int thrix=1; thrix<=RPS_NBJOBS_MAX; thrix++)
       {
-        for (int thrix=1; thrix<rps_nbjobs; thrix++)
+        Rps_CallFrame*topframe = agenda_work_gc_callframe_[thrix].load();
+        if (!topframe)
+          continue;
+        for (Rps_CallFrame*curframe = topframe;
+             curframe != nullptr;
+             curframe = curframe->dynamic_previous_frame())
+          curframe->gc_mark_frame(gc);
+        const void*stacklow = agenda_worker_stack_low_[thrix].load();
+        const void*stacktop = agenda_worker_stack_top_[thrix].load();
+        if (stacklow && stacktop && stacklow < stacktop)
           {
-            auto pcallfr = agenda_work_gc_callframe_[thrix].load();
-            if (!pcallfr)
-              continue;
-            gc->mark_call_stack(pcallfr);
-            agenda_work_gc_callframe_[thrix].store(nullptr);
+            for (const void*const*pw = (const void*const*)stacklow;
+                 (const void*)pw < stacktop;
+                 pw++)
+              {
+                Rps_QuasiZone*qz = Rps_QuasiZone::zone_at_address(*pw, largezones);
+                if (qz)
+                  gc_mark_root_zone(gc, qz);
+              }
           }
-      });
-      rps_garbage_collect(&gcfun);
-    };
-  std::this_thread::sleep_for(1ms/8);
-  // Every thread which is in GC state switches to EndGC state.
-  for (int wix=1; wix<rps_nbjobs; wix++)
+      }
+  });
+  /// collections triggered by allocation are mostly minor ones,
+  /// unless the heap went above the soft cap
+  rps_garbage_collect(&gcfun, /*minor:*/!Rps_GcPacer::over_soft_cap());
+  agenda_cumulw_gc_.store(Rps_QuasiZone::cumulative_allocated_wordcount());
+  Rps_GcPacer::note_collection();
+  agenda_gc_count_.fetch_add(1);
+  agenda_gc_stall_nanosec_.fetch_add
+  ((uint64_t)((rps_monotonic_real_time()
+               - rps_agenda_gc_request_time.exchange(0.0))*1.0e9));
+  /// before any worker leaves its safepoint
+  agenda_needs_garbcoll_.store(false);
+  agenda_gc_arrived_.store(0);
+  agenda_gc_leader_.store(0);
+  agenda_safepoint_epoch_.store(epoch+2);
+  (void) rps_agenda_futex(&agenda_safepoint_epoch_, FUTEX_WAKE_PRIVATE,
+                          INT_MAX, nullptr);
+} // end Rps_Agenda::collect_at_safepoint
+
+/// mark a zone kept by a stopped worker thread: a value, or the owner
+/// of a payload
+void
+Rps_Agenda::gc_mark_root_zone(Rps_GarbageCollector*gc, Rps_QuasiZone*qz)
+{
+  RPS_ASSERT(gc != nullptr && qz != nullptr);
+  if ((int)qz->stored_type() > (int)Rps_Type::None)
+    gc->mark_value(Rps_Value(static_cast<Rps_ZoneValue*>(qz)));
+  else if ((int)qz->stored_type() <= (int)Rps_Type::Payl__LeastRank
+           && qz->stored_type() != Rps_Type::CallFrame)
     {
-      std::thread*curthr = agenda_thread_array_[wix].load();
-      if (!curthr)
-        continue;
-      if (agenda_work_thread_state_[wix].load() == Rps_Agenda::WthrAg_GC)
-        agenda_work_thread_state_[wix].store(Rps_Agenda::WthrAg_EndGC);
-    };
-  std::this_thread::sleep_for(1ms/8);
-  Rps_Agenda::agenda_changed_condvar_.notify_all();
-  // at the next iteration of Rps_Agenda::run_agenda_worker, the
-  // thread will resume usual work if agenda is non-empty....
-} // end of Rps_Agenda::do_garbage_collect
+      Rps_ObjectZone*obown = static_cast<Rps_Payload*>(qz)->owner();
+      if (obown)
+        gc->mark_obj(obown);
+    }
+} // end Rps_Agenda::gc_mark_root_zone
+
+/// A leaving worker thread no longer takes part in the barrier; if
+/// every remaining one is already stopped, it collects for them.
+void
+Rps_Agenda::leave_safepoints(int ix)
+{
+  RPS_ASSERT(ix>0 && ix<=RPS_NBJOBS_MAX);
+  agenda_nosafepoint_depth_++;
+  uint32_t epoch = agenda_safepoint_epoch_.load();
+  int nbworkers = agenda_nb_workers_.fetch_sub(1) - 1;
+  int noleader = 0;
+  if (agenda_needs_garbcoll_.load() && nbworkers > 0
+      && agenda_gc_arrived_.load() >= nbworkers
+      && agenda_gc_leader_.compare_exchange_strong(noleader, ix))
+    collect_at_safepoint(ix, epoch);
+  agenda_worker_stack_top_[ix].store(nullptr);
+  agenda_thread_index_ = 0;
+} // end Rps_Agenda::leave_safepoints
 
 /// start and run the agenda mechanism. This does not return till the
 /// agenda has stopped.
@@ -396,10 +836,16 @@ rps_run_agenda_mechanism(int nbjobs)
    * See C++ code in file eventloop_rps.cc.  See Todo §2 below
    **/
   Rps_Agenda::agenda_is_running_.store(true);
+  /// every worker thread takes part in the safepoint barrier, even
+  /// before it starts
+  Rps_Agenda::agenda_needs_garbcoll_.store(false);
+  Rps_Agenda::agenda_gc_arrived_.store(0);
+  Rps_Agenda::agenda_gc_leader_.store(0);
+  Rps_Agenda::agenda_nb_workers_.store(nbjobs-1);
   /// start all worker threads
   for (int ix=1; ix<nbjobs; ix++)
     {
-      std::lock_guard<std::recursive_mutex> gu(Rps_Agenda::agenda_mtx_);
+      Rps_NoSafepointLock<std::recursive_mutex> gu(Rps_Agenda::agenda_mtx_);
       auto curthr = new std::thread(Rps_Agenda::run_agenda_worker, ix);
       Rps_Agenda::agenda_thread_array_[ix].store(curthr);
     }
@@ -413,8 +859,11 @@ rps_run_agenda_mechanism(int nbjobs)
        * and/or to handle SIGCHLD signals in that eventloop_rps.cc
        * file.  See Todo §1 above.
        ***/
-      Rps_Agenda::agenda_changed_condvar_.wait_for(Rps_Agenda::agenda_mtx_,
-          30ms + 1ms * Rps_Random::random_quickly_4bits());
+      {
+        std::unique_lock<std::recursive_mutex> ulock(Rps_Agenda::agenda_mtx_);
+        Rps_Agenda::agenda_changed_condvar_.wait_for(ulock,
+            30ms + 1ms * Rps_Random::random_quickly_4bits());
+      }
       if (Rps_Agenda::agenda_is_running_.load())
         continue;
       for (int ix=1; ix<nbjobs; ix++)
@@ -426,6 +875,7 @@ rps_run_agenda_mechanism(int nbjobs)
           delete thrp;
           Rps_Agenda::agenda_thread_array_[ix].store(nullptr);
         }
+      break;
     }
 } // end of rps_run_agenda_mechanism
 
@@ -433,6 +883,7 @@ void
 rps_stop_agenda_mechanism(void)
 {
   Rps_Agenda::agenda_is_running_.store(false);
+  Rps_Agenda::wake_all_workers();
   Rps_Agenda::agenda_changed_condvar_.notify_all();
 } // end of rps_stop_agenda_mechanism
 
@@ -0,0 +1,396 @@
+/****************************************************************
+ * file arena_rps.cc
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Description:
+ *      This file is part of the Reflective Persistent System.
+ *
+ *      It has the size class segregated arena allocator giving
+ *      memory to quasi-zones, see class Rps_ZoneArena.
+ *
+ * Author(s):
+ *      Basile Starynkevitch <basile@starynkevitch.net>
+ *      Abhishek Chakravarti <abhishek@taranjali.org>
+ *      Nimesh Neema <nimeshneema@gmail.com>
+ *
+ *      © Copyright 2019 - 2024 The Reflective Persistent System Team
+ *      team@refpersys.org & http://refpersys.org/
+ *
+ * License:
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "refpersys.hh"
+
+
+extern "C" const char rps_arena_gitid[];
+const char rps_arena_gitid[]= RPS_GITID;
+
+extern "C" const char rps_arena_date[];
+const char rps_arena_date[]= __DATE__;
+
+std::atomic<char*> Rps_ZoneArena::arena_region_base_;
+std::atomic<uint64_t> Rps_ZoneArena::arena_nb_mapped_pages_;
+std::atomic<uint64_t> Rps_ZoneArena::arena_nb_released_pages_;
+std::atomic<uint64_t> Rps_ZoneArena::arena_nb_large_alloc_;
+
+/// Each size class has its own mutex, and keeps a stack of its pages
+/// having some free slots. A page is in that stack iff its
+/// ap_partial flag is set.
+struct rps_arena_sizeclass_st
+{
+  std::mutex asc_mtx;
+  std::vector<Rps_ZoneArena::arena_page_st*> asc_partial;
+  unsigned asc_nbpages;
+};
+
+static rps_arena_sizeclass_st rps_arena_sizeclasses[Rps_ZoneArena::arena_nb_size_classes];
+
+/// The page pool gives pages from the reserved region; released pages
+/// are madvise-d away and reused before touching fresh ones.
+static std::mutex rps_arena_pagepool_mtx;
+static std::vector<char*> rps_arena_freepages;
+static size_t rps_arena_nextpagerank;
+
+/// The per-thread cache of free slots, chained thru their first
+/// word, for every size class.
+struct rps_arena_threadcache_st
+{
+  void* atc_slots[Rps_ZoneArena::arena_nb_size_classes];
+  unsigned atc_count[Rps_ZoneArena::arena_nb_size_classes];
+  ~rps_arena_threadcache_st()
+  {
+    Rps_ZoneArena::flush_thread_cache();
+  };
+};
+
+static thread_local rps_arena_threadcache_st rps_arena_thrcache;
+
+void
+Rps_ZoneArena::initialize(void)
+{
+  static std::mutex inimtx;
+  std::lock_guard<std::mutex> gu(inimtx);
+  if (arena_region_base_.load())
+    return;
+  /// reserve without committing, with one extra page for alignment
+  void*ad = mmap(nullptr, arena_region_size + arena_page_size,
+                 PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                 -1, 0);
+  if (ad == MAP_FAILED)
+    {
+      /// every zone will then be allocated by ::operator new
+      RPS_WARNOUT("Rps_ZoneArena::initialize failed to reserve "
+                  << (arena_region_size>>20) << " megabytes: "
+                  << strerror(errno));
+      return;
+    }
+  uintptr_t alignedad =
+    ((uintptr_t)ad + arena_page_size - 1) & ~(uintptr_t)(arena_page_size-1);
+  arena_region_base_.store((char*)alignedad);
+  RPS_DEBUG_LOG(GARBAGE_COLLECTOR, "Rps_ZoneArena::initialize region@"
+                << (void*)alignedad << " of " << (arena_region_size>>20)
+                << " megabytes, " << arena_nb_size_classes
+                << " size classes up to " << arena_max_small_size << " bytes");
+} // end Rps_ZoneArena::initialize
+
+
+/// get a fresh page for a given size class; caller should hold the
+/// mutex of that size class. Return nullptr once the reserved region
+/// is exhausted.
+Rps_ZoneArena::arena_page_st*
+Rps_ZoneArena::fresh_page(unsigned scix)
+{
+  RPS_ASSERT(scix < arena_nb_size_classes);
+  char*base = arena_region_base_.load();
+  RPS_ASSERT(base != nullptr);
+  char*pgad = nullptr;
+  {
+    std::lock_guard<std::mutex> gu(rps_arena_pagepool_mtx);
+    if (!rps_arena_freepages.empty())
+      {
+        pgad = rps_arena_freepages.back();
+        rps_arena_freepages.pop_back();
+      }
+    else if (rps_arena_nextpagerank < arena_region_size / arena_page_size)
+      {
+        pgad = base + rps_arena_nextpagerank * arena_page_size;
+        if (mprotect(pgad, arena_page_size, PROT_READ | PROT_WRITE))
+          {
+            RPS_WARNOUT("Rps_ZoneArena::fresh_page failed to commit page@"
+                        << (void*)pgad << ": " << strerror(errno));
+            return nullptr;
+          }
+        rps_arena_nextpagerank++;
+      }
+  }
+  if (!pgad)
+    return nullptr;
+  arena_nb_mapped_pages_.fetch_add(1);
+  size_t slotsiz = size_class_bytes(scix);
+  auto pg = new (pgad) arena_page_st;
+  pg->ap_magic = arena_page_magic;
+  pg->ap_sizeclass = scix;
+  pg->ap_slotsize = (uint32_t) slotsiz;
+  pg->ap_nbslots = (uint32_t) ((arena_page_size - arena_page_header_size) / slotsiz);
+  pg->ap_bumpix = 0;
+  pg->ap_nbused = 0;
+  pg->ap_freelist = nullptr;
+  pg->ap_partial = false;
+  return pg;
+} // end Rps_ZoneArena::fresh_page
+
+
+/// move up to arena_thread_batch slots from the pages into the empty
+/// cache of the current thread
+void
+Rps_ZoneArena::refill_thread_cache(unsigned scix)
+{
+  RPS_ASSERT(scix < arena_nb_size_classes);
+  auto& tc = rps_arena_thrcache;
+  RPS_ASSERT(tc.atc_slots[scix] == nullptr);
+  auto& sc = rps_arena_sizeclasses[scix];
+  std::lock_guard<std::mutex> gu(sc.asc_mtx);
+  void*slotlist = nullptr;
+  unsigned nbgot = 0;
+  while (nbgot < arena_thread_batch)
+    {
+      arena_page_st*pg = nullptr;
+      if (!sc.asc_partial.empty())
+        pg = sc.asc_partial.back();
+      else
+        {
+          pg = fresh_page(scix);
+          if (!pg)
+            break;
+          sc.asc_nbpages++;
+          pg->ap_partial = true;
+          sc.asc_partial.push_back(pg);
+        }
+      RPS_ASSERT(pg->ap_magic == arena_page_magic && pg->ap_partial);
+      while (nbgot < arena_thread_batch
+             && (pg->ap_freelist || pg->ap_bumpix < pg->ap_nbslots))
+        {
+          void*slot = nullptr;
+          if (pg->ap_freelist)
+            {
+              slot = pg->ap_freelist;
+              pg->ap_freelist = *(void**)slot;
+            }
+          else
+            slot = (char*)pg + arena_page_header_size
+                   + (size_t)(pg->ap_bumpix++) * pg->ap_slotsize;
+          pg->ap_nbused++;
+          *(void**)slot = slotlist;
+          slotlist = slot;
+          nbgot++;
+        }
+      if (!pg->ap_freelist && pg->ap_bumpix >= pg->ap_nbslots)
+        {
+          /// the page is full
+          pg->ap_partial = false;
+          sc.asc_partial.pop_back();
+        }
+    }
+  tc.atc_slots[scix] = slotlist;
+  tc.atc_count[scix] = nbgot;
+} // end Rps_ZoneArena::refill_thread_cache
+
+
+/// give back a chained list of free slots to their pages
+void
+Rps_ZoneArena::give_back_slots(unsigned scix, void*slotlist, unsigned nbslots)
+{
+  RPS_ASSERT(scix < arena_nb_size_classes);
+  auto& sc = rps_arena_sizeclasses[scix];
+  std::lock_guard<std::mutex> gu(sc.asc_mtx);
+  unsigned cnt = 0;
+  while (slotlist)
+    {
+      void*slot = slotlist;
+      slotlist = *(void**)slot;
+      auto pg = page_of(slot);
+      RPS_ASSERT(pg->ap_magic == arena_page_magic && pg->ap_sizeclass == scix);
+      RPS_ASSERT(pg->ap_nbused > 0);
+      *(void**)slot = pg->ap_freelist;
+      pg->ap_freelist = slot;
+      pg->ap_nbused--;
+      if (!pg->ap_partial)
+        {
+          pg->ap_partial = true;
+          sc.asc_partial.push_back(pg);
+        }
+      cnt++;
+    }
+  RPS_ASSERT(cnt == nbslots);
+} // end Rps_ZoneArena::give_back_slots
+
+
+void*
+Rps_ZoneArena::allocate(size_t siz)
+{
+  if (RPS_UNLIKELY(siz > arena_max_small_size
+                   || arena_region_base_.load(std::memory_order_relaxed) == nullptr))
+    {
+      arena_nb_large_alloc_.fetch_add(1, std::memory_order_relaxed);
+      return ::operator new (siz);
+    }
+  unsigned scix = size_class_index(siz);
+  auto& tc = rps_arena_thrcache;
+  if (RPS_UNLIKELY(tc.atc_slots[scix] == nullptr))
+    {
+      refill_thread_cache(scix);
+      if (RPS_UNLIKELY(tc.atc_slots[scix] == nullptr))
+        {
+          /// the reserved region is exhausted
+          arena_nb_large_alloc_.fetch_add(1, std::memory_order_relaxed);
+          return ::operator new (siz);
+        }
+    }
+  void*slot = tc.atc_slots[scix];
+  tc.atc_slots[scix] = *(void**)slot;
+  tc.atc_count[scix]--;
+  *(void**)slot = nullptr;
+  return slot;
+} // end Rps_ZoneArena::allocate
+
+
+void
+Rps_ZoneArena::deallocate(void*ptr)
+{
+  if (!ptr)
+    return;
+  if (!is_in_arena(ptr))
+    {
+      ::operator delete (ptr);
+      return;
+    }
+  auto pg = page_of(ptr);
+  RPS_ASSERT(pg->ap_magic == arena_page_magic);
+  unsigned scix = pg->ap_sizeclass;
+  auto& tc = rps_arena_thrcache;
+  *(void**)ptr = tc.atc_slots[scix];
+  tc.atc_slots[scix] = ptr;
+  tc.atc_count[scix]++;
+  if (RPS_UNLIKELY(tc.atc_count[scix] >= 2*arena_thread_batch))
+    {
+      /// detach a batch of slots from the thread cache
+      void*head = tc.atc_slots[scix];
+      void*last = head;
+      for (unsigned ix=1; ix<arena_thread_batch; ix++)
+        last = *(void**)last;
+      tc.atc_slots[scix] = *(void**)last;
+      *(void**)last = nullptr;
+      tc.atc_count[scix] -= arena_thread_batch;
+      give_back_slots(scix, head, arena_thread_batch);
+    }
+} // end Rps_ZoneArena::deallocate
+
+
+/// Used to scan conservatively the C++ stacks of stopped worker
+/// threads, so any word is accepted. Pages never committed are not
+/// readable, and released ones have a cleared magic. The returned
+/// slot could be free: the caller checks it with the zone table.
+const void*
+Rps_ZoneArena::block_containing(const void*ptr)
+{
+  if (!is_in_arena(ptr))
+    return nullptr;
+  const char*base = arena_region_base_.load();
+  size_t pgrank = ((const char*)ptr - base) / arena_page_size;
+  {
+    std::lock_guard<std::mutex> gu(rps_arena_pagepool_mtx);
+    if (pgrank >= rps_arena_nextpagerank)
+      return nullptr;
+  }
+  auto pg = page_of(ptr);
+  if (pg->ap_magic != arena_page_magic)
+    return nullptr;
+  const char*firstslot = (const char*)pg + arena_page_header_size;
+  if ((const char*)ptr < firstslot)
+    return nullptr;
+  size_t slotix = ((const char*)ptr - firstslot) / pg->ap_slotsize;
+  if (slotix >= pg->ap_nbslots)
+    return nullptr;
+  return firstslot + slotix * pg->ap_slotsize;
+} // end Rps_ZoneArena::block_containing
+
+
+void
+Rps_ZoneArena::flush_thread_cache(void)
+{
+  auto& tc = rps_arena_thrcache;
+  for (unsigned scix=0; scix<arena_nb_size_classes; scix++)
+    {
+      if (!tc.atc_slots[scix])
+        continue;
+      give_back_slots(scix, tc.atc_slots[scix], tc.atc_count[scix]);
+      tc.atc_slots[scix] = nullptr;
+      tc.atc_count[scix] = 0;
+    }
+} // end Rps_ZoneArena::flush_thread_cache
+
+
+/// Called by the garbage collector after its sweep. For each size
+/// class, we keep at most one empty page to avoid thrashing, and all
+/// other empty pages go back to the kernel in bulk.
+unsigned
+Rps_ZoneArena::release_empty_pages(void)
+{
+  if (!arena_region_base_.load())
+    return 0;
+  std::vector<arena_page_st*> emptypages;
+  for (unsigned scix=0; scix<arena_nb_size_classes; scix++)
+    {
+      auto& sc = rps_arena_sizeclasses[scix];
+      std::lock_guard<std::mutex> gu(sc.asc_mtx);
+      bool keptempty = false;
+      auto& partvec = sc.asc_partial;
+      size_t nbkept = 0;
+      for (size_t ix=0; ix<partvec.size(); ix++)
+        {
+          auto pg = partvec[ix];
+          RPS_ASSERT(pg->ap_magic == arena_page_magic && pg->ap_partial);
+          if (pg->ap_nbused == 0)
+            {
+              if (keptempty)
+                {
+                  emptypages.push_back(pg);
+                  sc.asc_nbpages--;
+                  pg->ap_magic = 0;
+                  continue;
+                }
+              keptempty = true;
+            }
+          partvec[nbkept++] = pg;
+        }
+      partvec.resize(nbkept);
+    }
+  for (auto pg: emptypages)
+    {
+      if (madvise((void*)pg, arena_page_size, MADV_DONTNEED))
+        RPS_WARNOUT("Rps_ZoneArena::release_empty_pages madvise failed for page@"
+                    << (void*)pg << ": " << strerror(errno));
+    }
+  {
+    std::lock_guard<std::mutex> gu(rps_arena_pagepool_mtx);
+    for (auto pg: emptypages)
+      rps_arena_freepages.push_back((char*)pg);
+  }
+  arena_nb_mapped_pages_.fetch_sub(emptypages.size());
+  arena_nb_released_pages_.fetch_add(emptypages.size());
+  return (unsigned) emptypages.size();
+} // end Rps_ZoneArena::release_empty_pages
+
+//////////////////////////////////////////////////////////// end of file arena_rps.cc
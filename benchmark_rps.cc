@@ -0,0 +1,575 @@
+/****************************************************************
+ * file benchmark_rps.cc
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Description:
+ *      This file is part of the Reflective Persistent System.
+ *
+ *      It has the load benchmark: a synthetic heap is generated,
+ *      dumped, and loaded again by a child process reporting the
+ *      timings of the loading phases. It also has the agenda
+ *      benchmark, running synthetic tasklets thru the agenda.
+ *
+ * Author(s):
+ *      Basile Starynkevitch <basile@starynkevitch.net>
+ *      Abhishek Chakravarti <abhishek@taranjali.org>
+ *      Nimesh Neema <nimeshneema@gmail.com>
+ *
+ *      © Copyright 2019 - 2024 The Reflective Persistent System Team
+ *      team@refpersys.org & http://refpersys.org/
+ *
+ * License:
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "refpersys.hh"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <dirent.h>
+#include <random>
+#include <thread>
+
+extern "C" const char rps_benchmark_gitid[];
+const char rps_benchmark_gitid[]= RPS_GITID;
+
+extern "C" const char rps_benchmark_date[];
+const char rps_benchmark_date[]= __DATE__;
+
+/// The --benchmark-load=NBOBJECTS[:ATTRS[:COMPS[:CLASSES]]] program
+/// option generates, after the normal load, a synthetic heap of
+/// NBOBJECTS objects in the initial space, each with ATTRS attributes
+/// and COMPS components referring to random other ones, whose classes
+/// form a binary tree of CLASSES classes. One object out of eight
+/// has a string buffer, string dictionary, vector of values, or
+/// mutable set payload. That heap is dumped into a fresh temporary
+/// directory, which is then loaded by a child process run with
+/// --benchmark-load=report. Every report line starts with
+/// RPS-BENCHMARK so is easy to grep.
+std::string rps_benchmark_load_spec;
+
+struct rps_benchmark_params_st
+{
+  unsigned bp_nbobjects = 10000;
+  unsigned bp_nbattrs = 4;
+  unsigned bp_nbcomps = 4;
+  unsigned bp_nbclasses = 8;
+};
+
+static rps_benchmark_params_st
+rps_benchmark_parse_spec(const std::string&spec)
+{
+  rps_benchmark_params_st bp;
+  unsigned* fields[] = {&bp.bp_nbobjects, &bp.bp_nbattrs,
+                        &bp.bp_nbcomps, &bp.bp_nbclasses
+                       };
+  const char*pc = spec.c_str();
+  for (unsigned ix=0; ix<sizeof(fields)/sizeof(fields[0]) && *pc; ix++)
+    {
+      char*end = nullptr;
+      unsigned long val = strtoul(pc, &end, 10);
+      if (end == pc || val > 100000000UL)
+        RPS_FATALOUT("bad --benchmark-load=" << spec
+                     << " expecting NBOBJECTS[:ATTRS[:COMPS[:CLASSES]]]");
+      *fields[ix] = (unsigned) val;
+      pc = end;
+      if (*pc == ':')
+        pc++;
+      else if (*pc)
+        RPS_FATALOUT("bad --benchmark-load=" << spec
+                     << " expecting NBOBJECTS[:ATTRS[:COMPS[:CLASSES]]]");
+    }
+  if (bp.bp_nbobjects == 0 || bp.bp_nbclasses == 0)
+    RPS_FATALOUT("--benchmark-load=" << spec << " needs some objects and classes");
+  return bp;
+} // end rps_benchmark_parse_spec
+
+static long
+rps_benchmark_peak_rss_kib(void)
+{
+  struct rusage ru;
+  memset (&ru, 0, sizeof(ru));
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+} // end rps_benchmark_peak_rss_kib
+
+/// the cumulated size of the files of a directory
+static long long
+rps_benchmark_directory_size(const std::string&dirpath)
+{
+  long long total = 0;
+  DIR* dir = opendir(dirpath.c_str());
+  if (!dir)
+    return 0;
+  while (struct dirent* ent = readdir(dir))
+    {
+      struct stat st;
+      memset (&st, 0, sizeof(st));
+      std::string path = dirpath + "/" + ent->d_name;
+      if (!stat(path.c_str(), &st) && S_ISREG(st.st_mode))
+        total += st.st_size;
+    }
+  closedir(dir);
+  return total;
+} // end rps_benchmark_directory_size
+
+/// run by the child process, right after its load
+static void
+rps_benchmark_report_load(void)
+{
+  const Rps_LoadStatistics& ls = rps_load_statistics;
+  double gcstart = rps_monotonic_real_time();
+  rps_garbage_collect();
+  double gctime = rps_monotonic_real_time() - gcstart;
+  printf("RPS-BENCHMARK load objects=%u spaces=%u unfilled=%u jobs=%d\n",
+         ls.ls_nbobjects, ls.ls_nbspaces, ls.ls_nbunfilled, rps_nbjobs);
+  printf("RPS-BENCHMARK load mapping=%.4f firstpass=%.4f secondpass=%.4f"
+         " journal=%.4f todo=%.4f roots=%.4f total=%.4f seconds\n",
+         ls.ls_mapping, ls.ls_firstpass, ls.ls_secondpass,
+         ls.ls_journal, ls.ls_todo, ls.ls_roots, ls.ls_total);
+  printf("RPS-BENCHMARK load gc-after-load=%.4f seconds peak-rss=%ld KiB\n",
+         gctime, rps_benchmark_peak_rss_kib());
+  fflush(nullptr);
+  exit(EXIT_SUCCESS);
+} // end rps_benchmark_report_load
+
+/// returns the mutable set of every synthetic object
+static Rps_ObjectRef
+rps_benchmark_generate(Rps_CallFrame*callerframe, const rps_benchmark_params_st&bp)
+{
+  RPS_LOCALFRAME(RPS_CALL_FRAME_UNDESCRIBED,
+                 callerframe,
+                 Rps_ObjectRef setob; // every synthetic object
+                 Rps_ObjectRef spaceob;
+                 Rps_ObjectRef classob;
+                 Rps_ObjectRef curob;
+                 Rps_ObjectRef otherob;
+                 Rps_Value val;
+                );
+  _f.spaceob = RPS_ROOT_OB(_8J6vNYtP5E800eCr5q); //"initial_space"∈space
+  /// the synthetic objects are kept, and dumped, thru this set put
+  /// in the system object
+  _f.setob = Rps_PayloadSetOb::make_mutable_set_object(&_, nullptr, _f.spaceob);
+  RPS_ROOT_OB(_1Io89yIORqn02SXx4p)->put_attr(_f.setob, _f.setob); //RefPerSys_system∈the_system_class
+  Rps_PayloadSetOb* paylset = _f.setob->get_dynamic_payload<Rps_PayloadSetOb>();
+  RPS_ASSERT(paylset != nullptr);
+  std::vector<Rps_ObjectRef> classvec, attrvec, obvec;
+  std::mt19937 rng(31);         // reproducible heaps
+  for (unsigned ix=0; ix<bp.bp_nbclasses; ix++)
+    {
+      Rps_ObjectRef superob = (ix==0)
+                              ? RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ) //object∈class
+                              : classvec[(ix-1)/2];
+      std::string name = std::string{"benchmark_class"} + std::to_string(ix)
+                         + "_p" + std::to_string((int)getpid());
+      _f.classob = Rps_ObjectRef::make_named_class(&_, superob, name);
+      _f.classob->put_space(_f.spaceob);
+      if ((_f.otherob = Rps_PayloadSymbol::find_named_object(name)))
+        _f.otherob->put_space(_f.spaceob);
+      paylset->add(_f.classob);
+      classvec.push_back(_f.classob);
+    }
+  for (unsigned ix=0; ix<bp.bp_nbattrs; ix++)
+    {
+      _f.curob = Rps_ObjectRef::make_object(&_, RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ), //object∈class
+                                            _f.spaceob);
+      paylset->add(_f.curob);
+      attrvec.push_back(_f.curob);
+    }
+  obvec.reserve(bp.bp_nbobjects);
+  for (unsigned ix=0; ix<bp.bp_nbobjects; ix++)
+    {
+      _f.classob = classvec[rng() % classvec.size()];
+      switch (ix % 8)
+        {
+        case 0:
+          _f.curob = Rps_PayloadStrBuf::make_string_buffer_object(&_, nullptr, _f.spaceob);
+          break;
+        case 1:
+          _f.curob = Rps_PayloadStringDict::make_string_dictionary_object(&_, nullptr, _f.spaceob);
+          break;
+        case 2:
+          _f.curob = Rps_ObjectRef::make_object(&_, _f.classob, _f.spaceob);
+          _f.curob->put_new_plain_payload<Rps_PayloadVectVal>();
+          break;
+        case 3:
+          _f.curob = Rps_PayloadSetOb::make_mutable_set_object(&_, nullptr, _f.spaceob);
+          break;
+        default:
+          _f.curob = Rps_ObjectRef::make_object(&_, _f.classob, _f.spaceob);
+          break;
+        }
+      paylset->add(_f.curob);
+      obvec.push_back(_f.curob);
+    }
+  /// random values, mostly objects, sometimes integers or strings
+  auto random_value = [&](void) -> Rps_Value
+  {
+    unsigned r = rng();
+    switch (r % 4)
+      {
+      case 0:
+        return Rps_Value((intptr_t)(r / 4));
+      case 1:
+        return Rps_StringValue(std::string{"bench#"} + std::to_string(r / 4));
+      default:
+        return Rps_ObjectValue(obvec[(r / 4) % obvec.size()]);
+      }
+  };
+  for (unsigned ix=0; ix<obvec.size(); ix++)
+    {
+      _f.curob = obvec[ix];
+      std::lock_guard<Rps_ObjectMutex> gu(*_f.curob->objmtxptr());
+      for (Rps_ObjectRef atob: attrvec)
+        {
+          _f.val = random_value();
+          _f.curob->put_attr(atob, _f.val);
+        }
+      for (unsigned cix=0; cix<bp.bp_nbcomps; cix++)
+        {
+          _f.val = random_value();
+          _f.curob->append_comp1(_f.val);
+        }
+      switch (ix % 8)
+        {
+        case 0:
+          _f.curob->get_dynamic_payload<Rps_PayloadStrBuf>()
+          ->append_string(std::string{"synthetic string buffer #"} + std::to_string(ix) + "\n");
+          break;
+        case 1:
+        {
+          auto payldict = _f.curob->get_dynamic_payload<Rps_PayloadStringDict>();
+          for (unsigned cix=0; cix<bp.bp_nbcomps; cix++)
+            {
+              _f.val = random_value();
+              payldict->add(std::string{"key"} + std::to_string(cix), _f.val);
+            }
+        }
+        break;
+        case 2:
+        {
+          auto paylvect = _f.curob->get_dynamic_payload<Rps_PayloadVectVal>();
+          for (unsigned cix=0; cix<bp.bp_nbcomps; cix++)
+            {
+              _f.val = random_value();
+              paylvect->push_back(_f.val);
+            }
+        }
+        break;
+        case 3:
+        {
+          auto paylcurset = _f.curob->get_dynamic_payload<Rps_PayloadSetOb>();
+          for (unsigned cix=0; cix<bp.bp_nbcomps; cix++)
+            paylcurset->add(obvec[rng() % obvec.size()]);
+        }
+        break;
+        default:
+          break;
+        }
+    }
+  return _f.setob;
+} // end rps_benchmark_generate
+
+/// called after the load by main; never returns
+void
+rps_benchmark_load(const std::string&spec)
+{
+  if (spec == "report")
+    rps_benchmark_report_load();
+  rps_benchmark_params_st bp = rps_benchmark_parse_spec(spec);
+  RPS_LOCALFRAME(RPS_CALL_FRAME_UNDESCRIBED,
+                 /*callerframe:*/nullptr,
+                 Rps_ObjectRef setob; // every synthetic object
+                );
+  double genstart = rps_monotonic_real_time();
+  _f.setob = rps_benchmark_generate(&_, bp);
+  double gentime = rps_monotonic_real_time() - genstart;
+  printf("RPS-BENCHMARK generate objects=%u attrs=%u comps=%u classes=%u"
+         " time=%.4f seconds\n",
+         bp.bp_nbobjects, bp.bp_nbattrs, bp.bp_nbcomps, bp.bp_nbclasses, gentime);
+  char dirbuf[] = "/tmp/rpsbench-XXXXXX";
+  if (!mkdtemp(dirbuf))
+    RPS_FATALOUT("benchmark failed to make temporary directory:" << strerror(errno));
+  double dumpstart = rps_monotonic_real_time();
+  rps_dump_into(dirbuf, &_);
+  double dumptime = rps_monotonic_real_time() - dumpstart;
+  printf("RPS-BENCHMARK dump directory=%s time=%.4f seconds store=%lld bytes"
+         " peak-rss=%ld KiB\n",
+         dirbuf, dumptime, rps_benchmark_directory_size(std::string{dirbuf} + "/persistore"),
+         rps_benchmark_peak_rss_kib());
+  fflush(nullptr);
+  /// the dumped heap is loaded by a fresh process, since the objects
+  /// of this one cannot be loaded again
+  std::string loadarg = std::string{"--load="} + dirbuf;
+  std::string jobsarg = std::string{"--jobs="} + std::to_string(rps_nbjobs);
+  std::vector<const char*> args = {rps_progexe, "--batch", loadarg.c_str(),
+                                   jobsarg.c_str(), "--benchmark-load=report"
+                                  };
+  if (rps_lazy_load)
+    args.push_back("--lazy-load");
+  args.push_back(nullptr);
+  double loadstart = rps_monotonic_real_time();
+  pid_t pid = fork();
+  if (pid < 0)
+    RPS_FATALOUT("benchmark failed to fork:" << strerror(errno));
+  if (pid == 0)
+    {
+      execv(rps_progexe, const_cast<char*const*>(args.data()));
+      perror(rps_progexe);
+      _exit(127);
+    }
+  int status = 0;
+  if (waitpid(pid, &status, 0) < 0)
+    RPS_FATALOUT("benchmark failed to wait for process " << pid << ":" << strerror(errno));
+  double loadtime = rps_monotonic_real_time() - loadstart;
+  bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  printf("RPS-BENCHMARK reload process=%.4f seconds %s\n", loadtime,
+         ok?"succeeded":"FAILED");
+  fflush(nullptr);
+  exit(ok?EXIT_SUCCESS:EXIT_FAILURE);
+} // end rps_benchmark_load
+
+
+////////////////////////////////////////////////////////////////
+////////////// AGENDA BENCHMARK
+
+/// The --benchmark-agenda=NBTASKLETS[:COSTMICROSEC[:LOW/NORMAL/HIGH[:RATE]]]
+/// program option makes, after the normal load, NBTASKLETS transient
+/// tasklets whose closure spins COSTMICROSEC microseconds and
+/// allocates a small string, so the garbage collector runs now and
+/// then. Their priorities are drawn with the LOW/NORMAL/HIGH weights.
+/// Once the worker threads are started, a feeder thread adds them to
+/// the agenda at RATE tasklets per second, or all at once if RATE is
+/// 0. The enqueue-to-start latency is measured for each tasklet.
+std::string rps_benchmark_agenda_spec;
+
+struct rps_agenda_bench_st
+{
+  unsigned ab_nbtasklets = 100000;
+  unsigned ab_costmicrosec = 10;
+  unsigned ab_prioweight[Rps_Agenda::AgPrio__Last] = {0, 1, 2, 1};
+  double ab_rate = 0.0;
+  /// monotonic times, indexed by tasklet rank
+  std::vector<double> ab_enqueuetime;
+  std::vector<double> ab_starttime;
+  std::atomic<unsigned> ab_nbdone;
+  std::atomic<double> ab_lastend;
+};
+static rps_agenda_bench_st rps_agenda_bench;
+
+static void
+rps_benchmark_parse_agenda_spec(const std::string&spec)
+{
+  rps_agenda_bench_st& ab = rps_agenda_bench;
+  unsigned low=1, normal=2, high=1;
+  const char*pc = spec.c_str();
+  int pos = -1;
+  int nbfields = sscanf(pc, "%u%n", &ab.ab_nbtasklets, &pos);
+  if (nbfields == 1 && pc[pos] == ':')
+    {
+      pc += pos+1;
+      pos = -1;
+      nbfields = sscanf(pc, "%u%n", &ab.ab_costmicrosec, &pos);
+      if (nbfields == 1 && pc[pos] == ':')
+        {
+          pc += pos+1;
+          pos = -1;
+          nbfields = sscanf(pc, "%u/%u/%u%n", &low, &normal, &high, &pos);
+          if (nbfields == 3 && pc[pos] == ':')
+            {
+              pc += pos+1;
+              pos = -1;
+              nbfields = sscanf(pc, "%lf%n", &ab.ab_rate, &pos);
+            }
+        }
+    }
+  if (nbfields <= 0 || pos < 0 || pc[pos] != (char)0
+      || ab.ab_nbtasklets == 0 || low+normal+high == 0 || !(ab.ab_rate >= 0.0))
+    RPS_FATALOUT("bad --benchmark-agenda=" << spec
+                 << " expecting NBTASKLETS[:COSTMICROSEC[:LOW/NORMAL/HIGH[:RATE]]]");
+  ab.ab_prioweight[Rps_Agenda::AgPrio_Low] = low;
+  ab.ab_prioweight[Rps_Agenda::AgPrio_Normal] = normal;
+  ab.ab_prioweight[Rps_Agenda::AgPrio_High] = high;
+} // end rps_benchmark_parse_agenda_spec
+
+/// the applying function of every benchmark tasklet closure, whose
+/// only value is the tasklet rank
+static Rps_TwoValues
+rps_benchmark_tasklet_apply(Rps_CallFrame*callerframe,
+                            const Rps_Value arg0,
+                            [[maybe_unused]] const Rps_Value arg1,
+                            [[maybe_unused]] const Rps_Value arg2,
+                            [[maybe_unused]] const Rps_Value arg3,
+                            [[maybe_unused]] const std::vector<Rps_Value>* restargs)
+{
+  RPS_ASSERT_CALLFRAME (callerframe);
+  rps_agenda_bench_st& ab = rps_agenda_bench;
+  double start = rps_monotonic_real_time();
+  intptr_t rk = callerframe->call_frame_closure()->at(0).as_int();
+  RPS_ASSERT(rk >= 0 && rk < (intptr_t)ab.ab_nbtasklets);
+  ab.ab_starttime[rk] = start;
+  (void) Rps_StringValue(std::string{"benchmark tasklet#"} + std::to_string(rk));
+  double end = start + 1.0e-6 * ab.ab_costmicrosec;
+  while (rps_monotonic_real_time() < end)
+    continue;
+  if (ab.ab_nbdone.fetch_add(1) + 1 == ab.ab_nbtasklets)
+    {
+      ab.ab_lastend.store(rps_monotonic_real_time());
+      rps_stop_agenda_mechanism();
+    }
+  return Rps_TwoValues(arg0);
+} // end rps_benchmark_tasklet_apply
+
+/// run by the feeder thread, which does not allocate; the tasklets
+/// are kept alive by a set in the system object
+static void
+rps_benchmark_feed_agenda(const std::vector<Rps_ObjectRef>*taskvec,
+                          const std::vector<Rps_Agenda::agenda_prio_en>*priovec)
+{
+  using namespace std::chrono_literals;
+  rps_agenda_bench_st& ab = rps_agenda_bench;
+  pthread_setname_np(pthread_self(), "rps-agbench");
+  /// every worker thread sleeps a bit before its first fetch
+  for (int ix=1; ix<rps_nbjobs; ix++)
+    while (Rps_Agenda::worker_state(ix) == Rps_Agenda::WthrAg__None)
+      std::this_thread::sleep_for(1ms);
+  std::this_thread::sleep_for(50ms + rps_nbjobs * 10ms);
+  double t0 = rps_monotonic_real_time();
+  for (unsigned rk=0; rk<ab.ab_nbtasklets; rk++)
+    {
+      if (ab.ab_rate > 0.0)
+        {
+          double due = t0 + rk / ab.ab_rate;
+          double now = rps_monotonic_real_time();
+          if (due - now > 1.0e-3)
+            std::this_thread::sleep_for(std::chrono::duration<double>(due - now));
+          while (rps_monotonic_real_time() < due)
+            continue;
+        }
+      ab.ab_enqueuetime[rk] = rps_monotonic_real_time();
+      Rps_Agenda::add_tasklet((*priovec)[rk], (*taskvec)[rk]);
+    }
+} // end rps_benchmark_feed_agenda
+
+static void
+rps_benchmark_report_agenda(void)
+{
+  rps_agenda_bench_st& ab = rps_agenda_bench;
+  unsigned nb = ab.ab_nbtasklets;
+  double first = *std::min_element(ab.ab_enqueuetime.begin(), ab.ab_enqueuetime.end());
+  double elapsed = ab.ab_lastend.load() - first;
+  std::vector<double> latvec(nb);
+  for (unsigned rk=0; rk<nb; rk++)
+    latvec[rk] = ab.ab_starttime[rk] - ab.ab_enqueuetime[rk];
+  std::sort(latvec.begin(), latvec.end());
+  auto percentile = [&](double pc) -> double
+  {
+    size_t rk = (size_t)(pc / 100.0 * (nb - 1));
+    return 1.0e6 * latvec[std::min<size_t>(rk, nb-1)];
+  };
+  printf("RPS-BENCHMARK agenda tasklets=%u cost=%u microseconds weights=%u/%u/%u"
+         " rate=%.0f jobs=%d\n",
+         nb, ab.ab_costmicrosec,
+         ab.ab_prioweight[Rps_Agenda::AgPrio_Low],
+         ab.ab_prioweight[Rps_Agenda::AgPrio_Normal],
+         ab.ab_prioweight[Rps_Agenda::AgPrio_High],
+         ab.ab_rate, rps_nbjobs);
+  printf("RPS-BENCHMARK agenda elapsed=%.4f seconds throughput=%.0f tasklets/second\n",
+         elapsed, nb / elapsed);
+  printf("RPS-BENCHMARK agenda latency p50=%.1f p90=%.1f p99=%.1f p99.9=%.1f"
+         " max=%.1f microseconds\n",
+         percentile(50), percentile(90), percentile(99), percentile(99.9),
+         1.0e6 * latvec.back());
+  double totidle = 0.0, totrun = 0.0, totgc = 0.0;
+  for (int ix=1; ix<rps_nbjobs; ix++)
+    {
+      double idle = Rps_Agenda::worker_state_seconds(ix, Rps_Agenda::WthrAg_Idle);
+      double run = Rps_Agenda::worker_state_seconds(ix, Rps_Agenda::WthrAg_Run);
+      double gc = Rps_Agenda::worker_state_seconds(ix, Rps_Agenda::WthrAg_GC);
+      double tot = idle + run + gc;
+      if (tot <= 0.0)
+        tot = 1.0;
+      printf("RPS-BENCHMARK agenda worker#%d idle=%.4f run=%.4f gc=%.4f seconds"
+             " utilization=%.1f%%\n", ix, idle, run, gc, 100.0 * run / tot);
+      totidle += idle;
+      totrun += run;
+      totgc += gc;
+    }
+  printf("RPS-BENCHMARK agenda workers idle=%.4f run=%.4f gc=%.4f seconds\n",
+         totidle, totrun, totgc);
+  printf("RPS-BENCHMARK agenda gc count=%lu stall=%.4f seconds peak-rss=%ld KiB\n",
+         Rps_Agenda::gc_count(), Rps_Agenda::gc_stall_seconds(),
+         rps_benchmark_peak_rss_kib());
+  printf("RPS-BENCHMARK agenda time-to-safepoint mean=%.1f max=%.1f microseconds\n",
+         Rps_Agenda::gc_count()
+         ? 1.0e6 * Rps_Agenda::time_to_safepoint_seconds() / Rps_Agenda::gc_count()
+         : 0.0,
+         1.0e6 * Rps_Agenda::max_time_to_safepoint_seconds());
+  fflush(nullptr);
+} // end rps_benchmark_report_agenda
+
+/// called after the load by main; never returns
+void
+rps_benchmark_agenda(const std::string&spec)
+{
+  rps_benchmark_parse_agenda_spec(spec);
+  rps_agenda_bench_st& ab = rps_agenda_bench;
+  RPS_LOCALFRAME(RPS_CALL_FRAME_UNDESCRIBED,
+                 /*callerframe:*/nullptr,
+                 Rps_ObjectRef setob;
+                 Rps_ObjectRef connob;
+                 Rps_ObjectRef taskob;
+                 Rps_ClosureValue closv;
+                );
+  /// no worker thread runs yet, so no collection happens while the
+  /// tasklets are made
+  _f.setob = Rps_PayloadSetOb::make_mutable_set_object(&_, nullptr, nullptr);
+  RPS_ROOT_OB(_1Io89yIORqn02SXx4p)->put_attr(_f.setob, _f.setob); //RefPerSys_system∈the_system_class
+  Rps_PayloadSetOb* paylset = _f.setob->get_dynamic_payload<Rps_PayloadSetOb>();
+  RPS_ASSERT(paylset != nullptr);
+  _f.connob = Rps_ObjectRef::make_object(&_, RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ)); //object∈class
+  _f.connob->put_applying_function(rps_benchmark_tasklet_apply);
+  paylset->add(_f.connob);
+  std::vector<Rps_ObjectRef> taskvec;
+  std::vector<Rps_Agenda::agenda_prio_en> priovec;
+  taskvec.reserve(ab.ab_nbtasklets);
+  priovec.reserve(ab.ab_nbtasklets);
+  std::mt19937 rng(37);
+  unsigned totweight = 0;
+  for (int prio=Rps_Agenda::AgPrio_Low; prio<Rps_Agenda::AgPrio__Last; prio++)
+    totweight += ab.ab_prioweight[prio];
+  for (unsigned rk=0; rk<ab.ab_nbtasklets; rk++)
+    {
+      _f.closv = Rps_ClosureValue(_f.connob, {Rps_Value((intptr_t)rk)});
+      _f.taskob = Rps_ObjectRef::make_object(&_, Rps_Agenda::tasklet_class());
+      _f.taskob->put_new_plain_payload<Rps_PayloadTasklet>()->put_todo_closure(_f.closv);
+      paylset->add(_f.taskob);
+      taskvec.push_back(_f.taskob);
+      unsigned w = rng() % totweight;
+      int prio = Rps_Agenda::AgPrio_Low;
+      while (w >= ab.ab_prioweight[prio])
+        w -= ab.ab_prioweight[prio++];
+      priovec.push_back((Rps_Agenda::agenda_prio_en)prio);
+    }
+  ab.ab_enqueuetime.assign(ab.ab_nbtasklets, 0.0);
+  ab.ab_starttime.assign(ab.ab_nbtasklets, 0.0);
+  ab.ab_nbdone.store(0);
+  std::thread feeder(rps_benchmark_feed_agenda, &taskvec, &priovec);
+  rps_run_agenda_mechanism(rps_nbjobs);
+  feeder.join();
+  rps_benchmark_report_agenda();
+  exit(EXIT_SUCCESS);
+} // end rps_benchmark_agenda
+
+//////////////////////////////////////////////////////////// end of file benchmark_rps.cc
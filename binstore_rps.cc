@@ -0,0 +1,697 @@
+/****************************************************************
+ * file binstore_rps.cc
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Description:
+ *      This file is part of the Reflective Persistent System.
+ *
+ *      It has the compact binary format of space files, an
+ *      alternative to the textual JSON ones, and the converter
+ *      between both formats.
+ *
+ * Author(s):
+ *      Basile Starynkevitch <basile@starynkevitch.net>
+ *      Abhishek Chakravarti <abhishek@taranjali.org>
+ *      Nimesh Neema <nimeshneema@gmail.com>
+ *
+ *      © Copyright 2019 - 2024 The Reflective Persistent System Team
+ *      team@refpersys.org & http://refpersys.org/
+ *
+ * License:
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "refpersys.hh"
+
+
+extern "C" const char rps_binstore_gitid[];
+const char rps_binstore_gitid[]= RPS_GITID;
+
+extern "C" const char rps_binstore_date[];
+const char rps_binstore_date[]= __DATE__;
+
+// comment for our do-scan-pkgconfig.c utility
+//@@PKGCONFIG jsoncpp
+
+bool rps_dump_binary_format;
+std::string rps_convert_store_format;
+
+/// the binary layout is little endian, like every host running
+/// RefPerSys; the header records the byte order to detect others
+static inline void
+rps_binstore_put_varint(std::string&buf, uint64_t v)
+{
+  while (v >= 0x80)
+    {
+      buf.push_back((char)((v & 0x7f) | 0x80));
+      v >>= 7;
+    }
+  buf.push_back((char)v);
+} // end rps_binstore_put_varint
+
+template <typename T> static inline void
+rps_binstore_put_fixed(std::string&buf, T v)
+{
+  buf.append(reinterpret_cast<const char*>(&v), sizeof(v));
+} // end rps_binstore_put_fixed
+
+bool
+Rps_BinaryStoreWriter::string_is_oid(const std::string&str, Rps_Id*pid)
+{
+  if (str.size() != Rps_Id::nbchars || str[0] != '_')
+    return false;
+  const char*end = nullptr;
+  bool ok = false;
+  Rps_Id id(str.c_str(), &end, &ok);
+  if (!ok || !id.valid() || end != str.c_str() + str.size())
+    return false;
+  /// only lossless conversions are accepted
+  if (id.to_string() != str)
+    return false;
+  if (pid)
+    *pid = id;
+  return true;
+} // end Rps_BinaryStoreWriter::string_is_oid
+
+Rps_BinaryStoreWriter::Rps_BinaryStoreWriter(Rps_Id spacid)
+  : bw_spacid(spacid), bw_jsonvec(), bw_recoidix(),
+    bw_oidmap(), bw_oidvec(), bw_namemap(), bw_namevec()
+{
+  RPS_ASSERT(spacid.valid());
+} // end Rps_BinaryStoreWriter::Rps_BinaryStoreWriter
+
+void
+Rps_BinaryStoreWriter::add_object(Json::Value jobject)
+{
+  Rps_Id oid;
+  if (!jobject.isObject() || !jobject.isMember("oid")
+      || !jobject["oid"].isString()
+      || !string_is_oid(jobject["oid"].asString(), &oid))
+    throw RPS_RUNTIME_ERROR_OUT("binary store of space " << bw_spacid
+                                << " got object without oid:" << jobject);
+  jobject.removeMember("oid");
+  intern_value(Json::Value(oid.to_string()));
+  bw_recoidix.push_back(bw_oidmap[oid]);
+  intern_value(jobject);
+  bw_jsonvec.push_back(std::move(jobject));
+} // end Rps_BinaryStoreWriter::add_object
+
+void
+Rps_BinaryStoreWriter::intern_value(const Json::Value&jv)
+{
+  switch (jv.type())
+    {
+    case Json::stringValue:
+    {
+      Rps_Id id;
+      if (string_is_oid(jv.asString(), &id)
+          && bw_oidmap.find(id) == bw_oidmap.end())
+        {
+          bw_oidmap.insert({id, (uint32_t)bw_oidvec.size()});
+          bw_oidvec.push_back(id);
+        }
+    }
+    break;
+    case Json::arrayValue:
+      for (const Json::Value&jcomp : jv)
+        intern_value(jcomp);
+      break;
+    case Json::objectValue:
+      for (auto it = jv.begin(); it != jv.end(); it++)
+        {
+          std::string name = it.name();
+          if (bw_namemap.find(name) == bw_namemap.end())
+            {
+              bw_namemap.insert({name, (uint32_t)bw_namevec.size()});
+              bw_namevec.push_back(name);
+            }
+          intern_value(*it);
+        }
+      break;
+    default:
+      break;
+    }
+} // end Rps_BinaryStoreWriter::intern_value
+
+void
+Rps_BinaryStoreWriter::encode_value(std::string&buf, const Json::Value&jv)
+{
+  switch (jv.type())
+    {
+    case Json::nullValue:
+      buf.push_back((char)BsTag_Null);
+      return;
+    case Json::booleanValue:
+      buf.push_back((char)(jv.asBool()?BsTag_True:BsTag_False));
+      return;
+    case Json::intValue:
+    {
+      int64_t i = jv.asInt64();
+      buf.push_back((char)BsTag_Int);
+      rps_binstore_put_varint(buf, ((uint64_t)i << 1) ^ (uint64_t)(i >> 63));
+    }
+    return;
+    case Json::uintValue:
+      buf.push_back((char)BsTag_UInt);
+      rps_binstore_put_varint(buf, jv.asUInt64());
+      return;
+    case Json::realValue:
+      buf.push_back((char)BsTag_Double);
+      rps_binstore_put_fixed<double>(buf, jv.asDouble());
+      return;
+    case Json::stringValue:
+    {
+      Rps_Id id;
+      const std::string str = jv.asString();
+      if (string_is_oid(str, &id))
+        {
+          buf.push_back((char)BsTag_Oid);
+          rps_binstore_put_varint(buf, bw_oidmap.at(id));
+        }
+      else
+        {
+          buf.push_back((char)BsTag_String);
+          rps_binstore_put_varint(buf, str.size());
+          buf.append(str);
+        }
+    }
+    return;
+    case Json::arrayValue:
+      buf.push_back((char)BsTag_Array);
+      rps_binstore_put_varint(buf, jv.size());
+      for (const Json::Value&jcomp : jv)
+        encode_value(buf, jcomp);
+      return;
+    case Json::objectValue:
+      buf.push_back((char)BsTag_Object);
+      rps_binstore_put_varint(buf, jv.size());
+      for (auto it = jv.begin(); it != jv.end(); it++)
+        {
+          rps_binstore_put_varint(buf, bw_namemap.at(it.name()));
+          encode_value(buf, *it);
+        }
+      return;
+    }
+  RPS_FATALOUT("Rps_BinaryStoreWriter::encode_value unexpected JSON type#"
+               << (int)jv.type());
+} // end Rps_BinaryStoreWriter::encode_value
+
+void
+Rps_BinaryStoreWriter::write(std::ostream&out)
+{
+  std::string buf;
+  buf.append(bs_magic, sizeof(bs_magic));
+  rps_binstore_put_fixed<uint32_t>(buf, bs_version);
+  rps_binstore_put_fixed<uint32_t>(buf, bs_byteorder);
+  rps_binstore_put_fixed<uint64_t>(buf, bw_spacid.hi());
+  rps_binstore_put_fixed<uint64_t>(buf, bw_spacid.lo());
+  rps_binstore_put_fixed<uint64_t>(buf, bw_jsonvec.size());
+  rps_binstore_put_fixed<uint32_t>(buf, bw_oidvec.size());
+  rps_binstore_put_fixed<uint32_t>(buf, bw_namevec.size());
+  for (const Rps_Id& id : bw_oidvec)
+    {
+      rps_binstore_put_fixed<uint64_t>(buf, id.hi());
+      rps_binstore_put_fixed<uint64_t>(buf, id.lo());
+    }
+  for (const std::string& name : bw_namevec)
+    {
+      rps_binstore_put_varint(buf, name.size());
+      buf.append(name);
+    }
+  out.write(buf.data(), buf.size());
+  std::string recbuf;
+  for (unsigned ix=0; ix<bw_jsonvec.size(); ix++)
+    {
+      buf.clear();
+      recbuf.clear();
+      encode_value(recbuf, bw_jsonvec[ix]);
+      rps_binstore_put_varint(buf, bw_recoidix[ix]);
+      rps_binstore_put_varint(buf, recbuf.size());
+      out.write(buf.data(), buf.size());
+      out.write(recbuf.data(), recbuf.size());
+    }
+  out.write(bs_endmagic, sizeof(bs_endmagic));
+  out.flush();
+  if (!out)
+    throw RPS_RUNTIME_ERROR_OUT("failed to write binary space " << bw_spacid);
+} // end Rps_BinaryStoreWriter::write
+
+
+
+////////////////////////////////////////////////////////////////
+Rps_BinaryStoreReader::Rps_BinaryStoreReader(const char*base, size_t size,
+    const std::string&path)
+  : br_base(base), br_size(size), br_path(path), br_spacid(),
+    br_oidvec(), br_namevec(), br_records()
+{
+  const char*pc = base;
+  const char*end = base + size;
+  auto get_fixed = [&](auto&v)
+  {
+    if (pc + sizeof(v) > end)
+      corrupted(pc, "truncated header");
+    memcpy(&v, pc, sizeof(v));
+    pc += sizeof(v);
+  };
+  if (!base || size < sizeof(Rps_BinaryStoreWriter::bs_magic)
+      || memcmp(base, Rps_BinaryStoreWriter::bs_magic,
+                sizeof(Rps_BinaryStoreWriter::bs_magic)))
+    corrupted(base, "bad magic");
+  pc += sizeof(Rps_BinaryStoreWriter::bs_magic);
+  uint32_t version = 0, byteorder = 0, nboids = 0, nbnames = 0;
+  uint64_t spahi = 0, spalo = 0, nbobjects = 0;
+  get_fixed(version);
+  if (version != Rps_BinaryStoreWriter::bs_version)
+    corrupted(pc, "unsupported version");
+  get_fixed(byteorder);
+  if (byteorder != Rps_BinaryStoreWriter::bs_byteorder)
+    corrupted(pc, "wrong byte order");
+  get_fixed(spahi);
+  get_fixed(spalo);
+  br_spacid = Rps_Id(spahi, spalo);
+  if (!br_spacid.valid())
+    corrupted(pc, "invalid space id");
+  get_fixed(nbobjects);
+  get_fixed(nboids);
+  get_fixed(nbnames);
+  if ((size_t)nboids * 2*sizeof(uint64_t) > (size_t)(end - pc))
+    corrupted(pc, "truncated oid table");
+  br_oidvec.reserve(nboids);
+  for (uint32_t ix=0; ix<nboids; ix++)
+    {
+      uint64_t hi = 0, lo = 0;
+      get_fixed(hi);
+      get_fixed(lo);
+      Rps_Id id(hi, lo);
+      if (!id.valid())
+        corrupted(pc, "invalid interned oid");
+      br_oidvec.push_back(id);
+    }
+  br_namevec.reserve(nbnames);
+  for (uint32_t ix=0; ix<nbnames; ix++)
+    {
+      uint64_t len = read_varint(pc, end);
+      if (len > (uint64_t)(end - pc))
+        corrupted(pc, "truncated name table");
+      br_namevec.emplace_back(pc, len);
+      pc += len;
+    }
+  if (nbobjects > (uint64_t)(end - pc))
+    corrupted(pc, "too many objects");
+  br_records.reserve(nbobjects);
+  for (uint64_t ix=0; ix<nbobjects; ix++)
+    {
+      uint64_t oidix = read_varint(pc, end);
+      if (oidix >= br_oidvec.size())
+        corrupted(pc, "bad record oid");
+      uint64_t len = read_varint(pc, end);
+      if (len > (uint64_t)(end - pc))
+        corrupted(pc, "truncated record");
+      br_records.push_back(bs_record_st{br_oidvec[oidix], (size_t)(pc - base), (size_t)len});
+      pc += len;
+    }
+  if (end - pc != sizeof(Rps_BinaryStoreWriter::bs_endmagic)
+      || memcmp(pc, Rps_BinaryStoreWriter::bs_endmagic,
+                sizeof(Rps_BinaryStoreWriter::bs_endmagic)))
+    corrupted(pc, "bad end");
+} // end Rps_BinaryStoreReader::Rps_BinaryStoreReader
+
+void
+Rps_BinaryStoreReader::corrupted(const char*pc, const char*why) const
+{
+  throw RPS_RUNTIME_ERROR_OUT("corrupted binary space file " << br_path
+                              << " at offset " << (pc?(long)(pc - br_base):-1L)
+                              << ": " << why);
+} // end Rps_BinaryStoreReader::corrupted
+
+uint64_t
+Rps_BinaryStoreReader::read_varint(const char*&pc, const char*end) const
+{
+  uint64_t v = 0;
+  for (unsigned shift=0; shift<64; shift+=7)
+    {
+      if (pc >= end)
+        corrupted(pc, "truncated varint");
+      uint8_t b = (uint8_t) *pc++;
+      v |= (uint64_t)(b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return v;
+    }
+  corrupted(pc, "too long varint");
+} // end Rps_BinaryStoreReader::read_varint
+
+Json::Value
+Rps_BinaryStoreReader::decode_value(const char*&pc, const char*end, unsigned depth) const
+{
+  if (depth > 1024)
+    corrupted(pc, "too deep value");
+  if (pc >= end)
+    corrupted(pc, "truncated value");
+  uint8_t tag = (uint8_t) *pc++;
+  switch (tag)
+    {
+    case Rps_BinaryStoreWriter::BsTag_Null:
+      return Json::Value(Json::nullValue);
+    case Rps_BinaryStoreWriter::BsTag_False:
+      return Json::Value(false);
+    case Rps_BinaryStoreWriter::BsTag_True:
+      return Json::Value(true);
+    case Rps_BinaryStoreWriter::BsTag_Int:
+    {
+      uint64_t z = read_varint(pc, end);
+      return Json::Value((Json::Int64)((z >> 1) ^ -(z & 1)));
+    }
+    case Rps_BinaryStoreWriter::BsTag_UInt:
+      return Json::Value((Json::UInt64)read_varint(pc, end));
+    case Rps_BinaryStoreWriter::BsTag_Double:
+    {
+      double d = 0.0;
+      if (pc + sizeof(d) > end)
+        corrupted(pc, "truncated double");
+      memcpy(&d, pc, sizeof(d));
+      pc += sizeof(d);
+      return Json::Value(d);
+    }
+    case Rps_BinaryStoreWriter::BsTag_String:
+    {
+      uint64_t len = read_varint(pc, end);
+      if (len > (uint64_t)(end - pc))
+        corrupted(pc, "truncated string");
+      Json::Value js(pc, pc+len);
+      pc += len;
+      return js;
+    }
+    case Rps_BinaryStoreWriter::BsTag_Oid:
+    {
+      uint64_t oidix = read_varint(pc, end);
+      if (oidix >= br_oidvec.size())
+        corrupted(pc, "bad oid index");
+      return Json::Value(br_oidvec[oidix].to_string());
+    }
+    case Rps_BinaryStoreWriter::BsTag_Array:
+    {
+      uint64_t nb = read_varint(pc, end);
+      if (nb > (uint64_t)(end - pc))
+        corrupted(pc, "too big array");
+      Json::Value ja(Json::arrayValue);
+      ja.resize((Json::ArrayIndex)nb);
+      for (uint64_t ix=0; ix<nb; ix++)
+        ja[(Json::ArrayIndex)ix] = decode_value(pc, end, depth+1);
+      return ja;
+    }
+    case Rps_BinaryStoreWriter::BsTag_Object:
+    {
+      uint64_t nb = read_varint(pc, end);
+      if (nb > (uint64_t)(end - pc))
+        corrupted(pc, "too big object");
+      Json::Value jo(Json::objectValue);
+      for (uint64_t ix=0; ix<nb; ix++)
+        {
+          uint64_t namix = read_varint(pc, end);
+          if (namix >= br_namevec.size())
+            corrupted(pc, "bad name index");
+          jo[br_namevec[namix]] = decode_value(pc, end, depth+1);
+        }
+      return jo;
+    }
+    default:
+      corrupted(pc-1, "bad tag");
+    }
+} // end Rps_BinaryStoreReader::decode_value
+
+Json::Value
+Rps_BinaryStoreReader::decode_record(const bs_record_st&rec) const
+{
+  RPS_ASSERT(rec.br_start + rec.br_size <= br_size);
+  const char*pc = br_base + rec.br_start;
+  const char*end = pc + rec.br_size;
+  Json::Value jobject = decode_value(pc, end, 0);
+  if (!jobject.isObject() || pc != end)
+    corrupted(pc, "bad record");
+  jobject["oid"] = Json::Value(rec.br_oid.to_string());
+  return jobject;
+} // end Rps_BinaryStoreReader::decode_record
+
+void
+Rps_BinaryStoreReader::skip_value(const char*&pc, const char*end, unsigned depth) const
+{
+  if (depth > 1024)
+    corrupted(pc, "too deep value");
+  if (pc >= end)
+    corrupted(pc, "truncated value");
+  uint8_t tag = (uint8_t) *pc++;
+  switch (tag)
+    {
+    case Rps_BinaryStoreWriter::BsTag_Null:
+    case Rps_BinaryStoreWriter::BsTag_False:
+    case Rps_BinaryStoreWriter::BsTag_True:
+      return;
+    case Rps_BinaryStoreWriter::BsTag_Int:
+    case Rps_BinaryStoreWriter::BsTag_UInt:
+    case Rps_BinaryStoreWriter::BsTag_Oid:
+      (void) read_varint(pc, end);
+      return;
+    case Rps_BinaryStoreWriter::BsTag_Double:
+      if (pc + sizeof(double) > end)
+        corrupted(pc, "truncated double");
+      pc += sizeof(double);
+      return;
+    case Rps_BinaryStoreWriter::BsTag_String:
+    {
+      uint64_t len = read_varint(pc, end);
+      if (len > (uint64_t)(end - pc))
+        corrupted(pc, "truncated string");
+      pc += len;
+    }
+    return;
+    case Rps_BinaryStoreWriter::BsTag_Array:
+    {
+      uint64_t nb = read_varint(pc, end);
+      for (uint64_t ix=0; ix<nb; ix++)
+        skip_value(pc, end, depth+1);
+    }
+    return;
+    case Rps_BinaryStoreWriter::BsTag_Object:
+    {
+      uint64_t nb = read_varint(pc, end);
+      for (uint64_t ix=0; ix<nb; ix++)
+        {
+          (void) read_varint(pc, end);
+          skip_value(pc, end, depth+1);
+        }
+    }
+    return;
+    default:
+      corrupted(pc-1, "bad tag");
+    }
+} // end Rps_BinaryStoreReader::skip_value
+
+bool
+Rps_BinaryStoreReader::record_has_member(const bs_record_st&rec, const std::string&name) const
+{
+  RPS_ASSERT(rec.br_start + rec.br_size <= br_size);
+  const char*pc = br_base + rec.br_start;
+  const char*end = pc + rec.br_size;
+  if (pc >= end || (uint8_t) *pc++ != Rps_BinaryStoreWriter::BsTag_Object)
+    corrupted(pc, "bad record");
+  uint64_t nb = read_varint(pc, end);
+  for (uint64_t ix=0; ix<nb; ix++)
+    {
+      uint64_t namix = read_varint(pc, end);
+      if (namix >= br_namevec.size())
+        corrupted(pc, "bad name index");
+      if (br_namevec[namix] == name)
+        return true;
+      skip_value(pc, end, 1);
+    }
+  return false;
+} // end Rps_BinaryStoreReader::record_has_member
+
+
+
+////////////////////////////////////////////////////////////////
+//// conversion between textual and binary space files
+
+static std::string
+rps_convert_read_file(const std::string&path, const std::string&codec="")
+{
+  std::ifstream inp(path, std::ios::in|std::ios::binary);
+  if (!inp)
+    throw RPS_RUNTIME_ERROR_OUT("failed to read " << path << ":" << strerror(errno));
+  std::ostringstream outs;
+  outs << inp.rdbuf();
+  if (!codec.empty())
+    {
+      std::string content = outs.str();
+      return rps_decompress_buffer(content.data(), content.size(), codec, path);
+    }
+  return outs.str();
+} // end rps_convert_read_file
+
+/// write a file under a temporary name, then rename it, keeping a
+/// backup of the older one
+static void
+rps_convert_write_file(const std::string&path,
+                       const std::function<void(std::ostream&)>&writefun,
+                       const std::string&codec="")
+{
+  std::string tempath = path + "%conv";
+  {
+    std::unique_ptr<std::ostream> pout = rps_compressed_output_stream(tempath, codec);
+    if (!pout || !pout->good())
+      throw RPS_RUNTIME_ERROR_OUT("failed to open " << tempath << ":" << strerror(errno));
+    writefun(*pout);
+    pout->flush();
+    if (!pout->good())
+      throw RPS_RUNTIME_ERROR_OUT("failed to write " << tempath);
+  }
+  if (!access(path.c_str(), F_OK))
+    (void) rename(path.c_str(), (path + "~").c_str());
+  if (rename(tempath.c_str(), path.c_str()))
+    throw RPS_RUNTIME_ERROR_OUT("failed to rename " << tempath << " as " << path
+                                << ":" << strerror(errno));
+} // end rps_convert_write_file
+
+static void
+rps_convert_space_to_binary(const std::string&dirpath, Rps_Id spacid,
+                            const std::string&codec)
+{
+  std::string suffix = rps_codec_suffix(codec);
+  std::string relpath = std::string{"persistore/sp"} + spacid.to_string() + "-rps.json" + suffix;
+  std::string path = dirpath + "/" + relpath;
+  std::istringstream ins(rps_convert_read_file(path, codec));
+  Rps_BinaryStoreWriter writer(spacid);
+  std::string objbuf;
+  bool inobject = false;
+  unsigned lincnt = 0, oblin = 0;
+  auto add_objbuf = [&](void)
+  {
+    if (!inobject)
+      return;
+    writer.add_object(rps_load_string_to_json(objbuf, path.c_str(), oblin));
+    objbuf.clear();
+  };
+  for (std::string linbuf; std::getline(ins, linbuf); )
+    {
+      lincnt++;
+      if (linbuf.size() > 0 && linbuf[0] == '#')
+        continue;
+      if (linbuf.compare(0, 6, "//+ob_") == 0)
+        {
+          add_objbuf();
+          inobject = true;
+          oblin = lincnt;
+        }
+      if (inobject)
+        {
+          objbuf += linbuf;
+          objbuf += '\n';
+        }
+    }
+  add_objbuf();
+  rps_convert_write_file(dirpath + "/persistore/sp" + spacid.to_string() + "-rps.bin" + suffix,
+                         [&](std::ostream&out)
+  {
+    writer.write(out);
+  }, codec);
+} // end rps_convert_space_to_binary
+
+static void
+rps_convert_space_to_json(const std::string&dirpath, Rps_Id spacid,
+                          const std::string&codec)
+{
+  std::string suffix = rps_codec_suffix(codec);
+  std::string relpath = std::string{"persistore/sp"} + spacid.to_string() + "-rps.json" + suffix;
+  std::string binpath = dirpath + "/persistore/sp" + spacid.to_string() + "-rps.bin" + suffix;
+  std::string content = rps_convert_read_file(binpath, codec);
+  Rps_BinaryStoreReader reader(content.data(), content.size(), binpath);
+  if (reader.space_id() != spacid)
+    throw RPS_RUNTIME_ERROR_OUT("binary space file " << binpath
+                                << " has unexpected space id " << reader.space_id());
+  Json::StreamWriterBuilder builder;
+  builder["commentStyle"] = "None";
+  builder["indentation"] = " ";
+  std::unique_ptr<Json::StreamWriter> jsonwriter(builder.newStreamWriter());
+  rps_convert_write_file(dirpath + "/" + relpath, [&](std::ostream&out)
+  {
+    rps_emit_gplv3_copyright_notice(out, relpath, "//// ", "");
+    out << std::endl << std::endl
+        << "///!!! prologue of RefPerSys space file:" << std::endl;
+    Json::Value jprologue(Json::objectValue);
+    jprologue["format"] = Json::Value (RPS_MANIFEST_FORMAT);
+    jprologue["spaceid"] = Json::Value (spacid.to_string());
+    jprologue["jsoncpp-version"] =  JSONCPP_VERSION_STRING;
+    jprologue["nbobjects"] = Json::Value ((int)reader.records().size());
+    jsonwriter->write(jprologue, &out);
+    out << std::endl;
+    for (const auto& rec : reader.records())
+      {
+        std::string oidstr = rec.br_oid.to_string();
+        out << std::endl << std::endl << "//+ob" << oidstr << std::endl;
+        jsonwriter->write(reader.decode_record(rec), &out);
+        out << std::endl << "//-ob" << oidstr << std::endl << std::endl;
+      }
+    out << std::endl << std::endl
+        << "//// end of RefPerSys converted space file " << relpath << std::endl;
+  }, codec);
+} // end rps_convert_space_to_json
+
+void
+rps_convert_store(const std::string&dirpath, bool tobinary)
+{
+  double startime = rps_monotonic_real_time();
+  std::string manifpath = dirpath + "/" RPS_MANIFEST_JSON;
+  Json::Value manifjson
+    = rps_load_string_to_json(rps_convert_read_file(manifpath), manifpath.c_str());
+  std::string oldformat = manifjson["format"].asString();
+  bool wasbinary = (oldformat == RPS_BINARY_FORMAT);
+  if (!wasbinary && oldformat != RPS_MANIFEST_FORMAT)
+    RPS_FATALOUT("cannot convert store in " << dirpath << " of format " << oldformat);
+  if (wasbinary == tobinary)
+    {
+      RPS_INFORMOUT("store in " << dirpath << " already has format " << oldformat);
+      return;
+    }
+  /// compressed space files stay compressed with the same codec
+  std::string codec = manifjson["codec"].asString();
+  const Json::Value& jspaceset = manifjson["spaceset"];
+  int nbspaces = 0;
+  for (const Json::Value& jspace : jspaceset)
+    {
+      Rps_Id spacid;
+      if (!Rps_BinaryStoreWriter::string_is_oid(jspace.asString(), &spacid))
+        RPS_FATALOUT("bad space " << jspace << " in " << manifpath);
+      if (tobinary)
+        rps_convert_space_to_binary(dirpath, spacid, codec);
+      else
+        rps_convert_space_to_json(dirpath, spacid, codec);
+      nbspaces++;
+    }
+  manifjson["format"] = Json::Value(tobinary?RPS_BINARY_FORMAT:RPS_MANIFEST_FORMAT);
+  Json::StreamWriterBuilder builder;
+  builder["commentStyle"] = "None";
+  builder["indentation"] = " ";
+  std::unique_ptr<Json::StreamWriter> jsonwriter(builder.newStreamWriter());
+  rps_convert_write_file(manifpath, [&](std::ostream&out)
+  {
+    rps_emit_gplv3_copyright_notice(out, RPS_MANIFEST_JSON, "//!! ", "");
+    jsonwriter->write(manifjson, &out);
+    out << std::endl <<  std::endl << "//// end of RefPerSys manifest file" << std::endl;
+  });
+  RPS_INFORMOUT("converted " << nbspaces << " spaces in " << dirpath
+                << " to " << (tobinary?"binary":"JSON") << " format in "
+                << (rps_monotonic_real_time() - startime) << " seconds");
+} // end rps_convert_store
+
+//////////////////////////////////////////////////////////// end of file binstore_rps.cc
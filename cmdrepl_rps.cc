@@ -186,7 +186,7 @@ rps_full_evaluate_repl_expr(Rps_CallFrame*callframe, Rps_Value exprarg, Rps_Obje
   else if (_f.exprv.is_object())
     {
       _f.evalob = _f.exprv.as_object();
-      std::lock_guard<std::recursive_mutex> gu(*_f.evalob->objmtxptr());
+      std::lock_guard<Rps_ObjectMutex> gu(*_f.evalob->objmtxptr());
       _f.classob = _f.exprv.compute_class(&_);
       RPS_DEBUG_LOG(REPL, "rps_full_evaluate_repl_expr#" << eval_number
                     << " object expr:" << _f.exprv
@@ -425,7 +425,7 @@ Rps_PayloadEnvironment::make_with_parent_environment(Rps_CallFrame*callframe, Rp
   _f.obenv = Rps_ObjectRef::make_object(&_, _f.obclass, _f.obspace);
   auto paylenv = _f.obenv->put_new_plain_payload<Rps_PayloadEnvironment>();
   RPS_ASSERT(paylenv);
-  paylenv->env_parent = parentob;
+  paylenv->put_parent_environment(_f.obparent);
   return _f.obenv;
 } // end Rps_PayloadEnvironment::make_with_parent_environment
 
@@ -707,6 +707,15 @@ rps_environment_overwrite_binding(Rps_CallFrame*callframe,
 } // end rps_environment_overwrite_binding
 
 
+void
+Rps_PayloadEnvironment::put_parent_environment(Rps_ObjectRef envob)
+{
+  RPS_ASSERT(!envob || envob->is_instance_of(RPS_ROOT_OB(_5LMLyzRp6kq04AMM8a))); //environment∈class
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
+  env_parent = envob;
+  gc_write_barrier(envob);
+} // end Rps_PayloadEnvironment::put_parent_environment
+
 void
 Rps_PayloadEnvironment::gc_mark(Rps_GarbageCollector&gc) const
 {
@@ -988,7 +997,7 @@ void rps_show_object_for_repl(Rps_CallFrame*callerframe,
       return;
     }
   /// we lock the shown object to avoid other threads modifying it during the show.
-  std::lock_guard<std::recursive_mutex> gushownob(*_f.shownob->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gushownob(*_f.shownob->objmtxptr());
   (*pout) << "¤¤ showing object " << _f.shownob << " of class "
           << _f.shownob->get_class()
           << " in space " << _f.shownob->get_space() << std::endl;
@@ -0,0 +1,245 @@
+/****************************************************************
+ * file compress_rps.cc
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Description:
+ *      This file is part of the Reflective Persistent System.
+ *
+ *      It has the optional streaming compression of space files,
+ *      using the zstd library.
+ *
+ * Author(s):
+ *      Basile Starynkevitch <basile@starynkevitch.net>
+ *      Abhishek Chakravarti <abhishek@taranjali.org>
+ *      Nimesh Neema <nimeshneema@gmail.com>
+ *
+ *      © Copyright 2019 - 2024 The Reflective Persistent System Team
+ *      team@refpersys.org & http://refpersys.org/
+ *
+ * License:
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "refpersys.hh"
+
+#include <zstd.h>
+
+extern "C" const char rps_compress_gitid[];
+const char rps_compress_gitid[]= RPS_GITID;
+
+extern "C" const char rps_compress_date[];
+const char rps_compress_date[]= __DATE__;
+
+// comment for our do-scan-pkgconfig.c utility
+//@@PKGCONFIG libzstd
+
+/// The codec of the dumped space files, recorded in the manifest. It
+/// is empty for plain files.
+std::string rps_dump_codec;
+
+/// a fast level; space files are mostly repetitive JSON
+#define RPS_ZSTD_LEVEL 3
+
+std::string
+rps_codec_suffix(const std::string&codec)
+{
+  if (codec.empty())
+    return "";
+  if (codec == "zstd")
+    return ".zst";
+  throw RPS_RUNTIME_ERROR_OUT("unknown space file codec " << codec);
+} // end rps_codec_suffix
+
+
+/// A stream buffer compressing into a file: the put area is the zstd
+/// input block, compressed when full, and the zstd frame is ended
+/// and written by finish.
+class Rps_ZstdOutBuf : public std::streambuf
+{
+  std::ofstream zo_out;
+  ZSTD_CStream* zo_cstream;
+  std::vector<char> zo_inbuf;
+  std::vector<char> zo_outbuf;
+  bool zo_finished;
+  bool compress_pending(ZSTD_EndDirective mode);
+protected:
+  virtual int_type overflow(int_type ch);
+  virtual int sync(void);
+public:
+  Rps_ZstdOutBuf(const std::string&path, int level);
+  ~Rps_ZstdOutBuf();
+  bool is_open(void) const
+  {
+    return zo_cstream != nullptr && zo_out.is_open();
+  };
+  bool finish(void);
+};                              // end class Rps_ZstdOutBuf
+
+Rps_ZstdOutBuf::Rps_ZstdOutBuf(const std::string&path, int level)
+  : zo_out(path, std::ios::out|std::ios::binary|std::ios::trunc),
+    zo_cstream(ZSTD_createCStream()),
+    zo_inbuf(ZSTD_CStreamInSize()),
+    zo_outbuf(ZSTD_CStreamOutSize()),
+    zo_finished(false)
+{
+  if (zo_cstream)
+    (void) ZSTD_CCtx_setParameter(zo_cstream, ZSTD_c_compressionLevel, level);
+  setp(zo_inbuf.data(), zo_inbuf.data() + zo_inbuf.size());
+} // end Rps_ZstdOutBuf::Rps_ZstdOutBuf
+
+Rps_ZstdOutBuf::~Rps_ZstdOutBuf()
+{
+  if (!zo_finished)
+    (void) finish();
+  if (zo_cstream)
+    ZSTD_freeCStream(zo_cstream);
+  zo_cstream = nullptr;
+} // end Rps_ZstdOutBuf::~Rps_ZstdOutBuf
+
+bool
+Rps_ZstdOutBuf::compress_pending(ZSTD_EndDirective mode)
+{
+  if (!zo_cstream)
+    return false;
+  ZSTD_inBuffer inb = { pbase(), (size_t)(pptr() - pbase()), 0 };
+  for (;;)
+    {
+      ZSTD_outBuffer outb = { zo_outbuf.data(), zo_outbuf.size(), 0 };
+      size_t remaining = ZSTD_compressStream2(zo_cstream, &outb, &inb, mode);
+      if (ZSTD_isError(remaining))
+        {
+          RPS_WARNOUT("zstd compression failed: " << ZSTD_getErrorName(remaining));
+          return false;
+        }
+      zo_out.write(zo_outbuf.data(), outb.pos);
+      // when continuing, the input just has to be consumed; flushing
+      // and ending want every compressed byte written
+      if (mode == ZSTD_e_continue ? (inb.pos == inb.size) : (remaining == 0))
+        break;
+    }
+  setp(zo_inbuf.data(), zo_inbuf.data() + zo_inbuf.size());
+  return zo_out.good();
+} // end Rps_ZstdOutBuf::compress_pending
+
+Rps_ZstdOutBuf::int_type
+Rps_ZstdOutBuf::overflow(int_type ch)
+{
+  if (zo_finished || !compress_pending(ZSTD_e_continue))
+    return traits_type::eof();
+  if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+  return traits_type::not_eof(ch);
+} // end Rps_ZstdOutBuf::overflow
+
+int
+Rps_ZstdOutBuf::sync(void)
+{
+  // the dumper writes std::endl after most lines; a zstd flush there
+  // would close a tiny block each time, so data stays buffered until
+  // the put area is full or the frame ends
+  return (zo_finished || !zo_out.good())?-1:0;
+} // end Rps_ZstdOutBuf::sync
+
+bool
+Rps_ZstdOutBuf::finish(void)
+{
+  if (zo_finished)
+    return false;
+  bool ok = compress_pending(ZSTD_e_end);
+  zo_finished = true;
+  setp(nullptr, nullptr);
+  zo_out.close();
+  return ok && !zo_out.fail();
+} // end Rps_ZstdOutBuf::finish
+
+
+/// the output stream returned by rps_compressed_output_stream; its
+/// destructor ends the zstd frame and closes the file.
+class Rps_ZstdOstream : public std::ostream
+{
+  Rps_ZstdOutBuf zs_buf;
+public:
+  Rps_ZstdOstream(const std::string&path, int level)
+    : std::ostream(nullptr), zs_buf(path, level)
+  {
+    rdbuf(&zs_buf);
+    if (!zs_buf.is_open())
+      setstate(std::ios::failbit);
+  };
+  ~Rps_ZstdOstream()
+  {
+    if (!zs_buf.finish())
+      RPS_WARNOUT("failed to end zstd compressed output");
+  };
+};                              // end class Rps_ZstdOstream
+
+std::unique_ptr<std::ostream>
+rps_compressed_output_stream(const std::string&path, const std::string&codec)
+{
+  if (codec.empty())
+    return std::make_unique<std::ofstream>(path);
+  if (codec == "zstd")
+    return std::make_unique<Rps_ZstdOstream>(path, RPS_ZSTD_LEVEL);
+  throw RPS_RUNTIME_ERROR_OUT("unknown codec " << codec << " to write " << path);
+} // end rps_compressed_output_stream
+
+std::string
+rps_decompress_buffer(const char*buf, size_t len,
+                      const std::string&codec, const std::string&path)
+{
+  if (codec.empty())
+    return std::string(buf, len);
+  if (codec != "zstd")
+    throw RPS_RUNTIME_ERROR_OUT("unknown codec " << codec << " to read " << path);
+  std::string res;
+  unsigned long long contsize = ZSTD_getFrameContentSize(buf, len);
+  if (contsize != ZSTD_CONTENTSIZE_UNKNOWN && contsize != ZSTD_CONTENTSIZE_ERROR
+      && contsize < (1ULL << 34))
+    res.reserve(contsize);
+  else
+    res.reserve(4*len);
+  ZSTD_DStream* dstream = ZSTD_createDStream();
+  if (!dstream)
+    throw RPS_RUNTIME_ERROR_OUT("failed to create zstd stream to read " << path);
+  (void) ZSTD_initDStream(dstream);
+  std::vector<char> outbuf(ZSTD_DStreamOutSize());
+  ZSTD_inBuffer inb = { buf, len, 0 };
+  size_t lastret = 0;
+  for (;;)
+    {
+      ZSTD_outBuffer outb = { outbuf.data(), outbuf.size(), 0 };
+      lastret = ZSTD_decompressStream(dstream, &outb, &inb);
+      if (ZSTD_isError(lastret))
+        {
+          const char* errmsg = ZSTD_getErrorName(lastret);
+          ZSTD_freeDStream(dstream);
+          throw RPS_RUNTIME_ERROR_OUT("zstd decompression of " << path
+                                      << " failed at offset " << inb.pos << ":" << errmsg);
+        }
+      res.append(outbuf.data(), outb.pos);
+      // a partly filled output means the decoder has nothing more to
+      // give for the input already consumed
+      if (inb.pos == inb.size && outb.pos < outb.size)
+        break;
+    }
+  ZSTD_freeDStream(dstream);
+  if (lastret != 0)
+    throw RPS_RUNTIME_ERROR_OUT("truncated zstd compressed file " << path);
+  return res;
+} // end rps_decompress_buffer
+
+//////////////////////////////////////////////////////////// end of file compress_rps.cc
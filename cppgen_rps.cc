@@ -64,7 +64,7 @@ rps_generate_cplusplus_code(Rps_CallFrame*callerframe,
   RPS_ASSERT(callerframe && callerframe->is_good_call_frame());
   RPS_ASSERT(obmodule);
   _f.obmodule = obmodule;
-  std::lock_guard<std::recursive_mutex> gumodule(*obmodule->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gumodule(*obmodule->objmtxptr());
   _f.obgenerator =
     Rps_ObjectRef::make_object(&_,
                                RPS_ROOT_OB(_2yzD3HZ6VQc038ekBU)//midend_cplusplus_code_generator∈class
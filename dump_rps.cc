@@ -59,6 +59,67 @@ rps_dump_json_to_string(const Json::Value&jv)
 } // end rps_dump_json_to_string
 
 
+//////////////////////////////////////////////// incremental dumps
+
+bool rps_dump_incremental;
+
+/// What is known about the space files of a directory after its last
+/// dump or load. A space file is still valid if it holds the same set
+/// of objects and none of them has been modified since.
+struct rps_dumpstate_st
+{
+  double ds_basetime;           // wallclock start of last dump or load
+  bool ds_binary;
+  std::string ds_codec;
+  std::map<Rps_Id, std::pair<size_t,uint64_t>> ds_spaces; // count & digest
+};
+static std::mutex rps_dumpstate_mtx;
+static std::map<std::string,rps_dumpstate_st> rps_dumpstate_map;
+
+uint64_t
+rps_dump_space_digest_add(uint64_t digest, Rps_Id oid)
+{
+  // a splitmix64 finalizer, summed so the order does not matter
+  uint64_t h = oid.hi() ^ (oid.lo() * 0x9e3779b97f4a7c15ULL);
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return digest + h;
+} // end rps_dump_space_digest_add
+
+void
+rps_dump_note_loaded_space(const std::string&dirpath, Rps_Id spacid,
+                           size_t nbobjects, uint64_t digest,
+                           double loadtime, bool binary,
+                           const std::string&codec)
+{
+  char* rp = realpath(dirpath.c_str(), nullptr);
+  if (!rp)
+    return;
+  std::string realdirpath(rp);
+  free (rp);
+  Rps_NoSafepointLock<std::mutex> gu(rps_dumpstate_mtx);
+  rps_dumpstate_st& ds = rps_dumpstate_map[realdirpath];
+  ds.ds_basetime = loadtime;
+  ds.ds_binary = binary;
+  ds.ds_codec = codec;
+  ds.ds_spaces[spacid] = {nbobjects, digest};
+} // end rps_dump_note_loaded_space
+
+void
+rps_dump_forget_loaded_space(const std::string&dirpath, Rps_Id spacid)
+{
+  char* rp = realpath(dirpath.c_str(), nullptr);
+  if (!rp)
+    return;
+  std::string realdirpath(rp);
+  free (rp);
+  Rps_NoSafepointLock<std::mutex> gu(rps_dumpstate_mtx);
+  auto itds = rps_dumpstate_map.find(realdirpath);
+  if (itds != rps_dumpstate_map.end())
+    itds->second.ds_spaces.erase(spacid);
+} // end rps_dump_forget_loaded_space
+
 //////////////////////////////////////////////// dumper
 class Rps_Dumper
 {
@@ -68,6 +129,9 @@ class Rps_Dumper
   friend double rps_dump_start_wallclock_time(Rps_Dumper*);
   friend double rps_dump_start_monotonic_time(Rps_Dumper*);
   friend void rps_dump_into (const std::string dirpath, Rps_CallFrame*);
+  friend void rps_start_background_dump(const std::string&dirpath);
+  friend void rps_finish_background_dump(void);
+  friend void rps_dump_gc_mark(Rps_GarbageCollector&gc);
   friend void rps_dump_scan_code_addr(Rps_Dumper*, const void*);
   friend void rps_dump_scan_object(Rps_Dumper*, Rps_ObjectRef obr);
   friend void rps_dump_scan_space_component(Rps_Dumper*, Rps_ObjectRef obrspace, Rps_ObjectRef obrcomp);
@@ -80,6 +144,21 @@ class Rps_Dumper
   std::recursive_mutex du_mtx;
   std::unordered_map<Rps_Id, Rps_ObjectRef,Rps_Id::Hasher> du_mapobjects;
   std::deque<Rps_ObjectRef> du_scanque;
+  /// the scan loop runs on rps_nbjobs threads, each with its own
+  /// deque; idle threads steal from the front of the others.
+  struct du_scanworker_st
+  {
+    std::mutex sw_mtx;
+    std::deque<Rps_ObjectRef> sw_deque;
+  };
+  std::vector<std::unique_ptr<du_scanworker_st>> du_scanworkers;
+  std::atomic<long> du_scanpending; // queued or being scanned
+  std::atomic<bool> du_scanfailed;
+  std::exception_ptr du_failure;
+  /// while space files are written, du_mapobjects is read only, so
+  /// is not locked
+  std::atomic<bool> du_writing;
+  static thread_local int du_thrworkix; // index in du_scanworkers, or -1
   std::string du_tempsuffix;
   long du_newobcount;   // counter for new dumped objects
   double du_startelapsedtime;
@@ -92,6 +171,13 @@ class Rps_Dumper
     Rps_Id sp_id;
     std::set<Rps_ObjectRef> sp_setob;
     du_space_st(Rps_Id id) : sp_id(id), sp_setob() {};
+    uint64_t digest(void) const
+    {
+      uint64_t dg = 0;
+      for (Rps_ObjectRef obr: sp_setob)
+        dg = rps_dump_space_digest_add(dg, obr->oid());
+      return dg;
+    };
   };
   std::map<Rps_ObjectRef,std::shared_ptr<du_space_st>> du_spacemap; // map from spaces to objects inside
   std::set<Rps_ObjectRef> du_pluginobset;
@@ -117,10 +203,14 @@ private:
   };
   void scan_roots(void);
   Rps_ObjectRef pop_object_to_scan(void);
+  void push_object_to_scan(Rps_ObjectRef obr);
+  void note_failure(std::exception_ptr exp);
   void scan_loop_pass(void);
   void scan_cplusplus_source_file_for_constants(const std::string&relfilename);
   void scan_every_cplusplus_source_file_for_constants(void);
   void write_all_space_files(void);
+  bool space_file_is_clean(const du_space_st&spa, const rps_dumpstate_st*ds) const;
+  void record_dump_state(void);
   void write_all_generated_files(void);
   void write_generated_roots_file(void);
   void write_generated_names_file(void);
@@ -131,7 +221,9 @@ private:
   void write_manifest_file(void);
   void write_space_file(Rps_ObjectRef spacobr);
   void scan_object_contents(Rps_ObjectRef obr);
+  std::string reserve_output_path(const std::string& relpath);
   std::unique_ptr<std::ofstream> open_output_file(const std::string& relpath);
+  std::unique_ptr<std::ostream> open_compressed_output_file(const std::string& relpath);
   void rename_opened_files(void);
   void scan_code_addr(const void*);
 public:
@@ -160,7 +252,7 @@ public:
   {
     RPS_ASSERT(obrspace);
     RPS_ASSERT(obrcomp);
-    std::lock_guard<std::recursive_mutex> gu(du_mtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
     auto itspace = du_spacemap.find(obrspace);
     if (itspace == du_spacemap.end())
       {
@@ -174,6 +266,7 @@ public:
 
 Rps_Dumper::Rps_Dumper(const std::string&topdir, Rps_CallFrame*callframe) :
   du_topdir(topdir), du_curworkdir(), du_jsonwriterbuilder(), du_mtx(), du_mapobjects(), du_scanque(),
+  du_scanworkers(), du_scanpending(0), du_scanfailed(false), du_failure(), du_writing(false),
   du_tempsuffix(make_temporary_suffix()),
   du_newobcount(0),
   du_startelapsedtime(rps_elapsed_real_time()),
@@ -195,16 +288,19 @@ Rps_Dumper::Rps_Dumper(const std::string&topdir, Rps_CallFrame*callframe) :
                 << " this@" << (void*)this
                 << std::endl
                 << RPS_FULL_BACKTRACE_HERE(1, "Rps_Dumper constr"));
-  RPS_ASSERT(rps_is_main_thread());
+  // the dumper of the journal serializes objects on its own thread
+  RPS_ASSERT(rps_is_main_thread() || !callframe);
 } // end Rps_Dumper::Rps_Dumper
 
+thread_local int Rps_Dumper::du_thrworkix = -1;
+
 Rps_Dumper::~Rps_Dumper()
 {
   RPS_DEBUG_LOG(DUMP, "Rps_Dumper destr topdir=" << du_topdir
                 << " this@" << (void*)this
                 << std::endl
                 << RPS_FULL_BACKTRACE_HERE(1, "Rps_Dumper destr"));
-  RPS_ASSERT(rps_is_main_thread());
+  RPS_ASSERT(rps_is_main_thread() || !du_callframe);
   du_callframe = nullptr;
 } // end Rps_Dumper::~Rps_Dumper
 
@@ -246,20 +342,28 @@ Rps_Dumper::scan_object(const Rps_ObjectRef obr)
 {
   if (!obr)
     return;
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
-  if (du_mapobjects.find(obr->oid()) != du_mapobjects.end())
-    return;
-  if (!obr->get_space()) // transient
-    return;
-  du_mapobjects.insert({obr->oid(), obr});
-  if (obr->get_mtime() > rps_get_start_wallclock_real_time())
+  if (RPS_UNLIKELY(du_writing.load()))
     {
-      du_newobcount++;
-      RPS_DEBUG_LOG(DUMP, "new object #" << du_newobcount << ": " << obr
-                    << " with mtime " << obr->get_mtime()
-                    << " and start wallclock " <<  rps_get_start_wallclock_real_time());
+      // too late, the set of dumped objects is frozen
+      RPS_DEBUG_LOG(DUMP, "dumper ignoring scan_object " << obr << " while writing");
+      return;
     }
-  du_scanque.push_back(obr);
+  {
+    Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
+    if (du_mapobjects.find(obr->oid()) != du_mapobjects.end())
+      return;
+    if (!obr->get_space()) // transient
+      return;
+    du_mapobjects.insert({obr->oid(), obr});
+    if (obr->get_mtime() > rps_get_start_wallclock_real_time())
+      {
+        du_newobcount++;
+        RPS_DEBUG_LOG(DUMP, "new object #" << du_newobcount << ": " << obr
+                      << " with mtime " << obr->get_mtime()
+                      << " and start wallclock " <<  rps_get_start_wallclock_real_time());
+      }
+  }
+  push_object_to_scan(obr);
   //  RPS_INFORMOUT("Rps_Dumper::scan_object adding oid " << obr->oid());
 } // end Rps_Dumper::scan_object
 
@@ -291,7 +395,9 @@ Rps_Dumper::is_dumpable_objref(const Rps_ObjectRef obr)
 {
   if (!obr)
     return false;
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  std::unique_lock<std::recursive_mutex> gu(du_mtx, std::defer_lock);
+  if (!du_writing.load())
+    gu.lock();
   if (du_mapobjects.find(obr->oid()) != du_mapobjects.end())
     return true;
   auto obrspace = obr->get_space();
@@ -308,7 +414,6 @@ Rps_Dumper::is_dumpable_objattr(const Rps_ObjectRef obr)
     return false;
   if (!is_dumpable_objref(obr))
     return false;
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
 #warning incomplete Rps_Dumper::is_dumpable_objattr
   return true;
 } // end Rps_Dumper::is_dumpable_objattr
@@ -340,27 +445,48 @@ Rps_Dumper::is_dumpable_value(const Rps_Value val)
 #warning Rps_Dumper::is_dumpable_value partly unimplemented
 } // end Rps_Dumper::is_dumpable_value
 
-std::unique_ptr<std::ofstream>
-Rps_Dumper::open_output_file(const std::string& relpath)
+/// register a relative path to be written, returning its temporary path
+std::string
+Rps_Dumper::reserve_output_path(const std::string& relpath)
 {
   RPS_ASSERT(relpath.size()>1 && relpath[0] != '/');
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   if (RPS_UNLIKELY(du_openedpathset.find(relpath) != du_openedpathset.end()))
     {
       RPS_WARNOUT("duplicate opened dump file " << relpath);
       throw std::runtime_error(std::string{"duplicate opened dump file "} + relpath);
     }
-  std::string tempathstr =  temporary_opened_path(relpath);
+  du_openedpathset.insert(relpath);
+  return temporary_opened_path(relpath);
+} // end Rps_Dumper::reserve_output_path
+
+std::unique_ptr<std::ofstream>
+Rps_Dumper::open_output_file(const std::string& relpath)
+{
+  std::string tempathstr =  reserve_output_path(relpath);
   auto poutf= std::make_unique<std::ofstream>(tempathstr);
   if (!poutf || !poutf->is_open())
     {
       RPS_WARNOUT("dump failed to open " << tempathstr);
       throw std::runtime_error(std::string{"duplicate failed to open "} + tempathstr + ":" + strerror(errno));
     }
-  du_openedpathset.insert(relpath);
   return poutf;
 } // end Rps_Dumper::open_output_file
 
+/// space files are compressed on the fly with the rps_dump_codec
+std::unique_ptr<std::ostream>
+Rps_Dumper::open_compressed_output_file(const std::string& relpath)
+{
+  std::string tempathstr =  reserve_output_path(relpath);
+  auto poutf = rps_compressed_output_stream(tempathstr, rps_dump_codec);
+  if (!poutf || !poutf->good())
+    {
+      RPS_WARNOUT("dump failed to open " << tempathstr << " with codec " << rps_dump_codec);
+      throw std::runtime_error(std::string{"dump failed to open "} + tempathstr + ":" + strerror(errno));
+    }
+  return poutf;
+} // end Rps_Dumper::open_compressed_output_file
+
 
 void
 Rps_Dumper::scan_cplusplus_source_file_for_constants(const std::string&relfilename)
@@ -398,7 +524,7 @@ Rps_Dumper::scan_cplusplus_source_file_for_constants(const std::string&relfilena
                 {
                   scan_object(obr);
                   nbconst++;
-                  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+                  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
                   if (du_constantobset.find(obr) != du_constantobset.end())
                     RPS_DEBUG_LOG(DUMP, "scan_cplusplus_source_file_for_constants const#" << nbconst
                                   << " is " << obr);
@@ -432,7 +558,7 @@ Rps_Dumper::scan_code_addr(const void*ad)
    **/
   if (!ad)
     return;
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   static char rpsmodfmt[80];
   static size_t rpsmodfmtlen;
   if (!rpsmodfmt[0])
@@ -485,7 +611,7 @@ Rps_Dumper::scan_code_addr(const void*ad)
 void
 Rps_Dumper::rename_opened_files(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   for (std::string curelpath: du_openedpathset)
     {
       std::string curpath = du_topdir + "/" + curelpath;
@@ -508,6 +634,24 @@ Rps_Dumper::rename_opened_files(void)
 } // end Rps_Dumper::rename_opened_files
 
 
+/// Serialize the current contents of an object for the mutation
+/// journal, like write_space_file does. A dumper without scanned
+/// objects considers every persistent object as dumpable; it is only
+/// used by the committer thread of Rps_Journal.
+Json::Value
+rps_dump_json_for_journal(Rps_ObjectRef obr)
+{
+  RPS_ASSERT(obr);
+  static Rps_Dumper* journaldumper =
+    new Rps_Dumper(std::string(rps_topdirectory), nullptr);
+  std::lock_guard<Rps_ObjectMutex> gu(*(obr->objmtxptr()));
+  Json::Value jobject(Json::objectValue);
+  jobject["oid"] = Json::Value (obr->oid().to_string());
+  jobject["mtime"] = Json::Value (obr->get_mtime());
+  obr->dump_json_content(journaldumper,jobject);
+  return jobject;
+} // end rps_dump_json_for_journal
+
 //////////////// public interface to dumper::::
 bool rps_is_dumpable_objref(Rps_Dumper*du, const Rps_ObjectRef obr)
 {
@@ -771,7 +915,7 @@ Rps_ObjectZone::dump_json(Rps_Dumper*du) const
 void
 Rps_Dumper::scan_roots(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   int nbroots = 0;
   RPS_DEBUG_LOG(DUMP, "dumper: scan_roots begin");
   rps_each_root_object([&](Rps_ObjectRef obr)
@@ -783,33 +927,138 @@ Rps_Dumper::scan_roots(void)
   RPS_DEBUG_LOG(DUMP, "dumper: scan_roots ends nbroots#" << nbroots);
 } // end Rps_Dumper::scan_roots
 
+void
+Rps_Dumper::push_object_to_scan(Rps_ObjectRef obr)
+{
+  RPS_ASSERT(obr);
+  du_scanpending.fetch_add(1);
+  int wix = du_thrworkix;
+  if (wix >= 0 && wix < (int)du_scanworkers.size())
+    {
+      du_scanworker_st& sw = *du_scanworkers[wix];
+      std::lock_guard<std::mutex> gu(sw.sw_mtx);
+      sw.sw_deque.push_back(obr);
+      return;
+    }
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
+  du_scanque.push_back(obr);
+} // end Rps_Dumper::push_object_to_scan
+
+/// a scanning thread pops the most recent object of its own deque,
+/// which is likely to still be in its cache, otherwise takes from the
+/// shared queue of roots, otherwise steals the oldest object of
+/// another thread.
 Rps_ObjectRef
 Rps_Dumper::pop_object_to_scan(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
-  if (du_scanque.empty())
-    return Rps_ObjectRef(nullptr);
-  auto obr = du_scanque.front();
-  du_scanque.pop_front();
-  return obr;
+  int wix = du_thrworkix;
+  int nbworkers = (int) du_scanworkers.size();
+  if (wix >= 0 && wix < nbworkers)
+    {
+      du_scanworker_st& sw = *du_scanworkers[wix];
+      std::lock_guard<std::mutex> gu(sw.sw_mtx);
+      if (!sw.sw_deque.empty())
+        {
+          auto obr = sw.sw_deque.back();
+          sw.sw_deque.pop_back();
+          return obr;
+        }
+    }
+  {
+    Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
+    if (!du_scanque.empty())
+      {
+        auto obr = du_scanque.front();
+        du_scanque.pop_front();
+        return obr;
+      }
+  }
+  for (int off = 1; off < nbworkers; off++)
+    {
+      du_scanworker_st& victim = *du_scanworkers[(wix + off + nbworkers) % nbworkers];
+      std::lock_guard<std::mutex> gu(victim.sw_mtx);
+      if (!victim.sw_deque.empty())
+        {
+          auto obr = victim.sw_deque.front();
+          victim.sw_deque.pop_front();
+          return obr;
+        }
+    }
+  return Rps_ObjectRef(nullptr);
 } // end Rps_Dumper::pop_object_to_scan
 
+/// keep the first exception of some dumping thread, to be rethrown
+/// by the main thread
+void
+Rps_Dumper::note_failure(std::exception_ptr exp)
+{
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
+  if (!du_failure)
+    du_failure = exp;
+  du_scanfailed.store(true);
+} // end Rps_Dumper::note_failure
+
 
 void
 Rps_Dumper::scan_loop_pass(void)
 {
-  Rps_ObjectRef curobr;
-  int count=0;
-  // no locking here, it happens in pop_object_to_scan & scan_object_contents
-  //  RPS_INFORMOUT("scan_loop_pass start");
-  while ((curobr=pop_object_to_scan()))
-    {
-      count++;
-      // RPS_INFORMOUT("scan_loop_pass count#" << count
-      //              << " curobr=" << curobr->oid());
-      scan_object_contents(curobr);
-    };
-  RPS_DEBUG_LOG(DUMP, "dumper: scan_loop_pass end count#" << count);
+  std::atomic<long> count(0);
+  int nbthreads = rps_nbjobs;
+  if (nbthreads < 1)
+    nbthreads = 1;
+  du_scanworkers.clear();
+  for (int thix=0; thix<nbthreads; thix++)
+    du_scanworkers.push_back(std::make_unique<du_scanworker_st>());
+  // no global locking here, each object is locked by
+  // scan_object_contents. An object is pending from its push until
+  // its contents are scanned, so no pending object means that
+  // reachability is complete.
+  auto work = [&](int thix)
+  {
+    du_thrworkix = thix;
+    if (thix > 0)
+      {
+        char thname[16];
+        memset(thname, 0, sizeof(thname));
+        snprintf(thname, sizeof(thname), "rps-dumpscan#%d", thix);
+        pthread_setname_np(pthread_self(), thname);
+      }
+    long nbscanned = 0;
+    while (!du_scanfailed.load())
+      {
+        Rps_ObjectRef curobr = pop_object_to_scan();
+        if (!curobr)
+          {
+            if (du_scanpending.load() == 0)
+              break;
+            sched_yield();
+            continue;
+          }
+        try
+          {
+            scan_object_contents(curobr);
+          }
+        catch (...)
+          {
+            note_failure(std::current_exception());
+          }
+        nbscanned++;
+        du_scanpending.fetch_sub(1);
+      };
+    count.fetch_add(nbscanned);
+    du_thrworkix = -1;
+  };
+  std::vector<std::thread> threads;
+  for (int thix=1; thix<nbthreads; thix++)
+    threads.emplace_back(work, thix);
+  work(0);
+  for (std::thread& th: threads)
+    th.join();
+  du_scanworkers.clear();
+  if (du_failure)
+    std::rethrow_exception(du_failure);
+  RPS_DEBUG_LOG(DUMP, "dumper: scan_loop_pass end count#" << count.load()
+                << " with " << nbthreads << " threads");
 } // end Rps_Dumper::scan_loop_pass
 
 
@@ -817,7 +1066,7 @@ Rps_Dumper::scan_loop_pass(void)
 void
 Rps_Dumper::scan_object_contents(Rps_ObjectRef obr)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  // dump_scan_contents locks obr, and scan_object locks du_mtx briefly
   obr->dump_scan_contents(this);
   Rps_ObjectRef spacobr(obr->get_space());
   rps_dump_scan_object(this,spacobr);
@@ -850,23 +1099,115 @@ Rps_Dumper::write_all_space_files(void)
   RPS_DEBUG_LOG(DUMP, "dumper write_all_space_files start");
   std::set<Rps_ObjectRef> spaceset;
   {
-    std::lock_guard<std::recursive_mutex> gu(du_mtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
     for (auto it: du_spacemap)
       spaceset.insert(it.first);
   }
+  /// each space file is written by its own thread into its
+  /// temporary file; they are renamed later by rename_opened_files
   int nbspace = 0;
+  int nbclean = 0;
+  std::unique_ptr<rps_dumpstate_st> prevstate;
+  if (rps_dump_incremental)
+    {
+      Rps_NoSafepointLock<std::mutex> gu(rps_dumpstate_mtx);
+      auto itds = rps_dumpstate_map.find(du_topdir);
+      if (itds != rps_dumpstate_map.end())
+        prevstate = std::make_unique<rps_dumpstate_st>(itds->second);
+      else
+        RPS_INFORMOUT("no previous dump or load of " << du_topdir
+                      << ", so dumping every space");
+    }
+  du_writing.store(true);
+  std::vector<std::thread> threads;
   for (Rps_ObjectRef spacobr : spaceset)
     {
-      write_space_file(spacobr);
+      if (prevstate)
+        {
+          Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
+          if (space_file_is_clean(*du_spacemap[spacobr], prevstate.get()))
+            {
+              nbclean++;
+              continue;
+            }
+        }
       nbspace++;
+      threads.emplace_back([this,spacobr,nbspace]()
+      {
+        char thname[16];
+        memset(thname, 0, sizeof(thname));
+        snprintf(thname, sizeof(thname), "rps-dumpsp#%d", nbspace);
+        pthread_setname_np(pthread_self(), thname);
+        try
+          {
+            write_space_file(spacobr);
+          }
+        catch (...)
+          {
+            note_failure(std::current_exception());
+          }
+      });
     }
-  RPS_INFORMOUT("wrote " << nbspace << " space files into " << du_topdir);
+  for (std::thread& th: threads)
+    th.join();
+  du_writing.store(false);
+  if (du_failure)
+    std::rethrow_exception(du_failure);
+  if (nbclean > 0)
+    RPS_INFORMOUT("wrote " << nbspace << " space files into " << du_topdir
+                  << ", kept " << nbclean << " unchanged ones");
+  else
+    RPS_INFORMOUT("wrote " << nbspace << " space files into " << du_topdir);
 } // end Rps_Dumper::write_all_space_files
 
+/// A space file may be kept if it exists in the same format, with
+/// the same objects, none of them modified since the previous dump
+/// or load of that directory. Object mutators touch the ob_mtime, and
+/// payload mutators touch their owner's.
+bool
+Rps_Dumper::space_file_is_clean(const du_space_st&spa, const rps_dumpstate_st*ds) const
+{
+  RPS_ASSERT(ds != nullptr);
+  if (ds->ds_binary != rps_dump_binary_format || ds->ds_codec != rps_dump_codec)
+    return false;
+  auto itsp = ds->ds_spaces.find(spa.sp_id);
+  if (itsp == ds->ds_spaces.end())
+    return false;
+  if (itsp->second.first != spa.sp_setob.size()
+      || itsp->second.second != spa.digest())
+    return false;
+  std::string spacepath = du_topdir + "/persistore/sp" + spa.sp_id.to_string()
+                          + (rps_dump_binary_format?"-rps.bin":"-rps.json")
+                          + rps_codec_suffix(rps_dump_codec);
+  if (access(spacepath.c_str(), R_OK))
+    return false;
+  for (Rps_ObjectRef obr: spa.sp_setob)
+    if (obr->get_mtime() >= ds->ds_basetime)
+      return false;
+  return true;
+} // end Rps_Dumper::space_file_is_clean
+
+/// after a successful dump, remember what the space files contain
+void
+Rps_Dumper::record_dump_state(void)
+{
+  rps_dumpstate_st ds;
+  ds.ds_basetime = du_startwallclockrealtime;
+  ds.ds_binary = rps_dump_binary_format;
+  ds.ds_codec = rps_dump_codec;
+  {
+    Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
+    for (auto& it: du_spacemap)
+      ds.ds_spaces[it.second->sp_id] = {it.second->sp_setob.size(), it.second->digest()};
+  }
+  Rps_NoSafepointLock<std::mutex> gu(rps_dumpstate_mtx);
+  rps_dumpstate_map[du_topdir] = std::move(ds);
+} // end Rps_Dumper::record_dump_state
+
 void
 Rps_Dumper::write_generated_roots_file(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   RPS_DEBUG_LOG(DUMP, "dumper write_generated_roots_file start");
   auto rootpathstr = std::string{"generated/rps-roots.hh"};
   auto pouts = open_output_file(rootpathstr);
@@ -881,9 +1222,18 @@ Rps_Dumper::write_generated_roots_file(void)
   {
     RPS_ASSERT(obr);
     (*pouts) << "RPS_INSTALL_ROOT_OB(" << obr->oid() << ") //";
-    std::lock_guard<std::recursive_mutex> guobr(*(obr->objmtxptr()));
+    std::lock_guard<Rps_ObjectMutex> guobr(*(obr->objmtxptr()));
     Rps_ObjectRef obclass = obr->get_class();
     RPS_ASSERT(obclass);
+    /// with a background dump the agenda keeps running, so the class
+    /// is read under its own lock too
+    auto classname = [&](void) -> std::string
+    {
+      std::lock_guard<Rps_ObjectMutex> guclass(*(obclass->objmtxptr()));
+      auto claclapayl = obclass->get_dynamic_payload<Rps_PayloadClassInfo>();
+      RPS_ASSERT(claclapayl);
+      return claclapayl->class_name_str();
+    };
     if (auto clapayl = obr->get_dynamic_payload<Rps_PayloadClassInfo>())
       {
         if (obclass == Rps_ObjectRef::the_class_class())
@@ -892,9 +1242,7 @@ Rps_Dumper::write_generated_roots_file(void)
           }
         else
           {
-            auto claclapayl = obclass->get_dynamic_payload<Rps_PayloadClassInfo>();
-            RPS_ASSERT(claclapayl);
-            (*pouts) << clapayl->class_name_str() << "∈" << claclapayl->class_name_str();
+            (*pouts) << clapayl->class_name_str() << "∈" << classname();
           }
       }
     else if (auto symbpayl = obr->get_dynamic_payload<Rps_PayloadSymbol>())
@@ -905,19 +1253,15 @@ Rps_Dumper::write_generated_roots_file(void)
           }
         else
           {
-            auto claclapayl = obclass->get_dynamic_payload<Rps_PayloadClassInfo>();
-            RPS_ASSERT(claclapayl);
-            (*pouts) << symbpayl->symbol_name() << "∈" << claclapayl->class_name_str();
+            (*pouts) << symbpayl->symbol_name() << "∈" << classname();
           }
       }
     else
       {
-        auto claclapayl = obclass->get_dynamic_payload<Rps_PayloadClassInfo>();
         Rps_Value nameval = obr->get_physical_attr(Rps_ObjectRef::the_name_object());
-        RPS_ASSERT(claclapayl);
         if (nameval.is_string())
           (*pouts) << '"' << Rps_Cjson_String(nameval.to_cppstring()) << '"';
-        (*pouts) << "∈" << claclapayl->class_name_str();
+        (*pouts) << "∈" << classname();
       };
     (*pouts) << std::endl;
     rootcnt++;
@@ -934,7 +1278,7 @@ Rps_Dumper::write_generated_roots_file(void)
 void
 Rps_Dumper::write_generated_names_file(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   auto rootpathstr = std::string{"generated/rps-names.hh"};
   RPS_DEBUG_LOG(DUMP, "dumper write_generated_names_file start");
   auto pouts = open_output_file(rootpathstr);
@@ -947,10 +1291,10 @@ Rps_Dumper::write_generated_names_file(void)
   //  std::ofstream& out = *pouts;
   rps_each_root_object([=, &pouts, &namecnt](Rps_ObjectRef obr)
   {
+    std::lock_guard<Rps_ObjectMutex> gu(*(obr->objmtxptr()));
     Rps_PayloadSymbol* cursym = obr->get_dynamic_payload<Rps_PayloadSymbol>();
     if (!cursym || cursym->symbol_is_weak())
       return;
-    std::lock_guard<std::recursive_mutex> gu(*(obr->objmtxptr()));
     (*pouts) << "RPS_INSTALL_NAMED_ROOT_OB(" << obr->oid()
              << "," << (cursym->symbol_name()) << ")" << std::endl;
     namecnt++;
@@ -970,7 +1314,7 @@ Rps_Dumper::write_generated_names_file(void)
 void
 Rps_Dumper::write_generated_constants_file(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   auto rootpathstr = std::string{"generated/rps-constants.hh"};
   RPS_DEBUG_LOG(DUMP, "dumper write_generated_constants_file start");
   auto pouts = open_output_file(rootpathstr);
@@ -1004,7 +1348,7 @@ Rps_Dumper::write_generated_constants_file(void)
 void
 Rps_Dumper::write_generated_data_file(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   char osbuf[64];
   memset (osbuf, 0, sizeof(osbuf));
   char cwdbuf[rps_path_byte_size];
@@ -1145,7 +1489,7 @@ Rps_Dumper::write_generated_data_file(void)
 void
 Rps_Dumper::write_generated_parser_decl_file(Rps_CallFrame*callfr, Rps_ObjectRef genob)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   auto rootpathstr = std::string{"generated/rps-parser-decl.hh"};
   RPS_DEBUG_LOG(DUMP, "dumper write_generated_parser_decl_file start");
   auto pouts = open_output_file(rootpathstr);
@@ -1161,7 +1505,7 @@ Rps_Dumper::write_generated_parser_decl_file(Rps_CallFrame*callfr, Rps_ObjectRef
 void
 Rps_Dumper::write_generated_parser_impl_file(Rps_CallFrame*callfr, Rps_ObjectRef genob)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   auto rootpathstr = std::string{"generated/rps-parser-impl.cc"};
   RPS_DEBUG_LOG(DUMP, "dumper write_generated_parser_decl_file start");
   auto pouts = open_output_file(rootpathstr);
@@ -1177,7 +1521,7 @@ Rps_Dumper::write_generated_parser_impl_file(Rps_CallFrame*callfr, Rps_ObjectRef
 void
 Rps_Dumper::write_all_generated_files(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   write_generated_roots_file();
   write_generated_names_file();
   write_generated_constants_file();
@@ -1199,7 +1543,7 @@ Rps_Dumper::write_all_generated_files(void)
   _f.gencodselob = RPS_ROOT_OB(_5VC4IuJ0dyr01b8lA0); //generate_code∈named_selector
   try
     {
-      std::unique_lock<std::recursive_mutex> gurefpersysob(*(_f.refpersysob->objmtxptr()));
+      std::unique_lock<Rps_ObjectMutex> gurefpersysob(*(_f.refpersysob->objmtxptr()));
 
       _f.refpersysv = Rps_ObjectValue(_f.refpersysob);
       /* We create a temporary object to hold some "arbitrary"
@@ -1247,12 +1591,14 @@ void
 Rps_Dumper::write_manifest_file(void)
 {
   std::unique_ptr<Json::StreamWriter> jsonwriter(du_jsonwriterbuilder.newStreamWriter());
-  std::lock_guard<std::recursive_mutex> gu(du_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
   RPS_DEBUG_LOG(DUMP, "dumper write_manifest_file start");
   auto pouts = open_output_file(RPS_MANIFEST_JSON);
   rps_emit_gplv3_copyright_notice(*pouts, RPS_MANIFEST_JSON, "//!! ", "");
   Json::Value jmanifest(Json::objectValue);
-  jmanifest["format"] = Json::Value (RPS_MANIFEST_FORMAT);
+  jmanifest["format"] = Json::Value (rps_dump_binary_format?RPS_BINARY_FORMAT:RPS_MANIFEST_FORMAT);
+  if (!rps_dump_codec.empty())
+    jmanifest["codec"] = Json::Value (rps_dump_codec);
   jmanifest["jsoncpp-version"] = JSONCPP_VERSION_STRING;
   jmanifest["short-git-id"] = rps_shortgitid;
   jmanifest["git-branch"] = rps_gitbranch;
@@ -1309,6 +1655,7 @@ Rps_Dumper::write_manifest_file(void)
     //  std::ofstream& out = *pouts;
     rps_each_root_object([=, &pouts, &namecnt, &jglobalnames](Rps_ObjectRef obr)
     {
+      std::lock_guard<Rps_ObjectMutex> gu(*(obr->objmtxptr()));
       Rps_PayloadSymbol* cursym = obr->get_dynamic_payload<Rps_PayloadSymbol>();
       if (!cursym || cursym->symbol_is_weak())
         return;
@@ -1353,24 +1700,47 @@ Rps_Dumper::write_space_file(Rps_ObjectRef spacobr)
 {
   du_space_st* curspa = nullptr;
   {
-    std::lock_guard<std::recursive_mutex> gu(du_mtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
     curspa = du_spacemap[spacobr].get();
   }
   RPS_ASSERT(curspa);
   std::string curelpath;
   std::set<Rps_ObjectRef> curspaset;
   Rps_Id spacid;
-  std::unique_ptr<std::ofstream> pouts;
+  std::unique_ptr<std::ostream> pouts;
   RPS_ASSERT(du_jsonwriterbuilder["indentation"] == std::string{" "});
   std::unique_ptr<Json::StreamWriter> jsonwriter(du_jsonwriterbuilder.newStreamWriter());
   {
-    std::lock_guard<std::recursive_mutex> gu(du_mtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gu(du_mtx);
     spacid = curspa->sp_id;
-    curelpath = std::string{"persistore/sp"} + spacid.to_string() + "-rps.json";
-    pouts = open_output_file(curelpath);
+    curelpath = std::string{"persistore/sp"} + spacid.to_string()
+                + (rps_dump_binary_format?"-rps.bin":"-rps.json")
+                + rps_codec_suffix(rps_dump_codec);
+    pouts = open_compressed_output_file(curelpath);
     curspaset = curspa->sp_setob;
   }
   RPS_ASSERT(pouts);
+  if (rps_dump_binary_format)
+    {
+      /// the binary space file encodes the very same JSON objects,
+      /// without any human readable comments
+      Rps_BinaryStoreWriter binwriter(spacid);
+      for (auto curobr: curspaset)
+        {
+          std::lock_guard<Rps_ObjectMutex> gucurob(*(curobr->objmtxptr()));
+          Json::Value jobject(Json::objectValue);
+          jobject["oid"] = Json::Value (curobr->oid().to_string());
+          jobject["mtime"] = Json::Value (curobr->ob_mtime.load());
+          curobr->dump_json_content(this,jobject);
+          binwriter.add_object(jobject);
+        }
+      binwriter.write(*pouts);
+      if (!pouts->good())
+        throw RPS_RUNTIME_ERROR_OUT("failed to write binary space file " << curelpath);
+      RPS_DEBUG_LOG(DUMP, "dumper write_space_file end binary " << curelpath
+                    << " with " << curspaset.size() << " objects." << std::endl);
+      return;
+    }
   rps_emit_gplv3_copyright_notice(*pouts, curelpath, "//// ", "");
   *pouts << std::endl;
   // emit the prologue
@@ -1386,11 +1756,12 @@ Rps_Dumper::write_space_file(Rps_ObjectRef spacobr)
     *pouts << std::endl;
   }
   int count = 0;
+  std::map<Rps_ObjectRef,std::string> classnamecache;
   for (auto curobr: curspaset)
     {
       *pouts << std::endl << std::endl;
       ++count;
-      std::lock_guard<std::recursive_mutex> gucurob(*(curobr->objmtxptr()));
+      std::lock_guard<Rps_ObjectMutex> gucurob(*(curobr->objmtxptr()));
       std::string namestr;
       Rps_Value vname = curobr //
                         ->get_physical_attr(RPS_ROOT_OB(_1EBVGSfW2m200z18rx)); //name∈named_attribute
@@ -1408,34 +1779,41 @@ Rps_Dumper::write_space_file(Rps_ObjectRef spacobr)
       RPS_NOPRINTOUT("Rps_Dumper::write_space_file emits " << (curobr->oid().to_string())
                      << " of hi=" <<  (curobr->oid().hi())
                      << " #" << count);
-      /// output a comment giving the class name for readability
+      /// output a comment giving the class name for readability; the
+      /// few classes are looked up once per space file
       {
         Rps_ObjectRef obclass = curobr->get_class();
-        Rps_ObjectRef obsymb;
-        if (obclass)
+        auto itcla = classnamecache.find(obclass);
+        if (itcla == classnamecache.end())
           {
-            RPS_NOPRINTOUT("Rps_Dumper::write_space_file obclass " << obclass->oid().to_string()
-                           << " for obr " <<curobr->oid().to_string());
-            usleep(1000);
-            std::lock_guard<std::recursive_mutex> gu(*(obclass->objmtxptr()));
-            auto classinfo = obclass->get_dynamic_payload<Rps_PayloadClassInfo>();
-            if (classinfo)
-              obsymb = classinfo->symbname();
-          };
-        if (obsymb)
-          {
-            RPS_NOPRINTOUT("Rps_Dumper::write_space_file obsymb " << obsymb->oid().to_string()
-                           << " for obr " <<curobr->oid().to_string());
-            std::lock_guard<std::recursive_mutex> gu(*(obsymb->objmtxptr()));
-            auto symb = obsymb->get_dynamic_payload<Rps_PayloadSymbol>();
-            if (symb)
-              *pouts << "//∈" /*U+2208 ELEMENT OF*/
-                     << symb->symbol_name() << std::endl;
+            Rps_ObjectRef obsymb;
+            std::string symbname;
+            if (obclass)
+              {
+                RPS_NOPRINTOUT("Rps_Dumper::write_space_file obclass " << obclass->oid().to_string()
+                               << " for obr " <<curobr->oid().to_string());
+                std::lock_guard<Rps_ObjectMutex> gu(*(obclass->objmtxptr()));
+                auto classinfo = obclass->get_dynamic_payload<Rps_PayloadClassInfo>();
+                if (classinfo)
+                  obsymb = classinfo->symbname();
+              };
+            if (obsymb)
+              {
+                RPS_NOPRINTOUT("Rps_Dumper::write_space_file obsymb " << obsymb->oid().to_string()
+                               << " for obr " <<curobr->oid().to_string());
+                std::lock_guard<Rps_ObjectMutex> gu(*(obsymb->objmtxptr()));
+                auto symb = obsymb->get_dynamic_payload<Rps_PayloadSymbol>();
+                if (symb)
+                  symbname = symb->symbol_name();
+              }
+            else
+              RPS_WARNOUT("Rps_Dumper::write_space_file no obsymb for obr "
+                          <<curobr->oid().to_string());
+            itcla = classnamecache.insert({obclass, symbname}).first;
           }
-        else
-          RPS_WARNOUT("Rps_Dumper::write_space_file no obsymb for obr "
-                      <<curobr->oid().to_string());
-
+        if (!itcla->second.empty())
+          *pouts << "//∈" /*U+2208 ELEMENT OF*/
+                 << itcla->second << std::endl;
       }
       Json::Value jobject(Json::objectValue);
       jobject["oid"] = Json::Value (curobr->oid().to_string());
@@ -1510,17 +1888,11 @@ Rps_PayloadSpace::dump_scan(Rps_Dumper*du) const
 
 
 ////////////////////////////////////////////////////////////////
-void rps_dump_into (std::string dirpath, Rps_CallFrame* callframe)
+/// check, make and canonicalize a directory to dump into, with its
+/// persistore/ and generated/ subdirectories; gives its real path
+static std::string
+rps_dump_prepare_directory(std::string dirpath)
 {
-  RPS_LOCALFRAME(RPS_CALL_FRAME_UNDESCRIBED, //
-                 /*callerframe:*/callframe, //
-                 Rps_ObjectRef obdumper;
-                );
-  double startelapsed = rps_elapsed_real_time();
-  double startcputime = rps_process_cpu_time();
-  RPS_DEBUG_LOG(DUMP, "rps_dump_into start dirpath=" << dirpath
-                << std::endl
-                << RPS_FULL_BACKTRACE_HERE(1, "rps_dump_into"));
   if (dirpath.empty())
     dirpath = std::string(".");
   int lendirpath = dirpath.size();
@@ -1567,11 +1939,49 @@ void rps_dump_into (std::string dirpath, Rps_CallFrame* callframe)
       RPS_FATAL("getcwd failed: %m");
     cwdpath = std::string(cwdbuf);
   }
-  RPS_DEBUG_LOG(DUMP, "rps_dump_into realdirpath=" << realdirpath << " cwdpath=" << cwdpath);
+  RPS_DEBUG_LOG(DUMP, "rps_dump_prepare_directory realdirpath=" << realdirpath << " cwdpath=" << cwdpath);
   /// ensure that realdirpath exists
   {
     RPS_ASSERT(strrchr(realdirpath.c_str(), '/') != nullptr);
   }
+  if (realdirpath != cwdpath)
+    {
+      if (!std::filesystem::create_directories(realdirpath
+          + "/persistore"))
+        {
+          RPS_WARNOUT("failed to make dump sub-directory " << realdirpath
+                      << "/persistore:" << strerror(errno));
+          throw std::runtime_error(std::string{"failed to make dump directory:"} + realdirpath + "/persistore");
+        }
+      else
+        RPS_INFORMOUT("made real dump sub-directory: " << realdirpath
+                      << "/persistore");
+      if (!std::filesystem::create_directories(realdirpath
+          + "/generated"))
+        {
+          RPS_WARNOUT("failed to make dump sub-directory " << realdirpath
+                      << "/generated:" << strerror(errno));
+          throw std::runtime_error(std::string{"failed to make dump directory:"} + realdirpath + "/persistore");
+        }
+      else
+        RPS_INFORMOUT("made real dump sub-directory: " << realdirpath
+                      << "/generated");
+    }
+  return realdirpath;
+} // end rps_dump_prepare_directory
+
+void rps_dump_into (std::string dirpath, Rps_CallFrame* callframe)
+{
+  RPS_LOCALFRAME(RPS_CALL_FRAME_UNDESCRIBED, //
+                 /*callerframe:*/callframe, //
+                 Rps_ObjectRef obdumper;
+                );
+  double startelapsed = rps_elapsed_real_time();
+  double startcputime = rps_process_cpu_time();
+  RPS_DEBUG_LOG(DUMP, "rps_dump_into start dirpath=" << dirpath
+                << std::endl
+                << RPS_FULL_BACKTRACE_HERE(1, "rps_dump_into"));
+  std::string realdirpath = rps_dump_prepare_directory(dirpath);
   //// TODO: we may want to create a temporary object in obdumper to
   //// keep data related to that particular dump. And keep that
   //// dumpobject in Rps_Dumper.
@@ -1581,29 +1991,7 @@ void rps_dump_into (std::string dirpath, Rps_CallFrame* callframe)
                 << " with temporary suffix " << dumper.get_temporary_suffix());
   try
     {
-      if (realdirpath != cwdpath)
-        {
-          if (!std::filesystem::create_directories(realdirpath
-              + "/persistore"))
-            {
-              RPS_WARNOUT("failed to make dump sub-directory " << realdirpath
-                          << "/persistore:" << strerror(errno));
-              throw std::runtime_error(std::string{"failed to make dump directory:"} + realdirpath + "/persistore");
-            }
-          else
-            RPS_INFORMOUT("made real dump sub-directory: " << realdirpath
-                          << "/persistore");
-          if (!std::filesystem::create_directories(realdirpath
-              + "/generated"))
-            {
-              RPS_WARNOUT("failed to make dump sub-directory " << realdirpath
-                          << "/generated:" << strerror(errno));
-              throw std::runtime_error(std::string{"failed to make dump directory:"} + realdirpath + "/persistore");
-            }
-          else
-            RPS_INFORMOUT("made real dump sub-directory: " << realdirpath
-                          << "/generated");
-        }
+      Rps_Journal::begin_dump(realdirpath);
       dumper.scan_roots();
       dumper.scan_every_cplusplus_source_file_for_constants();
       dumper.scan_loop_pass();
@@ -1616,6 +2004,8 @@ void rps_dump_into (std::string dirpath, Rps_CallFrame* callframe)
       dumper.write_all_generated_files();
       dumper.write_manifest_file();
       dumper.rename_opened_files();
+      dumper.record_dump_state();
+      Rps_Journal::end_dump(realdirpath);
       double endelapsed = rps_elapsed_real_time();
       double endcputime = rps_process_cpu_time();
       RPS_INFORMOUT("dump into " << dumper.get_top_dir()
@@ -1637,6 +2027,154 @@ void rps_dump_into (std::string dirpath, Rps_CallFrame* callframe)
   ///
 } // end of rps_dump_into
 
+
+////////////////////////////////////////////////////////////////
+//// background dumps
+
+bool rps_background_dump;
+
+/// Set and cleared by the main thread, read by the garbage collector.
+static std::mutex rps_bgdump_mtx;
+static Rps_Dumper* rps_bgdump_dumper;
+static std::thread rps_bgdump_thread;
+static bool rps_bgdump_again;
+
+/// A background dump is a fuzzy snapshot: each object is scanned and
+/// serialized under its own lock while the agenda keeps running, and
+/// so are the payloads read for the generated files and the manifest. The journal
+/// is moved aside first, so mutations during the snapshot are in the
+/// fresh journal, and replaying it on top of the snapshot gives the
+/// state of its last commit. The main thread starts the dump with its
+/// roots, then a background thread scans the heap and writes the
+/// space files, then the main thread writes the manifest and the
+/// generated files and renames everything.
+void
+rps_start_background_dump(const std::string&dirpath)
+{
+  RPS_ASSERT(rps_is_main_thread());
+  if (rps_bgdump_dumper)
+    {
+      RPS_INFORMOUT("a background dump into " << rps_bgdump_dumper->get_top_dir()
+                    << " is running, another one will follow");
+      rps_bgdump_again = true;
+      return;
+    }
+  if (!Rps_Journal::active())
+    RPS_WARNOUT("background dump into " << dirpath
+                << " without --journal: objects changed meanwhile may be inconsistent");
+  std::string realdirpath = rps_dump_prepare_directory(dirpath);
+  Rps_Dumper* du = new Rps_Dumper(realdirpath, nullptr);
+  {
+    Rps_NoSafepointLock<std::mutex> gu(rps_bgdump_mtx);
+    rps_bgdump_dumper = du;
+  }
+  RPS_INFORMOUT("start background dumping into " << du->get_top_dir()
+                << " with temporary suffix " << du->get_temporary_suffix());
+  try
+    {
+      Rps_Journal::begin_dump(realdirpath);
+      du->scan_roots();
+    }
+  catch (...)
+    {
+      du->note_failure(std::current_exception());
+    }
+  rps_bgdump_thread = std::thread([du]()
+  {
+    pthread_setname_np(pthread_self(), "rps-bgdump");
+    try
+      {
+        if (!du->du_failure)
+          {
+            du->scan_every_cplusplus_source_file_for_constants();
+            du->scan_loop_pass();
+            du->write_all_space_files();
+          }
+      }
+    catch (...)
+      {
+        du->note_failure(std::current_exception());
+      }
+    rps_postpone_dump_completion();
+  });
+} // end rps_start_background_dump
+
+/// on the main thread, when the background thread is done
+void
+rps_finish_background_dump(void)
+{
+  RPS_ASSERT(rps_is_main_thread());
+  Rps_Dumper* du = rps_bgdump_dumper;
+  if (!du)
+    return;
+  if (rps_bgdump_thread.joinable())
+    rps_bgdump_thread.join();
+  try
+    {
+      if (du->du_failure)
+        std::rethrow_exception(du->du_failure);
+      du->write_all_generated_files();
+      du->write_manifest_file();
+      du->rename_opened_files();
+      du->record_dump_state();
+      Rps_Journal::end_dump(du->get_top_dir());
+      RPS_INFORMOUT("background dump into " << du->get_top_dir()
+                    << " completed in " << (rps_elapsed_real_time() - du->du_startelapsedtime)
+                    << " wallclock, " << (rps_process_cpu_time() - du->du_startprocesstime)
+                    << " cpu seconds with " << du->du_newobcount
+                    << " new objects dumped");
+    }
+  catch (const std::exception& exc)
+    {
+      RPS_WARNOUT("failure in background dump to " << du->get_top_dir()
+                  << std::endl
+                  << "... got exception of type "
+                  << typeid(exc).name()
+                  << ":"
+                  << exc.what());
+    };
+  {
+    Rps_NoSafepointLock<std::mutex> gu(rps_bgdump_mtx);
+    rps_bgdump_dumper = nullptr;
+  }
+  delete du;
+  if (rps_bgdump_again)
+    {
+      rps_bgdump_again = false;
+      rps_postpone_dump();
+    }
+} // end rps_finish_background_dump
+
+bool
+rps_background_dump_running(void)
+{
+  Rps_NoSafepointLock<std::mutex> gu(rps_bgdump_mtx);
+  return rps_bgdump_dumper != nullptr;
+} // end rps_background_dump_running
+
+/// the objects found by a running background dump stay alive until
+/// it is done; they are copied first, since the scanning threads take
+/// object locks before the dumper lock
+void
+rps_dump_gc_mark(Rps_GarbageCollector&gc)
+{
+  Rps_NoSafepointLock<std::mutex> gu(rps_bgdump_mtx);
+  Rps_Dumper* du = rps_bgdump_dumper;
+  if (!du)
+    return;
+  std::vector<Rps_ObjectRef> obvec;
+  {
+    std::unique_lock<std::recursive_mutex> gudu(du->du_mtx, std::defer_lock);
+    if (!du->du_writing.load())
+      gudu.lock();
+    obvec.reserve(du->du_mapobjects.size());
+    for (auto& it: du->du_mapobjects)
+      obvec.push_back(it.second);
+  }
+  for (Rps_ObjectRef obr: obvec)
+    obr->gc_mark(gc);
+} // end rps_dump_gc_mark
+
 /// NB rpsapply_5Q5E0Lw9v4f046uAKZ is installed as
 /// "generate_code°the_system_class" in commit  a87e55f74f78537 and before
 /***
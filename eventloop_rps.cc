@@ -48,6 +48,7 @@ enum self_pipe_code_en
 {
   SelfPipe__NONE=0,
   SelfPipe_Dump = 'D',
+  SelfPipe_DumpDone = 'd',
   SelfPipe_GarbColl = 'G',
   SelfPipe_Process = 'P',
   SelfPipe_Quit = 'Q',
@@ -56,14 +57,28 @@ enum self_pipe_code_en
 
 
 
-#define RPS_MAXPOLL_FD 128
-
 //extern "C" std::atomic<bool> rps_stop_event_loop_flag;
 
 std::atomic<bool> rps_stop_event_loop_flag;
 
 int rps_poll_delay_millisec;
 
+/// at most that many ready events are handled by one epoll_wait(2)
+#define RPS_EPOLL_MAXEVENTS 64
+
+/// A watched file descriptor, registered once in the epoll(7) set.
+/// The epoll data of its events keeps both the fd and a serial
+/// number, so events of a removed watcher are not given to another
+/// watcher later added for the same fd.
+struct rps_fdwatcher_st
+{
+  int fdw_fd;
+  uint32_t fdw_serial;
+  uint32_t fdw_events;
+  const char* fdw_explanation;
+  rps_fdwatch_handler_t fdw_handler;
+  Rps_ClosureValue fdw_closure; // when watched thru a closure
+};
 
 #define RPS_EVENTLOOPDATA_MAGIC 814538509 /*0x308cdf0d*/
 struct event_loop_data_st
@@ -73,10 +88,12 @@ struct event_loop_data_st
   std::mutex eld_mtx;
   double eld_startelapsedtime; // start real time of event loop
   double eld_startcputime; // start CPU time of event loop
-  std::array<std::function<void(Rps_CallFrame*, int/*fd*/, short /*revents*/)>,RPS_MAXPOLL_FD+1> eld_handlarr;
-  const char*eld_explarr[RPS_MAXPOLL_FD+1];
+  int eld_epollfd;      // file descriptor from epoll_create1(2)
+  std::map<int,std::shared_ptr<rps_fdwatcher_st>> eld_watchers;
+  uint32_t eld_watchserial;
   int eld_sigfd;  // file descriptor from signalfd(2)
   int eld_timfd;        // file descriptor from timerfd_create(2)
+  Rps_TimerWheel eld_timerwheel; // its timers, armed on eld_timfd
   int eld_selfpipereadfd; // self pipe, reading end
   int eld_selfpipewritefd; // self pipe, writing end
   std::deque<unsigned char> eld_selfpipefifo;
@@ -95,7 +112,7 @@ static std::stringstream rps_jsonrpc_rspstream; // should be used
 #warning use rps_jsonrpc_rspstream below
 
 /**
- * We probably want to use the pipe to self trick.
+ * We use the pipe to self trick.
  * https://www.sitepoint.com/the-self-pipe-trick-explained/
  *
  * in cooperation with Rps_PayloadUnixProcess::start_process
@@ -120,12 +137,25 @@ rps_do_stop_event_loop(void)
 extern "C" void jsonrpc_initialize_rps(void);
 
 
+/// the byte is queued, and the pipe written only to wake up the
+/// event loop when the queue was empty
 void
 rps_self_pipe_write_byte(unsigned char b)
 {
   RPS_ASSERT(b != (char)0);
-  std::lock_guard<std::mutex> gu(rps_eventloopdata.eld_mtx);
-  rps_eventloopdata.eld_selfpipefifo.push_back(b);
+  bool wakeup = false;
+  {
+    Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+    wakeup = rps_eventloopdata.eld_selfpipefifo.empty();
+    rps_eventloopdata.eld_selfpipefifo.push_back(b);
+  }
+  int wfd = rps_eventloopdata.eld_selfpipewritefd;
+  if (wakeup && wfd > 0)
+    {
+      /// a full pipe already wakes up the loop, so EAGAIN is harmless
+      if (write(wfd, &b, 1) < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        RPS_WARNOUT("failed to write on self pipe fd#" << wfd << ":" << strerror(errno));
+    }
 } // end rps_self_pipe_write_byte
 
 bool
@@ -137,6 +167,145 @@ rps_is_fifo(std::string path)
   return false;
 } // end rps_is_fifo
 
+
+////////////////////////////////////////////////////////////////
+//// the public API of watched file descriptors
+
+void
+rps_event_loop_add_fd(int fd, uint32_t events, const char*explanation,
+                      rps_fdwatch_handler_t handler)
+{
+  if (fd < 0)
+    throw RPS_RUNTIME_ERROR_OUT("cannot watch invalid fd#" << fd);
+  if (!handler)
+    throw RPS_RUNTIME_ERROR_OUT("cannot watch fd#" << fd << " without handler");
+  Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+  if (rps_eventloopdata.eld_epollfd <= 0)
+    throw RPS_RUNTIME_ERROR_OUT("cannot watch fd#" << fd
+                                << " before rps_initialize_event_loop");
+  if (rps_eventloopdata.eld_watchers.find(fd) != rps_eventloopdata.eld_watchers.end())
+    throw RPS_RUNTIME_ERROR_OUT("fd#" << fd << " is already watched");
+  auto watcher = std::make_shared<rps_fdwatcher_st>();
+  watcher->fdw_fd = fd;
+  watcher->fdw_serial = ++rps_eventloopdata.eld_watchserial;
+  watcher->fdw_events = events;
+  watcher->fdw_explanation = explanation?explanation:"?";
+  watcher->fdw_handler = handler;
+  struct epoll_event ev;
+  memset (&ev, 0, sizeof(ev));
+  ev.events = events | EPOLLET;
+  ev.data.u64 = ((uint64_t)watcher->fdw_serial << 32) | (uint32_t)fd;
+  if (epoll_ctl(rps_eventloopdata.eld_epollfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    throw RPS_RUNTIME_ERROR_OUT("failed to watch fd#" << fd << " for " << watcher->fdw_explanation
+                                << ":" << strerror(errno));
+  rps_eventloopdata.eld_watchers.insert({fd, watcher});
+} // end rps_event_loop_add_fd
+
+void
+rps_event_loop_add_fd(int fd, uint32_t events, const char*explanation,
+                      Rps_ClosureValue closv)
+{
+  if (!closv || !closv.is_closure())
+    throw RPS_RUNTIME_ERROR_OUT("cannot watch fd#" << fd << " without closure");
+  rps_event_loop_add_fd(fd, events, explanation,
+                        [=](Rps_CallFrame*cf, int curfd, uint32_t curevents)
+  {
+    closv.apply2(cf, Rps_Value((intptr_t)curfd), Rps_Value((intptr_t)curevents));
+  });
+  /// the closure is also kept in the watcher, for the GC
+  Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+  auto it = rps_eventloopdata.eld_watchers.find(fd);
+  if (it != rps_eventloopdata.eld_watchers.end())
+    it->second->fdw_closure = closv;
+} // end rps_event_loop_add_fd with closure
+
+void
+rps_event_loop_modify_fd(int fd, uint32_t events)
+{
+  Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+  auto it = rps_eventloopdata.eld_watchers.find(fd);
+  if (it == rps_eventloopdata.eld_watchers.end())
+    throw RPS_RUNTIME_ERROR_OUT("cannot modify unwatched fd#" << fd);
+  struct epoll_event ev;
+  memset (&ev, 0, sizeof(ev));
+  ev.events = events | EPOLLET;
+  ev.data.u64 = ((uint64_t)it->second->fdw_serial << 32) | (uint32_t)fd;
+  if (epoll_ctl(rps_eventloopdata.eld_epollfd, EPOLL_CTL_MOD, fd, &ev) < 0)
+    throw RPS_RUNTIME_ERROR_OUT("failed to modify watched fd#" << fd << " for "
+                                << it->second->fdw_explanation << ":" << strerror(errno));
+  it->second->fdw_events = events;
+} // end rps_event_loop_modify_fd
+
+bool
+rps_event_loop_remove_fd(int fd)
+{
+  Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+  auto it = rps_eventloopdata.eld_watchers.find(fd);
+  if (it == rps_eventloopdata.eld_watchers.end())
+    return false;
+  /// a closed fd has already left the epoll set, so errors are ignored
+  (void) epoll_ctl(rps_eventloopdata.eld_epollfd, EPOLL_CTL_DEL, fd, nullptr);
+  rps_eventloopdata.eld_watchers.erase(it);
+  return true;
+} // end rps_event_loop_remove_fd
+
+void
+rps_event_loop_gc_mark(Rps_GarbageCollector&gc)
+{
+  {
+    Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+    for (auto& it: rps_eventloopdata.eld_watchers)
+      if (it.second->fdw_closure)
+        gc.mark_value(it.second->fdw_closure);
+  }
+  rps_eventloopdata.eld_timerwheel.gc_mark(gc);
+} // end rps_event_loop_gc_mark
+
+Rps_TimerWheel&
+rps_event_loop_timer_wheel(void)
+{
+  return rps_eventloopdata.eld_timerwheel;
+} // end rps_event_loop_timer_wheel
+
+static std::string
+rps_epoll_events_string(uint32_t events)
+{
+  std::string evstr;
+  if (events & EPOLLIN)
+    evstr += " EPOLLIN";
+  if (events & EPOLLOUT)
+    evstr += " EPOLLOUT";
+  if (events & EPOLLPRI)
+    evstr += " EPOLLPRI";
+  if (events & EPOLLRDHUP)
+    evstr += " EPOLLRDHUP";
+  if (events & EPOLLERR)
+    evstr += " EPOLLERR";
+  if (events & EPOLLHUP)
+    evstr += " EPOLLHUP";
+  return evstr;
+} // end rps_epoll_events_string
+
+/// the self pipe is drained, then the queued bytes are handled in
+/// their order
+static void
+rps_handle_self_pipe_input(Rps_CallFrame*cf, int fd, uint32_t events)
+{
+  RPS_ASSERT(fd == rps_eventloopdata.eld_selfpipereadfd);
+  RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
+  RPS_ASSERT(events & EPOLLIN);
+  unsigned char buf[128];
+  while (read(fd, buf, sizeof(buf)) > 0)
+    continue;
+  std::deque<unsigned char> bytes;
+  {
+    Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+    bytes.swap(rps_eventloopdata.eld_selfpipefifo);
+  }
+  for (unsigned char b: bytes)
+    handle_self_pipe_byte_rps(b);
+} // end rps_handle_self_pipe_input
+
 void
 rps_initialize_event_loop(void)
 {
@@ -149,17 +318,32 @@ rps_initialize_event_loop(void)
     if (count++ > 0)
       RPS_FATALOUT("rps_initialize_event_loop should be called once");
   };
+  rps_eventloopdata.eld_magic = RPS_EVENTLOOPDATA_MAGIC;
+  rps_eventloopdata.eld_epollfd = epoll_create1(EPOLL_CLOEXEC);
+  if (rps_eventloopdata.eld_epollfd < 0)
+    RPS_FATALOUT("rps_initialize_event_loop failed to create epoll:" << strerror(errno));
   /**
-   * create the pipe to self
+   * create the pipe to self; both ends are non-blocking since the
+   * events are edge-triggered
    **/
   {
     int pipefdarr[2] = {-1, -1};
-    if (pipe2(pipefdarr, O_CLOEXEC) <0)
+    if (pipe2(pipefdarr, O_CLOEXEC|O_NONBLOCK) <0)
       RPS_FATALOUT("rps_initialize_event_loop failed to create pipe to self:" << strerror(errno));
     rps_eventloopdata.eld_selfpipereadfd = pipefdarr[0];
     RPS_ASSERT(rps_eventloopdata.eld_selfpipereadfd > 0);
     rps_eventloopdata.eld_selfpipewritefd = pipefdarr[1];
   }
+  rps_event_loop_add_fd(rps_eventloopdata.eld_selfpipereadfd, EPOLLIN,
+                        "self_pipe_read_fd", rps_handle_self_pipe_input);
+  /// bytes queued before are handled by the first loop
+  bool pending = false;
+  {
+    Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+    pending = !rps_eventloopdata.eld_selfpipefifo.empty();
+  }
+  if (pending && write(rps_eventloopdata.eld_selfpipewritefd, "W", 1) < 0)
+    RPS_WARNOUT("failed to write on self pipe:" << strerror(errno));
   if (rps_poll_delay_millisec==0)
     rps_poll_delay_millisec = RPS_EVENT_DEFAULT_POLL_DELAY_MILLISEC;
 } // end rps_initialize_event_loop
@@ -198,18 +382,17 @@ jsonrpc_initialize_rps(void)
 
 
 
-/* TODO: an event loop using poll(2) and also handling SIGCHLD using
-   https://man7.org/linux/man-pages/man2/signalfd.2.html
+/* The event loop uses edge-triggered epoll(7). Every watcher is
+   registered once with rps_event_loop_add_fd, and each wakeup costs
+   only its ready file descriptors. Signals such as SIGCHLD come thru
+   signalfd(2), timers thru timerfd_create(2).
  */
 void
 rps_event_loop(void)
 {
-  /// see https://man7.org/linux/man-pages/man2/poll.2.html
-  int nbfdpoll=0; /// number of polled file descriptors, second argument to poll(2)
   long pollcount=0;
   double startelapsedtime=rps_elapsed_real_time();
   double startcputime=rps_process_cpu_time();
-  std::array<std::function<void(Rps_CallFrame*, int/*fd*/, short /*revents*/)>,RPS_MAXPOLL_FD+1> handlarr;
   /// check that rps_event_loop is called exactly once from main
   /// thread, and after rps_initialize_event_loop...
   {
@@ -220,14 +403,13 @@ rps_event_loop(void)
       RPS_FATALOUT("rps_event_loop has already been called " << nbcall << " times");
     /// The rps_poll_delay_millisec should have been set by a prior call
     /// ... to rps_initialize_event_loop above.
-    if (rps_poll_delay_millisec<=0)
+    if (rps_poll_delay_millisec<=0 || rps_eventloopdata.eld_epollfd<=0)
       RPS_FATALOUT("the poll event loop has not being properly initialized");
   };
   RPS_LOCALFRAME(RPS_CALL_FRAME_UNDESCRIBED,
                  /*callerframe:*/RPS_NULL_CALL_FRAME, //
                  /** locals **/
-                 Rps_Value valarr[RPS_MAXPOLL_FD+1];
-                 Rps_ClosureValue closarr[RPS_MAXPOLL_FD+1];
+                 Rps_Value dummyv;
                 );
 #warning incomplete rps_event_loop
   sigset_t msk= {};
@@ -241,82 +423,61 @@ rps_event_loop(void)
   RPS_DEBUG_LOG(REPL, "starting rps_event_loop from "
                 << RPS_FULL_BACKTRACE_HERE(1, "rps_event_loop/start")
                );
-  rps_eventloopdata.eld_sigfd = signalfd(-1, &msk, SFD_CLOEXEC);
+  rps_eventloopdata.eld_sigfd = signalfd(-1, &msk, SFD_CLOEXEC|SFD_NONBLOCK);
   if (rps_eventloopdata.eld_sigfd<=0)
     RPS_FATALOUT("failed to call signalfd:" << strerror(errno));
-  rps_eventloopdata.eld_timfd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC);
+  rps_eventloopdata.eld_timfd = timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC|TFD_NONBLOCK);
   if (rps_eventloopdata.eld_timfd<=0)
     RPS_FATALOUT("failed to call timerfd:" << strerror(errno));
-  const char*explarr[RPS_MAXPOLL_FD+1];
-  memset (explarr, 0, sizeof(explarr));
-#warning TODO: consider using rps_timer ...?
-  /*** give output
-   ***/
-  RPS_INFORMOUT("starting rps_event_loop in pid " << (int)getpid() << " on " << rps_hostname()
-                << " git " << rps_shortgitid << std::endl
-                << RPS_FULL_BACKTRACE_HERE(1, "rps_event_loop")
-               );
-  while (!rps_stop_event_loop_flag.load())
+  /// timers may have been added before the event loop runs
+  rps_eventloopdata.eld_timerwheel.set_timerfd(rps_eventloopdata.eld_timfd);
+  struct rps_fifo_fdpair_st fdp = rps_get_gui_fifo_fds();
+  if (fdp.fifo_ui_wcmd >0)
     {
-      char elapsbuf[32];
-      memset(elapsbuf, 0, sizeof(elapsbuf));
-      struct pollfd pollarr[RPS_MAXPOLL_FD+1];
-      memset ((void*)&pollarr, 0, sizeof(pollarr));
-#define EXPLAIN_EVFD_AT(Fil,Lin,Ix,Expl) do { explarr[Ix] = Fil ":" #Lin " " Expl; } while(0)
-#define EXPLAIN_EVFD_ATBIS(Fil,Lin,Ix,Expl)  EXPLAIN_EVFD_AT(Fil,Lin,Ix,Expl)
-#define EXPLAIN_EVFD_RPS(Ix,Expl) EXPLAIN_EVFD_ATBIS(__FILE__,__LINE__,(Ix),Expl)
-      int loopcnt=1+ event_nbloops.fetch_add(1);
-      memset ((void*)&pollarr, 0, sizeof(pollarr));
-      nbfdpoll=0;
-      struct rps_fifo_fdpair_st fdp = rps_get_gui_fifo_fds();
-      if (fdp.fifo_ui_wcmd >0)
-        {
-          /// JSONRPC commands written from RefPerSys to the GUI process...
-          RPS_ASSERT(nbfdpoll<RPS_MAXPOLL_FD);
-          int pix = nbfdpoll++;
-          pollarr[pix].fd = fdp.fifo_ui_wcmd;
-          pollarr[pix].events = POLLOUT;
-          handlarr[pix] = [&](Rps_CallFrame* cf, int fd, short rev)
-          {
-            RPS_ASSERT(fd ==  pollarr[pix].fd);
-            RPS_ASSERT(rev == POLLOUT);
-            RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
-            RPS_FATALOUT("missing code to handle JSONRPC output commands to fd#"
-                         << fd << " pix#" << pix);
-            /* TODO: write the bytes that are in rps_jsonrpc_cmdbuf */
+      /// JSONRPC commands written from RefPerSys to the GUI process...
+      rps_event_loop_add_fd(fdp.fifo_ui_wcmd, EPOLLOUT, "JsonRpc commands to GUI",
+                            [=](Rps_CallFrame* cf, int fd, uint32_t rev)
+      {
+        RPS_ASSERT(fd == fdp.fifo_ui_wcmd);
+        RPS_ASSERT(rev & EPOLLOUT);
+        RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
+        RPS_FATALOUT("missing code to handle JSONRPC output commands to fd#"
+                     << fd);
+        /* TODO: write the bytes that are in rps_jsonrpc_cmdbuf */
 #warning missing code to handle JsonRpc output to the GUI process
-          };
-        };
-      if (fdp.fifo_ui_rout>0)
-        {
-          /// JSONRPC responses/events sent by the GUI process to RefPerSys
-          RPS_ASSERT(nbfdpoll<RPS_MAXPOLL_FD);
-          int pix = nbfdpoll++;
-          pollarr[pix].fd = fdp.fifo_ui_rout;
-          pollarr[pix].events = POLLIN;
-          EXPLAIN_EVFD_RPS(pix, "JsonRpc responses from GUI");
-          handlarr[pix] = [&](Rps_CallFrame* cf, int fd, short rev)
+      });
+    };
+  if (fdp.fifo_ui_rout>0)
+    {
+      /// JSONRPC responses/events sent by the GUI process to RefPerSys
+      rps_event_loop_add_fd(fdp.fifo_ui_rout, EPOLLIN, "JsonRpc responses from GUI",
+                            [=](Rps_CallFrame* cf, int fd, uint32_t rev)
+      {
+        char buf[1024];
+        RPS_ASSERT(fd == fdp.fifo_ui_rout);
+        RPS_ASSERT(rev & EPOLLIN);
+        RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
+        /// the FIFO is non-blocking and edge-triggered, so is read
+        /// till EAGAIN
+        long nbtot = 0;
+        for (;;)
           {
-            char buf[1024];
-            RPS_ASSERT(fd ==  pollarr[pix].fd);
-            RPS_ASSERT(rev == POLLIN);
-            RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
-            /* TODO: should read(2) */
             memset(buf, 0, sizeof(buf));
             int nbr = read(fd, buf, sizeof(buf));
+            if (nbr < 0 && errno == EINTR)
+              continue;
             if (nbr < 0)
-              return;
+              break;
             if (nbr == 0)
               {
                 RPS_FATALOUT("missing code to handle JSONRPC input EOF from fd#"
-                             << fd << " pix#" << pix);
+                             << fd);
 #warning missing code to handle JsonRpc EOF from GUI process
               }
-            /* TODO: append the bytes we did read to
-               rps_jsonrpc_rspbuf; by convention a double newline or a
-               formfeed is ending the JSON message. */
+            /* TODO: by convention a double newline or a formfeed is
+               ending the JSON message in rps_jsonrpc_rspbuf. */
             {
-              std::lock_guard<std::mutex> gu(rps_jsonrpc_mtx);
+              Rps_NoSafepointLock<std::mutex> gu(rps_jsonrpc_mtx);
 #warning oldbufsiz need a code review
               std::size_t oldbufsiz= rps_jsonrpc_rspbuf.in_avail();
               std::size_t oldprevix = (oldbufsiz>0)?(oldbufsiz-1):0;
@@ -325,183 +486,106 @@ rps_event_loop(void)
               /// oldprevix
 #warning missing code to handle JsonRpc input from the GUI process
             }
-            RPS_FATALOUT("missing code to handle JSONRPC input responses from fd#"
-                         << fd << " pix#" << pix
-                         << " did read " << nbr << " bytes");
-          };
-        };
-      if (rps_eventloopdata.eld_sigfd>0)
-        {
-          /// signals transformed to data with signalfd(2)
-          RPS_ASSERT(nbfdpoll<RPS_MAXPOLL_FD);
-          int pix = nbfdpoll++;
-          pollarr[pix].fd = rps_eventloopdata.eld_sigfd;
-          pollarr[pix].events = POLLIN;
-          EXPLAIN_EVFD_RPS(pix, "signalfd");
-          handlarr[pix] = [&](Rps_CallFrame* cf, int fd, short rev)
+            nbtot += nbr;
+          }
+        if (nbtot == 0)
+          return;
+        RPS_FATALOUT("missing code to handle JSONRPC input responses from fd#"
+                     << fd << " did read " << nbtot << " bytes");
+      });
+    };
+  /// signals transformed to data with signalfd(2)
+  rps_event_loop_add_fd(rps_eventloopdata.eld_sigfd, EPOLLIN, "signalfd",
+                        [](Rps_CallFrame* cf, int fd, uint32_t rev)
+  {
+    RPS_ASSERT(fd == rps_eventloopdata.eld_sigfd);
+    RPS_ASSERT(rev & EPOLLIN);
+    RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
+    long loopcnt = event_nbloops.load();
+    for (;;)
+      {
+        struct signalfd_siginfo infsig;
+        memset(&infsig, 0, sizeof(infsig));
+        int nbr = read(fd, (void*)&infsig, sizeof(infsig));
+        if (nbr < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+          break;
+        if (nbr != sizeof(infsig))
+          RPS_FATALOUT("signalfd read failure on fd#" << fd << " got " << nbr << " bytes, expecting " << sizeof(infsig)
+                       << ":" << strerror(errno));
+        std::int32_t scod= infsig.ssi_code;
+        pid_t origpid= infsig.ssi_pid;
+        std::int32_t status= infsig.ssi_status;
+        int signum= infsig.ssi_signo;
+        RPS_DEBUG_LOG(REPL, "eventloop sigfd signal#" << signum << ":" << strsignal(signum)
+                      << " scod:" << scod << " origpid:"<< origpid << " status:" << status);
+        switch (infsig.ssi_signo)
           {
-            struct signalfd_siginfo infsig;
-            memset(&infsig, 0, sizeof(infsig));
-            RPS_ASSERT(fd ==  pollarr[pix].fd && fd == rps_eventloopdata.eld_sigfd);
-            RPS_ASSERT(rev == POLLIN);
-            RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
-            int nbr = read(fd, (void*)&infsig, sizeof(infsig));
-            if (nbr != sizeof(infsig))
-              RPS_FATALOUT("signalfd read failure on fd#" << fd << " pix#" << pix << " got " << nbr << " bytes, expecting " << sizeof(infsig)
-                           << ":" << strerror(errno));
-            std::int32_t scod= infsig.ssi_code;
-            pid_t origpid= infsig.ssi_pid;
-            std::int32_t status= infsig.ssi_status;
-            int signum= infsig.ssi_signo;
-            RPS_DEBUG_LOG(REPL, "eventloop sigfd signal#" << signum << ":" << strsignal(signum)
-                          << " scod:" << scod << " origpid:"<< origpid << " status:" << status);
-            switch (infsig.ssi_signo)
-              {
-              case SIGTERM:
-              {
-                RPS_INFORMOUT("event loop#"<< loopcnt
-                              << " got SIGTERM from pid " << origpid);
-                rps_stop_event_loop_flag.store(true);
-              };
-              break;
-              case SIGINT:
-              {
-                RPS_INFORMOUT("event loop#" << loopcnt
-                              << " got SIGINT from pid " << origpid);
-                rps_stop_event_loop_flag.store(true);
-              };
-              break;
-              case SIGQUIT:
-              {
-                RPS_INFORMOUT("event loop#" << loopcnt
-                              << " got SIGQUIT from pid " << origpid);
-                rps_stop_event_loop_flag.store(true);
-              };
-              break;
-              case SIGCHLD:
-              {
-                RPS_INFORMOUT("event loop#" << loopcnt
-                              << " got SIGCHLD from pid " << origpid << " status:" << status);
-              };
-              break;
-              default:
-                RPS_FATALOUT("event loop#" << loopcnt
-                             << " got unexpected signal#" << signum << ":" << strsignal(signum));
-              };
-#warning missing code to handle signalfd...
+          case SIGTERM:
+          {
+            RPS_INFORMOUT("event loop#"<< loopcnt
+                          << " got SIGTERM from pid " << origpid);
+            rps_stop_event_loop_flag.store(true);
           };
-        }
-      if (rps_eventloopdata.eld_timfd>0)
-        {
-          /// timers transformed to data with timerfd_create(2)
-          RPS_ASSERT(nbfdpoll<RPS_MAXPOLL_FD);
-          int pix = nbfdpoll++;
-          pollarr[pix].fd = rps_eventloopdata.eld_timfd;
-          pollarr[pix].events = POLLIN;
-          EXPLAIN_EVFD_RPS(pix, "timerfd");
-          handlarr[pix] = [&](Rps_CallFrame*cf, int fd, short rev)
+          break;
+          case SIGINT:
           {
-            RPS_ASSERT(fd ==  pollarr[pix].fd);
-            RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
-            RPS_ASSERT(rev == POLLIN);
-            uint64_t timbuf[16];
-            memset (&timbuf, 0, sizeof(timbuf));
-            int nbr = read(fd, (void*)&timbuf, sizeof(timbuf));
-            if (nbr>0)
-              {
-                RPS_DEBUG_LOG(REPL, "eventloop read " << nbr << " bytes on timerfd, so " << (nbr/sizeof(std::uint64_t)) << " int64s: "
-                              << Rps_Do_Output([=](std::ostream& out)
-                {
-                  for (int ix=0; ix< (int) (nbr/sizeof(std::uint64_t)); ix++)
-                    out << ' ' << timbuf[ix];
-                }
-                                              )
-                    << std::flush);
-              }
-#warning some missing code to handle timerfd...
+            RPS_INFORMOUT("event loop#" << loopcnt
+                          << " got SIGINT from pid " << origpid);
+            rps_stop_event_loop_flag.store(true);
           };
-        };
-      if (rps_eventloopdata.eld_selfpipereadfd>0)
-        {
-          RPS_ASSERT(nbfdpoll<RPS_MAXPOLL_FD);
-          int pix = nbfdpoll++;
-          pollarr[pix].fd = rps_eventloopdata.eld_selfpipereadfd;
-          pollarr[pix].events = POLLIN;
-          EXPLAIN_EVFD_RPS(pix, "self_pipe_read_fd");
-          handlarr[pix] = [&](Rps_CallFrame* cf, int fd, short rev)
+          break;
+          case SIGQUIT:
           {
-            unsigned char buf[128];
-            RPS_ASSERT(fd == rps_eventloopdata.eld_selfpipereadfd);
-            RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
-            RPS_ASSERT(rev == POLLIN);
-            /* TODO: should read(2) */
-            memset(buf, 0, sizeof(buf));
-            int nbr = read(fd, buf, sizeof(buf));
-            if (nbr > 0)
-              for (int i = 0; i<nbr; i++)
-                handle_self_pipe_byte_rps(buf[i]);
+            RPS_INFORMOUT("event loop#" << loopcnt
+                          << " got SIGQUIT from pid " << origpid);
+            rps_stop_event_loop_flag.store(true);
           };
-        };
-      bool wantselfwrite = false;
-      {
-        std::lock_guard<std::mutex> gu(rps_eventloopdata.eld_mtx);
-        wantselfwrite = !rps_eventloopdata.eld_selfpipefifo.empty();
-      }
-      if (rps_eventloopdata.eld_selfpipewritefd>0 && wantselfwrite)
-        {
-          RPS_ASSERT(nbfdpoll<RPS_MAXPOLL_FD);
-          int pix = nbfdpoll++;
-          pollarr[pix].fd = rps_eventloopdata.eld_selfpipewritefd;
-          pollarr[pix].events = POLLOUT;
-          EXPLAIN_EVFD_RPS(pix, "self_pipe_write_fd");
-          handlarr[pix] = [&](Rps_CallFrame* cf, int fd, short rev)
+          break;
+          case SIGCHLD:
           {
-            RPS_ASSERT(fd == rps_eventloopdata.eld_selfpipewritefd);
-            RPS_ASSERT(rev == POLLOUT);
-            RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
-            std::lock_guard<std::mutex> gu(rps_eventloopdata.eld_mtx);
-            while (!rps_eventloopdata.eld_selfpipefifo.empty())
-              {
-                unsigned char b = rps_eventloopdata.eld_selfpipefifo.back();
-                if (write(fd, &b, 1) > 0)
-                  rps_eventloopdata.eld_selfpipefifo.pop_back();
-                else
-                  break;
-              };
+            RPS_INFORMOUT("event loop#" << loopcnt
+                          << " got SIGCHLD from pid " << origpid << " status:" << status);
           };
-        };
+          break;
+          default:
+            RPS_FATALOUT("event loop#" << loopcnt
+                         << " got unexpected signal#" << signum << ":" << strsignal(signum));
+          };
+#warning missing code to handle signalfd...
+      }
+  });
+  /// timers transformed to data with timerfd_create(2)
+  rps_event_loop_add_fd(rps_eventloopdata.eld_timfd, EPOLLIN, "timerfd",
+                        [](Rps_CallFrame*cf, int fd, uint32_t rev)
+  {
+    RPS_ASSERT(fd == rps_eventloopdata.eld_timfd);
+    RPS_ASSERT(cf != nullptr && cf->is_good_call_frame());
+    RPS_ASSERT(rev & EPOLLIN);
+    uint64_t nbexpir = 0;
+    int nbr = read(fd, (void*)&nbexpir, sizeof(nbexpir));
+    /// the wheel is advanced even on a spurious wakeup, since the
+    /// realtime clock could have been set
+    RPS_DEBUG_LOG(EVENT_LOOP, "eventloop read " << nbr << " bytes on timerfd, expirations "
+                  << nbexpir << " with "
+                  << rps_eventloopdata.eld_timerwheel.size() << " timers");
+    rps_eventloopdata.eld_timerwheel.advance(rps_wallclock_real_time());
+  });
+  /*** give output
+   ***/
+  RPS_INFORMOUT("starting rps_event_loop in pid " << (int)getpid() << " on " << rps_hostname()
+                << " git " << rps_shortgitid << std::endl
+                << RPS_FULL_BACKTRACE_HERE(1, "rps_event_loop")
+               );
+  event_loop_is_active.store(true);
+  struct epoll_event evarr[RPS_EPOLL_MAXEVENTS];
+  while (!rps_stop_event_loop_flag.load())
+    {
+      char elapsbuf[32];
+      memset(elapsbuf, 0, sizeof(elapsbuf));
+      event_nbloops.fetch_add(1);
       bool debugpoll = RPS_DEBUG_ENABLED(REPL) //
                        || RPS_DEBUG_ENABLED(EVENT_LOOP) //
                        || RPS_DEBUG_ENABLED(GUI);
-      if (debugpoll)
-        {
-          char pidbuf[16];
-          memset(pidbuf, 0, sizeof(pidbuf));
-          if (event_nbloops.load() % 10)
-            snprintf(pidbuf, sizeof(pidbuf)-1, " pid %d", (int)getpid());
-          for (int pix=0; pix<nbfdpoll; pix++)
-            {
-              std::string evstr;
-              if (pollarr[pix].events & POLLIN)
-                evstr += " POLLIN";
-              if (pollarr[pix].events & POLLOUT)
-                evstr += " POLLOUT";
-              if (pollarr[pix].events & POLLPRI)
-                evstr += " POLLPRI";
-              if (pollarr[pix].events & POLLRDHUP)
-                evstr += " POLLRDHUP";
-              if (pollarr[pix].events & POLLERR)
-                evstr += " POLLERR";
-              if (pollarr[pix].events & POLLHUP)
-                evstr += " POLLHUP";
-              if (pollarr[pix].events & POLLNVAL)
-                evstr += " POLLNVAL";
-              rps_debug_printf_at(__FILE__,__LINE__,RPS_DEBUG__EVERYTHING,
-                                  "poll[%d] loop%ld:fd#%d:%s,%s%s\n",
-                                  pix, event_nbloops.load(), pollarr[pix].fd,
-                                  explarr[pix], evstr.c_str(), pidbuf);
-            }
-        };
       errno = 0;
       if (Rps_Agenda::agenda_timeout > 0
           && rps_elapsed_real_time() >= Rps_Agenda::agenda_timeout)
@@ -514,61 +598,46 @@ rps_event_loop(void)
         };
       fflush(nullptr);
       errno = 0;
-      int respoll = poll(pollarr, nbfdpoll, (rps_poll_delay_millisec*(debugpoll?3:1)));
+      int nbready = epoll_wait(rps_eventloopdata.eld_epollfd, evarr, RPS_EPOLL_MAXEVENTS,
+                               (rps_poll_delay_millisec*(debugpoll?3:1)));
       pollcount++;
       if (pollcount %2 && debugpoll)
         snprintf(elapsbuf, sizeof(elapsbuf), " elti: %.3fs", rps_elapsed_real_time());
       RPS_DEBUG_LOG(REPL, "rps_event_loop pollcount#"
-                    << pollcount << " respoll=" << respoll
-                    << " nbfdpoll=" << nbfdpoll);
-      if (respoll>0)
+                    << pollcount << " nbready=" << nbready);
+      if (nbready>0)
         {
           if (debugpoll)
             rps_debug_printf_at(__FILE__,__LINE__,RPS_DEBUG__EVERYTHING,
-                                "respoll=%d loop%ld%s\n", respoll, event_nbloops.load(), elapsbuf);
-          int nbrev=0;
-          for (int pix=0; pix<nbfdpoll; pix++)
+                                "nbready=%d loop%ld%s\n", nbready, event_nbloops.load(), elapsbuf);
+          for (int eix=0; eix<nbready; eix++)
             {
-              if (pollarr[pix].revents != 0)
-                {
-                  nbrev++;
-                  if (debugpoll)
-                    {
-                      std::string evstr;
-                      if (pollarr[pix].revents & POLLIN)
-                        evstr += " POLLIN";
-                      if (pollarr[pix].revents & POLLOUT)
-                        evstr += " POLLOUT";
-                      if (pollarr[pix].revents & POLLPRI)
-                        evstr += " POLLPRI";
-                      if (pollarr[pix].revents & POLLRDHUP)
-                        evstr += " POLLRDHUP";
-                      if (pollarr[pix].revents & POLLERR)
-                        evstr += " POLLERR";
-                      if (pollarr[pix].revents & POLLHUP)
-                        evstr += " POLLHUP";
-                      if (pollarr[pix].revents & POLLNVAL)
-                        evstr += " POLLNVAL";
-                      rps_debug_printf_at(__FILE__,__LINE__,RPS_DEBUG__EVERYTHING,
-                                          "polled[%d]:fd#%d:%s>%s\n",
-                                          pix, pollarr[pix].fd, explarr[pix], evstr.c_str());
-                    }
-                  if (handlarr[pix])
-                    handlarr[pix](&_, pollarr[pix].fd, pollarr[pix].revents);
-                  else
-                    usleep((5+(pix & 0xf))*1024);
-                };
+              int fd = (int)(uint32_t)evarr[eix].data.u64;
+              uint32_t serial = (uint32_t)(evarr[eix].data.u64 >> 32);
+              std::shared_ptr<rps_fdwatcher_st> watcher;
+              {
+                Rps_NoSafepointLock<std::mutex> gu(rps_eventloopdata.eld_mtx);
+                auto it = rps_eventloopdata.eld_watchers.find(fd);
+                if (it != rps_eventloopdata.eld_watchers.end()
+                    && it->second->fdw_serial == serial)
+                  watcher = it->second;
+              }
+              /// removed by a previous handler of this wakeup
+              if (!watcher)
+                continue;
+              if (debugpoll)
+                rps_debug_printf_at(__FILE__,__LINE__,RPS_DEBUG__EVERYTHING,
+                                    "ready[%d]:fd#%d:%s>%s\n",
+                                    eix, fd, watcher->fdw_explanation,
+                                    rps_epoll_events_string(evarr[eix].events).c_str());
+              watcher->fdw_handler(&_, fd, evarr[eix].events);
             };
-          if (debugpoll)
-            rps_debug_printf_at(__FILE__,__LINE__,RPS_DEBUG__EVERYTHING,
-                                "respoll=%d nbrev=%d event_nbloops=%ld\n",
-                                respoll, nbrev, event_nbloops.load());
         }
-      else if (respoll==0)   // timed out poll
+      else if (nbready==0)   // timed out epoll
         {
           if (debugpoll)
             rps_debug_printf_at(__FILE__,__LINE__,RPS_DEBUG__EVERYTHING,
-                                "poll timeout loop%ld\n", event_nbloops.load());
+                                "epoll timeout loop%ld\n", event_nbloops.load());
         }
       else if (errno != EINTR)
         RPS_FATALOUT("rps_event_loop failure : " << strerror(errno));
@@ -576,13 +645,16 @@ rps_event_loop(void)
         {
           if (debugpoll)
             rps_debug_printf_at(__FILE__,__LINE__,RPS_DEBUG__EVERYTHING,
-                                "poll interrupt loop%ld\n", event_nbloops.load());
+                                "epoll interrupt loop%ld\n", event_nbloops.load());
         };
       fflush(nullptr);
     };       // end while not rps_stop_event_loop_flag
+  event_loop_is_active.store(false);
   /*TODO: cooperation with transientobj_rps.cc ... */
 #warning incomplete rps_event_loop see related file transientobj_rps.cc, missing code
-  /*TODO: use Rps_PayloadUnixProcess::do_on_active_process_queue to collect file descriptors inside such payloads */
+  /*TODO: use Rps_PayloadUnixProcess::do_on_active_process_queue to
+    watch, with rps_event_loop_add_fd, the file descriptors inside
+    such payloads */
 
   double endelapsedtime=rps_elapsed_real_time();
   double endcputime=rps_process_cpu_time();
@@ -592,9 +664,6 @@ rps_event_loop(void)
                 << " git " << rps_shortgitid << std::endl
                 << RPS_FULL_BACKTRACE_HERE(1, "rps_event_loop")
                );
-#undef EXPLAIN_EVFD_AT
-#undef EXPLAIN_EVFD_ATBIS
-#undef EXPLAIN_EVFD_RPS
 } // end rps_event_loop
 
 void
@@ -605,15 +674,23 @@ handle_self_pipe_byte_rps(unsigned char b)
   switch (b)
     {
     case SelfPipe_Dump:
-      rps_dump_into (rps_get_loaddir());
+      if (rps_background_dump)
+        rps_start_background_dump(rps_get_loaddir());
+      else
+        rps_dump_into (rps_get_loaddir());
+      break;
+    case SelfPipe_DumpDone:
+      rps_finish_background_dump();
       break;
     case SelfPipe_GarbColl:
       rps_garbage_collect();
       break;
     case SelfPipe_Quit:
+      rps_finish_background_dump();
       rps_stop_event_loop_flag.store(true);
       break;
     case SelfPipe_Exit:
+      rps_finish_background_dump();
       rps_dump_into (rps_get_loaddir());
       rps_stop_event_loop_flag.store(true);
       break;
@@ -655,6 +732,12 @@ rps_postpone_dump(void)
   rps_self_pipe_write_byte(SelfPipe_Dump);
 } // end rps_postpone_dump
 
+void
+rps_postpone_dump_completion(void)
+{
+  rps_self_pipe_write_byte(SelfPipe_DumpDone);
+} // end rps_postpone_dump_completion
+
 void
 rps_postpone_garbage_collection(void)
 {
@@ -41,12 +41,22 @@ const char rps_garbcoll_date[]= __DATE__;
 
 std::atomic<Rps_GarbageCollector*> Rps_GarbageCollector::gc_this_;
 std::atomic<uint64_t> Rps_GarbageCollector::gc_count_;
+std::atomic<int> Rps_GarbageCollector::gc_nbhelpers_;
+std::mutex Rps_GarbageCollector::gc_rememberedmtx_;
+std::vector<Rps_ZoneValue*> Rps_GarbageCollector::gc_remembered_;
+std::atomic<unsigned> Rps_GarbageCollector::gc_nbminor_;
 
-Rps_GarbageCollector::Rps_GarbageCollector(const std::function<void(Rps_GarbageCollector*)> &rootmarkers) :
-  gc_mtx(), gc_running(false), gc_magic(_gc_magicnum_),
+/// the index of the scan queue of the current marking thread
+static thread_local int rps_gc_marker_ix;
+
+Rps_GarbageCollector::Rps_GarbageCollector(const std::function<void(Rps_GarbageCollector*)> &rootmarkers,
+    bool minor) :
+  gc_mtx(), gc_running(false), gc_minor(minor), gc_magic(_gc_magicnum_),
   gc_rootmarkers(rootmarkers),
-  gc_obscanque(),
+  gc_scanqueues(),
+  gc_marking(false), gc_nbactivemarkers(0),
   gc_nbscan(0), gc_nbmark(0), gc_nbdelete(0), gc_nbroots(0),
+  gc_nbfreedpages(0),
   gc_startrealtime(rps_wallclock_real_time()),
   gc_startelapsedtime(rps_elapsed_real_time()),
   gc_startprocesstime(rps_process_cpu_time())
@@ -62,8 +72,11 @@ Rps_GarbageCollector::~Rps_GarbageCollector()
   RPS_ASSERT(is_valid_garbcoll());
   RPS_ASSERT(gc_this_.load() == this);
   RPS_ASSERT(gc_running.load() == false);
-  RPS_ASSERT(gc_obscanque.empty());
+  RPS_ASSERT(gc_marking.load() == false);
   gc_this_.store(nullptr);
+  /// a late helper could still be looking at us
+  while (gc_nbhelpers_.load() > 0)
+    std::this_thread::yield();
   gc_magic = 0;
 } // end Rps_GarbageCollector::~Rps_GarbageCollector
 
@@ -95,6 +108,7 @@ Rps_CallFrame::gc_mark_frame(Rps_GarbageCollector* gc)
 
 
 std::atomic<int> Rps_ProtoCallFrame::_cfram_output_depth_(16);
+thread_local Rps_ProtoCallFrame* Rps_ProtoCallFrame::_cfram_thread_top_;
 
 void // this is Rps_ProtoCallFrame::output
 Rps_CallFrame::output(std::ostream&out, unsigned depth, unsigned maxdepth) const
@@ -116,22 +130,33 @@ Rps_CallFrame::output(std::ostream&out, unsigned depth, unsigned maxdepth) const
     cfram_prev->output(out, depth+1, maxdepth);
 } // end of Rps_CallFrame::output i.e. Rps_ProtoCallFrame::output
 
+/// A minor collection traces only the young zones, from the roots and
+/// the remembered set; every few minor collections a major one is
+/// done instead.
 void
-rps_garbage_collect (std::function<void(Rps_GarbageCollector*)>* pfun)
+rps_garbage_collect (std::function<void(Rps_GarbageCollector*)>* pfun, bool minor)
 {
   RPS_ASSERT(Rps_GarbageCollector::gc_this_.load() == nullptr);
+  if (minor
+      && Rps_GarbageCollector::gc_nbminor_.load() >= Rps_GarbageCollector::gc_major_period)
+    minor = false;
+  if (minor)
+    Rps_GarbageCollector::gc_nbminor_.fetch_add(1);
+  else
+    Rps_GarbageCollector::gc_nbminor_.store(0);
   Rps_GarbageCollector the_gc([=](Rps_GarbageCollector*gc)
   {
     if (pfun)
       (*pfun)(gc);
-  });
+  }, minor);
   auto gcnt = Rps_GarbageCollector::gc_count_.load();
-  RPS_INFORM("rps_garbage_collect before run; count#%ld",
-             gcnt);
+  RPS_INFORM("rps_garbage_collect before %s run; count#%ld",
+             minor?"minor":"major", gcnt);
   the_gc.run_gc();
   auto nbroots = the_gc.nb_roots();
-  RPS_INFORM("rps_garbage_collect completed; count#%ld, %ld roots, %ld scans, %ld marks, %ld deletions, real %.3f, cpu %.3f sec",
+  RPS_INFORM("rps_garbage_collect completed; count#%ld, %ld roots, %ld scans, %ld zones, %ld swept deletions, %ld freed pages, real %.3f, cpu %.3f sec",
              gcnt, (long) nbroots, (long)(the_gc.nb_scans()),  (long)(the_gc.nb_marks()),  (long)(the_gc.nb_deletions()),
+             (long)(the_gc.nb_freed_pages()),
              the_gc.elapsed_time(), the_gc.process_time());
 } // end of rps_garbage_collect
 
@@ -140,12 +165,173 @@ Rps_GarbageCollector::mark_obj(Rps_ObjectRef ob)
 {
   if (!ob) return;
   RPS_ASSERT(gc_running.load());
-  if (!ob->is_gcmarked(*this))
+  if (ob->test_and_set_gcmark(*this))
+    return;
+  /// old objects are kept by minor collections, without being scanned
+  if (gc_minor && ob->is_old_zone())
+    return;
+  auto& scanq = gc_scanqueues[rps_gc_marker_ix];
+  std::lock_guard<std::mutex> gu(scanq.gsq_mtx);
+  scanq.gsq_deque.push_back(ob);
+  scanq.gsq_size.store(scanq.gsq_deque.size());
+} // end of Rps_GarbageCollector::mark_obj
+
+
+/// scan an old object in a minor collection, even if it was already
+/// marked; scanning twice the same object is harmless
+void
+Rps_GarbageCollector::scan_old_obj(Rps_ObjectZone*ob)
+{
+  RPS_ASSERT(ob != nullptr);
+  RPS_ASSERT(gc_running.load());
+  ob->set_gcmark(*this);
+  auto& scanq = gc_scanqueues[rps_gc_marker_ix];
+  std::lock_guard<std::mutex> gu(scanq.gsq_mtx);
+  scanq.gsq_deque.push_back(Rps_ObjectRef(ob));
+  scanq.gsq_size.store(scanq.gsq_deque.size());
+} // end of Rps_GarbageCollector::scan_old_obj
+
+
+void
+Rps_GarbageCollector::remember_zone(Rps_ZoneValue*zv)
+{
+  RPS_ASSERT(zv != nullptr);
+  std::lock_guard<std::mutex> gu(gc_rememberedmtx_);
+  gc_remembered_.push_back(zv);
+} // end of Rps_GarbageCollector::remember_zone
+
+
+/// take the remembered set filled since the previous collection; a
+/// minor collection scans it as additional roots. Remembered tree
+/// zones are scanned at once, since they never go in scan queues.
+void
+Rps_GarbageCollector::mark_remembered_set(void)
+{
+  std::vector<Rps_ZoneValue*> remvec;
+  {
+    std::lock_guard<std::mutex> gu(gc_rememberedmtx_);
+    remvec.swap(gc_remembered_);
+  }
+  for (Rps_ZoneValue*zv: remvec)
     {
-      ob->set_gcmark(*this);
-      gc_obscanque.push_back(ob);
+      zv->qz_gcinfo.fetch_and(~Rps_QuasiZone::qz_gcremember_bit);
+      if (!gc_minor)
+        continue;
+      if (zv->stored_type() == Rps_Type::Object)
+        {
+          auto ob = static_cast<Rps_ObjectZone*>(zv);
+          if (ob->is_old_zone())
+            scan_old_obj(ob);
+          else
+            mark_obj(Rps_ObjectRef(ob));
+        }
+      else if (zv->is_old_zone())
+        {
+          zv->set_gcmark(*this);
+          zv->gc_mark(*this, 0);
+        }
+      else
+        mark_value(Rps_Value(zv));
     }
-} // end of Rps_GarbageCollector::mark_obj
+} // end of Rps_GarbageCollector::mark_remembered_set
+
+
+/// steal the oldest object of some other non-empty scan queue
+bool
+Rps_GarbageCollector::steal_scanned_object(int qix, Rps_ObjectRef& obr)
+{
+  constexpr int nbqueues = RPS_NBJOBS_MAX+2;
+  for (int off=1; off<nbqueues; off++)
+    {
+      auto& victimq = gc_scanqueues[(qix+off) % nbqueues];
+      if (victimq.gsq_size.load() == 0)
+        continue;
+      std::lock_guard<std::mutex> gu(victimq.gsq_mtx);
+      if (victimq.gsq_deque.empty())
+        continue;
+      obr = victimq.gsq_deque.front();
+      victimq.gsq_deque.pop_front();
+      victimq.gsq_size.store(victimq.gsq_deque.size());
+      return true;
+    }
+  return false;
+} // end Rps_GarbageCollector::steal_scanned_object
+
+
+/// The marking loop of every marking thread. A marker becomes
+/// inactive only once its own queue is empty, and only a marker
+/// pushes into its own queue, so when no marker is active every
+/// queue is empty and marking is complete.
+void
+Rps_GarbageCollector::drain_scan_queues(int qix)
+{
+  RPS_ASSERT(qix >= 0 && qix < RPS_NBJOBS_MAX+2);
+  RPS_ASSERT(rps_gc_marker_ix == qix);
+  auto& ownq = gc_scanqueues[qix];
+  for (;;)
+    {
+      Rps_ObjectRef obr;
+      bool gotob = false;
+      {
+        std::lock_guard<std::mutex> gu(ownq.gsq_mtx);
+        if (!ownq.gsq_deque.empty())
+          {
+            obr = ownq.gsq_deque.back();
+            ownq.gsq_deque.pop_back();
+            ownq.gsq_size.store(ownq.gsq_deque.size());
+            gotob = true;
+          }
+      }
+      if (!gotob)
+        gotob = steal_scanned_object(qix, obr);
+      if (gotob)
+        {
+          RPS_ASSERT(obr);
+          obr->mark_gc_inside(*this);
+          ownq.gsq_nbscan++;
+          continue;
+        }
+      gc_nbactivemarkers.fetch_sub(1);
+      for (;;)
+        {
+          if (gc_nbactivemarkers.load() == 0)
+            return;
+          bool somework = false;
+          for (auto& curq: gc_scanqueues)
+            if (curq.gsq_size.load() > 0)
+              {
+                somework = true;
+                break;
+              }
+          if (somework)
+            {
+              gc_nbactivemarkers.fetch_add(1);
+              break;
+            }
+          std::this_thread::yield();
+        }
+    }
+} // end Rps_GarbageCollector::drain_scan_queues
+
+
+void
+Rps_GarbageCollector::help_marking(int ix)
+{
+  RPS_ASSERT(ix > 0 && ix < RPS_NBJOBS_MAX+2);
+  /// increment the helper count before looking at gc_this_, so the
+  /// destructor of the collector waits for us
+  gc_nbhelpers_.fetch_add(1);
+  Rps_GarbageCollector*gc = gc_this_.load();
+  if (gc && gc->gc_marking.load())
+    {
+      RPS_ASSERT(gc->is_valid_garbcoll());
+      gc->gc_nbactivemarkers.fetch_add(1);
+      rps_gc_marker_ix = ix;
+      gc->drain_scan_queues(ix);
+      rps_gc_marker_ix = 0;
+    }
+  gc_nbhelpers_.fetch_sub(1);
+} // end Rps_GarbageCollector::help_marking
 
 void
 Rps_GarbageCollector::mark_gcroots(void)
@@ -178,6 +364,10 @@ Rps_GarbageCollector::mark_gcroots(void)
     this->mark_root_objectref(rpskob##Oid); \
 };
   Rps_PayloadUnixProcess::gc_mark_active_processes(*this);
+  Rps_Journal::gc_mark(*this);
+  rps_load_gc_mark(*this);
+  rps_event_loop_gc_mark(*this);
+  rps_dump_gc_mark(*this);
 #include "generated/rps-constants.hh"
   ///
   if (gc_rootmarkers)
@@ -190,33 +380,63 @@ Rps_GarbageCollector::run_gc(void)
 {
   RPS_ASSERT(!gc_running.load());
   gc_running.store(true);
+  /// the lazy sweep of the previous collection should be complete
+  /// before marks are cleared
+  if (Rps_QuasiZone::is_sweeping())
+    {
+      uint64_t oldnbswept = Rps_QuasiZone::nb_swept_zones();
+      uint64_t oldnbreleased = Rps_ZoneArena::nb_released_pages();
+      Rps_QuasiZone::finish_sweep();
+      gc_nbdelete = Rps_QuasiZone::nb_swept_zones() - oldnbswept;
+      gc_nbfreedpages = Rps_ZoneArena::nb_released_pages() - oldnbreleased;
+    }
+  Rps_QuasiZone::clear_all_gcmarks(*this);
+  double marktime = 0.0;
+  /// zones allocated from now on by other threads are born marked, so
+  /// are kept by this collection
   Rps_QuasiZone::run_locked_gc
   (*this,
-   [] (Rps_GarbageCollector&gc)
+   [&] (Rps_GarbageCollector&gc)
   {
-    Rps_QuasiZone::clear_all_gcmarks(gc);
+    double markstart = rps_monotonic_real_time();
+    /// the collecting thread uses scan queue 0; agenda workers parked
+    /// in GC state may steal from it as soon as we start marking
+    RPS_ASSERT(rps_gc_marker_ix == 0);
+    gc.gc_nbactivemarkers.store(1);
+    gc.gc_marking.store(true);
+    gc.mark_remembered_set();
     gc.mark_gcroots();
     Rps_PayloadSymbol::gc_mark_strong_symbols(&gc);
-    while (!gc.gc_obscanque.empty())
+    gc.drain_scan_queues(0);
+    gc.gc_marking.store(false);
+    marktime = rps_monotonic_real_time() - markstart;
+    /// wait for helpers to leave the mark phase before sweeping
+    while (gc_nbhelpers_.load() > 0)
+      std::this_thread::yield();
+    for (auto& curq: gc.gc_scanqueues)
       {
-        auto obfront = gc.gc_obscanque.front();
-        gc.gc_obscanque.pop_front();
-        RPS_ASSERT(obfront);
-        obfront->mark_gc_inside(gc);
-        gc.gc_nbscan++;
-      };
-  });
-  Rps_QuasiZone::every_zone
-  (*this,
-   [] (Rps_GarbageCollector&gc, Rps_QuasiZone*qz)
-  {
-    gc.gc_nbmark++;
-    if (qz->is_gcmarked(gc))
-      return;
-    RPS_ASSERT(Rps_QuasiZone::raw_nth_zone(qz->qz_rank,gc) == qz);
-    delete qz;
-    gc.gc_nbdelete++;
+        RPS_ASSERT(curq.gsq_deque.empty());
+        gc.gc_nbscan += curq.gsq_nbscan;
+        curq.gsq_nbscan = 0;
+      }
+    gc.gc_nbmark = Rps_QuasiZone::nb_zones();
+    /// objects remembered by other threads during marking but found
+    /// dead are swept, so should be forgotten
+    {
+      std::lock_guard<std::mutex> gu(gc_rememberedmtx_);
+      auto& remvec = gc_remembered_;
+      remvec.erase(std::remove_if(remvec.begin(), remvec.end(),
+                                  [&](Rps_ZoneValue*zv)
+      {
+        return !zv->is_gcmarked(gc) && !(gc.gc_minor && zv->is_old_zone());
+      }), remvec.end());
+    }
   });
+  /// the unmarked zones are deleted later, chunk by chunk, by agenda
+  /// workers between their tasklets or by the next collection; so
+  /// the pause depends on the live zones only
+  Rps_GcStatistics::record_collection(*this, marktime);
+  Rps_QuasiZone::start_sweep(*this);
   gc_running.store(false);
 #warning Rps_GarbageCollector::run_gc could be incomplete or wrong
 } // end Rps_GarbageCollector::run_gc
@@ -0,0 +1,568 @@
+/****************************************************************
+ * file gcstats_rps.cc
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Description:
+ *      This file is part of the Reflective Persistent System.
+ *
+ *      It has the garbage collector statistics: pause, mark and
+ *      sweep times of recent collections, live heap per zone type,
+ *      and allocation rate per thread, see class Rps_GcStatistics.
+ *      It also has the pacing policy triggering collections from
+ *      the agenda, see class Rps_GcPacer.
+ *
+ * Author(s):
+ *      Basile Starynkevitch <basile@starynkevitch.net>
+ *      Abhishek Chakravarti <abhishek@taranjali.org>
+ *      Nimesh Neema <nimeshneema@gmail.com>
+ *
+ *      © Copyright 2019 - 2024 The Reflective Persistent System Team
+ *      team@refpersys.org & http://refpersys.org/
+ *
+ * License:
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "refpersys.hh"
+
+
+extern "C" const char rps_gcstats_gitid[];
+const char rps_gcstats_gitid[]= RPS_GITID;
+
+extern "C" const char rps_gcstats_date[];
+const char rps_gcstats_date[]= __DATE__;
+
+// comment for our do-scan-pkgconfig.c utility
+//@@PKGCONFIG jsoncpp
+
+thread_local Rps_GcStatistics::gcs_thread_alloc_st* Rps_GcStatistics::gcs_thralloc;
+std::mutex Rps_GcStatistics::gcs_mtx;
+Rps_GcStatistics::gcs_record_st Rps_GcStatistics::gcs_records[Rps_GcStatistics::gcs_window];
+uint64_t Rps_GcStatistics::gcs_nbrecords;
+uint64_t Rps_GcStatistics::gcs_prevallocwords;
+double Rps_GcStatistics::gcs_prevtime;
+double Rps_GcStatistics::gcs_cumulgctime;
+uint64_t Rps_GcStatistics::gcs_livecount[Rps_GcStatistics::gcs_nb_types];
+uint64_t Rps_GcStatistics::gcs_livewords[Rps_GcStatistics::gcs_nb_types];
+uint64_t Rps_GcStatistics::gcs_lastlivecount[Rps_GcStatistics::gcs_nb_types];
+uint64_t Rps_GcStatistics::gcs_lastlivewords[Rps_GcStatistics::gcs_nb_types];
+std::vector<Rps_GcStatistics::gcs_thread_alloc_st*> Rps_GcStatistics::gcs_threads;
+
+/// The thread allocation counters are never freed, since the
+/// statistics could be output after their thread ended.
+Rps_GcStatistics::gcs_thread_alloc_st*
+Rps_GcStatistics::register_thread_alloc(void)
+{
+  RPS_ASSERT(gcs_thralloc == nullptr);
+  gcs_thread_alloc_st*ta = new gcs_thread_alloc_st;
+  ta->ta_words.store(0);
+  ta->ta_tid = rps_thread_id();
+  memset(ta->ta_name, 0, sizeof(ta->ta_name));
+  pthread_getname_np(pthread_self(), ta->ta_name, sizeof(ta->ta_name));
+  ta->ta_prevwords = 0;
+  ta->ta_rate = 0.0;
+  {
+    std::lock_guard<std::mutex> gu(gcs_mtx);
+    gcs_threads.push_back(ta);
+  }
+  gcs_thralloc = ta;
+  return ta;
+} // end Rps_GcStatistics::register_thread_alloc
+
+const char*
+Rps_GcStatistics::type_name(int tyix)
+{
+  RPS_ASSERT(tyix >= 0 && tyix < (int)gcs_nb_types);
+  switch ((Rps_Type)(tyix + gcs_first_type))
+    {
+#define RPS_GCSTAT_TYPE(Ty) case Rps_Type::Ty: return #Ty
+      RPS_GCSTAT_TYPE(PaylLightCodeGen);
+      RPS_GCSTAT_TYPE(PaylEnviron);
+      RPS_GCSTAT_TYPE(PaylObjMap);
+      RPS_GCSTAT_TYPE(PaylCppStream);
+      RPS_GCSTAT_TYPE(PaylPopenedFile);
+      RPS_GCSTAT_TYPE(PaylUnixProcess);
+      RPS_GCSTAT_TYPE(PaylWebHandler);
+      RPS_GCSTAT_TYPE(PaylWebex);
+      RPS_GCSTAT_TYPE(PaylTasklet);
+      RPS_GCSTAT_TYPE(PaylStringDict);
+      RPS_GCSTAT_TYPE(PaylAgenda);
+      RPS_GCSTAT_TYPE(PaylSymbol);
+      RPS_GCSTAT_TYPE(PaylSpace);
+      RPS_GCSTAT_TYPE(PaylStrBuf);
+      RPS_GCSTAT_TYPE(PaylRelation);
+      RPS_GCSTAT_TYPE(PaylAssoc);
+      RPS_GCSTAT_TYPE(PaylVectVal);
+      RPS_GCSTAT_TYPE(PaylVectOb);
+      RPS_GCSTAT_TYPE(PaylSetOb);
+      RPS_GCSTAT_TYPE(PaylClassInfo);
+      RPS_GCSTAT_TYPE(Int);
+      RPS_GCSTAT_TYPE(None);
+      RPS_GCSTAT_TYPE(String);
+      RPS_GCSTAT_TYPE(Double);
+      RPS_GCSTAT_TYPE(Set);
+      RPS_GCSTAT_TYPE(Tuple);
+      RPS_GCSTAT_TYPE(Object);
+      RPS_GCSTAT_TYPE(Closure);
+      RPS_GCSTAT_TYPE(Instance);
+      RPS_GCSTAT_TYPE(Json);
+      RPS_GCSTAT_TYPE(LexToken);
+#undef RPS_GCSTAT_TYPE
+    default:
+      return "?";
+    }
+} // end Rps_GcStatistics::type_name
+
+/// Called by the collecting thread at end of marking, before the
+/// sweep starts, so sweepers add their times to this record.
+void
+Rps_GcStatistics::record_collection(const Rps_GarbageCollector&gc, double marktime)
+{
+  double now = rps_monotonic_real_time();
+  uint64_t allocw = Rps_QuasiZone::cumulative_allocated_wordcount();
+  std::lock_guard<std::mutex> gu(gcs_mtx);
+  gcs_record_st&rec = gcs_records[gcs_nbrecords % gcs_window];
+  memset((void*)&rec, 0, sizeof(rec));
+  rec.gr_count = Rps_GarbageCollector::gc_count_.load();
+  rec.gr_minor = gc.is_minor();
+  rec.gr_realtime = gc.start_real_time();
+  rec.gr_pause = gc.elapsed_time();
+  rec.gr_mark = marktime;
+  rec.gr_allocwords = allocw - gcs_prevallocwords;
+  gcs_prevallocwords = allocw;
+  gcs_nbrecords++;
+  gcs_cumulgctime += rec.gr_pause;
+  double delta = now - gcs_prevtime;
+  for (gcs_thread_alloc_st*ta : gcs_threads)
+    {
+      uint64_t w = ta->ta_words.load(std::memory_order_relaxed);
+      if (gcs_prevtime > 0.0 && delta > 0.0)
+        ta->ta_rate = (double)(w - ta->ta_prevwords) / delta;
+      ta->ta_prevwords = w;
+    }
+  gcs_prevtime = now;
+} // end Rps_GcStatistics::record_collection
+
+void
+Rps_GcStatistics::add_live_zones(const uint64_t*counts, const uint64_t*words)
+{
+  RPS_ASSERT(counts != nullptr && words != nullptr);
+  std::lock_guard<std::mutex> gu(gcs_mtx);
+  for (unsigned ix=0; ix<gcs_nb_types; ix++)
+    {
+      gcs_livecount[ix] += counts[ix];
+      gcs_livewords[ix] += words[ix];
+    }
+} // end Rps_GcStatistics::add_live_zones
+
+/// sweep time is spent outside of the pause, by agenda workers, but
+/// still counts as garbage collection time
+void
+Rps_GcStatistics::add_sweep_time(double sweeptime)
+{
+  std::lock_guard<std::mutex> gu(gcs_mtx);
+  gcs_cumulgctime += sweeptime;
+  if (gcs_nbrecords > 0)
+    gcs_records[(gcs_nbrecords-1) % gcs_window].gr_sweep += sweeptime;
+} // end Rps_GcStatistics::add_sweep_time
+
+void
+Rps_GcStatistics::end_sweep(void)
+{
+  std::lock_guard<std::mutex> gu(gcs_mtx);
+  uint64_t nbzones = 0, nbwords = 0;
+  for (unsigned ix=0; ix<gcs_nb_types; ix++)
+    {
+      nbzones += gcs_livecount[ix];
+      nbwords += gcs_livewords[ix];
+    }
+  memcpy(gcs_lastlivecount, gcs_livecount, sizeof(gcs_livecount));
+  memcpy(gcs_lastlivewords, gcs_livewords, sizeof(gcs_livewords));
+  memset(gcs_livecount, 0, sizeof(gcs_livecount));
+  memset(gcs_livewords, 0, sizeof(gcs_livewords));
+  if (gcs_nbrecords > 0)
+    {
+      gcs_record_st&rec = gcs_records[(gcs_nbrecords-1) % gcs_window];
+      rec.gr_livezones = nbzones;
+      rec.gr_livewords = nbwords;
+      rec.gr_swept = true;
+    }
+} // end Rps_GcStatistics::end_sweep
+
+double
+Rps_GcStatistics::cumulated_gc_time(void)
+{
+  std::lock_guard<std::mutex> gu(gcs_mtx);
+  return gcs_cumulgctime;
+} // end Rps_GcStatistics::cumulated_gc_time
+
+uint64_t
+Rps_GcStatistics::last_live_words(void)
+{
+  std::lock_guard<std::mutex> gu(gcs_mtx);
+  uint64_t nbwords = 0;
+  for (unsigned ix=0; ix<gcs_nb_types; ix++)
+    nbwords += gcs_lastlivewords[ix];
+  return nbwords;
+} // end Rps_GcStatistics::last_live_words
+
+/// A rolling histogram over the recent collections, bucket B counts
+/// the values V with 2**(B-1) <= V < 2**B, so bucket 0 counts zeros.
+struct rps_gcstat_histogram_st
+{
+  uint64_t gh_buckets[Rps_GcStatistics::gcs_nb_buckets];
+  uint64_t gh_count;
+  uint64_t gh_max;
+  long double gh_sum;
+  void add(uint64_t v)
+  {
+    unsigned b = 0;
+    while (v >> b && b+1 < Rps_GcStatistics::gcs_nb_buckets)
+      b++;
+    gh_buckets[b]++;
+    gh_count++;
+    gh_sum += v;
+    if (v > gh_max)
+      gh_max = v;
+  };
+  Json::Value as_json(void) const
+  {
+    Json::Value jh(Json::objectValue);
+    jh["count"] = (Json::UInt64)gh_count;
+    jh["max"] = (Json::UInt64)gh_max;
+    jh["mean"] = gh_count?(double)(gh_sum/gh_count):0.0;
+    Json::Value jb(Json::arrayValue);
+    for (unsigned b=0; b<Rps_GcStatistics::gcs_nb_buckets; b++)
+      if (gh_buckets[b] > 0)
+        {
+          Json::Value je(Json::objectValue);
+          je["below"] = (Json::UInt64)((uint64_t)1<<b);
+          je["count"] = (Json::UInt64)gh_buckets[b];
+          jb.append(je);
+        }
+    jh["buckets"] = jb;
+    return jh;
+  };
+  void output(std::ostream&out, const char*title, const char*unit) const
+  {
+    out << title << ": " << gh_count << " samples, mean "
+        << (gh_count?(double)(gh_sum/gh_count):0.0)
+        << " " << unit << ", max " << gh_max << " " << unit << std::endl;
+    uint64_t maxbucket = 1;
+    for (unsigned b=0; b<Rps_GcStatistics::gcs_nb_buckets; b++)
+      if (gh_buckets[b] > maxbucket)
+        maxbucket = gh_buckets[b];
+    for (unsigned b=0; b<Rps_GcStatistics::gcs_nb_buckets; b++)
+      {
+        if (gh_buckets[b] == 0)
+          continue;
+        char line[80];
+        snprintf(line, sizeof(line), "  < %-12llu %7llu ",
+                 (unsigned long long)((uint64_t)1<<b),
+                 (unsigned long long)gh_buckets[b]);
+        out << line << std::string((size_t)(1 + 40*gh_buckets[b]/maxbucket), '#')
+            << std::endl;
+      }
+  };
+};                              // end rps_gcstat_histogram_st
+
+/// All the histograms are computed, under the lock, from the ring of
+/// recent records.
+struct rps_gcstat_snapshot_st
+{
+  rps_gcstat_histogram_st gs_pause;   // microseconds
+  rps_gcstat_histogram_st gs_mark;    // microseconds
+  rps_gcstat_histogram_st gs_sweep;   // microseconds
+  rps_gcstat_histogram_st gs_live;    // words
+  uint64_t gs_nbgc;
+  uint64_t gs_nbminor;
+  double gs_cumultime;
+  uint64_t gs_livecount[Rps_GcStatistics::gcs_nb_types];
+  uint64_t gs_livewords[Rps_GcStatistics::gcs_nb_types];
+  std::vector<Rps_GcStatistics::gcs_record_st> gs_recent;
+};                              // end rps_gcstat_snapshot_st
+
+static void
+rps_gcstat_take_snapshot(rps_gcstat_snapshot_st&snap,
+                         const Rps_GcStatistics::gcs_record_st*records,
+                         uint64_t nbrecords)
+{
+  unsigned nb = (nbrecords < Rps_GcStatistics::gcs_window)
+                ? (unsigned)nbrecords : Rps_GcStatistics::gcs_window;
+  for (unsigned i=0; i<nb; i++)
+    {
+      const Rps_GcStatistics::gcs_record_st&rec
+        = records[(nbrecords - nb + i) % Rps_GcStatistics::gcs_window];
+      snap.gs_recent.push_back(rec);
+      if (rec.gr_minor)
+        snap.gs_nbminor++;
+      snap.gs_pause.add((uint64_t)(rec.gr_pause*1.0e6));
+      snap.gs_mark.add((uint64_t)(rec.gr_mark*1.0e6));
+      if (rec.gr_swept)
+        {
+          snap.gs_sweep.add((uint64_t)(rec.gr_sweep*1.0e6));
+          snap.gs_live.add(rec.gr_livewords);
+        }
+    }
+} // end rps_gcstat_take_snapshot
+
+Json::Value
+Rps_GcStatistics::as_json(void)
+{
+  rps_gcstat_snapshot_st snap = {};
+  Json::Value jthreads(Json::arrayValue);
+  {
+    std::lock_guard<std::mutex> gu(gcs_mtx);
+    rps_gcstat_take_snapshot(snap, gcs_records, gcs_nbrecords);
+    snap.gs_nbgc = gcs_nbrecords;
+    snap.gs_cumultime = gcs_cumulgctime;
+    memcpy(snap.gs_livecount, gcs_lastlivecount, sizeof(gcs_lastlivecount));
+    memcpy(snap.gs_livewords, gcs_lastlivewords, sizeof(gcs_lastlivewords));
+    for (gcs_thread_alloc_st*ta : gcs_threads)
+      {
+        Json::Value jt(Json::objectValue);
+        jt["tid"] = (Json::Int)ta->ta_tid;
+        jt["name"] = ta->ta_name;
+        jt["allocated_words"]
+          = (Json::UInt64)ta->ta_words.load(std::memory_order_relaxed);
+        jt["words_per_second"] = ta->ta_rate;
+        jthreads.append(jt);
+      }
+  }
+  Json::Value jstat(Json::objectValue);
+  jstat["nb_gc"] = (Json::UInt64)snap.gs_nbgc;
+  jstat["window"] = (Json::UInt)snap.gs_recent.size();
+  jstat["window_minor"] = (Json::UInt64)snap.gs_nbminor;
+  jstat["cumulated_gc_time"] = snap.gs_cumultime;
+  jstat["allocated_words"]
+    = (Json::UInt64)Rps_QuasiZone::cumulative_allocated_wordcount();
+  jstat["pause_us"] = snap.gs_pause.as_json();
+  jstat["mark_us"] = snap.gs_mark.as_json();
+  jstat["sweep_us"] = snap.gs_sweep.as_json();
+  jstat["live_words"] = snap.gs_live.as_json();
+  Json::Value jlive(Json::objectValue);
+  for (unsigned ix=0; ix<gcs_nb_types; ix++)
+    if (snap.gs_livecount[ix] > 0)
+      {
+        Json::Value jt(Json::objectValue);
+        jt["zones"] = (Json::UInt64)snap.gs_livecount[ix];
+        jt["words"] = (Json::UInt64)snap.gs_livewords[ix];
+        jlive[type_name(ix)] = jt;
+      }
+  jstat["live_by_type"] = jlive;
+  jstat["threads"] = jthreads;
+  Json::Value jrecent(Json::arrayValue);
+  for (const gcs_record_st&rec : snap.gs_recent)
+    {
+      Json::Value jr(Json::objectValue);
+      jr["gc"] = (Json::UInt64)rec.gr_count;
+      jr["minor"] = rec.gr_minor;
+      jr["start"] = rec.gr_realtime;
+      jr["pause"] = rec.gr_pause;
+      jr["mark"] = rec.gr_mark;
+      jr["sweep"] = rec.gr_sweep;
+      jr["allocated_words"] = (Json::UInt64)rec.gr_allocwords;
+      if (rec.gr_swept)
+        {
+          jr["live_zones"] = (Json::UInt64)rec.gr_livezones;
+          jr["live_words"] = (Json::UInt64)rec.gr_livewords;
+        }
+      jrecent.append(jr);
+    }
+  jstat["recent"] = jrecent;
+  jstat["pacing"] = Rps_GcPacer::as_json();
+  return jstat;
+} // end Rps_GcStatistics::as_json
+
+void
+Rps_GcStatistics::output(std::ostream&out)
+{
+  rps_gcstat_snapshot_st snap = {};
+  std::vector<std::string> threadlines;
+  {
+    std::lock_guard<std::mutex> gu(gcs_mtx);
+    rps_gcstat_take_snapshot(snap, gcs_records, gcs_nbrecords);
+    snap.gs_nbgc = gcs_nbrecords;
+    snap.gs_cumultime = gcs_cumulgctime;
+    memcpy(snap.gs_livecount, gcs_lastlivecount, sizeof(gcs_lastlivecount));
+    memcpy(snap.gs_livewords, gcs_lastlivewords, sizeof(gcs_lastlivewords));
+    for (gcs_thread_alloc_st*ta : gcs_threads)
+      {
+        char line[128];
+        snprintf(line, sizeof(line), "  %-15s tid#%-7d %14llu words %12.1f words/s",
+                 ta->ta_name[0]?ta->ta_name:"?", (int)ta->ta_tid,
+                 (unsigned long long)ta->ta_words.load(std::memory_order_relaxed),
+                 ta->ta_rate);
+        threadlines.push_back(line);
+      }
+  }
+  out << "garbage collection statistics: " << snap.gs_nbgc
+      << " collections, cumulated " << snap.gs_cumultime << " s" << std::endl;
+  out << "last " << snap.gs_recent.size() << " collections, "
+      << snap.gs_nbminor << " minor" << std::endl;
+  snap.gs_pause.output(out, "pause", "µs");
+  snap.gs_mark.output(out, "mark", "µs");
+  snap.gs_sweep.output(out, "sweep", "µs");
+  snap.gs_live.output(out, "live heap", "words");
+  out << "live zones by type at last sweep:" << std::endl;
+  for (unsigned ix=0; ix<gcs_nb_types; ix++)
+    if (snap.gs_livecount[ix] > 0)
+      {
+        char line[96];
+        snprintf(line, sizeof(line), "  %-18s %12llu zones %14llu words",
+                 type_name(ix), (unsigned long long)snap.gs_livecount[ix],
+                 (unsigned long long)snap.gs_livewords[ix]);
+        out << line << std::endl;
+      }
+  out << "allocation by thread:" << std::endl;
+  for (const std::string&line : threadlines)
+    out << line << std::endl;
+  Rps_GcPacer::output(out);
+} // end Rps_GcStatistics::output
+
+/// an empty path or "-" means the standard output
+void
+Rps_GcStatistics::dump_json(const std::string&path)
+{
+  Json::StreamWriterBuilder builder;
+  builder["commentStyle"] = "None";
+  builder["indentation"] = " ";
+  std::string str = Json::writeString(builder, as_json());
+  if (path.empty() || path == "-")
+    {
+      std::cout << str << std::endl;
+      return;
+    }
+  std::ofstream outf(path);
+  if (!outf)
+    throw RPS_RUNTIME_ERROR_OUT("failed to open GC statistics file " << path
+                                << ":" << strerror(errno));
+  outf << str << std::endl;
+  outf.close();
+  RPS_INFORMOUT("wrote garbage collection statistics to " << path);
+} // end Rps_GcStatistics::dump_json
+
+
+////////////////////////////////////////////////////////////////
+/////// garbage collection pacing
+
+std::atomic<double> Rps_GcPacer::pacer_growth_(Rps_GcPacer::pacer_default_growth);
+std::atomic<uint64_t> Rps_GcPacer::pacer_softcap_;
+std::atomic<double> Rps_GcPacer::pacer_cpubudget_(Rps_GcPacer::pacer_default_cpu_budget);
+std::atomic<double> Rps_GcPacer::pacer_prevgcrealtime_;
+std::atomic<double> Rps_GcPacer::pacer_prevgctime_;
+std::atomic<double> Rps_GcPacer::pacer_lastcost_;
+std::atomic<uint64_t> Rps_GcPacer::pacer_nbdeferred_;
+
+void
+Rps_GcPacer::set_growth_factor(double fact)
+{
+  RPS_ASSERT(fact > 1.0);
+  pacer_growth_.store(fact);
+  RPS_INFORMOUT("garbage collection when heap grows by a factor of " << fact);
+} // end Rps_GcPacer::set_growth_factor
+
+void
+Rps_GcPacer::set_soft_cap_words(uint64_t nbwords)
+{
+  pacer_softcap_.store(nbwords);
+  if (nbwords > 0)
+    RPS_INFORMOUT("garbage collection soft cap of " << nbwords << " words");
+} // end Rps_GcPacer::set_soft_cap_words
+
+void
+Rps_GcPacer::set_cpu_budget(double fraction)
+{
+  RPS_ASSERT(fraction > 0.0 && fraction <= 1.0);
+  pacer_cpubudget_.store(fraction);
+  RPS_INFORMOUT("garbage collection budget of " << (fraction*100.0)
+                << "% of worker time");
+} // end Rps_GcPacer::set_cpu_budget
+
+/// Called very often by every agenda worker, so the usual case of
+/// not enough allocation is decided without locking.
+bool
+Rps_GcPacer::should_collect(uint64_t allocwords_at_prevgc)
+{
+  uint64_t allocw = Rps_QuasiZone::cumulative_allocated_wordcount();
+  if (allocw < allocwords_at_prevgc + pacer_min_words)
+    return false;
+  uint64_t sincegc = allocw - allocwords_at_prevgc;
+  uint64_t live = Rps_GcStatistics::last_live_words();
+  uint64_t cap = soft_cap_words();
+  if (cap > 0 && live + sincegc >= cap)
+    return true;
+  if ((double)sincegc < (growth_factor() - 1.0) * (double)live)
+    return false;
+  /// the previous collection should not use more than the budget of
+  /// worker time elapsed since it
+  double prevreal = pacer_prevgcrealtime_.load();
+  if (prevreal > 0.0)
+    {
+      int nbworkers = (rps_nbjobs > 2) ? (rps_nbjobs - 1) : 1;
+      double worktime = (rps_monotonic_real_time() - prevreal) * nbworkers;
+      if (pacer_lastcost_.load() > cpu_budget() * worktime)
+        {
+          pacer_nbdeferred_.fetch_add(1);
+          return false;
+        }
+    }
+  return true;
+} // end Rps_GcPacer::should_collect
+
+bool
+Rps_GcPacer::over_soft_cap(void)
+{
+  uint64_t cap = soft_cap_words();
+  if (cap == 0)
+    return false;
+  return Rps_GcStatistics::last_live_words() >= cap;
+} // end Rps_GcPacer::over_soft_cap
+
+/// The cost of a collection is known only roughly: its pause, and the
+/// lazy sweep of the one before.
+void
+Rps_GcPacer::note_collection(void)
+{
+  double gctime = Rps_GcStatistics::cumulated_gc_time();
+  pacer_lastcost_.store(gctime - pacer_prevgctime_.load());
+  pacer_prevgctime_.store(gctime);
+  pacer_prevgcrealtime_.store(rps_monotonic_real_time());
+} // end Rps_GcPacer::note_collection
+
+void
+Rps_GcPacer::output(std::ostream&out)
+{
+  out << "pacing: growth factor " << growth_factor()
+      << ", cpu budget " << (cpu_budget()*100.0) << "%";
+  if (soft_cap_words() > 0)
+    out << ", soft cap " << soft_cap_words() << " words";
+  out << ", last cost " << pacer_lastcost_.load() << " s, "
+      << pacer_nbdeferred_.load() << " deferred checks" << std::endl;
+} // end Rps_GcPacer::output
+
+Json::Value
+Rps_GcPacer::as_json(void)
+{
+  Json::Value jp(Json::objectValue);
+  jp["growth_factor"] = growth_factor();
+  jp["cpu_budget"] = cpu_budget();
+  jp["soft_cap_words"] = (Json::UInt64)soft_cap_words();
+  jp["min_words"] = (Json::UInt64)pacer_min_words;
+  jp["last_cost"] = pacer_lastcost_.load();
+  jp["deferred"] = (Json::UInt64)pacer_nbdeferred_.load();
+  return jp;
+} // end Rps_GcPacer::as_json
+
+//////////////////////////////////////////////////////////// end of file gcstats_rps.cc
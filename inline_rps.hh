@@ -223,9 +223,16 @@ void
 Rps_Value::gc_mark(Rps_GarbageCollector&gc, unsigned depth) const
 {
   if (!is_ptr()) return;
-  if (_pval->is_gcmarked(gc)) return;
   Rps_ZoneValue* pzv = const_cast<Rps_ZoneValue*>(_pval);
-  pzv->set_gcmark(gc);
+  /// objects are scanned later from the scan queues
+  if (pzv->stored_type() == Rps_Type::Object)
+    {
+      gc.mark_obj(static_cast<Rps_ObjectZone*>(pzv));
+      return;
+    }
+  if (pzv->test_and_set_gcmark(gc)) return;
+  /// old immutable values can only refer to old zones
+  if (gc.is_minor() && pzv->is_old_zone()) return;
   if (RPS_UNLIKELY(depth > max_gc_mark_depth))
     throw std::runtime_error("too deep gc_mark");
   pzv->gc_mark(gc, depth);
@@ -1056,14 +1063,14 @@ Rps_QuasiZone::Rps_QuasiZone(Rps_Type ty)
   register_in_zonevec();
 } // end of Rps_QuasiZone::Rps_QuasiZone
 
+/// zones registered while we iterate could be seen or not
 void
 Rps_QuasiZone::every_zone(Rps_GarbageCollector&gc, std::function<void(Rps_GarbageCollector&, Rps_QuasiZone*)>fun)
 {
-  std::lock_guard<std::recursive_mutex> gu(qz_mtx);
-  auto nbzones = (uint32_t)qz_zonvec.size();
-  for (uint32_t zix=1; zix<nbzones; zix++)
+  uint32_t toprk = qz_toprank.load(std::memory_order_acquire);
+  for (uint32_t zix=1; zix<toprk; zix++)
     {
-      auto curzon = qz_zonvec[zix];
+      auto curzon = raw_nth_zone(zix, gc);
       if (!curzon)
         continue;
       RPS_ASSERT(curzon->qz_rank == zix);
@@ -1074,22 +1081,24 @@ Rps_QuasiZone::every_zone(Rps_GarbageCollector&gc, std::function<void(Rps_Garbag
 Rps_QuasiZone*
 Rps_QuasiZone::nth_zone(uint32_t rk)
 {
-  std::lock_guard<std::recursive_mutex> gu(qz_mtx);
-  if (rk<=0 || rk>=qz_zonvec.size()) return nullptr;
-  return qz_zonvec[rk];
+  if (rk<=0 || rk>=qz_toprank.load(std::memory_order_acquire)) return nullptr;
+  qz_chunk_st*chk = qz_chunktab[rk>>qz_chunk_shift].load(std::memory_order_acquire);
+  if (!chk) return nullptr;
+  return chk->qzc_zones[rk & (qz_chunk_size-1)].load(std::memory_order_acquire);
 } // end  Rps_QuasiZone::nth_zone
 
 Rps_QuasiZone*
 Rps_QuasiZone::raw_nth_zone(uint32_t rk, Rps_GarbageCollector&)
 {
-  if (rk<=0 || rk>=qz_zonvec.size()) return nullptr;
-  return qz_zonvec[rk];
+  return nth_zone(rk);
 } // end Rps_QuasiZone::raw_nth_zone
 
 void
 Rps_QuasiZone::run_locked_gc(Rps_GarbageCollector&gc, std::function<void(Rps_GarbageCollector&)>fun)
 {
-  std::lock_guard<std::recursive_mutex> gu(qz_mtx);
+  /// zones are born with the current mark color, so no lock is needed
+  /// to keep the zones allocated by other threads during fun
+  RPS_ASSERT(!is_sweeping());
   fun(gc);
 } // end Rps_QuasiZone::run_locked_gc
 
@@ -1097,34 +1106,81 @@ Rps_QuasiZone::run_locked_gc(Rps_GarbageCollector&gc, std::function<void(Rps_Gar
 // the GC related routines below don't really use the
 // Rps_GarbageCollector but needs one for typing safety.
 
-// test the GC mark
+// test the GC mark, which is set when the mark bit has the current color
 bool
 Rps_QuasiZone::is_gcmarked(Rps_GarbageCollector&) const
 {
   auto gcinf = qz_gcinfo.load();
-  return gcinf & qz_gcmark_bit;
+  return (gcinf & qz_gcmark_bit) == qz_markcolor.load(std::memory_order_relaxed);
 } // end Rps_QuasiZone::is_gcmarked
 
 // set the GC mark
 void
 Rps_QuasiZone::set_gcmark(Rps_GarbageCollector&)
 {
-  qz_gcinfo.fetch_or(qz_gcmark_bit);
+  if (qz_markcolor.load(std::memory_order_relaxed))
+    qz_gcinfo.fetch_or(qz_gcmark_bit);
+  else
+    qz_gcinfo.fetch_and(~qz_gcmark_bit);
 } // end Rps_QuasiZone::set_gcmark
 
+// set the GC mark, giving its previous state; when several marking
+// threads race, only one of them sees false
+bool
+Rps_QuasiZone::test_and_set_gcmark(Rps_GarbageCollector&)
+{
+  if (qz_markcolor.load(std::memory_order_relaxed))
+    return qz_gcinfo.fetch_or(qz_gcmark_bit) & qz_gcmark_bit;
+  else
+    return !(qz_gcinfo.fetch_and(~qz_gcmark_bit) & qz_gcmark_bit);
+} // end Rps_QuasiZone::test_and_set_gcmark
+
 // clear the GC mark
 void
 Rps_QuasiZone::clear_gcmark(Rps_GarbageCollector&)
 {
-  qz_gcinfo.fetch_and(~qz_gcmark_bit);
+  if (qz_markcolor.load(std::memory_order_relaxed))
+    qz_gcinfo.fetch_and(~qz_gcmark_bit);
+  else
+    qz_gcinfo.fetch_or(qz_gcmark_bit);
 } // end Rps_QuasiZone::clear _gcmark
 
+// during a lazy sweep, unmarked zones are dead, since zones born
+// meanwhile are marked
+bool
+Rps_QuasiZone::is_awaiting_sweep(void) const
+{
+  if (RPS_LIKELY(!qz_sweeping.load(std::memory_order_acquire)))
+    return false;
+  auto gcinf = qz_gcinfo.load();
+  /// after a minor collection, unmarked old zones are alive
+  if ((gcinf & qz_gcold_bit) && qz_sweepminor.load())
+    return false;
+  return (gcinf & qz_gcmark_bit)
+         != qz_markcolor.load(std::memory_order_relaxed);
+} // end Rps_QuasiZone::is_awaiting_sweep
+
+/// only the owning thread increments its counter, so no atomic
+/// read-modify-write is needed
+void
+Rps_GcStatistics::count_allocation(uint64_t nbwords)
+{
+  gcs_thread_alloc_st*ta = gcs_thralloc;
+  if (RPS_UNLIKELY(!ta))
+    ta = register_thread_alloc();
+  ta->ta_words.store(ta->ta_words.load(std::memory_order_relaxed) + nbwords,
+                     std::memory_order_relaxed);
+} // end Rps_GcStatistics::count_allocation
+
+/// allocating is not a safepoint: the caller might hold some
+/// non-object lock, e.g. the symbol table one, needed to mark
 inline void*
 Rps_QuasiZone::operator new (std::size_t siz, std::nullptr_t)
 {
   RPS_ASSERT(siz % sizeof(void*) == 0);
   qz_alloc_cumulw.fetch_add(siz / sizeof(void*));
-  return ::operator new (siz);
+  Rps_GcStatistics::count_allocation(siz / sizeof(void*));
+  return Rps_ZoneArena::allocate (siz);
 } // end plain Rps_QuasiZone::operator new
 
 
@@ -1134,9 +1190,30 @@ Rps_QuasiZone::operator new (std::size_t siz, unsigned wordgap)
   RPS_ASSERT(siz % sizeof(void*) == 0);
   auto realsize = siz + wordgap * sizeof(void*);
   qz_alloc_cumulw.fetch_add(realsize / sizeof(void*));
-  return ::operator new (realsize);
+  Rps_GcStatistics::count_allocation(realsize / sizeof(void*));
+  return Rps_ZoneArena::allocate (realsize);
 } // end wordgapped Rps_QuasiZone::operator new
 
+inline void
+Rps_QuasiZone::operator delete (void*ptr)
+{
+  Rps_ZoneArena::deallocate (ptr);
+} // end plain Rps_QuasiZone::operator delete
+
+// called only when the constructor throws after a plain allocation
+inline void
+Rps_QuasiZone::operator delete (void*ptr, std::nullptr_t)
+{
+  Rps_ZoneArena::deallocate (ptr);
+} // end placement Rps_QuasiZone::operator delete
+
+// called only when the constructor throws after a wordgapped allocation
+inline void
+Rps_QuasiZone::operator delete (void*ptr, unsigned)
+{
+  Rps_ZoneArena::deallocate (ptr);
+} // end wordgapped Rps_QuasiZone::operator delete
+
 
 //////////////////////////////////////////////////////////// zone values
 
@@ -1488,17 +1565,93 @@ Rps_JsonZone::Rps_JsonZone(const Json::Value& jv)
 
 //////////////////////////////////////////////////////////// objects zones
 
+const Rps_AttrStore::entry_st*
+Rps_AttrStore::find_entry(const Rps_ObjectZone*atob) const
+{
+  if (!is_hashed())
+    {
+      const entry_st* ents = entries();
+      for (unsigned ix=0; ix<as_count; ix++)
+        if (ents[ix].en_atob.optr() == atob)
+          return ents+ix;
+      return nullptr;
+    }
+  /// the table is never more than half full
+  size_t mask = as_capacity-1;
+  for (size_t ix=hash_slot(atob, as_capacity); ; ix = (ix+1) & mask)
+    {
+      const entry_st& ent = as_heap[ix];
+      if (ent.en_atob.optr() == atob)
+        return &ent;
+      if (ent.en_atob.is_empty())
+        return nullptr;
+    }
+} // end Rps_AttrStore::find_entry
 
+Rps_Value
+Rps_AttrStore::get(const Rps_ObjectRef atob) const
+{
+  if (atob.is_empty())
+    return nullptr;
+  const entry_st* ent = find_entry(atob.optr());
+  if (ent)
+    return ent->en_val;
+  return nullptr;
+} // end Rps_AttrStore::get
+
+template <typename FunT> void
+Rps_AttrStore::for_each(FunT fun) const
+{
+  if (!is_hashed())
+    {
+      const entry_st* ents = entries();
+      for (unsigned ix=0; ix<as_count; ix++)
+        fun(ents[ix].en_atob, ents[ix].en_val);
+      return;
+    }
+  std::vector<const entry_st*> vecent;
+  vecent.reserve(as_count);
+  for (unsigned ix=0; ix<as_capacity; ix++)
+    if (!as_heap[ix].en_atob.is_empty())
+      vecent.push_back(as_heap+ix);
+  std::sort(vecent.begin(), vecent.end(),
+            [](const entry_st*ent1, const entry_st*ent2)
+  {
+    return ent1->en_atob < ent2->en_atob;
+  });
+  for (const entry_st* ent: vecent)
+    fun(ent->en_atob, ent->en_val);
+} // end Rps_AttrStore::for_each
+
+template <typename FunT> void
+Rps_AttrStore::for_each_unordered(FunT fun) const
+{
+  const entry_st* ents = entries();
+  unsigned nbslots = is_hashed()?as_capacity:as_count;
+  for (unsigned ix=0; ix<nbslots; ix++)
+    if (!ents[ix].en_atob.is_empty())
+      fun(ents[ix].en_atob, ents[ix].en_val);
+} // end Rps_AttrStore::for_each_unordered
+
+
+void
+Rps_ObjectZone::materialize(void) const
+{
+  if (RPS_UNLIKELY(qz_gcinfo.load(std::memory_order_acquire) & qz_unfilled_bit))
+    rps_load_materialize(const_cast<Rps_ObjectZone*>(this));
+} // end Rps_ObjectZone::materialize
 
 Rps_Payload*
 Rps_ObjectZone::get_payload(void) const
 {
+  materialize();
   return ob_payload.load();
 } // end Rps_ObjectZone::get_payload(void)
 
 Rps_PayloadClassInfo*
 Rps_ObjectZone::get_classinfo_payload(void) const
 {
+  materialize();
   auto payl = ob_payload.load();
   if (payl && RPS_UNLIKELY(payl->stored_type() == Rps_Type::PaylClassInfo))
     return reinterpret_cast<Rps_PayloadClassInfo*>(payl);
@@ -1508,6 +1661,7 @@ Rps_ObjectZone::get_classinfo_payload(void) const
 bool
 Rps_ObjectZone::has_erasable_payload(void) const
 {
+  materialize();
   auto py = ob_payload.load();
   if (py != nullptr)
     return py->is_erasable();
@@ -1518,15 +1672,17 @@ Rps_ObjectZone::has_erasable_payload(void) const
 void
 Rps_ObjectZone::clear_payload(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
-  Rps_Payload*oldpayl = ob_payload.exchange(nullptr);
+  materialize();
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
+  Rps_Payload*oldpayl = exchange_payload(nullptr);
   if (oldpayl)
     {
+      touch_now();
       if (oldpayl->owner() == this)
         {
           if (!oldpayl->is_erasable())
             {
-              ob_payload.store(oldpayl);
+              exchange_payload(oldpayl);
               RPS_WARNOUT("cannot remove unerasable payload " <<
                           oldpayl->payload_type_name()
                           << " from " << Rps_ObjectRef(this)
@@ -1542,9 +1698,133 @@ Rps_ObjectZone::clear_payload(void)
     }
 } // end Rps_ObjectZone::clear_payload
 
+void
+Rps_ObjectZone::loader_clear_contents(Rps_Loader*ld)
+{
+  RPS_ASSERT(ld != nullptr);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
+  ob_attrs.clear();
+  ob_comps.clear();
+  ob_magicgetterfun.store(nullptr);
+  ob_applyingfun.store(nullptr);
+  Rps_Payload*oldpayl = exchange_payload(nullptr);
+  if (oldpayl)
+    {
+      if (oldpayl->owner() == this)
+        oldpayl->clear_owner();
+      delete oldpayl;
+    }
+} // end Rps_ObjectZone::loader_clear_contents
+
+void
+Rps_ObjectZone::gc_write_barrier(const Rps_ZoneValue*zv)
+{
+  if (!zv || zv->is_old_zone())
+    return;
+  /// young objects are traced anyway by the next collection, unless
+  /// they are promoted by the sweep of the current one
+  if (RPS_LIKELY(!is_old_zone())
+      && RPS_LIKELY(!is_collecting()))
+    return;
+  if (qz_gcinfo.fetch_or(qz_gcremember_bit) & qz_gcremember_bit)
+    return;
+  Rps_GarbageCollector::remember_zone(this);
+} // end Rps_ObjectZone::gc_write_barrier
+
+void
+Rps_ObjectZone::gc_write_barrier(Rps_Value val)
+{
+  if (val.is_ptr())
+    gc_write_barrier(val.as_ptr());
+} // end Rps_ObjectZone::gc_write_barrier
+
+void
+Rps_ObjectZone::gc_write_barrier(Rps_ObjectRef obr)
+{
+  if (obr)
+    gc_write_barrier(obr.optr());
+} // end Rps_ObjectZone::gc_write_barrier
+
+void
+Rps_ObjectZone::gc_remember_if_old(void)
+{
+  if (RPS_LIKELY(!is_old_zone())
+      && RPS_LIKELY(!is_collecting()))
+    return;
+  if (qz_gcinfo.fetch_or(qz_gcremember_bit) & qz_gcremember_bit)
+    return;
+  Rps_GarbageCollector::remember_zone(this);
+} // end Rps_ObjectZone::gc_remember_if_old
+
+void
+Rps_ObjectZone::store_class(Rps_ObjectZone*obzclass)
+{
+  ob_class.store(obzclass);
+  gc_write_barrier(obzclass);
+} // end Rps_ObjectZone::store_class
+
+void
+Rps_ObjectZone::store_space(Rps_ObjectZone*obzspace)
+{
+  ob_space.store(obzspace);
+  gc_write_barrier(obzspace);
+} // end Rps_ObjectZone::store_space
+
+void
+Rps_ObjectZone::store_attr(const Rps_ObjectRef obattr, const Rps_Value valattr)
+{
+  ob_attrs.put(obattr, valattr);
+  gc_write_barrier(obattr);
+  gc_write_barrier(valattr);
+} // end Rps_ObjectZone::store_attr
+
+void
+Rps_ObjectZone::store_comp(const Rps_Value compval)
+{
+  ob_comps.push_back(compval);
+  gc_write_barrier(compval);
+} // end Rps_ObjectZone::store_comp
+
+/// the new payload may refer to young zones, so an old owner is
+/// remembered
+Rps_Payload*
+Rps_ObjectZone::exchange_payload(Rps_Payload*newpayl)
+{
+  Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+  if (newpayl)
+    {
+      ob_paylstat.store(((uint64_t)newpayl->wordsize() << 16)
+                        | (uint16_t)newpayl->stored_type(),
+                        std::memory_order_relaxed);
+      gc_remember_if_old();
+    }
+  else
+    ob_paylstat.store(0, std::memory_order_relaxed);
+  return oldpayl;
+} // end Rps_ObjectZone::exchange_payload
+
+void
+Rps_ObjectZone::journal_mutation(void)
+{
+  if (RPS_LIKELY(!Rps_Journal::active()))
+    return;
+  /// only the first mutation since the last commit queues the object
+  if (qz_gcinfo.fetch_or(qz_journaled_bit) & qz_journaled_bit)
+    return;
+  Rps_Journal::add_pending(this);
+} // end Rps_ObjectZone::journal_mutation
+
+void
+Rps_ObjectZone::touch_now(void)
+{
+  ob_mtime.store(rps_wallclock_real_time());
+  journal_mutation();
+} // end Rps_ObjectZone::touch_now
+
 Rps_ObjectRef
 Rps_ObjectZone::get_class(void) const
 {
+  materialize();
   return Rps_ObjectRef(ob_class.load());
 } // end Rps_ObjectZone::get_class
 
@@ -1564,7 +1844,7 @@ Rps_ObjectZone::is_class(void) const
     return false;
   if (curclass == RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ)) // `object` class
     return false;
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   /// some classes might be instances of yet another metaclass, this is
   /// rare, and we use C++ dynamic cast of payload
   auto curpayl = get_dynamic_payload<Rps_PayloadClassInfo>();
@@ -1590,8 +1870,8 @@ Rps_ObjectZone::is_instance_of(Rps_ObjectRef obwclass) const
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (!obwclass)
     return false;
-  std::lock_guard<std::recursive_mutex> guthislock(this->ob_mtx);
-  std::lock_guard<std::recursive_mutex> guclasslock(obwclass->ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> guthislock(this->ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> guclasslock(obwclass->ob_mtx);
   RPS_DEBUG_LOG(LOW_REPL, "+Rps_ObjectZone::is_instance_of call#" << curcallcnt << " thisob=" << Rps_ObjectRef(this)
                 << " obwclass="<< obwclass);
   int cnt = 0;
@@ -1649,7 +1929,7 @@ Rps_ObjectZone::is_instance_of(Rps_ObjectRef obwclass) const
                         << " obwclass=" << obwclass << " FAIL-value");
           return false;
         }
-      std::lock_guard<std::recursive_mutex> gu(obthisclass->ob_mtx);
+      std::lock_guard<Rps_ObjectMutex> gu(obthisclass->ob_mtx);
       if (!obthisclass->is_class())
         {
           RPS_DEBUG_LOG(LOW_REPL, "%Rps_ObjectZone::is_instance_of thisob=" << Rps_ObjectRef(this)
@@ -1677,7 +1957,7 @@ Rps_ObjectZone::is_subclass_of(Rps_ObjectRef obsuperclass) const
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   RPS_DEBUG_LOG(LOW_REPL, "+Rps_ObjectZone::is_subclass_of call#" << curcallcnt << " thisob="
                 << Rps_ObjectRef(this) << " obsuperclass=" << obsuperclass);
-  std::lock_guard<std::recursive_mutex> guthislock(this->ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> guthislock(this->ob_mtx);
   {
     auto thisclasspayl = get_dynamic_payload<Rps_PayloadClassInfo>();
     if (!thisclasspayl)
@@ -1752,12 +2032,14 @@ Rps_ObjectZone::is_subclass_of(Rps_ObjectRef obsuperclass) const
 Rps_ObjectRef
 Rps_ObjectZone::get_space(void) const
 {
+  materialize();
   return Rps_ObjectRef(ob_space.load());
 } // end Rps_ObjectZone::get_space
 
 double
 Rps_ObjectZone::get_mtime(void) const
 {
+  materialize();
   return ob_mtime.load();
 } // end Rps_ObjectZone::get_mtime
 
@@ -1941,6 +2223,7 @@ Rps_TreeZone<RpsTree,treety,k1,k2,k3,k4>::put_metadata(Rps_ObjectRef obr, int32_
   _treemetaob.store(obz);
   _treemetarank.store(num);
   _treemetatransient.store(transient);
+  gc_metadata_write_barrier(obz);
 } // end Rps_TreeZone::put_metadata
 
 
@@ -1955,9 +2238,25 @@ Rps_TreeZone<RpsTree,treety,k1,k2,k3,k4>::swap_metadata(Rps_ObjectRef obr, int32
   Rps_ObjectZone* oldobz=_treemetaob.exchange(obz);
   int32_t oldnum = _treemetarank.exchange(num);
   _treemetatransient.store(transient);
+  gc_metadata_write_barrier(obz);
   return   std::pair<Rps_ObjectZone*,int32_t> {oldobz, oldnum};
 } // end Rps_TreeZone::swap_metadata
 
+/// same as Rps_ObjectZone::gc_write_barrier
+template<typename RpsTree, Rps_Type treety, unsigned k1, unsigned k2, unsigned k3, unsigned k4>
+void
+Rps_TreeZone<RpsTree,treety,k1,k2,k3,k4>::gc_metadata_write_barrier(Rps_ObjectZone*obz)
+{
+  if (!obz || obz->is_old_zone())
+    return;
+  if (RPS_LIKELY(!is_old_zone())
+      && RPS_LIKELY(!is_collecting()))
+    return;
+  if (qz_gcinfo.fetch_or(qz_gcremember_bit) & qz_gcremember_bit)
+    return;
+  Rps_GarbageCollector::remember_zone(this);
+} // end Rps_TreeZone::gc_metadata_write_barrier
+
 //////////////// closures
 
 Rps_ClosureValue::Rps_ClosureValue (const Rps_ObjectRef connob, const std::initializer_list<Rps_Value>& valil)
@@ -2341,6 +2640,7 @@ Rps_PayloadClassInfo::Rps_PayloadClassInfo(Rps_ObjectZone*owner)
     pclass_super(nullptr), pclass_methdict(), pclass_symbname(nullptr), pclass_attrset(nullptr)
 {
   RPS_ASSERT(owner && owner->stored_type() == Rps_Type::Object);
+  rps_invalidate_method_caches();
 }      // end Rps_PayloadClassInfo::Rps_PayloadClassInfo
 
 Rps_PayloadClassInfo::Rps_PayloadClassInfo(Rps_ObjectZone*owner, Rps_Loader*ld)
@@ -2348,6 +2648,7 @@ Rps_PayloadClassInfo::Rps_PayloadClassInfo(Rps_ObjectZone*owner, Rps_Loader*ld)
     pclass_super(nullptr), pclass_methdict(), pclass_symbname(nullptr), pclass_attrset(nullptr)
 {
   RPS_ASSERT(owner && owner->stored_type() == Rps_Type::Object);
+  rps_invalidate_method_caches();
 }      // end Rps_PayloadClassInfo::Rps_PayloadClassInfo ..loading
 
 
@@ -2417,11 +2718,13 @@ Rps_PayloadVectVal::Rps_PayloadVectVal(Rps_ObjectZone*owner, Rps_Loader*ld)
 Rps_ObjectRef
 Rps_PayloadSymbol::find_named_object(const std::string&str)
 {
-  std::lock_guard<std::recursive_mutex> gu(symb_tablemtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(symb_tablemtx);
   auto it = symb_table.find(str);
   if (it != symb_table.end())
     {
       auto symb = it->second;
+      if (symb && symb->is_dead_symbol())
+        return nullptr;
       if (symb)
         {
           RPS_DEBUG_LOG(LOWREP, "find_named_object str='" << str << "' symb=" << symb << " owner=" << symb->owner());
@@ -2469,7 +2772,12 @@ Rps_GarbageCollector::mark_root_objectref(Rps_ObjectRef obr)
 {
   if (!obr.is_empty())
     {
-      mark_obj(obr);
+      /// minor collections still scan the old root objects, so the
+      /// global data reachable from their payloads is traced
+      if (gc_minor && obr->is_old_zone())
+        scan_old_obj(obr.optr());
+      else
+        mark_obj(obr);
       gc_nbroots++;
     }
 }      // end Rps_GarbageCollector::mark_root_objectref
@@ -2500,6 +2808,62 @@ Rps_Agenda::tasklet_class()
   return RPS_ROOT_OB(_8fYqEw8vTED03wsznt);
 }      // end Rps_Agenda::tasklet_class
 
+void
+Rps_Agenda::poll_safepoint(void)
+{
+  if (RPS_UNLIKELY(agenda_needs_garbcoll_.load(std::memory_order_relaxed)))
+    stop_at_safepoint();
+}      // end Rps_Agenda::poll_safepoint
+
+Rps_NoSafepointGuard::Rps_NoSafepointGuard()
+{
+  Rps_Agenda::agenda_nosafepoint_depth_++;
+}      // end Rps_NoSafepointGuard::Rps_NoSafepointGuard
+
+Rps_NoSafepointGuard::~Rps_NoSafepointGuard()
+{
+  RPS_ASSERT(Rps_Agenda::agenda_nosafepoint_depth_ > 0);
+  Rps_Agenda::agenda_nosafepoint_depth_--;
+}      // end Rps_NoSafepointGuard::~Rps_NoSafepointGuard
+
+/// a worker thread waiting for an object mutex could wait for a
+/// worker stopped at a safepoint, so it polls safepoints meanwhile
+void
+Rps_ObjectMutex::lock(void)
+{
+  int ix = Rps_Agenda::worker_index();
+  if (RPS_LIKELY(om_mtx.try_lock()))
+    ;
+  else if (ix > 0)
+    {
+      while (!om_mtx.try_lock_for(std::chrono::milliseconds(1)))
+        Rps_Agenda::poll_safepoint();
+    }
+  else
+    om_mtx.lock();
+  if (om_depth++ == 0)
+    om_owner.store(ix, std::memory_order_release);
+}      // end Rps_ObjectMutex::lock
+
+bool
+Rps_ObjectMutex::try_lock(void)
+{
+  if (!om_mtx.try_lock())
+    return false;
+  if (om_depth++ == 0)
+    om_owner.store(Rps_Agenda::worker_index(), std::memory_order_release);
+  return true;
+}      // end Rps_ObjectMutex::try_lock
+
+void
+Rps_ObjectMutex::unlock(void)
+{
+  RPS_ASSERT(om_depth > 0);
+  if (--om_depth == 0)
+    om_owner.store(0, std::memory_order_release);
+  om_mtx.unlock();
+}      // end Rps_ObjectMutex::unlock
+
 
 /////////////////////////////////////////////////////////////////
 //////////////// Tasklets
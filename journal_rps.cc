@@ -0,0 +1,459 @@
+/****************************************************************
+ * file journal_rps.cc
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Description:
+ *      This file is part of the Reflective Persistent System.
+ *
+ *      It has the write-ahead mutation journal, appended between
+ *      dumps and replayed by the loader after the space files.
+ *
+ * Author(s):
+ *      Basile Starynkevitch <basile@starynkevitch.net>
+ *      Abhishek Chakravarti <abhishek@taranjali.org>
+ *      Nimesh Neema <nimeshneema@gmail.com>
+ *
+ *      © Copyright 2019 - 2024 The Reflective Persistent System Team
+ *      team@refpersys.org & http://refpersys.org/
+ *
+ * License:
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "refpersys.hh"
+
+
+extern "C" const char rps_journal_gitid[];
+const char rps_journal_gitid[]= RPS_GITID;
+
+extern "C" const char rps_journal_date[];
+const char rps_journal_date[]= __DATE__;
+
+// comment for our do-scan-pkgconfig.c utility
+//@@PKGCONFIG jsoncpp
+
+/// A journal file starts with Rps_Journal::jr_magic. Each record has
+/// a little endian 32 bits length, a 32 bits checksum of its body,
+/// then its body. The body is a binary space file (see
+/// binstore_rps.cc) holding the whole contents of one object after
+/// some mutation, in its current space. Replaying the last record of
+/// every object gives its state at the last commit. A record torn by
+/// a crash is detected by its length or checksum, and ends the replay.
+
+bool rps_journal_enabled;
+
+std::atomic<bool> Rps_Journal::jr_active_;
+std::mutex Rps_Journal::jr_mtx_;
+std::mutex Rps_Journal::jr_filemtx_;
+std::condition_variable Rps_Journal::jr_cond_;
+std::vector<Rps_ObjectZone*> Rps_Journal::jr_pending_;
+std::vector<Rps_ObjectZone*> Rps_Journal::jr_committing_;
+std::string Rps_Journal::jr_dirpath_;
+std::thread Rps_Journal::jr_thread_;
+int Rps_Journal::jr_fd_ = -1;
+bool Rps_Journal::jr_stop_;
+bool Rps_Journal::jr_flushreq_;
+uint64_t Rps_Journal::jr_nbrecords_;
+uint64_t Rps_Journal::jr_nbcommits_;
+uint64_t Rps_Journal::jr_nbbytes_;
+
+std::string
+Rps_Journal::journal_path(const std::string&dirpath, bool old)
+{
+  return dirpath + (old?"/persistore/journal-rps.old":"/persistore/journal-rps.bin");
+} // end Rps_Journal::journal_path
+
+uint32_t
+Rps_Journal::checksum(const char*buf, size_t len)
+{
+  // 32 bits FNV-1a
+  uint32_t h = 2166136261u;
+  for (size_t ix=0; ix<len; ix++)
+    {
+      h ^= (uint8_t) buf[ix];
+      h *= 16777619u;
+    }
+  return h;
+} // end Rps_Journal::checksum
+
+static inline void
+rps_journal_put_u32(std::string&buf, uint32_t v)
+{
+  for (int ix=0; ix<4; ix++)
+    buf.push_back((char)((v >> (8*ix)) & 0xff));
+} // end rps_journal_put_u32
+
+static inline uint32_t
+rps_journal_get_u32(const char*pc)
+{
+  uint32_t v = 0;
+  for (int ix=0; ix<4; ix++)
+    v |= ((uint32_t)(uint8_t)pc[ix]) << (8*ix);
+  return v;
+} // end rps_journal_get_u32
+
+size_t
+Rps_Journal::scan_records(const std::string&content, const std::string&path,
+                          const std::function<void(const char*body, size_t len)>&fun)
+{
+  if (content.size() < jr_magic_len
+      || memcmp(content.data(), jr_magic, jr_magic_len))
+    {
+      if (!content.empty())
+        RPS_WARNOUT("journal file " << path << " has a bad header, ignored");
+      return 0;
+    }
+  size_t pos = jr_magic_len;
+  unsigned nbrec = 0;
+  while (content.size() - pos >= jr_record_header_size)
+    {
+      uint32_t len = rps_journal_get_u32(content.data() + pos);
+      uint32_t ck = rps_journal_get_u32(content.data() + pos + 4);
+      if (content.size() - pos - jr_record_header_size < len)
+        break;
+      const char*body = content.data() + pos + jr_record_header_size;
+      if (checksum(body, len) != ck)
+        break;
+      if (fun)
+        fun(body, len);
+      nbrec++;
+      pos += jr_record_header_size + len;
+    }
+  if (pos < content.size())
+    RPS_WARNOUT("journal file " << path << " has a torn tail of "
+                << (content.size() - pos) << " bytes after "
+                << nbrec << " valid records");
+  return pos;
+} // end Rps_Journal::scan_records
+
+static std::string
+rps_journal_read_file(const std::string&path)
+{
+  std::ifstream inp(path, std::ios::in|std::ios::binary);
+  if (!inp)
+    return std::string();
+  std::ostringstream outs;
+  outs << inp.rdbuf();
+  return outs.str();
+} // end rps_journal_read_file
+
+static void
+rps_journal_sync_directory(const std::string&dirpath)
+{
+  int dfd = ::open((dirpath + "/persistore").c_str(), O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+  if (dfd >= 0)
+    {
+      (void) fsync(dfd);
+      ::close(dfd);
+    }
+} // end rps_journal_sync_directory
+
+static bool
+rps_journal_write_all(int fd, const char*buf, size_t len)
+{
+  while (len > 0)
+    {
+      ssize_t wcnt = write(fd, buf, len);
+      if (wcnt < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return false;
+        }
+      buf += wcnt;
+      len -= wcnt;
+    }
+  return true;
+} // end rps_journal_write_all
+
+/// open the journal file, with jr_filemtx_ held; a torn tail left by
+/// a crash is cut, so new records are appended to valid ones
+void
+Rps_Journal::open_file(bool truncate)
+{
+  std::string path = journal_path(jr_dirpath_);
+  size_t validlen = 0;
+  if (!truncate)
+    {
+      validlen = scan_records(rps_journal_read_file(path), path, nullptr);
+      truncate = (validlen == 0);
+    }
+  int fd = ::open(path.c_str(),
+                  O_WRONLY|O_CREAT|O_APPEND|O_CLOEXEC|(truncate?O_TRUNC:0), 0640);
+  if (fd < 0)
+    throw RPS_RUNTIME_ERROR_OUT("failed to open journal " << path
+                                << ":" << strerror(errno));
+  if (truncate)
+    {
+      if (!rps_journal_write_all(fd, jr_magic, jr_magic_len) || fdatasync(fd))
+        {
+          int err = errno;
+          ::close(fd);
+          throw RPS_RUNTIME_ERROR_OUT("failed to start journal " << path
+                                      << ":" << strerror(err));
+        }
+      rps_journal_sync_directory(jr_dirpath_);
+    }
+  else if (ftruncate(fd, validlen))
+    RPS_WARNOUT("failed to cut journal " << path << " to " << validlen
+                << " bytes:" << strerror(errno));
+  jr_fd_ = fd;
+} // end Rps_Journal::open_file
+
+void
+Rps_Journal::open(const std::string&dirpath)
+{
+  char* rp = realpath(dirpath.c_str(), nullptr);
+  if (!rp)
+    RPS_FATALOUT("cannot journal into " << dirpath << ":" << strerror(errno));
+  {
+    Rps_NoSafepointLock<std::mutex> gu(jr_mtx_);
+    if (jr_active_.load())
+      {
+        RPS_WARNOUT("journal already active into " << jr_dirpath_);
+        free (rp);
+        return;
+      }
+    Rps_NoSafepointLock<std::mutex> gufil(jr_filemtx_);
+    jr_dirpath_.assign(rp);
+    free (rp);
+    open_file(false);
+    jr_stop_ = false;
+    jr_flushreq_ = false;
+    jr_active_.store(true);
+  }
+  jr_thread_ = std::thread(committer_loop);
+  static bool atexitdone;
+  if (!atexitdone)
+    {
+      atexitdone = true;
+      atexit([]()
+      {
+        Rps_Journal::close();
+      });
+    }
+  RPS_INFORMOUT("journaling mutations into " << journal_path(jr_dirpath_)
+                << " every " << jr_commit_period_millis << " milliseconds");
+} // end Rps_Journal::open
+
+void
+Rps_Journal::close(void)
+{
+  {
+    Rps_NoSafepointLock<std::mutex> gu(jr_mtx_);
+    if (!jr_active_.load())
+      return;
+    jr_stop_ = true;
+  }
+  jr_cond_.notify_all();
+  if (jr_thread_.joinable())
+    jr_thread_.join();
+  Rps_NoSafepointLock<std::mutex> gu(jr_mtx_);
+  Rps_NoSafepointLock<std::mutex> gufil(jr_filemtx_);
+  jr_active_.store(false);
+  if (jr_fd_ >= 0)
+    ::close(jr_fd_);
+  jr_fd_ = -1;
+  RPS_DEBUG_LOG(DUMP, "closed journal " << journal_path(jr_dirpath_)
+                << " after " << jr_nbcommits_ << " commits of "
+                << jr_nbrecords_ << " records");
+} // end Rps_Journal::close
+
+void
+Rps_Journal::add_pending(Rps_ObjectZone*obz)
+{
+  RPS_ASSERT(obz != nullptr);
+  Rps_NoSafepointLock<std::mutex> gu(jr_mtx_);
+  jr_pending_.push_back(obz);
+} // end Rps_Journal::add_pending
+
+void
+Rps_Journal::flush(void)
+{
+  if (!active())
+    return;
+  std::unique_lock<std::mutex> lk(jr_mtx_);
+  jr_flushreq_ = true;
+  jr_cond_.notify_all();
+  jr_cond_.wait(lk, []()
+  {
+    return jr_stop_ || (jr_pending_.empty() && jr_committing_.empty());
+  });
+} // end Rps_Journal::flush
+
+/// the pending and committing objects are kept alive until committed
+void
+Rps_Journal::gc_mark(Rps_GarbageCollector&gc)
+{
+  if (!active())
+    return;
+  Rps_NoSafepointLock<std::mutex> gu(jr_mtx_);
+  for (Rps_ObjectZone*obz: jr_pending_)
+    obz->gc_mark(gc);
+  for (Rps_ObjectZone*obz: jr_committing_)
+    obz->gc_mark(gc);
+} // end Rps_Journal::gc_mark
+
+void
+Rps_Journal::committer_loop(void)
+{
+  pthread_setname_np(pthread_self(), "rps-journal");
+  std::unique_lock<std::mutex> lk(jr_mtx_);
+  for (;;)
+    {
+      jr_cond_.wait_for(lk, std::chrono::milliseconds(jr_commit_period_millis),
+                        []()
+      {
+        return jr_stop_ || jr_flushreq_;
+      });
+      if (!jr_pending_.empty())
+        {
+          jr_committing_.swap(jr_pending_);
+          lk.unlock();
+          commit_batch(jr_committing_);
+          lk.lock();
+          jr_committing_.clear();
+        }
+      jr_flushreq_ = false;
+      jr_cond_.notify_all();
+      if (jr_stop_ && jr_pending_.empty())
+        break;
+    }
+} // end Rps_Journal::committer_loop
+
+/// serialize a batch of mutated objects, append their records with
+/// one write, and sync them once: the group commit
+void
+Rps_Journal::commit_batch(std::vector<Rps_ObjectZone*>&batch)
+{
+  std::string buf;
+  unsigned nbrec = 0;
+  for (Rps_ObjectZone*obz: batch)
+    {
+      /// mutations from now on queue the object again
+      obz->qz_gcinfo.fetch_and(~Rps_ObjectZone::qz_journaled_bit);
+      Rps_ObjectZone*obspace = obz->ob_space.load();
+      if (!obspace) // transient objects are not persisted
+        continue;
+      Rps_ObjectRef obr(obz);
+      try
+        {
+          Rps_BinaryStoreWriter binwriter(obspace->oid());
+          binwriter.add_object(rps_dump_json_for_journal(obr));
+          std::ostringstream outs;
+          binwriter.write(outs);
+          std::string body = outs.str();
+          rps_journal_put_u32(buf, (uint32_t) body.size());
+          rps_journal_put_u32(buf, checksum(body.data(), body.size()));
+          buf.append(body);
+          nbrec++;
+        }
+      catch (const std::exception&exc)
+        {
+          RPS_WARNOUT("journal failed to serialize " << obr << ":" << exc.what());
+        }
+    }
+  if (buf.empty())
+    return;
+  {
+    Rps_NoSafepointLock<std::mutex> gufil(jr_filemtx_);
+    if (jr_fd_ < 0)
+      return;
+    if (!rps_journal_write_all(jr_fd_, buf.data(), buf.size()))
+      RPS_WARNOUT("failed to append " << buf.size() << " bytes to journal "
+                  << journal_path(jr_dirpath_) << ":" << strerror(errno));
+    else if (fdatasync(jr_fd_))
+      RPS_WARNOUT("failed to sync journal " << journal_path(jr_dirpath_)
+                  << ":" << strerror(errno));
+  }
+  Rps_NoSafepointLock<std::mutex> gu(jr_mtx_);
+  jr_nbrecords_ += nbrec;
+  jr_nbcommits_++;
+  jr_nbbytes_ += buf.size();
+} // end Rps_Journal::commit_batch
+
+/// Before a dump into the journaled directory, the records committed
+/// so far move to the old journal, and new ones go to a fresh journal.
+/// Both are replayed by the loader, the old one first, until the dump
+/// completes.
+void
+Rps_Journal::begin_dump(const std::string&realdirpath)
+{
+  if (!active() || realdirpath != jr_dirpath_)
+    return;
+  flush();
+  Rps_NoSafepointLock<std::mutex> gufil(jr_filemtx_);
+  std::string curpath = journal_path(jr_dirpath_);
+  std::string oldpath = journal_path(jr_dirpath_, true);
+  if (jr_fd_ >= 0)
+    ::close(jr_fd_);
+  jr_fd_ = -1;
+  if (!access(oldpath.c_str(), F_OK))
+    {
+      /// a previous dump failed; keep the older records first
+      std::string content = rps_journal_read_file(curpath);
+      size_t validlen = scan_records(content, curpath, nullptr);
+      int ofd = ::open(oldpath.c_str(), O_WRONLY|O_APPEND|O_CLOEXEC);
+      if (ofd < 0
+          || (validlen > jr_magic_len
+              && !rps_journal_write_all(ofd, content.data() + jr_magic_len,
+                                        validlen - jr_magic_len))
+          || fdatasync(ofd))
+        RPS_FATALOUT("failed to append journal " << curpath << " to " << oldpath
+                     << ":" << strerror(errno));
+      ::close(ofd);
+    }
+  else if (rename(curpath.c_str(), oldpath.c_str()))
+    RPS_FATALOUT("failed to rename journal " << curpath << " to " << oldpath
+                 << ":" << strerror(errno));
+  open_file(true);
+} // end Rps_Journal::begin_dump
+
+/// After a successful dump, the old journal is useless. Any journal of
+/// a directory which is not journaled now is stale.
+void
+Rps_Journal::end_dump(const std::string&realdirpath)
+{
+  bool ours = false;
+  {
+    Rps_NoSafepointLock<std::mutex> gu(jr_mtx_);
+    ours = jr_active_.load() && realdirpath == jr_dirpath_;
+  }
+  std::string oldpath = journal_path(realdirpath, true);
+  if (unlink(oldpath.c_str()) && errno != ENOENT)
+    RPS_WARNOUT("failed to remove old journal " << oldpath << ":" << strerror(errno));
+  if (!ours)
+    {
+      std::string curpath = journal_path(realdirpath);
+      if (unlink(curpath.c_str()) && errno != ENOENT)
+        RPS_WARNOUT("failed to remove stale journal " << curpath << ":" << strerror(errno));
+    }
+} // end Rps_Journal::end_dump
+
+void
+Rps_Journal::output(std::ostream&out)
+{
+  Rps_NoSafepointLock<std::mutex> gu(jr_mtx_);
+  if (!jr_active_.load())
+    {
+      out << "mutation journal inactive" << std::endl;
+      return;
+    }
+  out << "mutation journal " << journal_path(jr_dirpath_)
+      << ": " << jr_nbrecords_ << " records in " << jr_nbcommits_
+      << " commits, " << jr_nbbytes_ << " bytes, "
+      << jr_pending_.size() << " pending objects" << std::endl;
+} // end Rps_Journal::output
+
+//////////////////////////////////////////////////////////// end of file journal_rps.cc
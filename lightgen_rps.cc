@@ -129,7 +129,7 @@ rps_generate_lightning_code(Rps_CallFrame*callerframe,
                  Rps_ObjectRef obgenerator;
                 );
   _f.obmodule = obmodule;
-  std::lock_guard<std::recursive_mutex> gumodule(*obmodule->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gumodule(*obmodule->objmtxptr());
   _f.obgenerator =
     Rps_ObjectRef::make_object(&_,
                                RPS_ROOT_OB(_6SM7PykipQW01HVClH) //midend_lightning_code_generator∈class
@@ -46,14 +46,14 @@ extern "C" const char rps_load_date[];
 const char rps_load_date[]= __DATE__;
 
 Json::Value
-rps_load_string_to_json(const std::string&str, const char*filnam, int lineno)
+rps_load_string_to_json(std::string_view str, const char*filnam, int lineno)
 {
   Json::CharReaderBuilder jsonreaderbuilder;
   std::unique_ptr<Json::CharReader> pjsonreader(jsonreaderbuilder.newCharReader());
   Json::Value jv;
   JSONCPP_STRING errstr;
   RPS_ASSERT(pjsonreader);
-  if (!pjsonreader->parse(str.c_str(), str.c_str() + str.size(), &jv, &errstr))
+  if (!pjsonreader->parse(str.data(), str.data() + str.size(), &jv, &errstr))
     {
       if (filnam != nullptr && lineno > 0)
         {
@@ -67,6 +67,14 @@ rps_load_string_to_json(const std::string&str, const char*filnam, int lineno)
 
 
 //////////////////////////////////////////////// loader
+
+bool rps_lazy_load;
+Rps_LoadStatistics rps_load_statistics;
+
+class Rps_Loader;
+/// the loader of a lazy load, kept while some objects are unfilled
+static std::atomic<Rps_Loader*> rps_lazy_loader;
+
 class Rps_Loader
 {
   std::string ld_topdir;
@@ -96,18 +104,80 @@ class Rps_Loader
   static constexpr unsigned ld_maxtodo = 1<<20;
   /// dictionary of payload loaders - used as a cache to avoid most dlsym-s
   std::map<std::string,rpsldpysig_t*> ld_payloadercache;
-  bool is_object_starting_line(Rps_Id spacid, unsigned lineno, const std::string&linbuf, Rps_Id*pobid);
+  bool is_object_starting_line(Rps_Id spacid, unsigned lineno, std::string_view linbuf, Rps_Id*pobid);
   Rps_ObjectRef fetch_one_constant_at(const char*oid,int lin);
   void parse_json_buffer_second_pass (Rps_Id spacid, unsigned lineno,
-                                      Rps_Id objid, const std::string& objbuf, unsigned count);
+                                      Rps_Id objid, std::string_view objbuf, unsigned count);
+  void fill_loaded_object (Rps_Id spacid, unsigned lineno,
+                           Rps_Id objid, const Json::Value& objjson, unsigned count);
+  void replay_journal(void);
+  /// true when the manifest has the RPS_BINARY_FORMAT
+  bool ld_binary;
+  /// the "codec" of the manifest, empty for uncompressed space files
+  std::string ld_codec;
+  /// A space file is memory mapped once, and scanned once to find
+  /// the byte offsets of its objects; both passes then parse slices
+  /// of that mapping.
+  struct objspan_st
+  {
+    Rps_Id os_oid;
+    unsigned os_lineno;
+    size_t os_start;            // of the //+ob line
+    size_t os_end;
+  };
+  struct spacemap_st
+  {
+    Rps_Id sm_spacid;
+    std::string sm_path;
+    const char* sm_base;
+    size_t sm_size;
+    /// a compressed space file is decompressed here, and sm_base
+    /// points into it instead of a mapping
+    std::string sm_inflated;
+    size_t sm_prologend;
+    std::vector<objspan_st> sm_objects;
+    /// for binary space files, os_lineno is the record rank
+    std::unique_ptr<Rps_BinaryStoreReader> sm_binreader;
+    std::string_view prolog(void) const
+    {
+      return std::string_view(sm_base, sm_prologend);
+    };
+    std::string_view span(const objspan_st&os) const
+    {
+      return std::string_view(sm_base + os.os_start, os.os_end - os.os_start);
+    };
+  };
+  std::map<Rps_Id,spacemap_st> ld_spacemaps;
+  void map_space_file(Rps_Id spacid, spacemap_st&sm);
+  void unmap_space_files(void);
+  static void run_in_parallel(unsigned nbitems, const std::function<void(unsigned)>&fun);
+  void fill_object_span(const spacemap_st&sm, const objspan_st&os, unsigned count);
+  /// With --lazy-load, the second pass leaves unfilled the objects
+  /// without payload nor magic getter which are neither roots nor
+  /// constants. They keep their span in ld_lazymap, and the space
+  /// files stay mapped until the last of them is filled.
+  bool is_lazy_span(const spacemap_st&sm, const objspan_st&os) const;
+  std::set<Rps_Id> ld_constantidset;
+  std::recursive_mutex ld_lazymtx;
+  std::unordered_map<Rps_ObjectZone*,std::pair<const spacemap_st*,const objspan_st*>> ld_lazymap;
+  std::atomic<unsigned> ld_nbunfilled;
+  bool ld_finished;
 public:
+  void materialize_lazy_object(Rps_ObjectZone*obz);
+  void forget_lazy_object(Rps_ObjectZone*obz);
+  void gc_mark_lazy(Rps_GarbageCollector&gc) const;
+  unsigned nb_unfilled(void) const
+  {
+    return ld_nbunfilled.load();
+  };
+  /// once loaded, the loader is kept only for unfilled objects
+  bool finish_load(void);
   Rps_Loader(const std::string&topdir);
   ~Rps_Loader();
   void parse_manifest_file(void);
   void parse_user_manifest(const std::string&path);
   void first_pass_space(Rps_Id spacid);
   void initialize_constant_objects(void);
-  void second_pass_space(Rps_Id spacid);
   std::string string_of_loaded_file(const std::string& relpath);
   std::string space_file_path(Rps_Id spacid);
   std::string load_real_path(const std::string& path);
@@ -141,7 +211,15 @@ Rps_Loader::Rps_Loader(const std::string&topdir) :
   ld_mapobjects(),
   ld_todoque(),
   ld_todocount(0),
-  ld_payloadercache()
+  ld_payloadercache(),
+  ld_binary(false),
+  ld_codec(),
+  ld_spacemaps(),
+  ld_constantidset(),
+  ld_lazymtx(),
+  ld_lazymap(),
+  ld_nbunfilled(0),
+  ld_finished(false)
 {
   RPS_DEBUG_LOG(LOAD, "Rps_Loader constr topdir=" << topdir
                 << " this@" << (void*)this
@@ -155,6 +233,7 @@ Rps_Loader::~Rps_Loader()
                 << " this@" << (void*)this
                 << std::endl
                 << RPS_FULL_BACKTRACE_HERE(1, "Rps_Loader constr"));
+  unmap_space_files();
 } // end Rps_Loader::~Rps_Loader
 
 
@@ -200,13 +279,15 @@ Rps_Loader::space_file_path(Rps_Id spacid)
 {
   if (!spacid.valid())
     throw std::runtime_error("Rps_Loader::space_file_path invalid spacid");
-  return std::string{"persistore/sp"} + spacid.to_string() + "-rps.json";
+  return std::string{"persistore/sp"} + spacid.to_string()
+         + (ld_binary?"-rps.bin":"-rps.json")
+         + rps_codec_suffix(ld_codec);
 } // end Rps_Loader::space_file_path
 
 
 
 bool
-Rps_Loader::is_object_starting_line(Rps_Id spacid, unsigned lineno, const std::string&linbuf, Rps_Id*pobid)
+Rps_Loader::is_object_starting_line(Rps_Id spacid, unsigned lineno, std::string_view linbuf, Rps_Id*pobid)
 {
   const char*reason = nullptr;
   const char*oidstart = nullptr;
@@ -232,7 +313,7 @@ Rps_Loader::is_object_starting_line(Rps_Id spacid, unsigned lineno, const std::s
       reason = "too short";
       goto bad;
     }
-  linestart = linbuf.c_str();
+  linestart = linbuf.data();
   oidstart = linestart + strlen("//+ob");
   char oidbuf[Rps_Id::nbchars+8];
   memset (oidbuf, 0, sizeof(oidbuf));
@@ -295,87 +376,228 @@ bad:
 
 
 
+/// Map a space file, check that it is UTF-8, and find its object
+/// starting lines. The memchr and memmem of the GNU libc are already
+/// vectorized, and lines are only counted up to object starts.
+void
+Rps_Loader::map_space_file(Rps_Id spacid, spacemap_st&sm)
+{
+  sm.sm_spacid = spacid;
+  sm.sm_path = load_real_path(space_file_path(spacid));
+  sm.sm_base = nullptr;
+  sm.sm_size = 0;
+  sm.sm_inflated.clear();
+  sm.sm_prologend = 0;
+  sm.sm_objects.clear();
+  sm.sm_binreader.reset();
+  const std::string& spacepath = sm.sm_path;
+  int fd = open(spacepath.c_str(), O_RDONLY|O_CLOEXEC);
+  if (fd < 0)
+    throw RPS_RUNTIME_ERROR_OUT("failed to open space file " << spacepath
+                                << ":" << strerror(errno));
+  struct stat st;
+  memset (&st, 0, sizeof(st));
+  if (fstat(fd, &st))
+    {
+      int err = errno;
+      close(fd);
+      throw RPS_RUNTIME_ERROR_OUT("failed to stat space file " << spacepath
+                                  << ":" << strerror(err));
+    }
+  size_t size = st.st_size;
+  if (size > 0)
+    {
+      void*ad = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ad == MAP_FAILED)
+        {
+          int err = errno;
+          close(fd);
+          throw RPS_RUNTIME_ERROR_OUT("failed to mmap space file " << spacepath
+                                      << " of " << size << " bytes:" << strerror(err));
+        }
+      (void) madvise(ad, size, MADV_SEQUENTIAL|MADV_WILLNEED);
+      sm.sm_base = (const char*)ad;
+      sm.sm_size = size;
+    }
+  close(fd);
+  if (!ld_codec.empty() && sm.sm_base)
+    {
+      /// the compressed mapping is only needed while decompressing
+      std::string inflated;
+      try
+        {
+          inflated = rps_decompress_buffer(sm.sm_base, sm.sm_size, ld_codec, spacepath);
+        }
+      catch (...)
+        {
+          munmap((void*)sm.sm_base, sm.sm_size);
+          sm.sm_base = nullptr;
+          sm.sm_size = 0;
+          throw;
+        }
+      munmap((void*)sm.sm_base, sm.sm_size);
+      RPS_DEBUG_LOG(LOAD, "map_space_file decompressed " << spacepath << " from "
+                    << sm.sm_size << " to " << inflated.size() << " bytes");
+      sm.sm_inflated = std::move(inflated);
+      sm.sm_base = sm.sm_inflated.empty()?nullptr:sm.sm_inflated.data();
+      sm.sm_size = size = sm.sm_inflated.size();
+    }
+  const char*base = sm.sm_base;
+  const char*end = base + size;
+  if (ld_binary)
+    {
+      /// the binary reader validates the whole header and indexes
+      /// the records; their spans are relative to the mapped base
+      sm.sm_binreader = std::make_unique<Rps_BinaryStoreReader>(base, size, spacepath);
+      unsigned rank = 0;
+      for (const Rps_BinaryStoreReader::bs_record_st& rec: sm.sm_binreader->records())
+        sm.sm_objects.push_back(objspan_st{rec.br_oid, ++rank, rec.br_start,
+                                           rec.br_start + rec.br_size});
+      RPS_DEBUG_LOG(LOAD, "map_space_file binary " << spacepath << " of " << size
+                    << " bytes has " << sm.sm_objects.size() << " objects");
+      return;
+    }
+  unsigned lineno = 1;
+  const char*counted = base;
+  auto count_lines_upto = [&](const char*pc)
+  {
+    unsigned nl = 0;
+    for (const char*p = counted; p < pc; p++)
+      nl += (*p == '\n');
+    lineno += nl;
+    counted = pc;
+  };
+  if (const uint8_t*bad = u8_check(reinterpret_cast<const uint8_t*>(base), size))
+    {
+      count_lines_upto((const char*)bad);
+      RPS_WARN("non UTF8 line#%u in %s", lineno, spacepath.c_str());
+      char errbuf[40];
+      snprintf(errbuf, sizeof(errbuf), "non UTF8 line#%u", lineno);
+      throw std::runtime_error(std::string(errbuf) + " in " + spacepath);
+    }
+  static constexpr char obmark[] = "\n//+ob";
+  constexpr size_t obmarklen = sizeof(obmark)-1;
+  const char*linestart = nullptr;
+  if (size >= obmarklen-1 && !memcmp(base, obmark+1, obmarklen-1))
+    linestart = base;
+  else if (size > 0)
+    {
+      const char*m = (const char*)memmem(base, size, obmark, obmarklen);
+      linestart = m?(m+1):nullptr;
+    }
+  while (linestart)
+    {
+      count_lines_upto(linestart);
+      const char*eol = (const char*)memchr(linestart, '\n', end - linestart);
+      if (!eol)
+        eol = end;
+      Rps_Id curobjid;
+      if (is_object_starting_line(spacid, lineno,
+                                  std::string_view(linestart, eol - linestart),
+                                  &curobjid))
+        {
+          size_t off = linestart - base;
+          if (sm.sm_objects.empty())
+            sm.sm_prologend = off;
+          else
+            sm.sm_objects.back().os_end = off;
+          sm.sm_objects.push_back(objspan_st{curobjid, lineno, off, size});
+        }
+      const char*m = (eol < end)
+                     ? (const char*)memmem(eol, end - eol, obmark, obmarklen)
+                     : nullptr;
+      linestart = m?(m+1):nullptr;
+    }
+  if (sm.sm_objects.empty())
+    sm.sm_prologend = size;
+  RPS_DEBUG_LOG(LOAD, "map_space_file " << spacepath << " of " << size
+                << " bytes has " << sm.sm_objects.size() << " objects");
+} // end Rps_Loader::map_space_file
+
+void
+Rps_Loader::unmap_space_files(void)
+{
+  for (auto& it: ld_spacemaps)
+    {
+      spacemap_st& sm = it.second;
+      if (sm.sm_base && sm.sm_inflated.empty())
+        munmap((void*)sm.sm_base, sm.sm_size);
+      sm.sm_base = nullptr;
+      sm.sm_size = 0;
+      sm.sm_inflated.clear();
+      sm.sm_objects.clear();
+      sm.sm_binreader.reset();
+    }
+  ld_spacemaps.clear();
+} // end Rps_Loader::unmap_space_files
+
+/// the space file has been mapped and scanned by map_space_file
 void
 Rps_Loader::first_pass_space(Rps_Id spacid)
 {
-  auto spacepath = load_real_path(space_file_path(spacid));
-  std::ifstream ins(spacepath);
-  std::string prologstr;
+  const spacemap_st& sm = ld_spacemaps.at(spacid);
+  const std::string& spacepath = sm.sm_path;
   int obcnt = 0;
   int expectedcnt = 0;
-  unsigned lincnt = 0;
   RPS_DEBUG_LOG(LOAD, "first_pass_space start spacepath=" << spacepath);
-  for (std::string linbuf; std::getline(ins, linbuf); )
+  if (sm.sm_binreader)
     {
-      lincnt++;
-      if (u8_check(reinterpret_cast<const uint8_t*> (linbuf.c_str()),
-                   linbuf.size()))
+      if (sm.sm_binreader->space_id() != spacid)
+        RPS_FATALOUT("binary space file " << spacepath << " should have space "
+                     << spacid << " but has " << sm.sm_binreader->space_id());
+      expectedcnt = (int) sm.sm_binreader->records().size();
+    }
+  else
+    {
+      Json::Value prologjson;
+      try
         {
-          RPS_WARN("non UTF8 line#%d in %s:\n%s",
-                   lincnt, spacepath.c_str(), linbuf.c_str());
-          char errbuf[40];
-          snprintf(errbuf, sizeof(errbuf), "non UTF8 line#%d", lincnt);
-          throw std::runtime_error(std::string(errbuf) + " in " + spacepath);
+          prologjson = rps_load_string_to_json(sm.prolog());
+          if (prologjson.type() != Json::objectValue)
+            RPS_FATAL("Rps_Loader::first_pass_space %s bad Json type #%d",
+                      spacepath.c_str(), (int)prologjson.type());
         }
-      if (RPS_UNLIKELY(obcnt == 0))
+      catch (std::exception& exc)
         {
-          prologstr += linbuf;
-          prologstr += '\n';
-        }
-      Rps_Id curobjid;
-      if (is_object_starting_line(spacid, lincnt, linbuf, &curobjid))
+          RPS_FATALOUT("Rps_Loader::first_pass_space " << " spacepath:" << spacepath
+                       << " failed to parse prologue: " << exc.what());
+        };
+      Json::Value formatjson = prologjson["format"];
+      if (formatjson.type() !=Json::stringValue)
+        RPS_FATALOUT("space file " << spacepath
+                     << " with bad format type#" << (int)formatjson.type());
+      if (formatjson.asString() != RPS_MANIFEST_FORMAT
+          && formatjson.asString() != RPS_PREVIOUS_MANIFEST_FORMAT)
+        RPS_FATALOUT("space file " << spacepath
+                     << "should have format: "
+                     << RPS_MANIFEST_FORMAT
+                     << " or " << RPS_PREVIOUS_MANIFEST_FORMAT
+                     << " but got "
+                     << formatjson);
+      if (prologjson["spaceid"].asString() != spacid.to_string())
+        RPS_FATAL("spacefile %s should have spaceid: '%s' but got '%s'",
+                  spacepath.c_str (), spacid.to_string().c_str(),
+                  prologjson["spaceid"].asString().c_str());
+      Json::Value nbobjectsjson =  prologjson["nbobjects"];
+      expectedcnt =nbobjectsjson.asInt();
+    }
+  for (const objspan_st& os: sm.sm_objects)
+    {
+      Rps_Id curobjid = os.os_oid;
+      RPS_DEBUG_LOG(LOAD, "firstpass got ob spacid:" << spacid
+                    << " line#" << os.os_lineno
+                    << " curobjid:" << curobjid
+                    << " count:" << (obcnt+1));
+      Rps_ObjectRef obref(Rps_ObjectZone::make_loaded(curobjid, this));
+      if (ld_mapobjects.find(curobjid) != ld_mapobjects.end())
         {
-          RPS_DEBUG_LOG(LOAD, "firstpass got ob spacid:" << spacid
-                        << " linbuf: " << linbuf
-                        << " lincnt#" << lincnt
-                        << " curobjid:" << curobjid
-                        << " count:" << (obcnt+1));
-          if (RPS_UNLIKELY(obcnt == 0))
-            {
-              Json::Value prologjson;
-              try
-                {
-                  prologjson = rps_load_string_to_json(prologstr);
-                  if (prologjson.type() != Json::objectValue)
-                    RPS_FATAL("Rps_Loader::first_pass_space %s line#%d bad Json type #%d",
-                              spacepath.c_str(), (int)lincnt, (int)prologjson.type());
-                }
-              catch (std::exception& exc)
-                {
-                  RPS_FATALOUT("Rps_Loader::first_pass_space " << " spacepath:" << spacepath
-                               << " line#" << lincnt
-                               << " failed to parse: " << exc.what());
-                };
-              Json::Value formatjson = prologjson["format"];
-              if (formatjson.type() !=Json::stringValue)
-                RPS_FATALOUT("space file " << spacepath
-                             << " with bad format type#" << (int)formatjson.type());
-              if (formatjson.asString() != RPS_MANIFEST_FORMAT
-                  && formatjson.asString() != RPS_PREVIOUS_MANIFEST_FORMAT)
-                RPS_FATALOUT("space file " << spacepath
-                             << "should have format: "
-                             << RPS_MANIFEST_FORMAT
-                             << " or " << RPS_PREVIOUS_MANIFEST_FORMAT
-                             << " but got "
-                             << formatjson);
-              if (prologjson["spaceid"].asString() != spacid.to_string())
-                RPS_FATAL("spacefile %s should have spaceid: '%s' but got '%s'",
-                          spacepath.c_str (), spacid.to_string().c_str(),
-                          prologjson["spaceid"].asString().c_str());
-              Json::Value nbobjectsjson =  prologjson["nbobjects"];
-              expectedcnt =nbobjectsjson.asInt();
-            }
-          Rps_ObjectRef obref(Rps_ObjectZone::make_loaded(curobjid, this));
-          if (ld_mapobjects.find(curobjid) != ld_mapobjects.end())
-            {
-              RPS_WARN("duplicate object of oid %s in  line#%d in %s",
-                       curobjid.to_string().c_str(), lincnt, spacepath.c_str());
-              throw std::runtime_error(std::string("duplicate objid "
-                                                   + curobjid.to_string() + " in " + spacepath));
-            }
-          ld_mapobjects.insert({curobjid,obref});
-          obcnt++;
+          RPS_WARN("duplicate object of oid %s in  line#%u in %s",
+                   curobjid.to_string().c_str(), os.os_lineno, spacepath.c_str());
+          throw std::runtime_error(std::string("duplicate objid "
+                                               + curobjid.to_string() + " in " + spacepath));
         }
+      ld_mapobjects.insert({curobjid,obref});
+      obcnt++;
     }
   if (obcnt != expectedcnt)
     {
@@ -384,6 +606,13 @@ Rps_Loader::first_pass_space(Rps_Id spacid)
       throw std::runtime_error(std::string("unexpected object count in ")
                                + spacepath);
     }
+  {
+    uint64_t digest = 0;
+    for (const objspan_st& os: sm.sm_objects)
+      digest = rps_dump_space_digest_add(digest, os.os_oid);
+    rps_dump_note_loaded_space(ld_topdir, spacid, sm.sm_objects.size(),
+                               digest, ld_startclock, ld_binary, ld_codec);
+  }
   RPS_DEBUG_LOG(LOAD, "first_pass_space end spacepath=" << spacepath << " obcnt="<< obcnt << std::endl
                 << "... read " << obcnt
                 << " objects while loading first pass of " << spacepath);
@@ -392,7 +621,7 @@ Rps_Loader::first_pass_space(Rps_Id spacid)
 void
 Rps_Loader::add_todo(const std::function<void(Rps_Loader*)>& todofun)
 {
-  std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
   ld_todoque.push_back(todo_st{rps_elapsed_real_time(),todofun});
 } // end Rps_Loader::add_todo
 
@@ -409,7 +638,7 @@ Rps_Loader::run_some_todo_functions(void)
   {
     todo_st td;
     {
-      std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+      Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
       bool emptyq = ld_todoque.empty();
       if (emptyq)
         return 0;
@@ -426,7 +655,7 @@ Rps_Loader::run_some_todo_functions(void)
     {
       todo_st td;
       {
-        std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+        Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
         bool emptyq = ld_todoque.empty();
         if (emptyq)
           return 0;
@@ -442,7 +671,7 @@ Rps_Loader::run_some_todo_functions(void)
     }
   /// finally
   {
-    std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
     return ld_todoque.size();
   }
 } // end of Rps_Loader::run_some_todo_functions
@@ -460,7 +689,7 @@ rps_load_add_todo(Rps_Loader*ld,const std::function<void(Rps_Loader*)>& todofun)
 void
 Rps_Loader::initialize_constant_objects(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
 #define RPS_INSTALL_CONSTANT_OB(Oid) \
   rpskob##Oid = fetch_one_constant_at(#Oid, __LINE__);
 #include "generated/rps-constants.hh"
@@ -473,6 +702,7 @@ Rps_Loader::fetch_one_constant_at(const char*oidstr, int lin)
   bool ok = false;
   Rps_Id id(oidstr, &end, &ok);
   RPS_ASSERT(end && *end==(char)0 && ok);
+  ld_constantidset.insert(id);
   auto it = ld_mapobjects.find(id);
   if (it == ld_mapobjects.end())
     {
@@ -489,7 +719,7 @@ Rps_Loader::fetch_one_constant_at(const char*oidstr, int lin)
 ////////////////
 void
 Rps_Loader::parse_json_buffer_second_pass (Rps_Id spacid, unsigned lineno,
-    Rps_Id objid, const std::string& objbuf, unsigned count)
+    Rps_Id objid, std::string_view objbuf, unsigned count)
 {
   RPS_DEBUG_LOG(LOAD, "parse_json_buffer_second_pass start spacid=" << spacid << " #" << count
                 << " lineno=" <<lineno
@@ -518,6 +748,16 @@ Rps_Loader::parse_json_buffer_second_pass (Rps_Id spacid, unsigned lineno,
                    << objbuf
                    << std::endl << "... and objjson:" << objjson);
     }
+  fill_loaded_object(spacid, lineno, objid, objjson, count);
+} // end of Rps_Loader::parse_json_buffer_second_pass
+
+
+/// fill an object created by the first pass from its JSON, parsed
+/// from text or decoded from a binary space file
+void
+Rps_Loader::fill_loaded_object (Rps_Id spacid, unsigned lineno,
+                                Rps_Id objid, const Json::Value& objjson, unsigned count)
+{
   Json::Value oidjson = objjson["oid"];
   if (oidjson.asString() != objid.to_string())
     RPS_FATALOUT("parse_json_buffer_second_pass spacid=" << spacid
@@ -543,7 +783,6 @@ Rps_Loader::parse_json_buffer_second_pass (Rps_Id spacid, unsigned lineno,
                   << " changed from " << mtim << " to " << cormtim);
       mtim = cormtim;
     }
-  obz->loader_set_mtime (this,mtim);
   if (objjson.isMember("comps"))
     {
       auto compjson = objjson["comps"];
@@ -597,7 +836,7 @@ Rps_Loader::parse_json_buffer_second_pass (Rps_Id spacid, unsigned lineno,
   if (objjson.isMember("magicattr"))
     {
       RPS_DEBUG_LOG(LOAD, "parse_json_buffer_second_pass magicattr objid=" << objid);
-      std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+      Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
       char getfunambuf[sizeof(RPS_GETTERFUN_PREFIX)+8+Rps_Id::nbchars];
       memset(getfunambuf, 0, sizeof(getfunambuf));
       char obidbuf[32];
@@ -616,7 +855,7 @@ Rps_Loader::parse_json_buffer_second_pass (Rps_Id spacid, unsigned lineno,
   if (objjson.isMember("applying"))
     {
       RPS_DEBUG_LOG(LOAD, "parse_json_buffer_second_pass applying objid=" << objid);
-      std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+      Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
       char appfunambuf[sizeof(RPS_APPLYINGFUN_PREFIX)+8+Rps_Id::nbchars];
       memset(appfunambuf, 0, sizeof(appfunambuf));
       char obidbuf[32];
@@ -637,7 +876,7 @@ Rps_Loader::parse_json_buffer_second_pass (Rps_Id spacid, unsigned lineno,
       rpsldpysig_t*pldfun = nullptr;
       auto paylstr = objjson["payload"].asString();
       {
-        std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+        Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
         auto ldit = ld_payloadercache.find(paylstr);
         if (RPS_UNLIKELY(ldit == ld_payloadercache.end()))
           {
@@ -685,89 +924,286 @@ Rps_Loader::parse_json_buffer_second_pass (Rps_Id spacid, unsigned lineno,
                        << std::endl);
         }
     }
+  /// set last, since payload mutators used by the payload loaders
+  /// touch the object
+  obz->loader_set_mtime (this,mtim);
+  /// the payload loaders fill their fields directly, so an old object
+  /// filled lazily or replayed from the journal is remembered
+  obz->gc_remember_if_old();
   RPS_DEBUG_LOG(LOAD, "parse_json_buffer_second_pass end objid=" << objid << " #" << count
                 << std::endl);
-} // end of Rps_Loader::parse_json_buffer_second_pass
+} // end of Rps_Loader::fill_loaded_object
+
+/// Replay the mutation journal of the loaded directory, if any, after
+/// the space files. Only the last record of each object matters, and
+/// all the objects are created before filling any of them, since they
+/// refer to each other.
+void
+Rps_Loader::replay_journal(void)
+{
+  std::map<Rps_Id, std::pair<Rps_Id,Json::Value>> imagemap; // oid -> space, contents
+  unsigned nbrec = 0;
+  for (bool old: {true, false})
+    {
+      std::string path = Rps_Journal::journal_path(ld_topdir, old);
+      if (access(path.c_str(), R_OK))
+        continue;
+      std::string content;
+      {
+        std::ifstream inp(path, std::ios::in|std::ios::binary);
+        std::ostringstream outs;
+        outs << inp.rdbuf();
+        content = outs.str();
+      }
+      Rps_Journal::scan_records(content, path, [&](const char*body, size_t len)
+      {
+        Rps_BinaryStoreReader binreader(body, len, path);
+        for (const Rps_BinaryStoreReader::bs_record_st& rec: binreader.records())
+          {
+            imagemap[rec.br_oid] = {binreader.space_id(), binreader.decode_record(rec)};
+            nbrec++;
+          }
+      });
+    }
+  if (imagemap.empty())
+    return;
+  for (auto& it: imagemap)
+    {
+      Rps_Id oid = it.first;
+      if (ld_mapobjects.find(oid) == ld_mapobjects.end())
+        ld_mapobjects.insert({oid, Rps_ObjectRef(Rps_ObjectZone::make_loaded(oid, this))});
+    }
+  /// the space files of changed spaces are not up to date anymore,
+  /// even for incremental dumps
+  std::set<Rps_Id> changedspaces;
+  unsigned count = 0;
+  for (auto& it: imagemap)
+    {
+      Rps_Id oid = it.first;
+      Rps_Id spacid = it.second.first;
+      Rps_ObjectZone* obz = Rps_ObjectZone::find(oid);
+      RPS_ASSERT(obz != nullptr);
+      if (Rps_ObjectZone* oldspace = obz->ob_space.load())
+        changedspaces.insert(oldspace->oid());
+      changedspaces.insert(spacid);
+      forget_lazy_object(obz);
+      obz->loader_clear_contents(this);
+      count++;
+      fill_loaded_object(spacid, count, oid, it.second.second, count);
+    }
+  for (Rps_Id spacid: changedspaces)
+    rps_dump_forget_loaded_space(ld_topdir, spacid);
+  RPS_INFORMOUT("replayed " << nbrec << " journal records of " << imagemap.size()
+                << " objects in " << changedspaces.size() << " spaces from " << ld_topdir);
+} // end Rps_Loader::replay_journal
 
 ////////////////////////////////////////////////////////////////
 
 
+/// Run fun on every index below nbitems, using up to rps_nbjobs
+/// threads including the current one. Each thread grabs the next
+/// index, so slow items don't delay the others.
 void
-Rps_Loader::second_pass_space(Rps_Id spacid)
+Rps_Loader::run_in_parallel(unsigned nbitems, const std::function<void(unsigned)>&fun)
 {
-  RPS_DEBUG_LOG(LOAD, "Rps_Loader::second_pass_space start spacid:" << spacid
-                << std::endl << RPS_FULL_BACKTRACE_HERE(0, "RpsLoader::second_pass_space"));
-  auto spacepath = load_real_path(space_file_path(spacid));
-  std::ifstream ins(spacepath);
-  unsigned lincnt = 0;
-  unsigned obcnt = 0;
-  Rps_Id prevoid;
-  unsigned prevlin=0;
-  std::string objbuf;
-  for (std::string linbuf; std::getline(ins, linbuf); )
-    {
-      lincnt++;
-      if (linbuf.size() > 0 && linbuf[0] == '#')
-        continue;
-      Rps_Id curobjid;
-      if (is_object_starting_line(spacid,lincnt,linbuf,&curobjid))
-        {
-          obcnt++;
-          RPS_DEBUG_LOG(LOAD, "secondpass lincnt="<< lincnt
-                        << " curobjid=" << curobjid
-                        << " obcnt=" << obcnt);
-          if (objbuf.size() > 0 && prevoid && prevlin>0)
-            {
-              try
-                {
-                  parse_json_buffer_second_pass(spacid, prevlin, prevoid, objbuf, obcnt);
-                }
-              catch (const std::exception& exc)
-                {
-                  RPS_FATALOUT("failed second pass in space " << spacid
-                               << " prevoid:" << prevoid
-                               << " line#" << prevlin
-                               << std::endl
-                               << "... got exception of type "
-                               << typeid(exc).name()
-                               << ":"
-                               << exc.what());
-                };
-              prevoid = Rps_Id(nullptr);
-            }
-          objbuf.clear();
-          objbuf = linbuf + '\n';
-          prevoid = curobjid;
-          prevlin = lincnt;
-        }
-      else if (objbuf.size() > 0)
-        {
-          objbuf += linbuf;
-          objbuf += '\n';
-        }
-    } // end for getline
-  if (objbuf.size() > 0 && prevoid && prevlin>0)
+  RPS_ASSERT(fun);
+  std::atomic<unsigned> nextix(0);
+  auto work = [&](int thix)
+  {
+    if (thix > 0)
+      {
+        char thname[16];
+        memset(thname, 0, sizeof(thname));
+        snprintf(thname, sizeof(thname), "rps-load#%d", thix);
+        pthread_setname_np(pthread_self(), thname);
+      }
+    for (;;)
+      {
+        unsigned ix = nextix.fetch_add(1);
+        if (ix >= nbitems)
+          break;
+        fun(ix);
+      }
+  };
+  int nbthreads = rps_nbjobs;
+  if (nbthreads > (int)nbitems)
+    nbthreads = (int)nbitems;
+  std::vector<std::thread> threads;
+  for (int thix=1; thix<nbthreads; thix++)
+    threads.emplace_back(work, thix);
+  work(0);
+  for (std::thread& th: threads)
+    th.join();
+} // end Rps_Loader::run_in_parallel
+
+
+/// fill an object from its span in a mapped space file
+void
+Rps_Loader::fill_object_span(const spacemap_st&sm, const objspan_st&os, unsigned count)
+{
+  Rps_Id spacid = sm.sm_spacid;
+  if (sm.sm_binreader)
     {
+      const Rps_BinaryStoreReader::bs_record_st rec
+      {os.os_oid, os.os_start, os.os_end - os.os_start};
       try
         {
-          parse_json_buffer_second_pass(spacid, prevlin, prevoid, objbuf, obcnt);
+          fill_loaded_object(spacid, os.os_lineno, os.os_oid,
+                             sm.sm_binreader->decode_record(rec), count);
         }
       catch (const std::exception& exc)
         {
-          RPS_FATALOUT("failed second pass in " << spacid
-                       << " prevoid:" << prevoid
-                       << " line#" << prevlin
-                       << std::endl
-                       << "... got exception of type "
-                       << typeid(exc).name()
-                       << ":"
-                       << exc.what());
+          RPS_FATALOUT("failed second pass in binary space " << spacid
+                       << " oid:" << os.os_oid
+                       << " record#" << os.os_lineno
+                       << ":" << exc.what());
         };
-      prevoid = Rps_Id(nullptr);
+      return;
+    }
+  std::string_view objview = sm.span(os);
+  /// lines starting with # are skipped, as they used to be
+  std::string filtered;
+  if (RPS_UNLIKELY(objview.find("\n#") != std::string_view::npos))
+    {
+      size_t pos = 0;
+      while (pos < objview.size())
+        {
+          size_t eol = objview.find('\n', pos);
+          size_t nextpos = (eol == std::string_view::npos)?objview.size():eol+1;
+          if (objview[pos] != '#')
+            filtered.append(objview.substr(pos, nextpos-pos));
+          pos = nextpos;
+        }
+      objview = filtered;
+    }
+  try
+    {
+      parse_json_buffer_second_pass(spacid, os.os_lineno, os.os_oid, objview, count);
+    }
+  catch (const std::exception& exc)
+    {
+      RPS_FATALOUT("failed second pass in space " << spacid
+                   << " oid:" << os.os_oid
+                   << " line#" << os.os_lineno
+                   << std::endl
+                   << "... got exception of type "
+                   << typeid(exc).name()
+                   << ":"
+                   << exc.what());
     };
-  RPS_DEBUG_LOG(LOAD, "Rps_Loader::second_pass_space end spacid:" << spacid);
-} // end of Rps_Loader::second_pass_space
+} // end Rps_Loader::fill_object_span
 
+bool
+Rps_Loader::is_lazy_span(const spacemap_st&sm, const objspan_st&os) const
+{
+  if (ld_globrootsidset.find(os.os_oid) != ld_globrootsidset.end()
+      || ld_constantidset.find(os.os_oid) != ld_constantidset.end())
+    return false;
+  /// payloads (symbols, classes, agendas...) have side effects when
+  /// loaded, and magic getters are used without the attribute object
+  if (sm.sm_binreader)
+    {
+      const Rps_BinaryStoreReader::bs_record_st rec
+      {os.os_oid, os.os_start, os.os_end - os.os_start};
+      return !sm.sm_binreader->record_has_member(rec, "payload")
+             && !sm.sm_binreader->record_has_member(rec, "magicattr");
+    }
+  /// a quoted "payload" inside some JSON string would be escaped, so
+  /// this can only be wrong by making an object eager
+  std::string_view objview = sm.span(os);
+  return objview.find("\"payload\"") == std::string_view::npos
+         && objview.find("\"magicattr\"") == std::string_view::npos;
+} // end Rps_Loader::is_lazy_span
+
+/// Fill an unfilled object; it is removed from ld_lazymap first, so
+/// uses of itself while filling don't recurse. Other threads wait on
+/// ld_lazymtx until the unfilled bit is cleared.
+void
+Rps_Loader::materialize_lazy_object(Rps_ObjectZone*obz)
+{
+  RPS_ASSERT(obz != nullptr);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(ld_lazymtx);
+  auto it = ld_lazymap.find(obz);
+  if (it == ld_lazymap.end())
+    return;
+  const spacemap_st* sm = it->second.first;
+  const objspan_st* os = it->second.second;
+  ld_lazymap.erase(it);
+  fill_object_span(*sm, *os, os->os_lineno);
+  if (ld_finished)
+    while (run_some_todo_functions() > 0)
+      continue;
+  obz->qz_gcinfo.fetch_and((uint16_t)~Rps_ObjectZone::qz_unfilled_bit,
+                           std::memory_order_release);
+  if (ld_nbunfilled.fetch_sub(1) == 1 && ld_finished)
+    (void) finish_load();
+} // end Rps_Loader::materialize_lazy_object
+
+/// a journaled object is replayed instead of being filled
+void
+Rps_Loader::forget_lazy_object(Rps_ObjectZone*obz)
+{
+  Rps_NoSafepointLock<std::recursive_mutex> gu(ld_lazymtx);
+  if (ld_lazymap.erase(obz) == 0)
+    return;
+  obz->qz_gcinfo.fetch_and((uint16_t)~Rps_ObjectZone::qz_unfilled_bit,
+                           std::memory_order_release);
+  ld_nbunfilled.fetch_sub(1);
+} // end Rps_Loader::forget_lazy_object
+
+/// An unfilled object may refer to any loaded object, so all of them
+/// stay alive while some are unfilled. The collector runs with the
+/// mutators stopped, so ld_mapobjects cannot be cleared meanwhile.
+void
+Rps_Loader::gc_mark_lazy(Rps_GarbageCollector&gc) const
+{
+  if (ld_nbunfilled.load() == 0)
+    return;
+  for (auto& it: ld_mapobjects)
+    gc.mark_root_objectref(it.second);
+} // end Rps_Loader::gc_mark_lazy
+
+/// called at the end of rps_load_from, and again after the last
+/// unfilled object is filled; returns true if the loader is still
+/// needed
+bool
+Rps_Loader::finish_load(void)
+{
+  Rps_NoSafepointLock<std::recursive_mutex> gu(ld_lazymtx);
+  ld_finished = true;
+  if (ld_nbunfilled.load() > 0)
+    return true;
+  if (rps_lazy_loader.load() == this)
+    {
+      unmap_space_files();
+      ld_mapobjects.clear();
+      RPS_INFORMOUT("lazy load of " << ld_topdir << " has filled every object");
+    }
+  return false;
+} // end Rps_Loader::finish_load
+
+void
+rps_load_materialize(Rps_ObjectZone*obz)
+{
+  Rps_Loader*ld = rps_lazy_loader.load();
+  RPS_ASSERT(ld != nullptr);
+  ld->materialize_lazy_object(obz);
+} // end rps_load_materialize
+
+void
+rps_load_gc_mark(Rps_GarbageCollector&gc)
+{
+  if (Rps_Loader*ld = rps_lazy_loader.load())
+    ld->gc_mark_lazy(gc);
+} // end rps_load_gc_mark
+
+unsigned
+rps_load_nb_unfilled(void)
+{
+  if (Rps_Loader*ld = rps_lazy_loader.load())
+    return ld->nb_unfilled();
+  return 0;
+} // end rps_load_nb_unfilled
 
 void
 Rps_Loader::load_all_state_files(void)
@@ -776,6 +1212,31 @@ Rps_Loader::load_all_state_files(void)
                 << std::endl << RPS_FULL_BACKTRACE_HERE(0, "RpsLoader::load_all_state_files"));
   int spacecnt1 = 0, spacecnt2 = 0;
   int todocount = 0;
+  double phasetime = rps_monotonic_real_time();
+  auto end_phase = [&](double& phasefield)
+  {
+    double now = rps_monotonic_real_time();
+    phasefield = now - phasetime;
+    phasetime = now;
+  };
+  /// every space file is mapped and scanned only once, concurrently
+  std::vector<Rps_Id> spacevec(ld_spaceset.begin(), ld_spaceset.end());
+  std::vector<spacemap_st*> spacemapvec;
+  for (Rps_Id spacid: spacevec)
+    spacemapvec.push_back(&ld_spacemaps[spacid]);
+  run_in_parallel((unsigned) spacevec.size(), [&](unsigned spix)
+  {
+    try
+      {
+        map_space_file(spacevec[spix], *spacemapvec[spix]);
+      }
+    catch (const std::exception& exc)
+      {
+        RPS_FATALOUT("failed to map space " << spacevec[spix]
+                     << ":" << exc.what());
+      }
+  });
+  end_phase(rps_load_statistics.ls_mapping);
   for (Rps_Id spacid: ld_spaceset)
     {
       first_pass_space(spacid);
@@ -783,21 +1244,61 @@ Rps_Loader::load_all_state_files(void)
     }
   RPS_NOPRINTOUT("loaded " << spacecnt1 << " space files in first pass");
   initialize_constant_objects();
-  /// conceptually, the second pass might be done in parallel
-  /// (multi-threaded, with different threads working on different
-  /// spaces), but this require more clever locking and
-  /// synchronization, so might be done after reaching our milestone#2
-  for (Rps_Id spacid: ld_spaceset)
+  run_some_todo_functions();
+  end_phase(rps_load_statistics.ls_firstpass);
+  /// The first pass created every object, so the second pass fills
+  /// them concurrently: each object is filled by one thread, and
+  /// objects refer to others only thru pointers. Todo functions added
+  /// meanwhile are queued under ld_mtx, and run afterwards by this
+  /// thread only.
+  std::vector<std::pair<const spacemap_st*,const objspan_st*>> objspans;
+  for (unsigned spix=0; spix<spacevec.size(); spix++)
     {
-      run_some_todo_functions();
-      second_pass_space(spacid);
+      for (const objspan_st& os: spacemapvec[spix]->sm_objects)
+        objspans.push_back({spacemapvec[spix], &os});
       spacecnt2++;
     }
+  if (rps_lazy_load)
+    {
+      /// the lazy objects are marked before any filling, since eager
+      /// ones may use them
+      rps_lazy_loader.store(this);
+      std::vector<std::pair<const spacemap_st*,const objspan_st*>> eagerspans;
+      for (auto& it: objspans)
+        {
+          if (!is_lazy_span(*it.first, *it.second))
+            {
+              eagerspans.push_back(it);
+              continue;
+            }
+          Rps_ObjectZone*obz = ld_mapobjects.at(it.second->os_oid).optr();
+          ld_lazymap.insert({obz, it});
+          obz->qz_gcinfo.fetch_or(Rps_ObjectZone::qz_unfilled_bit);
+        }
+      ld_nbunfilled.store(ld_lazymap.size());
+      RPS_INFORMOUT("lazy load of " << ld_topdir << " fills " << eagerspans.size()
+                    << " objects and leaves " << ld_lazymap.size() << " unfilled");
+      objspans = std::move(eagerspans);
+    }
+  run_in_parallel((unsigned) objspans.size(), [&](unsigned obix)
+  {
+    fill_object_span(*objspans[obix].first, *objspans[obix].second, obix+1);
+  });
+  RPS_DEBUG_LOG(LOAD, "Rps_Loader::load_all_state_files parsed " << objspans.size()
+                << " objects in second pass with " << rps_nbjobs << " threads");
+  objspans.clear();
+  if (ld_lazymap.empty())
+    unmap_space_files();
+  end_phase(rps_load_statistics.ls_secondpass);
+  replay_journal();
+  end_phase(rps_load_statistics.ls_journal);
   while (run_some_todo_functions()>0)
     {
       // we sleep a tiny bit, so elapsed time is growing...
       usleep(20);
     };
+  end_phase(rps_load_statistics.ls_todo);
+  rps_load_statistics.ls_nbspaces = spacecnt1;
   RPS_DEBUG_LOG(LOAD, "Rps_Loader::load_all_state_files end this@" << (void*)this);
   RPS_INFORMOUT("loaded " << spacecnt1 << " space files in second pass with "
                 << ld_mapobjects.size() << " objects and " << todocount << " todos" << std::endl);
@@ -1015,7 +1516,7 @@ Rps_InstanceZone::load_from_json(Rps_Loader*ld, const Json::Value& jv)
     }
   {
     RPS_ASSERT(obclass);
-    std::lock_guard<std::recursive_mutex> guclass (*(obclass->objmtxptr()));
+    std::lock_guard<Rps_ObjectMutex> guclass (*(obclass->objmtxptr()));
     auto clpayl = obclass->get_classinfo_payload();
     const Rps_SetOb*setat = nullptr;
     if (clpayl
@@ -1085,7 +1586,7 @@ Rps_InstanceZone::fill_loaded_instance_from_json(Rps_Loader*ld,Rps_ObjectRef obc
     }
   {
     RPS_ASSERT(obclass);
-    std::lock_guard<std::recursive_mutex> guclass (*(obclass->objmtxptr()));
+    std::lock_guard<Rps_ObjectMutex> guclass (*(obclass->objmtxptr()));
     auto clpayl = obclass->get_classinfo_payload();
     const Rps_SetOb*attrset = nullptr;
     if (clpayl
@@ -1179,11 +1680,27 @@ Rps_Loader::parse_manifest_file(void)
     {
       RPS_FATALOUT("Rps_Loader::parse_manifest_file failed to parse: " << exc.what());
     };
-  if (manifjson["format"].asString() != RPS_MANIFEST_FORMAT && manifjson["format"].asString() != RPS_PREVIOUS_MANIFEST_FORMAT)
-    RPS_FATAL("manifest map in %s should have format: '%s' or older '%s' but got:\n"
+  if (manifjson["format"].asString() == RPS_BINARY_FORMAT)
+    ld_binary = true;
+  else if (manifjson["format"].asString() != RPS_MANIFEST_FORMAT && manifjson["format"].asString() != RPS_PREVIOUS_MANIFEST_FORMAT)
+    RPS_FATAL("manifest map in %s should have format: '%s' or older '%s' or binary '%s' but got:\n"
               "%s",
               manifpath.c_str (), RPS_MANIFEST_FORMAT, RPS_PREVIOUS_MANIFEST_FORMAT,
+              RPS_BINARY_FORMAT,
               manifjson["format"].toStyledString().c_str());
+  if (manifjson.isMember("codec"))
+    {
+      ld_codec = manifjson["codec"].asString();
+      try
+        {
+          (void) rps_codec_suffix(ld_codec);
+        }
+      catch (const std::exception& exc)
+        {
+          RPS_FATALOUT("Rps_Loader::parse_manifest_file in " << manifpath
+                       << " has unsupported codec: " << exc.what());
+        }
+    }
   /// parse spaceset
   {
     auto spsetjson = manifjson["spaceset"];
@@ -1229,7 +1746,7 @@ Rps_Loader::parse_manifest_file(void)
     size_t sizeplugins = pluginsjson.size();
     RPS_DEBUG_LOG(LOAD, "loader parse_manifest_file sizeplugins=" << sizeplugins);
     {
-      std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+      Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
       for (int ix=0; ix<(int)sizeplugins; ix++)
         {
           std::string curpluginidstr = pluginsjson[ix].asString();
@@ -1357,7 +1874,7 @@ Rps_Loader::parse_user_manifest(const std::string&umpath)
         size_t sizeplugins = pluginsjson.size();
         RPS_DEBUG_LOG(LOAD, "loader parse_user_manifest sizeplugins=" << sizeplugins);
         {
-          std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+          Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
           for (int ix=0; ix<(int)sizeplugins; ix++)
             {
               std::string curpluginidstr = pluginsjson[ix].asString();
@@ -1391,7 +1908,7 @@ void Rps_Loader::load_install_roots(void)
   RPS_DEBUG_LOG(LOAD, "loader load_install_roots start");
   for (Rps_Id curootid: ld_globrootsidset)
     {
-      std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+      Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
       Rps_ObjectRef curootobr = find_object_by_oid(curootid);
       if (!curootobr)
         RPS_FATALOUT("load_install_roots: curootid " << curootid
@@ -1402,7 +1919,7 @@ void Rps_Loader::load_install_roots(void)
   /// install the hard coded global roots
   int nbroots=0;
   {
-    std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
 #define RPS_INSTALL_ROOT_OB(Oid)    {     \
       const char *end##Oid = nullptr;     \
       bool ok##Oid = false;       \
@@ -1424,7 +1941,7 @@ void Rps_Loader::load_install_roots(void)
   /// install the hard coded symbols
   int nbsymb=0;
   {
-    std::lock_guard<std::recursive_mutex> gu(ld_mtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gu(ld_mtx);
 #define RPS_INSTALL_NAMED_ROOT_OB(Oid,Name)    {  \
       const char *end##Oid##Name = nullptr;   \
       bool ok##Oid##Name = false;     \
@@ -1467,24 +1984,33 @@ void rps_load_from (const std::string& dirpath)
                 << std::endl
                 << RPS_FULL_BACKTRACE_HERE(1, "rps_load_from"));
   {
-    Rps_Loader loader(dirpath);
+    /// a lazy load keeps its loader for the unfilled objects
+    auto loader = std::make_unique<Rps_Loader>(dirpath);
     try
       {
-        loader.parse_manifest_file();
+        loader->parse_manifest_file();
         {
           std::string usermanifest{rps_homedir()};
           usermanifest += "/";
           usermanifest += RPS_USER_MANIFEST_JSON;
           if (!access(usermanifest.c_str(), R_OK))
-            loader.parse_user_manifest(usermanifest);
+            loader->parse_user_manifest(usermanifest);
         }
-        loader.load_all_state_files();
-        loader.load_install_roots();
+        loader->load_all_state_files();
+        double rootstime = rps_monotonic_real_time();
+        loader->load_install_roots();
         RPS_DEBUG_LOG(LOAD, "rps_load_from start dirpath=" << dirpath << " after load_install_roots");
-        rps_initialize_roots_after_loading(&loader);
-        rps_initialize_symbols_after_loading(&loader);
-        nbloaded = loader.nb_loaded_objects();
+        rps_initialize_roots_after_loading(loader.get());
+        rps_initialize_symbols_after_loading(loader.get());
+        rps_load_statistics.ls_roots = rps_monotonic_real_time() - rootstime;
+        nbloaded = loader->nb_loaded_objects();
+        rps_load_statistics.ls_nbobjects = nbloaded;
+        rps_load_statistics.ls_nbunfilled = loader->nb_unfilled();
         RPS_DEBUG_LOG(LOAD, "rps_load_from start dirpath=" << dirpath << " nbloaded=" << nbloaded);
+        if (loader->finish_load())
+          (void) loader.release();
+        else if (rps_lazy_loader.load() == loader.get())
+          rps_lazy_loader.store(nullptr);
       }
     catch (const std::exception& exc)
       {
@@ -1501,6 +2027,7 @@ void rps_load_from (const std::string& dirpath)
   endcput = rps_process_cpu_time();
   double realt = endrealt - startrealt;
   double cput = endcput - startcput;
+  rps_load_statistics.ls_total = realt;
   char realtbuf[32];
   char cputbuf[32];
   char realmicrobuf[32];
@@ -1523,6 +2050,9 @@ void rps_load_from (const std::string& dirpath)
                 << Rps_QuasiZone::cumulative_allocated_wordcount() << " memory words."<< std::endl
                 << "============================================================================="
                 << std::endl << std::endl);
+  if (rps_load_nb_unfilled() > 0)
+    RPS_INFORMOUT("lazy load left " << rps_load_nb_unfilled()
+                  << " objects unfilled until their first use");
 } // end of rps_load_from
 
 
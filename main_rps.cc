@@ -150,6 +150,110 @@ struct argp_option rps_progoptions[] =
     /*doc:*/ "To set for RefPerSys a named EXTRA argument to ARG.\n", ///
     /*group:*/0 ///
   },
+  /* ======= garbage collection pacing ======= */
+  {/*name:*/ "gc-growth", ///
+    /*key:*/ RPSPROGOPT_GC_GROWTH, ///
+    /*arg:*/ "FACTOR", ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Garbage collect when the heap has grown by FACTOR over\n"
+    " the live size of the previous collection, default 2.0\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "gc-soft-cap", ///
+    /*key:*/ RPSPROGOPT_GC_SOFT_CAP, ///
+    /*arg:*/ "MEGABYTES", ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Above that heap size, garbage collect fully and more often,\n"
+    " e.g. --gc-soft-cap=2048; default is no cap\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "gc-cpu-budget", ///
+    /*key:*/ RPSPROGOPT_GC_CPU_BUDGET, ///
+    /*arg:*/ "PERCENT", ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Postpone garbage collections using more than PERCENT\n"
+    " of the agenda worker time, default 10\n", ///
+    /*group:*/0 ///
+  },
+  /* ======= binary or textual space files ======= */
+  {/*name:*/ "dump-format", ///
+    /*key:*/ RPSPROGOPT_DUMP_FORMAT, ///
+    /*arg:*/ "FORMAT", ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Dump space files in FORMAT, either json (the default)"
+    " or binary; the loader follows the format of the manifest\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "dump-compress", ///
+    /*key:*/ RPSPROGOPT_DUMP_COMPRESS, ///
+    /*arg:*/ "CODEC", ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Compress dumped space files with CODEC, either zstd"
+    " or none (the default); recorded in the manifest for the loader\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "convert-store", ///
+    /*key:*/ RPSPROGOPT_CONVERT_STORE, ///
+    /*arg:*/ "FORMAT", ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Convert the space files of the load directory to FORMAT,"
+    " json or binary, without loading them, then exit\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "journal", ///
+    /*key:*/ RPSPROGOPT_JOURNAL, ///
+    /*arg:*/ nullptr, ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Journal every mutation of persistent objects after load,"
+    " so a crash between dumps loses at most a tenth of second of changes\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "background-dump", ///
+    /*key:*/ RPSPROGOPT_BACKGROUND_DUMP, ///
+    /*arg:*/ nullptr, ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Run the dumps requested thru the event loop in a background"
+    " thread, without stopping the agenda; best with --journal\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "incremental-dump", ///
+    /*key:*/ RPSPROGOPT_INCREMENTAL_DUMP, ///
+    /*arg:*/ nullptr, ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Dump only the space files containing objects modified"
+    " since the previous dump or load of the same directory\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "lazy-load", ///
+    /*key:*/ RPSPROGOPT_LAZY_LOAD, ///
+    /*arg:*/ nullptr, ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "Load most objects lazily, filling them from their space"
+    " file when first used; roots, constants and objects with payloads"
+    " are still loaded at start\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "benchmark-agenda", ///
+    /*key:*/ RPSPROGOPT_BENCHMARK_AGENDA, ///
+    /*arg:*/ "NBTASKLETS[:COSTMICROSEC[:LOW/NORMAL/HIGH[:RATE]]]", ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "After load, run NBTASKLETS synthetic tasklets, each spinning"
+    " COSTMICROSEC microseconds, with priorities drawn by the LOW/NORMAL/HIGH"
+    " weights and added at RATE tasklets per second (0 for at once), thru"
+    " the agenda with --jobs workers; print throughput, latency percentiles"
+    " and per-worker utilization, then exit\n", ///
+    /*group:*/0 ///
+  },
+  {/*name:*/ "benchmark-load", ///
+    /*key:*/ RPSPROGOPT_BENCHMARK_LOAD, ///
+    /*arg:*/ "NBOBJECTS[:ATTRS[:COMPS[:CLASSES]]]", ///
+    /*flags:*/ 0, ///
+    /*doc:*/ "After load, generate a synthetic heap of NBOBJECTS objects"
+    " with ATTRS attributes and COMPS components in CLASSES classes,"
+    " dump it in a temporary directory, load that dump in a child"
+    " process and print timings of every load phase, then exit\n", ///
+    /*group:*/0 ///
+  },
   /* ======= interface thru some FIFO, relevant for JSONRPC  ======= */
   {/*name:*/ "interface-fifo", ///
     /*key:*/ RPSPROGOPT_INTERFACEFIFO, ///
@@ -1353,7 +1457,18 @@ main (int argc, char** argv)
       rps_my_load_dir = std::string(rpld);
       free ((void*)rpld);
     };
+  if (!rps_convert_store_format.empty())
+    {
+      rps_convert_store(rps_my_load_dir, rps_convert_store_format == "binary");
+      exit(EXIT_SUCCESS);
+    };
   rps_load_from(rps_my_load_dir);
+  if (!rps_benchmark_load_spec.empty())
+    rps_benchmark_load(rps_benchmark_load_spec);
+  if (!rps_benchmark_agenda_spec.empty())
+    rps_benchmark_agenda(rps_benchmark_agenda_spec);
+  if (rps_journal_enabled)
+    Rps_Journal::open(rps_my_load_dir);
   RPS_POSSIBLE_BREAKPOINT();
   //// at this point the persistent heap has been completely loaded!
   atexit (rps_exiting);
@@ -1366,6 +1481,7 @@ main (int argc, char** argv)
       RPS_POSSIBLE_BREAKPOINT();
       RPS_DEBUG_LOG(REPL, "before calling rps_event_loop");
       rps_event_loop();
+      rps_finish_background_dump();
     }
   ////
   RPS_POSSIBLE_BREAKPOINT();
@@ -79,7 +79,7 @@ Rps_InstanceZone::class_attrset(Rps_ObjectRef obclass)
 {
   if (!obclass || obclass.is_empty())
     return nullptr;
-  std::lock_guard<std::recursive_mutex> gucla(*(obclass->objmtxptr()));
+  std::lock_guard<Rps_ObjectMutex> gucla(*(obclass->objmtxptr()));
   auto paylcl = obclass->get_classinfo_payload();
   if (!paylcl)
     return nullptr;
@@ -162,7 +162,7 @@ Rps_InstanceZone::make_from_attributes_components(Rps_ObjectRef classob,
 {
   Rps_InstanceZone*res = nullptr;
   RPS_ASSERT(classob);
-  std::lock_guard<std::recursive_mutex> gucla(*(classob->objmtxptr()));
+  std::lock_guard<Rps_ObjectMutex> gucla(*(classob->objmtxptr()));
   auto clpayl = classob->get_classinfo_payload();
   if (!clpayl)
     throw RPS_RUNTIME_ERROR_OUT("Rps_InstanceZone::make_from_attributes_components with bad class:"
@@ -731,6 +731,8 @@ Rps_PayloadObjMap::put_obmap(Rps_ObjectRef obkey, Rps_Value val)
 {
   RPS_ASSERT(obkey);
   obm_map.insert({obkey,val});
+  gc_write_barrier(obkey);
+  gc_write_barrier(val);
 } // end Rps_PayloadObjMap::put_obmap
 
 void
@@ -40,10 +40,163 @@ extern "C" const char rps_objects_date[];
 const char rps_objects_date[]= __DATE__;
 
 
-std::unordered_map<Rps_Id,Rps_ObjectZone*,Rps_Id::Hasher> Rps_ObjectZone::ob_idmap_(50777);
+Rps_OidTable Rps_ObjectZone::ob_idtable_(65536);
+
+
+//////////////////////////////////////////////////////////// attribute stores
+
+void
+Rps_AttrStore::put_sorted(const Rps_ObjectRef atob, const Rps_Value val)
+{
+  RPS_ASSERT(!is_hashed() && as_count < small_max);
+  if (as_count == as_capacity)
+    {
+      uint32_t newcapacity = std::min<uint32_t>(2*as_capacity, small_max);
+      entry_st* newheap = new entry_st[newcapacity];
+      const entry_st* oldents = entries();
+      for (unsigned ix=0; ix<as_count; ix++)
+        newheap[ix] = oldents[ix];
+      delete[] as_heap;
+      for (unsigned ix=0; ix<inline_max; ix++)
+        as_inline[ix] = entry_st{};
+      as_heap = newheap;
+      as_capacity = newcapacity;
+    }
+  entry_st* ents = as_heap?as_heap:as_inline;
+  unsigned pos = as_count;
+  while (pos > 0 && atob < ents[pos-1].en_atob)
+    {
+      ents[pos] = ents[pos-1];
+      pos--;
+    }
+  ents[pos].en_atob = atob;
+  ents[pos].en_val = val;
+  as_count++;
+} // end Rps_AttrStore::put_sorted
+
+void
+Rps_AttrStore::put_hashed(entry_st*table, uint32_t capacity,
+                          const Rps_ObjectRef atob, const Rps_Value val)
+{
+  size_t mask = capacity-1;
+  size_t ix = hash_slot(atob.optr(), capacity);
+  while (!table[ix].en_atob.is_empty())
+    ix = (ix+1) & mask;
+  table[ix].en_atob = atob;
+  table[ix].en_val = val;
+} // end Rps_AttrStore::put_hashed
+
+void
+Rps_AttrStore::rehash(uint32_t newcapacity)
+{
+  RPS_ASSERT(newcapacity > small_max && (newcapacity & (newcapacity-1)) == 0);
+  entry_st* newtable = new entry_st[newcapacity];
+  for_each_unordered([&](const Rps_ObjectRef atob, const Rps_Value val)
+  {
+    put_hashed(newtable, newcapacity, atob, val);
+  });
+  delete[] as_heap;
+  for (unsigned ix=0; ix<inline_max; ix++)
+    as_inline[ix] = entry_st{};
+  as_heap = newtable;
+  as_capacity = newcapacity;
+} // end Rps_AttrStore::rehash
+
+/// back from the hashed table to a sorted vector
+void
+Rps_AttrStore::unhash(void)
+{
+  RPS_ASSERT(is_hashed() && as_count <= small_max);
+  entry_st* newheap = new entry_st[small_max];
+  unsigned cnt = 0;
+  for_each([&](const Rps_ObjectRef atob, const Rps_Value val)
+  {
+    newheap[cnt].en_atob = atob;
+    newheap[cnt].en_val = val;
+    cnt++;
+  });
+  delete[] as_heap;
+  as_heap = newheap;
+  as_capacity = small_max;
+} // end Rps_AttrStore::unhash
+
+void
+Rps_AttrStore::put(const Rps_ObjectRef atob, const Rps_Value val)
+{
+  if (atob.is_empty())
+    return;
+  entry_st* ent = const_cast<entry_st*>(find_entry(atob.optr()));
+  if (ent)
+    {
+      ent->en_val = val;
+      return;
+    }
+  if (!is_hashed())
+    {
+      if (as_count < small_max)
+        {
+          put_sorted(atob, val);
+          return;
+        }
+      rehash(4*small_max);
+    }
+  else if ((as_count+1)*2 > as_capacity)
+    rehash(2*as_capacity);
+  put_hashed(as_heap, as_capacity, atob, val);
+  as_count++;
+} // end Rps_AttrStore::put
+
+bool
+Rps_AttrStore::erase(const Rps_ObjectRef atob)
+{
+  if (atob.is_empty())
+    return false;
+  entry_st* ent = const_cast<entry_st*>(find_entry(atob.optr()));
+  if (!ent)
+    return false;
+  if (!is_hashed())
+    {
+      entry_st* ents = as_heap?as_heap:as_inline;
+      for (unsigned ix = ent-ents; ix+1<as_count; ix++)
+        ents[ix] = ents[ix+1];
+      ents[as_count-1] = entry_st{};
+      as_count--;
+      return true;
+    }
+  /// backward shift deletion keeps every probe sequence unbroken
+  size_t mask = as_capacity-1;
+  size_t hole = ent-as_heap;
+  as_heap[hole] = entry_st{};
+  for (size_t ix = (hole+1) & mask; !as_heap[ix].en_atob.is_empty(); ix = (ix+1) & mask)
+    {
+      size_t home = hash_slot(as_heap[ix].en_atob.optr(), as_capacity);
+      // the entry moves back unless its home is cyclically in (hole, ix]
+      bool stays = (hole <= ix)
+                   ? (home > hole && home <= ix)
+                   : (home > hole || home <= ix);
+      if (stays)
+        continue;
+      as_heap[hole] = as_heap[ix];
+      as_heap[ix] = entry_st{};
+      hole = ix;
+    }
+  as_count--;
+  if (as_count <= small_max/2)
+    unhash();
+  return true;
+} // end Rps_AttrStore::erase
+
+void
+Rps_AttrStore::clear(void)
+{
+  delete[] as_heap;
+  as_heap = nullptr;
+  for (unsigned ix=0; ix<inline_max; ix++)
+    as_inline[ix] = entry_st{};
+  as_count = 0;
+  as_capacity = inline_max;
+} // end Rps_AttrStore::clear
 
-std::map<Rps_Id,Rps_ObjectZone*> Rps_ObjectZone::ob_idbucketmap_[Rps_Id::maxbuckets];
-std::recursive_mutex Rps_ObjectZone::ob_idmtx_;
 
 
 
@@ -71,7 +224,7 @@ Rps_ObjectRef::output(std::ostream&outs, unsigned depth, unsigned maxdepth) cons
     outs << "??";
   else
     {
-      std::lock_guard<std::recursive_mutex> gu(*_optr->objmtxptr());
+      std::lock_guard<Rps_ObjectMutex> gu(*_optr->objmtxptr());
       Rps_Value valname = obptr()->get_physical_attr(RPS_ROOT_OB(_1EBVGSfW2m200z18rx)); //name
       outs << "◌" /*U+25CC DOTTED CIRCLE*/
            << obptr()-> oid().to_string();
@@ -100,7 +253,7 @@ Rps_ObjectRef::output(std::ostream&outs, unsigned depth, unsigned maxdepth) cons
           Rps_ObjectRef obclass = obptr()-> get_class();
           if (obclass)
             {
-              std::lock_guard<std::recursive_mutex> gucl(*obclass->objmtxptr());
+              std::lock_guard<Rps_ObjectMutex> gucl(*obclass->objmtxptr());
               auto obclpayl = obclass->get_dynamic_payload<Rps_PayloadClassInfo>();
               if (obclpayl)
                 {
@@ -123,7 +276,7 @@ Rps_ObjectRef::as_string(void) const
   else if (_optr == RPS_EMPTYSLOT)
     return std::string{"_⁂_"}; //U+2042 ASTERISM
   const Rps_Id curoid = _optr->oid();
-  std::lock_guard<std::recursive_mutex> gu(*_optr->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*_optr->objmtxptr());
   if (const Rps_PayloadSymbol*symbpayl
       = _optr->get_dynamic_payload<Rps_PayloadSymbol>())
     {
@@ -180,17 +333,13 @@ Rps_ObjectZone::val_output(std::ostream&out, unsigned depth, unsigned maxdepth)
   out << oid().to_string();
   if (depth<2)
     {
-      std::lock_guard<std::recursive_mutex> gu(ob_idmtx_);
+      std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
       out << "⟦"; // U+27E6 MATHEMATICAL LEFT WHITE SQUARE BRACKET
-      auto namit = ob_attrs.find(RPS_ROOT_OB(_1EBVGSfW2m200z18rx)); //name∈named_attribute);
-      if (namit != ob_attrs.end())
+      Rps_Value namv = ob_attrs.get(RPS_ROOT_OB(_1EBVGSfW2m200z18rx)); //name∈named_attribute);
+      if (namv && namv.is_string())
         {
-          Rps_Value namv = namit->second;
-          if (namv.is_string())
-            {
-              out << "⏵"; // U+23F5 BLACK MEDIUM RIGHT-POINTING TRIANGLE
-              out << namv.as_cstring();
-            }
+          out << "⏵"; // U+23F5 BLACK MEDIUM RIGHT-POINTING TRIANGLE
+          out << namv.as_cstring();
         }
       auto obcl = ob_class.load();
       if (obcl)
@@ -211,41 +360,32 @@ void
 Rps_ObjectZone::register_objzone(Rps_ObjectZone*obz)
 {
   RPS_ASSERT(obz != nullptr);
-  std::lock_guard<std::recursive_mutex> gu(ob_idmtx_);
   auto oid = obz->oid();
   RPS_DEBUG_LOG(LOWREP, "register_objzone obz=" << obz << " oid=" << oid
                 << std::endl
                 << RPS_FULL_BACKTRACE_HERE(1, "register_objzone"));
-  if (ob_idmap_.find(oid) != ob_idmap_.end())
+  Rps_OidTable::read_guard rg(ob_idtable_);
+  Rps_ObjectZone* oldobz = ob_idtable_.insert_or_replace(oid, obz);
+  /// a dead object waiting for the lazy sweep is replaced
+  if (oldobz && oldobz != obz && !oldobz->is_awaiting_sweep())
     RPS_FATALOUT("Rps_ObjectZone::register_objzone duplicate oid " << oid);
-  ob_idmap_.insert({oid,obz});
-  ob_idbucketmap_[oid.bucket_num()].insert({oid,obz});
 } // end Rps_ObjectZone::register_objzone
 
 Rps_Id
 Rps_ObjectZone::fresh_random_oid(Rps_ObjectZone*obz)
 {
-  Rps_Id oid;
-  std::lock_guard<std::recursive_mutex> gu(ob_idmtx_);
-  while(true)
-    {
-      oid = Rps_Id::random();
-      if (RPS_UNLIKELY(ob_idmap_.find(oid) != ob_idmap_.end()))
-        continue;
-      if (obz)
-        ob_idmap_.insert({oid,obz});
-      RPS_DEBUG_LOG(LOWREP, "Rps_ObjectZone::fresh_random_oid obz=" << obz
-                    << " -> oid=" << oid);
-      return oid;
-    }
-}
+  Rps_Id oid = ob_idtable_.fresh_random(obz);
+  RPS_DEBUG_LOG(LOWREP, "Rps_ObjectZone::fresh_random_oid obz=" << obz
+                << " -> oid=" << oid);
+  return oid;
+} // end Rps_ObjectZone::fresh_random_oid
 
 
 Rps_ObjectZone::Rps_ObjectZone(Rps_Id oid, registermode_en regmod)
   : Rps_ZoneValue(Rps_Type::Object),
     ob_oid(oid), ob_mtx(), ob_class(nullptr),
     ob_space(nullptr), ob_mtime(0.0),
-    ob_attrs(), ob_comps(), ob_payload(nullptr),
+    ob_attrs(), ob_comps(), ob_payload(nullptr), ob_paylstat(0),
     ob_magicgetterfun(nullptr),
     ob_applyingfun(nullptr)
 {
@@ -266,7 +406,7 @@ Rps_ObjectZone::Rps_ObjectZone(Rps_Id oid, registermode_en regmod)
   // Every object should have a class, initially `object`; the
   // ob_class can later be replaced, but we need something which is
   // not null.... That atomic field could be later overwritten.
-  ob_class.store(RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ)); //object∈class
+  store_class(RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ)); //object∈class
 } // end Rps_ObjectZone::Rps_ObjectZone
 
 
@@ -279,10 +419,10 @@ Rps_ObjectZone::~Rps_ObjectZone()
   ob_comps.clear();
   ob_class.store(nullptr);
   ob_mtime.store(0.0);
-  std::lock_guard<std::recursive_mutex> gu(ob_idmtx_);
   RPS_DEBUG_LOG(LOWREP,"~Rps_ObjectZone curid=" << curid << " this=" << this);
-  ob_idmap_.erase(curid);
-  ob_idbucketmap_[curid.bucket_num()].erase(curid);
+  /// the oid could have been registered again by another object while
+  /// we were waiting for the lazy sweep
+  ob_idtable_.remove(curid, this);
 } // end Rps_ObjectZone::~Rps_ObjectZone()
 
 Rps_ObjectZone::Rps_ObjectZone() :
@@ -297,6 +437,7 @@ Rps_ObjectZone::Rps_ObjectZone() :
 void
 Rps_ObjectZone::put_applying_function(rps_applyingfun_t*afun)
 {
+  materialize();
   auto oldappfun = ob_applyingfun.exchange(afun);
   if (oldappfun)
     {
@@ -323,7 +464,7 @@ Rps_ObjectZone::make(void)
   // Every object should have a class, initially `object`; the
   // ob_class can later be replaced, but we need something which is
   // not null.... That atomic field could be later overwritten.
-  obz->ob_class.store(RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ)); //object∈class
+  obz->store_class(RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ)); //object∈class
   RPS_DEBUG_LOG(LOWREP, "Rps_ObjectZone::make oid=" << oid << " obz=" << obz
                 << std::endl
                 << RPS_FULL_BACKTRACE_HERE(1, "Rps_ObjectZone::make"));
@@ -342,7 +483,7 @@ Rps_ObjectZone::make_loaded(Rps_Id oid, Rps_Loader* ld)
   // Every object should have a class, initially `object`; the
   // ob_class can later be replaced, but we need something which is
   // not null.... The loader could later overwrite that.
-  obz->ob_class.store(RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ)); //object∈class
+  obz->store_class(RPS_ROOT_OB(_5yhJGgxLwLp00X0xEQ)); //object∈class
   return obz;
 } // end Rps_ObjectZone::make_loaded
 
@@ -352,36 +493,41 @@ Rps_ObjectZone::find(Rps_Id oid)
 {
   if (!oid.valid())
     return nullptr;
-  std::lock_guard<std::recursive_mutex> gu(ob_idmtx_);
-  auto obr = ob_idmap_.find(oid);
-  if (obr != ob_idmap_.end())
-    return obr->second;
+  /// the lazy sweep cannot free obz before we have checked it
+  Rps_OidTable::read_guard rg(ob_idtable_);
+  Rps_ObjectZone* obz = ob_idtable_.lookup(oid);
+  if (obz && !obz->is_awaiting_sweep())
+    return obz;
   return nullptr;
 } // end Rps_ObjectZone::find
 
 void
 Rps_ObjectZone::gc_mark(Rps_GarbageCollector&gc, unsigned) const
 {
+  /// we don't lock ob_mtx here: marking threads may be scanning
+  /// other objects referring to this one
   if (is_gcmarked(gc)) return;
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
-  gc.mark_obj(this);
-  const_cast<Rps_ObjectZone*>(this)->set_gcmark(gc);
+  gc.mark_obj(const_cast<Rps_ObjectZone*>(this));
 } // end of Rps_ObjectZone::gc_mark
 
 void
 Rps_ObjectZone::mark_gc_inside(Rps_GarbageCollector&gc)
 {
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  /// a worker thread stopped at a safepoint with ob_mtx locked won't
+  /// unlock it, nor change this object, till the collection ends
+  std::unique_lock<Rps_ObjectMutex> gu(ob_mtx, std::defer_lock);
+  if (!Rps_Agenda::is_locked_by_stopped_worker(ob_mtx))
+    gu.lock();
 #warning perhaps the _gcinfo should be used here
   Rps_ObjectZone* obcla = ob_class.load();
   RPS_ASSERT(obcla != nullptr);
   gc.mark_obj(obcla);
-  for (auto atit: ob_attrs)
-    {
-      gc.mark_obj(atit.first);
-      if (atit.second.is_ptr())
-        gc.mark_value(atit.second);
-    }
+  ob_attrs.for_each_unordered([&](const Rps_ObjectRef atob, const Rps_Value atval)
+  {
+    gc.mark_obj(atob);
+    if (atval.is_ptr())
+      gc.mark_value(atval);
+  });
   for (auto compv: ob_comps)
     {
       if (compv.is_ptr())
@@ -395,13 +541,14 @@ Rps_ObjectZone::mark_gc_inside(Rps_GarbageCollector&gc)
 void
 Rps_ObjectZone::put_space(Rps_ObjectRef obr)
 {
+  materialize();
   if (obr)
     {
       if (obr->get_class() != RPS_ROOT_OB(_2i66FFjmS7n03HNNBx))
         throw std::runtime_error("invalid space object");
     };
-  ob_space.store(obr);
-  ob_mtime.store(rps_wallclock_real_time());
+  store_space(obr);
+  touch_now();
 } // end Rps_ObjectZone::put_space
 
 
@@ -409,6 +556,7 @@ Rps_ObjectZone::put_space(Rps_ObjectRef obr)
 void
 Rps_ObjectZone::remove_attr(const Rps_ObjectRef obattr)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr.is_empty() || obattr->stored_type() != Rps_Type::Object)
     return;
@@ -418,22 +566,25 @@ Rps_ObjectZone::remove_attr(const Rps_ObjectRef obattr)
       throw RPS_RUNTIME_ERROR_OUT("cannot remove magic attribute " << obattr
                                   << " in " << Rps_ObjectRef(this));
   }
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   ob_attrs.erase(obattr);
-  ob_mtime.store(rps_wallclock_real_time());
+  touch_now();
 } // end Rps_ObjectZone::remove_attr
 
 
 Rps_Value
 Rps_ObjectZone::set_of_attributes([[maybe_unused]] Rps_CallFrame*stkf) const
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   unsigned nbat = ob_attrs.size();
   std::vector<Rps_ObjectRef> vecat;
   vecat.reserve(nbat);
-  for (auto it : ob_attrs)
-    vecat.push_back(it.first);
+  ob_attrs.for_each_unordered([&](const Rps_ObjectRef atob, const Rps_Value)
+  {
+    vecat.push_back(atob);
+  });
   return Rps_SetValue(vecat);
 } // end of Rps_ObjectZone::set_of_attributes
 
@@ -441,7 +592,8 @@ Rps_ObjectZone::set_of_attributes([[maybe_unused]] Rps_CallFrame*stkf) const
 unsigned
 Rps_ObjectZone::nb_attributes([[maybe_unused]] Rps_CallFrame*stkf) const
 {
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  materialize();
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   unsigned nbat = ob_attrs.size();
   return nbat;
 } // end Rps_ObjectZone::nb_attributes
@@ -449,20 +601,19 @@ Rps_ObjectZone::nb_attributes([[maybe_unused]] Rps_CallFrame*stkf) const
 Rps_Value
 Rps_ObjectZone::get_attr1(Rps_CallFrame*stkf,const Rps_ObjectRef obattr0) const
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return nullptr;
   Rps_Value val0;
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   {
     rps_magicgetterfun_t*getfun0 = obattr0->ob_magicgetterfun.load();
     if (RPS_UNLIKELY(getfun0))
       val0 = (*getfun0)(stkf, *this, obattr0);
     else
       {
-        auto it0 = ob_attrs.find(obattr0);
-        if (it0 != ob_attrs.end())
-          val0 = it0->second;
+        val0 = ob_attrs.get(obattr0);
       }
   }
   return val0;
@@ -472,14 +623,13 @@ Rps_ObjectZone::get_attr1(Rps_CallFrame*stkf,const Rps_ObjectRef obattr0) const
 Rps_Value
 Rps_ObjectZone::get_physical_attr(const Rps_ObjectRef obattr0) const
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return nullptr;
   Rps_Value val0;
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
-  auto it0 = ob_attrs.find(obattr0);
-  if (it0 != ob_attrs.end())
-    val0 = it0->second;
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
+  val0 = ob_attrs.get(obattr0);
   return val0;
 } // end Rps_ObjectZone::get_physical_attr
 
@@ -488,6 +638,7 @@ Rps_ObjectZone::get_physical_attr(const Rps_ObjectRef obattr0) const
 Rps_TwoValues
 Rps_ObjectZone::get_attr2(Rps_CallFrame*stkf, const Rps_ObjectRef obattr0, const Rps_ObjectRef obattr1) const
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return Rps_TwoValues(nullptr,nullptr);
@@ -495,16 +646,14 @@ Rps_ObjectZone::get_attr2(Rps_CallFrame*stkf, const Rps_ObjectRef obattr0, const
     return Rps_TwoValues(nullptr,nullptr);
   Rps_Value val0;
   Rps_Value val1;
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   {
     rps_magicgetterfun_t*getfun0 = obattr0->ob_magicgetterfun.load();
     if (RPS_UNLIKELY(getfun0))
       val0 = (*getfun0)(stkf, *this, obattr0);
     else
       {
-        auto it0 = ob_attrs.find(obattr0);
-        if (it0 != ob_attrs.end())
-          val0 = it0->second;
+        val0 = ob_attrs.get(obattr0);
       }
   }
   {
@@ -513,9 +662,7 @@ Rps_ObjectZone::get_attr2(Rps_CallFrame*stkf, const Rps_ObjectRef obattr0, const
       val0 = (*getfun1)(stkf, *this, obattr1);
     else
       {
-        auto it1 = ob_attrs.find(obattr1);
-        if (it1 != ob_attrs.end())
-          val1 = it1->second;
+        val1 = ob_attrs.get(obattr1);
       }
   }
   return Rps_TwoValues(val0, val1);
@@ -525,6 +672,7 @@ Rps_ObjectZone::get_attr2(Rps_CallFrame*stkf, const Rps_ObjectRef obattr0, const
 void
 Rps_ObjectZone::put_attr(const Rps_ObjectRef obattr, const Rps_Value valattr)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr.is_empty() || obattr->stored_type() != Rps_Type::Object)
     return;
@@ -538,8 +686,8 @@ Rps_ObjectZone::put_attr(const Rps_ObjectRef obattr, const Rps_Value valattr)
   if (valattr.is_empty())
     ob_attrs.erase(obattr);
   else
-    ob_attrs.insert({obattr, valattr});
-  ob_mtime.store(rps_wallclock_real_time());
+    store_attr(obattr, valattr);
+  touch_now();
 } // end Rps_ObjectZone::put_attr
 
 
@@ -547,6 +695,7 @@ void
 Rps_ObjectZone::put_attr2(const Rps_ObjectRef obattr0, const Rps_Value valattr0,
                           const Rps_ObjectRef obattr1, const Rps_Value valattr1)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return;
@@ -568,12 +717,12 @@ Rps_ObjectZone::put_attr2(const Rps_ObjectRef obattr0, const Rps_Value valattr0,
   if (valattr0.is_empty())
     ob_attrs.erase(obattr0);
   else
-    ob_attrs.insert({obattr0, valattr0});
+    store_attr(obattr0, valattr0);
   if (valattr1.is_empty())
     ob_attrs.erase(obattr1);
   else
-    ob_attrs.insert({obattr1, valattr1});
-  ob_mtime.store(rps_wallclock_real_time());
+    store_attr(obattr1, valattr1);
+  touch_now();
 } // end Rps_ObjectZone::put_attr2
 
 void
@@ -581,6 +730,7 @@ Rps_ObjectZone::put_attr3(const Rps_ObjectRef obattr0, const Rps_Value valattr0,
                           const Rps_ObjectRef obattr1, const Rps_Value valattr1,
                           const Rps_ObjectRef obattr2, const Rps_Value valattr2)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return;
@@ -610,16 +760,16 @@ Rps_ObjectZone::put_attr3(const Rps_ObjectRef obattr0, const Rps_Value valattr0,
   if (valattr0.is_empty())
     ob_attrs.erase(obattr0);
   else
-    ob_attrs.insert({obattr0, valattr0});
+    store_attr(obattr0, valattr0);
   if (valattr1.is_empty())
     ob_attrs.erase(obattr1);
   else
-    ob_attrs.insert({obattr1, valattr1});
+    store_attr(obattr1, valattr1);
   if (valattr2.is_empty())
     ob_attrs.erase(obattr2);
   else
-    ob_attrs.insert({obattr2, valattr2});
-  ob_mtime.store(rps_wallclock_real_time());
+    store_attr(obattr2, valattr2);
+  touch_now();
 } // end Rps_ObjectZone::put_attr3
 
 
@@ -629,6 +779,7 @@ Rps_ObjectZone::put_attr4(const Rps_ObjectRef obattr0, const Rps_Value valattr0,
                           const Rps_ObjectRef obattr2, const Rps_Value valattr2,
                           const Rps_ObjectRef obattr3, const Rps_Value valattr3)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return;
@@ -666,26 +817,27 @@ Rps_ObjectZone::put_attr4(const Rps_ObjectRef obattr0, const Rps_Value valattr0,
   if (valattr0.is_empty())
     ob_attrs.erase(obattr0);
   else
-    ob_attrs.insert({obattr0, valattr0});
+    store_attr(obattr0, valattr0);
   if (valattr1.is_empty())
     ob_attrs.erase(obattr1);
   else
-    ob_attrs.insert({obattr1, valattr1});
+    store_attr(obattr1, valattr1);
   if (valattr2.is_empty())
     ob_attrs.erase(obattr2);
   else
-    ob_attrs.insert({obattr2, valattr2});
+    store_attr(obattr2, valattr2);
   if (valattr3.is_empty())
     ob_attrs.erase(obattr3);
   else
-    ob_attrs.insert({obattr3, valattr3});
-  ob_mtime.store(rps_wallclock_real_time());
+    store_attr(obattr3, valattr3);
+  touch_now();
 } // end Rps_ObjectZone::put_attr4
 
 
 void
 Rps_ObjectZone::exchange_attr(const Rps_ObjectRef obattr, const Rps_Value valattr, Rps_Value*poldval)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr.is_empty() || obattr->stored_type() != Rps_Type::Object)
     return;
@@ -699,17 +851,15 @@ Rps_ObjectZone::exchange_attr(const Rps_ObjectRef obattr, const Rps_Value valatt
   Rps_Value oldval;
   if (poldval)
     {
-      auto it = ob_attrs.find(obattr);
-      if (it != ob_attrs.end())
-        oldval = it->second;
+      oldval = ob_attrs.get(obattr);
     }
   if (valattr.is_empty())
     ob_attrs.erase(obattr);
   else
-    ob_attrs.insert({obattr, valattr});
+    store_attr(obattr, valattr);
   if (poldval)
     *poldval = oldval;
-  ob_mtime.store(rps_wallclock_real_time());
+  touch_now();
 } // end Rps_ObjectZone::exchange_attr
 
 
@@ -717,6 +867,7 @@ void
 Rps_ObjectZone::exchange_attr2(const Rps_ObjectRef obattr0, const Rps_Value valattr0, Rps_Value*poldval0,
                                const Rps_ObjectRef obattr1, const Rps_Value valattr1, Rps_Value*poldval1)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return;
@@ -739,29 +890,25 @@ Rps_ObjectZone::exchange_attr2(const Rps_ObjectRef obattr0, const Rps_Value vala
   Rps_Value oldval1;
   if (poldval0)
     {
-      auto it = ob_attrs.find(obattr0);
-      if (it != ob_attrs.end())
-        oldval0 = it->second;
+      oldval0 = ob_attrs.get(obattr0);
     }
   if (poldval1)
     {
-      auto it = ob_attrs.find(obattr1);
-      if (it != ob_attrs.end())
-        oldval1 = it->second;
+      oldval1 = ob_attrs.get(obattr1);
     }
   if (valattr0.is_empty())
     ob_attrs.erase(obattr0);
   else
-    ob_attrs.insert({obattr0, valattr0});
+    store_attr(obattr0, valattr0);
   if (valattr1.is_empty())
     ob_attrs.erase(obattr1);
   else
-    ob_attrs.insert({obattr1, valattr1});
+    store_attr(obattr1, valattr1);
   if (poldval0)
     *poldval0 = oldval0;
   if (poldval1)
     *poldval1 = oldval1;
-  ob_mtime.store(rps_wallclock_real_time());
+  touch_now();
 } // end Rps_ObjectZone::exchange_attr2
 
 void
@@ -769,6 +916,7 @@ Rps_ObjectZone::exchange_attr3(const Rps_ObjectRef obattr0, const Rps_Value vala
                                const Rps_ObjectRef obattr1, const Rps_Value valattr1, Rps_Value*poldval1,
                                const Rps_ObjectRef obattr2, const Rps_Value valattr2, Rps_Value*poldval2)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return;
@@ -800,41 +948,35 @@ Rps_ObjectZone::exchange_attr3(const Rps_ObjectRef obattr0, const Rps_Value vala
   Rps_Value oldval2;
   if (poldval0)
     {
-      auto it = ob_attrs.find(obattr0);
-      if (it != ob_attrs.end())
-        oldval0 = it->second;
+      oldval0 = ob_attrs.get(obattr0);
     }
   if (poldval1)
     {
-      auto it = ob_attrs.find(obattr1);
-      if (it != ob_attrs.end())
-        oldval1 = it->second;
+      oldval1 = ob_attrs.get(obattr1);
     }
   if (poldval2)
     {
-      auto it = ob_attrs.find(obattr2);
-      if (it != ob_attrs.end())
-        oldval2 = it->second;
+      oldval2 = ob_attrs.get(obattr2);
     }
   if (valattr0.is_empty())
     ob_attrs.erase(obattr0);
   else
-    ob_attrs.insert({obattr0, valattr0});
+    store_attr(obattr0, valattr0);
   if (valattr1.is_empty())
     ob_attrs.erase(obattr1);
   else
-    ob_attrs.insert({obattr1, valattr1});
+    store_attr(obattr1, valattr1);
   if (valattr2.is_empty())
     ob_attrs.erase(obattr2);
   else
-    ob_attrs.insert({obattr2, valattr2});
+    store_attr(obattr2, valattr2);
   if (poldval0)
     *poldval0 = oldval0;
   if (poldval1)
     *poldval1 = oldval1;
   if (poldval2)
     *poldval1 = oldval2;
-  ob_mtime.store(rps_wallclock_real_time());
+  touch_now();
 } // end Rps_ObjectZone::exchange_attr3
 
 
@@ -844,6 +986,7 @@ Rps_ObjectZone::exchange_attr4(const Rps_ObjectRef obattr0, const Rps_Value vala
                                const Rps_ObjectRef obattr2, const Rps_Value valattr2, Rps_Value*poldval2,
                                const Rps_ObjectRef obattr3, const Rps_Value valattr3, Rps_Value*poldval3)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (obattr0.is_empty() || obattr0->stored_type() != Rps_Type::Object)
     return;
@@ -884,44 +1027,36 @@ Rps_ObjectZone::exchange_attr4(const Rps_ObjectRef obattr0, const Rps_Value vala
   Rps_Value oldval3;
   if (poldval0)
     {
-      auto it = ob_attrs.find(obattr0);
-      if (it != ob_attrs.end())
-        oldval0 = it->second;
+      oldval0 = ob_attrs.get(obattr0);
     }
   if (poldval1)
     {
-      auto it = ob_attrs.find(obattr1);
-      if (it != ob_attrs.end())
-        oldval1 = it->second;
+      oldval1 = ob_attrs.get(obattr1);
     }
   if (poldval2)
     {
-      auto it = ob_attrs.find(obattr2);
-      if (it != ob_attrs.end())
-        oldval2 = it->second;
+      oldval2 = ob_attrs.get(obattr2);
     }
   if (poldval3)
     {
-      auto it = ob_attrs.find(obattr3);
-      if (it != ob_attrs.end())
-        oldval3 = it->second;
+      oldval3 = ob_attrs.get(obattr3);
     }
   if (valattr0.is_empty())
     ob_attrs.erase(obattr0);
   else
-    ob_attrs.insert({obattr0, valattr0});
+    store_attr(obattr0, valattr0);
   if (valattr1.is_empty())
     ob_attrs.erase(obattr1);
   else
-    ob_attrs.insert({obattr1, valattr1});
+    store_attr(obattr1, valattr1);
   if (valattr2.is_empty())
     ob_attrs.erase(obattr2);
   else
-    ob_attrs.insert({obattr2, valattr2});
+    store_attr(obattr2, valattr2);
   if (valattr3.is_empty())
     ob_attrs.erase(obattr3);
   else
-    ob_attrs.insert({obattr3, valattr3});
+    store_attr(obattr3, valattr3);
   if (poldval0)
     *poldval0 = oldval0;
   if (poldval1)
@@ -930,7 +1065,7 @@ Rps_ObjectZone::exchange_attr4(const Rps_ObjectRef obattr0, const Rps_Value vala
     *poldval1 = oldval2;
   if (poldval3)
     *poldval1 = oldval3;
-  ob_mtime.store(rps_wallclock_real_time());
+  touch_now();
 } // end Rps_ObjectZone::exchange_attr4
 
 
@@ -939,7 +1074,8 @@ Rps_ObjectZone::exchange_attr4(const Rps_ObjectRef obattr0, const Rps_Value vala
 unsigned
 Rps_ObjectZone::nb_components([[maybe_unused]] Rps_CallFrame*stkf) const
 {
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  materialize();
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   unsigned nbcomp = ob_comps.size();
   return nbcomp;
 } // end Rps_ObjectZone::nb_components
@@ -947,7 +1083,8 @@ Rps_ObjectZone::nb_components([[maybe_unused]] Rps_CallFrame*stkf) const
 Rps_Value
 Rps_ObjectZone::component_at ([[maybe_unused]] Rps_CallFrame*stkf, int rk, bool dontfail) const
 {
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  materialize();
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   unsigned nbcomp = ob_comps.size();
   if (rk<0) rk += nbcomp;
   if (rk>=0 && rk<(int)nbcomp)
@@ -960,11 +1097,13 @@ Rps_ObjectZone::component_at ([[maybe_unused]] Rps_CallFrame*stkf, int rk, bool
 void
 Rps_ObjectZone::append_comp1(Rps_Value comp0)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (RPS_UNLIKELY(comp0.is_empty()))
     comp0.clear();
   std::lock_guard gu(ob_mtx);
-  ob_comps.push_back(comp0);
+  store_comp(comp0);
+  touch_now();
 } // end Rps_ObjectZone::append_comp1
 
 
@@ -972,6 +1111,7 @@ Rps_ObjectZone::append_comp1(Rps_Value comp0)
 void
 Rps_ObjectZone::append_comp2(Rps_Value comp0, Rps_Value comp1)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (RPS_UNLIKELY(comp0.is_empty()))
     comp0.clear();
@@ -984,8 +1124,9 @@ Rps_ObjectZone::append_comp2(Rps_Value comp0, Rps_Value comp1)
       auto newsiz = rps_prime_above(9*ob_comps.size()/8 + 2);
       ob_comps.reserve(newsiz);
     };
-  ob_comps.push_back(comp0);
-  ob_comps.push_back(comp1);
+  store_comp(comp0);
+  store_comp(comp1);
+  touch_now();
 } // end Rps_ObjectZone::append_comp2
 
 
@@ -993,6 +1134,7 @@ Rps_ObjectZone::append_comp2(Rps_Value comp0, Rps_Value comp1)
 void
 Rps_ObjectZone::append_comp3(Rps_Value comp0, Rps_Value comp1, Rps_Value comp2)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (RPS_UNLIKELY(comp0.is_empty()))
     comp0.clear();
@@ -1000,21 +1142,23 @@ Rps_ObjectZone::append_comp3(Rps_Value comp0, Rps_Value comp1, Rps_Value comp2)
     comp1.clear();
   if (RPS_UNLIKELY(comp2.is_empty()))
     comp2.clear();
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   // we want to avoid too frequent resizes, so....
   if (RPS_UNLIKELY(ob_comps.capacity() < ob_comps.size() + 3))
     {
       auto newsiz = rps_prime_above(9*ob_comps.size()/8 + 3);
       ob_comps.reserve(newsiz);
     };
-  ob_comps.push_back(comp0);
-  ob_comps.push_back(comp1);
-  ob_comps.push_back(comp2);
+  store_comp(comp0);
+  store_comp(comp1);
+  store_comp(comp2);
+  touch_now();
 } // end Rps_ObjectZone::append_comp3
 
 void
 Rps_ObjectZone::append_comp4(Rps_Value comp0, Rps_Value comp1, Rps_Value comp2, Rps_Value comp3)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   if (RPS_UNLIKELY(comp0.is_empty()))
     comp0.clear();
@@ -1024,26 +1168,28 @@ Rps_ObjectZone::append_comp4(Rps_Value comp0, Rps_Value comp1, Rps_Value comp2,
     comp2.clear();
   if (RPS_UNLIKELY(comp3.is_empty()))
     comp3.clear();
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   // we want to avoid too frequent resizes, so....
   if (RPS_UNLIKELY(ob_comps.capacity() < ob_comps.size() + 4))
     {
       auto newsiz = rps_prime_above(9*ob_comps.size()/8 + 4);
       ob_comps.reserve(newsiz);
     };
-  ob_comps.push_back(comp0);
-  ob_comps.push_back(comp1);
-  ob_comps.push_back(comp2);
-  ob_comps.push_back(comp3);
+  store_comp(comp0);
+  store_comp(comp1);
+  store_comp(comp2);
+  store_comp(comp3);
+  touch_now();
 } // end Rps_ObjectZone::append_comp4
 
 
 void
 Rps_ObjectZone::append_components(const std::initializer_list<Rps_Value>&compil)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   unsigned nbv = compil.size();
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   // we want to avoid too frequent resizes, so....
   if (RPS_UNLIKELY(ob_comps.capacity() < ob_comps.size() + nbv))
     {
@@ -1054,16 +1200,18 @@ Rps_ObjectZone::append_components(const std::initializer_list<Rps_Value>&compil)
     {
       if (RPS_UNLIKELY(v.is_empty()))
         v.clear();
-      ob_comps.push_back(v);
+      store_comp(v);
     }
+  touch_now();
 } // end Rps_ObjectZone::append_components
 
 
 void
 Rps_ObjectZone::append_components(const std::vector<Rps_Value>&compvec)
 {
+  materialize();
   RPS_ASSERT(stored_type() == Rps_Type::Object);
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   RPS_ASSERT(stored_type() == Rps_Type::Object);
   unsigned nbv = compvec.size();
   // we want to avoid too frequent resizes, so....
@@ -1076,8 +1224,9 @@ Rps_ObjectZone::append_components(const std::vector<Rps_Value>&compvec)
     {
       if (RPS_UNLIKELY(v.is_empty()))
         v.clear();
-      ob_comps.push_back(v);
+      store_comp(v);
     }
+  touch_now();
 } // end Rps_ObjectZone::append_components
 
 
@@ -1086,8 +1235,9 @@ Rps_ObjectZone::append_components(const std::vector<Rps_Value>&compvec)
 void
 Rps_ObjectZone::dump_scan_contents(Rps_Dumper*du) const
 {
+  materialize();
   RPS_ASSERT(du != nullptr);
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   Rps_ObjectZone* obcla = ob_class.load();
   RPS_ASSERT(obcla != nullptr);
   rps_dump_scan_object(du, obcla);
@@ -1095,17 +1245,15 @@ Rps_ObjectZone::dump_scan_contents(Rps_Dumper*du) const
   RPS_ASSERT(obspace != nullptr);
   rps_dump_scan_object(du, obspace);
   rps_dump_scan_space_component(du, Rps_ObjectRef(obspace), Rps_ObjectRef(this));
-  for (auto atit: ob_attrs)
-    {
-      Rps_ObjectRef obat = atit.first;
-      Rps_Value valat = atit.second;
-      if (!rps_is_dumpable_value(du, valat))
-        continue;
-      if (!rps_is_dumpable_objref(du, obat))
-        continue;
-      rps_dump_scan_object(du, obat);
-      rps_dump_scan_value(du, valat, 0);
-    }
+  ob_attrs.for_each([&](const Rps_ObjectRef obat, const Rps_Value valat)
+  {
+    if (!rps_is_dumpable_value(du, valat))
+      return;
+    if (!rps_is_dumpable_objref(du, obat))
+      return;
+    rps_dump_scan_object(du, obat);
+    rps_dump_scan_value(du, valat, 0);
+  });
   for (auto compv: ob_comps)
     {
       if (compv.is_ptr())
@@ -1130,9 +1278,10 @@ Rps_ObjectZone::dump_scan_contents(Rps_Dumper*du) const
 void
 Rps_ObjectZone::dump_json_content(Rps_Dumper*du, Json::Value&json) const
 {
+  materialize();
   RPS_ASSERT(du != nullptr);
   RPS_ASSERT(json.type() == Json::objectValue);
-  std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+  std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
   Rps_ObjectRef thisob(this);
   Rps_ObjectZone* obcla = ob_class.load();
   RPS_ASSERT(obcla != nullptr);
@@ -1249,21 +1398,19 @@ Rps_ObjectZone::dump_json_content(Rps_Dumper*du, Json::Value&json) const
   if (!ob_attrs.empty())
     {
       Json::Value jattrs(Json::arrayValue);
-      for (auto atit: ob_attrs)
-        {
-          Rps_ObjectRef atob = atit.first;
-          Rps_Value atval = atit.second;
-          if (!rps_is_dumpable_objref(du,atob))
-            continue;
-          if (!rps_is_dumpable_objattr(du,atob))
-            continue;
-          if (!rps_is_dumpable_value(du,atval))
-            continue;
-          Json::Value jcurat(Json::objectValue);
-          jcurat["at"] = rps_dump_json_objectref(du,atob);
-          jcurat["va"] = rps_dump_json_value(du,atval);
-          jattrs.append(jcurat);
-        };
+      ob_attrs.for_each([&](const Rps_ObjectRef atob, const Rps_Value atval)
+      {
+        if (!rps_is_dumpable_objref(du,atob))
+          return;
+        if (!rps_is_dumpable_objattr(du,atob))
+          return;
+        if (!rps_is_dumpable_value(du,atval))
+          return;
+        Json::Value jcurat(Json::objectValue);
+        jcurat["at"] = rps_dump_json_objectref(du,atob);
+        jcurat["va"] = rps_dump_json_value(du,atval);
+        jattrs.append(jcurat);
+      });
       json["attrs"] = jattrs;
     }
   ///
@@ -1370,15 +1517,10 @@ Rps_ObjectZone::autocomplete_oid(const char*prefix,
                 << "', prefixlen=" << prefixlen
                 << ", idpref=" << idpref << ", idlast=" << idlast);
   int count = 0;
-  std::lock_guard<std::recursive_mutex> gu(ob_idmtx_);
-  auto& curobuck = ob_idbucketmap_[idpref.bucket_num()];
-  for (auto it = curobuck.lower_bound(idpref); it != curobuck.end(); it++)
+  for (Rps_ObjectZone* curobz: ob_idtable_.range(idpref, idlast))
     {
-      Rps_Id curid = it->first;
-      if (curid > idlast)
-        break;
       count++;
-      Rps_ObjectRef curobr = it->second;
+      Rps_ObjectRef curobr = curobz;
       if (stopfun(curobr))
         break;
     }
@@ -1430,7 +1572,7 @@ Rps_PayloadClassInfo::dump_json_content(Rps_Dumper*du, Json::Value&jv) const
   RPS_ASSERT(jv.type() == Json::objectValue);
   if (pclass_symbname)
     {
-      std::lock_guard<std::recursive_mutex> gu(*(pclass_symbname->objmtxptr()));
+      std::lock_guard<Rps_ObjectMutex> gu(*(pclass_symbname->objmtxptr()));
       auto symb = pclass_symbname->get_dynamic_payload<Rps_PayloadSymbol>();
       if (symb)
         {
@@ -1459,6 +1601,7 @@ Rps_PayloadClassInfo::loader_put_symbname(Rps_ObjectRef obr, Rps_Loader*ld)
 {
   RPS_ASSERT(ld != nullptr);
   pclass_symbname = obr;
+  gc_write_barrier(obr);
 } // end Rps_PayloadClassInfo::loader_put_symbname
 
 void
@@ -1467,6 +1610,7 @@ Rps_PayloadClassInfo::loader_put_attrset(const Rps_SetOb*setob, Rps_Loader*ld)
   RPS_ASSERT(ld != nullptr);
   RPS_ASSERT(!setob || setob->stored_type() == Rps_Type::Set);
   pclass_attrset.store(setob);
+  gc_write_barrier(Rps_Value(setob));
 } // end Rps_PayloadClassInfo::loader_put_attrset
 
 void
@@ -1474,12 +1618,13 @@ Rps_PayloadClassInfo::put_symbname(Rps_ObjectRef obr)
 {
   if (!obr)
     return;
-  std::lock_guard<std::recursive_mutex> gu(*(obr->objmtxptr()));
+  std::lock_guard<Rps_ObjectMutex> gu(*(obr->objmtxptr()));
   auto symb = obr->get_dynamic_payload<Rps_PayloadSymbol>();
   if (symb && symb->owner() == obr)
     {
       symb->symbol_put_value(owner());
       pclass_symbname = obr;
+      gc_write_barrier(obr);
     }
 } // end Rps_PayloadClassInfo::put_symbname
 
@@ -1492,7 +1637,7 @@ Rps_PayloadClassInfo::class_name_str(void) const
   if (!obsymb)
     return obrown->oid().to_string();
   {
-    std::lock_guard<std::recursive_mutex> gusymb(*(obsymb->objmtxptr()));
+    std::lock_guard<Rps_ObjectMutex> gusymb(*(obsymb->objmtxptr()));
     if (auto symbpayl = obsymb->get_dynamic_payload<Rps_PayloadSymbol>())
       return symbpayl->symbol_name();
   }
@@ -1516,7 +1661,7 @@ Rps_PayloadClassInfo::compute_set_of_own_method_selectors(Rps_CallFrame*callerfr
   auto obrown = owner();
   if (!obrown)
     return Rps_SetValue();
-  std::lock_guard<std::recursive_mutex> guown(*(obrown->objmtxptr()));
+  std::lock_guard<Rps_ObjectMutex> guown(*(obrown->objmtxptr()));
   _.set_additional_gc_marker([&](Rps_GarbageCollector*gc)
   {
     RPS_ASSERT(gc != nullptr);
@@ -1693,7 +1838,7 @@ Rps_PayloadVectVal::make_closure_zone_from_vector(Rps_ObjectRef connob)
 {
   if (!connob)
     return nullptr;
-  std::lock_guard<std::recursive_mutex> gu(*(connob->objmtxptr()));
+  std::lock_guard<Rps_ObjectMutex> gu(*(connob->objmtxptr()));
   return Rps_ClosureZone::make(connob, pvectval);
 } // end Rps_PayloadVectVal::make_closure_zone_from_vector
 
@@ -1703,7 +1848,7 @@ Rps_PayloadVectVal::make_instance_zone_from_vector(Rps_ObjectRef classob)
 {
   if (!classob)
     return nullptr;
-  std::lock_guard<std::recursive_mutex> gu(*(classob->objmtxptr()));
+  std::lock_guard<Rps_ObjectMutex> gu(*(classob->objmtxptr()));
   if (!classob->is_class())
     return nullptr;
   return Rps_InstanceZone::make_from_components(classob, pvectval);
@@ -1762,13 +1907,19 @@ Rps_PayloadSymbol::Rps_PayloadSymbol(Rps_ObjectZone*obz)
 
 Rps_PayloadSymbol::~Rps_PayloadSymbol()
 {
-  std::lock_guard<std::recursive_mutex> gu(symb_tablemtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(symb_tablemtx);
   RPS_DEBUG_LOG(LOWREP, "~Rps_PayloadSymbol symb_name='"
                 << symb_name << "' owner=" << owner()
                 << std::endl
                 << RPS_FULL_BACKTRACE_HERE(1, "~Rps_PayloadSymbol"));
   if (!symb_name.empty())
-    symb_table.erase(symb_name);
+    {
+      /// the name could have been registered again while our dead
+      /// owner was waiting for the lazy sweep
+      auto it = symb_table.find(symb_name);
+      if (it != symb_table.end() && it->second == this)
+        symb_table.erase(it);
+    }
 } // end Rps_PayloadSymbol::~Rps_PayloadSymbol()
 
 
@@ -1781,7 +1932,7 @@ Rps_PayloadSymbol::load_register_name(const char*name, Rps_Loader*ld, bool weak)
   RPS_ASSERT(symb_name.empty());
   RPS_ASSERT(owner());
   RPS_ASSERT(ld != nullptr);
-  std::lock_guard<std::recursive_mutex> gu(symb_tablemtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(symb_tablemtx);
   symb_name.assign(name);
   if (RPS_UNLIKELY(symb_table.find(symb_name) != symb_table.end()))
     throw std::runtime_error(std::string("duplicate loaded symbol name:") + name + " for "
@@ -1835,7 +1986,7 @@ void
 Rps_PayloadSymbol::gc_mark_strong_symbols(Rps_GarbageCollector*gc)
 {
   RPS_ASSERT(gc != nullptr);
-  std::lock_guard<std::recursive_mutex> gu(symb_tablemtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(symb_tablemtx);
   for (auto it: symb_table)
     {
       Rps_PayloadSymbol*cursymb = it.second;
@@ -1856,16 +2007,19 @@ Rps_PayloadSymbol::register_name(std::string name, Rps_ObjectRef obj, bool weak)
     return false;
   if (!valid_name(name))
     return false;
-  std::lock_guard<std::recursive_mutex> gu(*(obj->objmtxptr()));
+  std::lock_guard<Rps_ObjectMutex> gu(*(obj->objmtxptr()));
   if (obj->get_payload() != nullptr
       && !obj->has_erasable_payload()) return false;
-  std::lock_guard<std::recursive_mutex> gusy(symb_tablemtx);
-  if (symb_table.find(name) != symb_table.end())
-    return false;
+  Rps_NoSafepointLock<std::recursive_mutex> gusy(symb_tablemtx);
+  {
+    auto oldit = symb_table.find(name);
+    if (oldit != symb_table.end() && !oldit->second->is_dead_symbol())
+      return false;
+  }
   Rps_PayloadSymbol* paylsymb =
     obj->put_new_plain_payload<Rps_PayloadSymbol>();
   paylsymb->symb_name = name;
-  symb_table.insert({paylsymb->symb_name, paylsymb});
+  symb_table[paylsymb->symb_name] = paylsymb;
   paylsymb->symb_is_weak.store(weak);
   {
     auto symbit = symb_hardcoded_hashtable.find(name);
@@ -1874,6 +2028,7 @@ Rps_PayloadSymbol::register_name(std::string name, Rps_ObjectRef obj, bool weak)
         *(symbit->second) = obj;
       }
   }
+  obj->touch_now();
   RPS_INFORMOUT("Rps_PayloadSymbol::register_name name=" << name << " obj=" << obj->oid().to_string()
                 << " " << (weak?"weak":"strong"));
   return true;
@@ -1885,7 +2040,7 @@ bool Rps_PayloadSymbol::forget_name(std::string name)
 {
   if (!valid_name(name))
     return false;
-  std::lock_guard<std::recursive_mutex> gusy(symb_tablemtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gusy(symb_tablemtx);
   auto it = symb_table.find(name);
   if (it == symb_table.end())
     return false;
@@ -1911,11 +2066,11 @@ Rps_PayloadSymbol::forget_object(Rps_ObjectRef obj)
 {
   if (!obj)
     return false;
-  std::lock_guard<std::recursive_mutex> gu(*(obj->objmtxptr()));
+  std::lock_guard<Rps_ObjectMutex> gu(*(obj->objmtxptr()));
   Rps_PayloadSymbol* paylsymb = obj->get_dynamic_payload<Rps_PayloadSymbol>();
   if (!paylsymb)
     return false;
-  std::lock_guard<std::recursive_mutex> gusy(symb_tablemtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gusy(symb_tablemtx);
   auto it = symb_table.find(paylsymb->symb_name);
   if (it == symb_table.end())
     return false;
@@ -1932,7 +2087,7 @@ Rps_PayloadSymbol::autocomplete_name(const char*prefix, const std::function<bool
   int count = 0;
   std::string prefixstr(prefix);
   int prefixlen = strlen(prefix);
-  std::lock_guard<std::recursive_mutex> gusy(symb_tablemtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gusy(symb_tablemtx);
   for (auto it = symb_table.lower_bound(prefixstr); it != symb_table.end(); it++)
     {
       if (!it->second)
@@ -1940,6 +2095,8 @@ Rps_PayloadSymbol::autocomplete_name(const char*prefix, const std::function<bool
       std::string curname = it->first;
       if (strncmp(prefix,curname.c_str(),prefixlen))
         break;
+      if (it->second->is_dead_symbol())
+        continue;
       count++;
       Rps_ObjectRef curobr = it->second->owner();
       if (stopfun(curobr,curname))
@@ -1953,11 +2110,11 @@ Rps_PayloadSymbol::set_of_all_symbols(void)
 {
   std::vector<Rps_ObjectRef> vecob;
   {
-    std::lock_guard<std::recursive_mutex> gusy(symb_tablemtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gusy(symb_tablemtx);
     unsigned nbsymb = symb_table.size();
     vecob.reserve(nbsymb);
     for (auto it : symb_table)
-      if (it.second && it.second->owner())
+      if (it.second && it.second->owner() && !it.second->is_dead_symbol())
         vecob.push_back(it.second->owner());
   }
   return Rps_SetValue(vecob);
@@ -2116,7 +2273,7 @@ Rps_ObjectRef::make_named_class(Rps_CallFrame*callerframe, Rps_ObjectRef supercl
   if (!_f.obsymbol)
     _f.obsymbol = Rps_ObjectRef::make_new_strong_symbol(&_, name);
   RPS_INFORMOUT("Rps_ObjectRef::make_named_class name=" << name <<", obsymbol=" << _f.obsymbol);
-  std::unique_lock<std::recursive_mutex> gusymb (*(_f.obsymbol->objmtxptr()));
+  std::unique_lock<Rps_ObjectMutex> gusymb (*(_f.obsymbol->objmtxptr()));
   // obsymbol should be of class `symbol`
   RPS_ASSERT(_f.obsymbol->get_class() == RPS_ROOT_OB(_36I1BY2NetN03WjrOv));
   RPS_INFORMOUT("Rps_ObjectRef::make_named_class good obsymbol=" << _f.obsymbol);
@@ -2126,7 +2283,7 @@ Rps_ObjectRef::make_named_class(Rps_CallFrame*callerframe, Rps_ObjectRef supercl
   RPS_INFORMOUT("Rps_ObjectRef::make_named_class name=" << name << ", paylsymbol=" << paylsymbol
                 << ", obclass=" << _f.obclass);
   /// the class is class `class`
-  _f.obclass->ob_class.store(RPS_ROOT_OB(_41OFI3r0S1t03qdB2E));
+  _f.obclass->store_class(RPS_ROOT_OB(_41OFI3r0S1t03qdB2E));
   auto paylclainf = _f.obclass->put_new_plain_payload<Rps_PayloadClassInfo>();
   paylclainf->put_superclass(_f.obsuperclass);
   paylclainf->put_symbname(_f.obsymbol);
@@ -2136,7 +2293,7 @@ Rps_ObjectRef::make_named_class(Rps_CallFrame*callerframe, Rps_ObjectRef supercl
   rps_add_root_object (_f.obclass);
   RPS_INFORMOUT("Rps_ObjectRef::make_named_class name="<< name
                 << " gives obclass=" << _f.obclass);
-  std::unique_lock<std::recursive_mutex> gumutsetcla (*(_f.obthemutsetclasses->objmtxptr()));
+  std::unique_lock<Rps_ObjectMutex> gumutsetcla (*(_f.obthemutsetclasses->objmtxptr()));
   auto paylsetcla = _f.obthemutsetclasses->get_dynamic_payload< Rps_PayloadSetOb>();
   RPS_ASSERT(paylsetcla != nullptr);
   paylsetcla->add(_f.obclass);
@@ -2153,7 +2310,7 @@ Rps_ObjectRef::make_new_symbol(Rps_CallFrame*callerframe, std::string name, bool
                  callerframe,
                  Rps_ObjectRef obsymbol; // the symbol
                 );
-  std::lock_guard<std::mutex> gusymb (rps_symbol_mtx);
+  Rps_NoSafepointLock<std::mutex> gusymb(rps_symbol_mtx);
   if (!Rps_PayloadSymbol::valid_name(name))
     {
       RPS_WARNOUT("make_new_symbol with invalid name " << name);
@@ -2165,7 +2322,7 @@ Rps_ObjectRef::make_new_symbol(Rps_CallFrame*callerframe, std::string name, bool
       throw std::runtime_error(std::string("make_new_symbol with existing name"));
     }
   _f.obsymbol = Rps_ObjectZone::make();
-  _f.obsymbol->ob_class.store(RPS_ROOT_OB(_36I1BY2NetN03WjrOv)); // the `symbol` class
+  _f.obsymbol->store_class(RPS_ROOT_OB(_36I1BY2NetN03WjrOv)); // the `symbol` class
   Rps_PayloadSymbol::register_name(name, _f.obsymbol, isweak);
   RPS_NOPRINTOUT("Rps_ObjectRef::make_new_symbol name=" << name
                  << " gives obsymbol=" << _f.obsymbol);
@@ -2200,7 +2357,7 @@ Rps_ObjectRef::make_object(Rps_CallFrame*callerframe, Rps_ObjectRef classobarg,
         }
     };
   _f.resultob = Rps_ObjectZone::make();
-  _f.resultob->ob_class.store(_f.classob);
+  _f.resultob->store_class(_f.classob);
   RPS_DEBUG_LOG(LOWREP, "make_object classob=" << _f.classob << " -> resultob=" << _f.resultob);
   _f.resultob->put_space(_f.spaceob);
   /// FIXME: perhaps we should send some `initialize_object` message?
@@ -2227,7 +2384,7 @@ Rps_ObjectRef::install_own_method(Rps_CallFrame*callerframe, Rps_ObjectRef obsel
       RPS_WARNOUT("empty class for install_own_method of selector " << _f.obsel);
       throw RPS_RUNTIME_ERROR_OUT("empty class for install_own_method of selector " << _f.obsel);
     }
-  std::unique_lock<std::recursive_mutex> guclass (*(_f.obclass->objmtxptr()));
+  std::unique_lock<Rps_ObjectMutex> guclass (*(_f.obclass->objmtxptr()));
   if (_f.obsel.is_empty())
     {
       RPS_WARNOUT("empty selector for install_own_method of class " << _f.obclass);
@@ -2270,7 +2427,7 @@ Rps_ObjectRef::install_own_2_methods(Rps_CallFrame*callerframe, Rps_ObjectRef ob
       RPS_WARNOUT("empty class for install_own_2_methods of selector#0 " << _f.obsel0 << ", selector#1 " << _f.obsel1);
       throw RPS_RUNTIME_ERROR_OUT("empty class for install_own_2_methods of selector#0 " << _f.obsel0 << ", selector#1 " << _f.obsel1);
     }
-  std::unique_lock<std::recursive_mutex> guclass (*(_f.obclass->objmtxptr()));
+  std::unique_lock<Rps_ObjectMutex> guclass (*(_f.obclass->objmtxptr()));
   if (_f.obsel0.is_empty())
     {
       RPS_WARNOUT("empty selector#0 for install_own_2_methods of class " << _f.obclass);
@@ -2329,7 +2486,7 @@ Rps_ObjectRef::install_own_3_methods(Rps_CallFrame*callerframe, Rps_ObjectRef ob
       RPS_WARNOUT("empty class for install_own_3_methods of selector#0 " << _f.obsel0);
       throw RPS_RUNTIME_ERROR_OUT("empty class for install_own_3_methods of selector#0 " << _f.obsel0);
     }
-  std::unique_lock<std::recursive_mutex> guclass (*(_f.obclass->objmtxptr()));
+  std::unique_lock<Rps_ObjectMutex> guclass (*(_f.obclass->objmtxptr()));
   if (_f.obsel0.is_empty())
     {
       RPS_WARNOUT("empty selector#0 for install_own_3_methods of class " << _f.obclass);
@@ -133,7 +133,7 @@ public:
   {
     return _id_lo;
   };
-  Rps_Id(uint64_t h, uint32_t l=0) : _id_hi(h), _id_lo(l)
+  Rps_Id(uint64_t h, uint64_t l=0) : _id_hi(h), _id_lo(l)
   {
     RPS_ASSERT((h==0 && l==0) || hash() != 0);
   };
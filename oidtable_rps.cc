@@ -0,0 +1,339 @@
+/****************************************************************
+ * file oidtable_rps.cc
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Description:
+ *      This file is part of the Reflective Persistent System.
+ *
+ *      It has the concurrent open addressing table of objects by
+ *      their oid, see class Rps_OidTable in refpersys.hh
+ *
+ * Author(s):
+ *      Basile Starynkevitch <basile@starynkevitch.net>
+ *      Abhishek Chakravarti <abhishek@taranjali.org>
+ *      Nimesh Neema <nimeshneema@gmail.com>
+ *
+ *      © Copyright 2019 - 2024 The Reflective Persistent System Team
+ *      team@refpersys.org & http://refpersys.org/
+ *
+ * License:
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "refpersys.hh"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /*__SSE2__*/
+
+extern "C" const char rps_oidtable_gitid[];
+const char rps_oidtable_gitid[]= RPS_GITID;
+
+extern "C" const char rps_oidtable_date[];
+const char rps_oidtable_date[]= __DATE__;
+
+Rps_OidTable::array_st::array_st(size_t nbgroups)
+  : ar_nbgroups(nbgroups), ar_used(0), ar_live(0),
+    ar_ctrl(new uint8_t[nbgroups*group_width]),
+    ar_slots(new slot_st[nbgroups*group_width]())
+{
+  RPS_ASSERT(nbgroups > 0 && (nbgroups & (nbgroups-1)) == 0);
+  memset(ar_ctrl.get(), ctrl_empty, nbgroups*group_width);
+} // end Rps_OidTable::array_st::array_st
+
+Rps_OidTable::read_guard::read_guard(const Rps_OidTable&tbl)
+  : rg_table(tbl), rg_epoch(0)
+{
+  /// if the epoch was flipped meanwhile, the grace period could have
+  /// missed our count, so we count again in the new epoch
+  for (;;)
+    {
+      rg_epoch = tbl.ot_epoch.load();
+      tbl.ot_readers[rg_epoch & 1].fetch_add(1);
+      if (tbl.ot_epoch.load() == rg_epoch)
+        return;
+      tbl.ot_readers[rg_epoch & 1].fetch_sub(1);
+    }
+} // end Rps_OidTable::read_guard::read_guard
+
+Rps_OidTable::read_guard::~read_guard()
+{
+  rg_table.ot_readers[rg_epoch & 1].fetch_sub(1);
+} // end Rps_OidTable::read_guard::~read_guard
+
+Rps_OidTable::Rps_OidTable(size_t initsize)
+  : ot_array(nullptr), ot_mtx(), ot_retired(),
+    ot_epoch(0), ot_readers{0,0}, ot_syncmtx(),
+    ot_sorted(), ot_pending(), ot_nbremoved(0)
+{
+  size_t nbgroups = 1;
+  while (nbgroups*group_width < initsize)
+    nbgroups *= 2;
+  ot_array.store(new array_st(nbgroups));
+} // end Rps_OidTable::Rps_OidTable
+
+Rps_OidTable::~Rps_OidTable()
+{
+  delete ot_array.exchange(nullptr);
+  ot_retired.clear();
+} // end Rps_OidTable::~Rps_OidTable
+
+/// the bit mask of the control bytes of a group equal to byte
+uint32_t
+Rps_OidTable::match_group(const uint8_t*ctrl, uint8_t byte)
+{
+#ifdef __SSE2__
+  /// this plain load may race with the release stores of a writer;
+  /// any byte seen is either the old or the new one, and the caller
+  /// fences before reading the slots
+  __m128i grp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(grp, _mm_set1_epi8((char)byte)));
+#else
+  uint32_t mask = 0;
+  for (unsigned ix=0; ix<group_width; ix++)
+    if (__atomic_load_n(ctrl+ix, __ATOMIC_RELAXED) == byte)
+      mask |= 1u << ix;
+  return mask;
+#endif /*__SSE2__*/
+} // end Rps_OidTable::match_group
+
+Rps_OidTable::slot_st*
+Rps_OidTable::lookup_slot(array_st*ar, uint64_t hi, uint64_t lo)
+{
+  uint64_t h = mix_hash(hi, lo);
+  uint8_t tag = (uint8_t)(h >> 57);
+  size_t gmask = ar->ar_nbgroups - 1;
+  size_t g = h & gmask;
+  /// triangular probing visits every group of a power of two array
+  for (size_t step=1; step<=ar->ar_nbgroups; step++)
+    {
+      const uint8_t* ctrl = ar->ar_ctrl.get() + g*group_width;
+      uint32_t mask = match_group(ctrl, tag);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      while (mask)
+        {
+          unsigned ix = __builtin_ctz(mask);
+          mask &= mask-1;
+          slot_st* sl = &ar->ar_slots[g*group_width + ix];
+          if (sl->sl_hi.load(std::memory_order_relaxed) == hi
+              && sl->sl_lo.load(std::memory_order_relaxed) == lo)
+            return sl;
+        }
+      if (match_group(ctrl, ctrl_empty))
+        return nullptr;
+      g = (g + step) & gmask;
+    }
+  return nullptr;
+} // end Rps_OidTable::lookup_slot
+
+/// with ot_mtx locked, for an oid known to be absent
+void
+Rps_OidTable::put_in_array(array_st*ar, uint64_t hi, uint64_t lo, Rps_ObjectZone*obz)
+{
+  uint64_t h = mix_hash(hi, lo);
+  uint8_t tag = (uint8_t)(h >> 57);
+  size_t gmask = ar->ar_nbgroups - 1;
+  size_t g = h & gmask;
+  for (size_t step=1; step<=ar->ar_nbgroups; step++)
+    {
+      uint8_t* ctrl = ar->ar_ctrl.get() + g*group_width;
+      uint32_t mask = match_group(ctrl, ctrl_empty);
+      if (mask)
+        {
+          unsigned ix = __builtin_ctz(mask);
+          slot_st* sl = &ar->ar_slots[g*group_width + ix];
+          sl->sl_hi.store(hi, std::memory_order_relaxed);
+          sl->sl_lo.store(lo, std::memory_order_relaxed);
+          sl->sl_obz.store(obz, std::memory_order_relaxed);
+          __atomic_store_n(ctrl+ix, tag, __ATOMIC_RELEASE);
+          ar->ar_used++;
+          ar->ar_live++;
+          return;
+        }
+      g = (g + step) & gmask;
+    }
+  RPS_FATALOUT("Rps_OidTable full array of " << ar->ar_nbgroups << " groups");
+} // end Rps_OidTable::put_in_array
+
+/// with ot_mtx locked; the new array is twice bigger, unless many
+/// slots are just removed ones
+void
+Rps_OidTable::grow(void)
+{
+  array_st* oldar = ot_array.load(std::memory_order_relaxed);
+  size_t nbgroups = oldar->ar_nbgroups;
+  if (oldar->ar_live*2 >= oldar->ar_used)
+    nbgroups *= 2;
+  array_st* newar = new array_st(nbgroups);
+  size_t nbslots = oldar->ar_nbgroups*group_width;
+  for (size_t ix=0; ix<nbslots; ix++)
+    {
+      if (oldar->ar_ctrl[ix] & 0x80) // empty or removed
+        continue;
+      slot_st& sl = oldar->ar_slots[ix];
+      put_in_array(newar, sl.sl_hi.load(std::memory_order_relaxed),
+                   sl.sl_lo.load(std::memory_order_relaxed),
+                   sl.sl_obz.load(std::memory_order_relaxed));
+    }
+  ot_array.store(newar, std::memory_order_release);
+  /// lock-free readers could still be probing the old array, which
+  /// is freed after the next grace period
+  ot_retired.emplace_back(oldar);
+} // end Rps_OidTable::grow
+
+void
+Rps_OidTable::add_locked(const Rps_Id&oid, Rps_ObjectZone*obz)
+{
+  array_st* ar = ot_array.load(std::memory_order_relaxed);
+  // keep at most 7/8 of the slots used
+  if ((ar->ar_used+1)*8 > ar->ar_nbgroups*group_width*7)
+    {
+      grow();
+      ar = ot_array.load(std::memory_order_relaxed);
+    }
+  put_in_array(ar, oid.hi(), oid.lo(), obz);
+  ot_pending.push_back(oid);
+  /// transient objects come and go, and only autocompletion calls
+  /// range, so the prefix index is also merged and pruned here
+  if (RPS_UNLIKELY(ot_pending.size() > ot_merge_threshold + ot_sorted.size()/2))
+    merge_pending_locked();
+} // end Rps_OidTable::add_locked
+
+/// merge ot_pending into ot_sorted, and forget the removed oids once
+/// they could be a quarter of it
+void
+Rps_OidTable::merge_pending_locked(void)
+{
+  array_st* ar = ot_array.load(std::memory_order_relaxed);
+  if (!ot_pending.empty())
+    {
+      std::sort(ot_pending.begin(), ot_pending.end());
+      size_t mid = ot_sorted.size();
+      ot_sorted.insert(ot_sorted.end(), ot_pending.begin(), ot_pending.end());
+      std::inplace_merge(ot_sorted.begin(), ot_sorted.begin()+mid, ot_sorted.end());
+      /// an oid removed then added again was pushed twice
+      ot_sorted.erase(std::unique(ot_sorted.begin(), ot_sorted.end()), ot_sorted.end());
+      ot_pending.clear();
+    }
+  if (ot_nbremoved*4 > ot_sorted.size())
+    {
+      ot_sorted.erase(std::remove_if(ot_sorted.begin(), ot_sorted.end(),
+                                     [=](const Rps_Id&oid)
+      {
+        slot_st* sl = lookup_slot(ar, oid.hi(), oid.lo());
+        return !sl || !sl->sl_obz.load(std::memory_order_relaxed);
+      }), ot_sorted.end());
+      ot_nbremoved = 0;
+    }
+} // end Rps_OidTable::merge_pending_locked
+
+Rps_ObjectZone*
+Rps_OidTable::lookup(const Rps_Id&oid) const
+{
+  array_st* ar = ot_array.load(std::memory_order_acquire);
+  slot_st* sl = lookup_slot(ar, oid.hi(), oid.lo());
+  if (!sl)
+    return nullptr;
+  return sl->sl_obz.load(std::memory_order_acquire);
+} // end Rps_OidTable::lookup
+
+Rps_ObjectZone*
+Rps_OidTable::insert_or_replace(const Rps_Id&oid, Rps_ObjectZone*obz)
+{
+  RPS_ASSERT(obz != nullptr);
+  std::lock_guard<std::mutex> gu(ot_mtx);
+  slot_st* sl = lookup_slot(ot_array.load(std::memory_order_relaxed), oid.hi(), oid.lo());
+  if (sl)
+    return sl->sl_obz.exchange(obz, std::memory_order_acq_rel);
+  add_locked(oid, obz);
+  return nullptr;
+} // end Rps_OidTable::insert_or_replace
+
+bool
+Rps_OidTable::remove(const Rps_Id&oid, const Rps_ObjectZone*obz)
+{
+  std::lock_guard<std::mutex> gu(ot_mtx);
+  array_st* ar = ot_array.load(std::memory_order_relaxed);
+  slot_st* sl = lookup_slot(ar, oid.hi(), oid.lo());
+  if (!sl || sl->sl_obz.load(std::memory_order_relaxed) != obz)
+    return false;
+  /// the oid stays in the slot, which is reused only by the next
+  /// rebuilt array
+  sl->sl_obz.store(nullptr, std::memory_order_release);
+  __atomic_store_n(&ar->ar_ctrl[sl - ar->ar_slots.get()], ctrl_removed, __ATOMIC_RELEASE);
+  ar->ar_live--;
+  ot_nbremoved++;
+  return true;
+} // end Rps_OidTable::remove
+
+Rps_Id
+Rps_OidTable::fresh_random(Rps_ObjectZone*obz)
+{
+  std::lock_guard<std::mutex> gu(ot_mtx);
+  for (;;)
+    {
+      Rps_Id oid = Rps_Id::random();
+      if (RPS_UNLIKELY(lookup_slot(ot_array.load(std::memory_order_relaxed),
+                                   oid.hi(), oid.lo()) != nullptr))
+        continue;
+      if (obz)
+        add_locked(oid, obz);
+      return oid;
+    }
+} // end Rps_OidTable::fresh_random
+
+size_t
+Rps_OidTable::size(void) const
+{
+  std::lock_guard<std::mutex> gu(ot_mtx);
+  return ot_array.load(std::memory_order_relaxed)->ar_live;
+} // end Rps_OidTable::size
+
+std::vector<Rps_ObjectZone*>
+Rps_OidTable::range(const Rps_Id&idfirst, const Rps_Id&idlast)
+{
+  std::vector<Rps_ObjectZone*> res;
+  std::lock_guard<std::mutex> gu(ot_mtx);
+  merge_pending_locked();
+  array_st* ar = ot_array.load(std::memory_order_relaxed);
+  for (auto it = std::lower_bound(ot_sorted.begin(), ot_sorted.end(), idfirst);
+       it != ot_sorted.end() && *it <= idlast;
+       it++)
+    {
+      slot_st* sl = lookup_slot(ar, it->hi(), it->lo());
+      Rps_ObjectZone* obz = sl?sl->sl_obz.load(std::memory_order_relaxed):nullptr;
+      /// a zone still bound while we hold ot_mtx is not yet freed,
+      /// and the sweep frees only the ones awaiting it
+      if (obz && !obz->is_awaiting_sweep())
+        res.push_back(obz);
+    }
+  return res;
+} // end Rps_OidTable::range
+
+void
+Rps_OidTable::synchronize_readers(void)
+{
+  std::vector<std::unique_ptr<array_st>> retired;
+  {
+    std::lock_guard<std::mutex> gu(ot_mtx);
+    retired.swap(ot_retired);
+  }
+  std::lock_guard<std::mutex> gusync(ot_syncmtx);
+  uint64_t ep = ot_epoch.fetch_add(1);
+  /// lookups are short, so we just yield
+  while (ot_readers[ep & 1].load() != 0)
+    std::this_thread::yield();
+} // end Rps_OidTable::synchronize_readers
+
+//////////////////////////////////////////////////////////// end of file oidtable_rps.cc
@@ -116,6 +116,7 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <sys/poll.h>
+#include <sys/epoll.h>
 #include <sys/personality.h>
 #include <sys/signalfd.h>
 #include <sys/timerfd.h>
@@ -713,6 +714,18 @@ enum rps_progoption_en
   RPSPROGOPT_RUN_NAME,
   RPSPROGOPT_VERSION,
   RPSPROGOPT_PUBLISH_ME,
+  RPSPROGOPT_GC_GROWTH,
+  RPSPROGOPT_GC_SOFT_CAP,
+  RPSPROGOPT_GC_CPU_BUDGET,
+  RPSPROGOPT_DUMP_FORMAT,
+  RPSPROGOPT_CONVERT_STORE,
+  RPSPROGOPT_INCREMENTAL_DUMP,
+  RPSPROGOPT_JOURNAL,
+  RPSPROGOPT_BACKGROUND_DUMP,
+  RPSPROGOPT_DUMP_COMPRESS,
+  RPSPROGOPT_LAZY_LOAD,
+  RPSPROGOPT_BENCHMARK_LOAD,
+  RPSPROGOPT_BENCHMARK_AGENDA,
 };
 
 
@@ -2157,32 +2170,74 @@ std::ostream& operator << (std::ostream& out, const Rps_Backtracer& rpb)
   Rps_Backtracer(Rps_Backtracer::FullOut_Tag{},__FILE__,__LINE__,(Skip),(Name),(std::ostream*)nullptr)
 
 ////////////////////////////////////////////////////// garbage collector
-extern "C" void rps_garbage_collect(std::function<void(Rps_GarbageCollector*)>* fun=nullptr);
+extern "C" void rps_garbage_collect(std::function<void(Rps_GarbageCollector*)>* fun=nullptr, bool minor=false);
 class Rps_GarbageCollector
 {
-  friend void rps_garbage_collect(std::function<void(Rps_GarbageCollector*)>* fun);
+  friend void rps_garbage_collect(std::function<void(Rps_GarbageCollector*)>* fun, bool minor);
   static unsigned constexpr _gc_magicnum_ = 0xdae21691;  // 3672250001
   static std::atomic<Rps_GarbageCollector*> gc_this_;
   static std::atomic<uint64_t> gc_count_;
+  // number of threads inside help_marking
+  static std::atomic<int> gc_nbhelpers_;
+  /// The remembered set of old objects, and of old tree zones given
+  /// some young metadata, which got references to young zones since
+  /// the previous collection, filled by write barriers.
+  static std::mutex gc_rememberedmtx_;
+  static std::vector<Rps_ZoneValue*> gc_remembered_;
+  // minor collections since the last major one
+  static std::atomic<unsigned> gc_nbminor_;
   friend class Rps_QuasiZone;
+  friend class Rps_GcStatistics;
   std::mutex gc_mtx;
   std::atomic<bool> gc_running;
+  const bool gc_minor; // minor collections trace only young zones
   unsigned gc_magic;
   const std::function<void(Rps_GarbageCollector*)> gc_rootmarkers;
-  std::deque<Rps_ObjectRef> gc_obscanque;
+  /// Each marking thread owns one scan queue of marked objects still
+  /// to be scanned. The collecting thread uses queue 0, and agenda
+  /// worker threads parked in WthrAg_GC state use their worker
+  /// index. A marker pops from the back of its own queue, and when it
+  /// is empty steals from the front of other queues.
+  struct gc_scanqueue_st
+  {
+    std::mutex gsq_mtx;
+    std::deque<Rps_ObjectRef> gsq_deque;
+    std::atomic<unsigned> gsq_size;
+    uint64_t gsq_nbscan;
+  };
+  gc_scanqueue_st gc_scanqueues[RPS_NBJOBS_MAX+2];
+  std::atomic<bool> gc_marking; // true while helpers may join marking
+  std::atomic<int> gc_nbactivemarkers;
   uint64_t gc_nbscan;
   uint64_t gc_nbmark;
   uint64_t gc_nbdelete;
   uint64_t gc_nbroots;
+  uint64_t gc_nbfreedpages;
   double gc_startrealtime;
   double gc_startelapsedtime;
   double gc_startprocesstime;
 private:
-  Rps_GarbageCollector(const std::function<void(Rps_GarbageCollector*)> &rootmarkers=nullptr);
+  Rps_GarbageCollector(const std::function<void(Rps_GarbageCollector*)> &rootmarkers=nullptr,
+                       bool minor=false);
   ~Rps_GarbageCollector();
   void run_gc(void);
   void mark_gcroots(void);
+  void mark_remembered_set(void);
+  void scan_old_obj(Rps_ObjectZone*ob);
+  void drain_scan_queues(int qix);
+  bool steal_scanned_object(int qix, Rps_ObjectRef& obr);
 public:
+  /// every few minor collections, a major one traces everything
+  static constexpr unsigned gc_major_period = 8;
+  /// called repeatedly by agenda worker threads in GC state, so they
+  /// take part in the mark phase; returns when marking is over
+  static void help_marking(int ix);
+  /// called by write barriers, once per remembered zone
+  static void remember_zone(Rps_ZoneValue*zv);
+  bool is_minor(void) const
+  {
+    return gc_minor;
+  };
   double elapsed_time(void) const
   {
     return rps_elapsed_real_time() - gc_startelapsedtime;
@@ -2211,6 +2266,11 @@ public:
   {
     return gc_nbdelete;
   };
+  /// arena pages given back to the kernel after the sweep
+  uint64_t nb_freed_pages() const
+  {
+    return gc_nbfreedpages;
+  };
   void mark_obj(Rps_ObjectZone* ob);
   void mark_obj(Rps_ObjectRef ob);
   void mark_value(Rps_Value val, unsigned depth=0);
@@ -2223,6 +2283,228 @@ public:
   };
 };                              // end class Rps_GarbageCollector
 
+////////////////////////////////////////////////////// GC statistics
+
+/// Rolling statistics about the last garbage collections, and about
+/// allocation by each thread, implemented in gcstats_rps.cc. They are
+/// shown by the !gcstats REPL command and exported as JSON by the
+/// !gcstats_json one.
+class Rps_GcStatistics
+{
+  friend class Rps_GarbageCollector;
+  friend class Rps_QuasiZone;
+public:
+  // number of recent collections kept
+  static constexpr unsigned gcs_window = 256;
+  // histogram buckets are powers of two
+  static constexpr unsigned gcs_nb_buckets = 32;
+  // zone types, from the first payload type to the last value type
+  static constexpr int gcs_first_type = (int)Rps_Type::PaylLightCodeGen;
+  static constexpr int gcs_last_type = (int)Rps_Type::LexToken;
+  static constexpr unsigned gcs_nb_types = gcs_last_type - gcs_first_type + 1;
+  struct gcs_record_st
+  {
+    uint64_t gr_count;          // the collection number
+    bool gr_minor;
+    double gr_realtime;         // wall clock time at start
+    double gr_pause;            // in seconds, for the whole run_gc
+    double gr_mark;             // in seconds, for marking
+    double gr_sweep;            // cumulated seconds spent by sweepers
+    uint64_t gr_allocwords;     // words allocated since previous collection
+    uint64_t gr_livezones;      // known at end of sweep
+    uint64_t gr_livewords;
+    bool gr_swept;
+  };
+  /// per thread allocation counter, only incremented by its thread
+  struct gcs_thread_alloc_st
+  {
+    std::atomic<uint64_t> ta_words;
+    pid_t ta_tid;
+    char ta_name[16];
+    uint64_t ta_prevwords;      // at previous collection
+    double ta_rate;             // words per second between collections
+  };
+  static inline void count_allocation(uint64_t nbwords);
+  static void output(std::ostream&out);
+  static Json::Value as_json(void);
+  static void dump_json(const std::string&path);
+  static double cumulated_gc_time(void);
+private:
+  static thread_local gcs_thread_alloc_st* gcs_thralloc;
+  static gcs_thread_alloc_st* register_thread_alloc(void);
+  static int type_index(Rps_Type ty)
+  {
+    int tyix = (int)ty;
+    if (tyix < gcs_first_type || tyix > gcs_last_type)
+      return -1;
+    return tyix - gcs_first_type;
+  };
+  static const char* type_name(int tyix);
+  /// called by the collector, and by sweepers
+  static void record_collection(const Rps_GarbageCollector&gc, double marktime);
+  static void add_live_zones(const uint64_t*counts, const uint64_t*words);
+  static void add_sweep_time(double sweeptime);
+  static void end_sweep(void);
+  static std::mutex gcs_mtx;
+  static gcs_record_st gcs_records[gcs_window];
+  static uint64_t gcs_nbrecords;
+  static uint64_t gcs_prevallocwords;
+  static double gcs_prevtime;
+  static double gcs_cumulgctime;
+  static uint64_t gcs_livecount[gcs_nb_types];
+  static uint64_t gcs_livewords[gcs_nb_types];
+  static uint64_t gcs_lastlivecount[gcs_nb_types];
+  static uint64_t gcs_lastlivewords[gcs_nb_types];
+  static std::vector<gcs_thread_alloc_st*> gcs_threads;
+public:
+  /// live words and zones found by the last completed sweep
+  static uint64_t last_live_words(void);
+};                              // end class Rps_GcStatistics
+
+
+/// The pacing policy deciding when agenda workers collect. A
+/// collection is wanted once the heap has grown by some factor over
+/// the live size found by the previous sweep, but never before a
+/// minimal amount of words has been allocated. It is postponed while
+/// the collector used more than its share of worker time, except
+/// above the soft memory cap, where major collections are wanted.
+/// Settable by --gc-growth, --gc-soft-cap and --gc-cpu-budget
+/// program options.
+class Rps_GcPacer
+{
+public:
+  static constexpr double pacer_default_growth = 2.0;
+  static constexpr double pacer_default_cpu_budget = 0.10;
+  static constexpr uint64_t pacer_min_words = 1<<18;
+  static void set_growth_factor(double fact);
+  static void set_soft_cap_words(uint64_t nbwords);
+  static void set_cpu_budget(double fraction);
+  static double growth_factor(void)
+  {
+    return pacer_growth_.load(std::memory_order_relaxed);
+  };
+  static uint64_t soft_cap_words(void)
+  {
+    return pacer_softcap_.load(std::memory_order_relaxed);
+  };
+  static double cpu_budget(void)
+  {
+    return pacer_cpubudget_.load(std::memory_order_relaxed);
+  };
+  /// given the cumulated allocated words at the previous collection,
+  /// tell if a collection is wanted now
+  static bool should_collect(uint64_t allocwords_at_prevgc);
+  /// tell if the heap is above the soft cap
+  static bool over_soft_cap(void);
+  /// called after each collection triggered by the agenda
+  static void note_collection(void);
+  static void output(std::ostream&out);
+  static Json::Value as_json(void);
+private:
+  static std::atomic<double> pacer_growth_;
+  static std::atomic<uint64_t> pacer_softcap_; // in words, 0 means none
+  static std::atomic<double> pacer_cpubudget_;
+  static std::atomic<double> pacer_prevgcrealtime_;
+  static std::atomic<double> pacer_prevgctime_; // cumulated GC time then
+  static std::atomic<double> pacer_lastcost_;   // of the previous collection
+  static std::atomic<uint64_t> pacer_nbdeferred_;
+};                              // end class Rps_GcPacer
+
+////////////////////////////////////////////////////// zone arenas
+
+/// The memory of quasi-zones (values and payloads) comes from size
+/// class segregated arenas, implemented in arena_rps.cc. Size classes
+/// are multiples of rps_allocation_unit. Small zones are carved from
+/// large mmap-ed pages, all inside one reserved address range, so
+/// testing if a pointer belongs to some arena is a cheap range
+/// check. Each thread keeps a small cache of free slots per size
+/// class. Larger zones go to ::operator new. The garbage collector
+/// gives back whole empty pages to the kernel after each sweep.
+class Rps_ZoneArena
+{
+  friend class Rps_QuasiZone;
+  friend class Rps_GarbageCollector;
+public:
+  static constexpr unsigned arena_nb_size_classes = 64;
+  static constexpr size_t arena_max_small_size
+    = arena_nb_size_classes * rps_allocation_unit;
+  static constexpr size_t arena_page_size = 1<<20;
+  // reserved, but not committed, virtual address space for all pages
+  static constexpr size_t arena_region_size = (size_t)1<<36;
+  // number of slots moved at once between a thread cache and the pages
+  static constexpr unsigned arena_thread_batch = 32;
+  static constexpr uint32_t arena_page_magic = 0x1a5e9f37; // 441360183
+  struct arena_page_st
+  {
+    uint32_t ap_magic;
+    uint32_t ap_sizeclass;      // index of the size class
+    uint32_t ap_slotsize;       // in bytes
+    uint32_t ap_nbslots;
+    /// the fields below are guarded by the mutex of the size class
+    uint32_t ap_bumpix;         // slots above it were never given
+    uint32_t ap_nbused;         // slots given to zones or thread caches
+    void* ap_freelist;          // chained thru first word of free slots
+    bool ap_partial;            // when having free slots
+  };
+  static constexpr size_t arena_page_header_size =
+    ((sizeof(arena_page_st) + rps_allocation_unit - 1)
+     / rps_allocation_unit) * rps_allocation_unit;
+  static void initialize(void);
+  static void* allocate(size_t siz);
+  static void deallocate(void*ptr);
+  /// the start of the arena slot around some address, or nullptr
+  static const void* block_containing(const void*ptr);
+  static bool is_in_arena(const void*ptr)
+  {
+    const char*base = arena_region_base_.load(std::memory_order_relaxed);
+    return base != nullptr
+           && (const char*)ptr >= base
+           && (const char*)ptr < base + arena_region_size;
+  };
+  static unsigned size_class_index(size_t siz)
+  {
+    RPS_ASSERT(siz > 0 && siz <= arena_max_small_size);
+    return (unsigned)((siz + rps_allocation_unit - 1) / rps_allocation_unit) - 1;
+  };
+  static size_t size_class_bytes(unsigned scix)
+  {
+    RPS_ASSERT(scix < arena_nb_size_classes);
+    return (size_t)(scix+1) * rps_allocation_unit;
+  };
+  static arena_page_st* page_of(const void*ptr)
+  {
+    RPS_ASSERT(is_in_arena(ptr));
+    return reinterpret_cast<arena_page_st*>
+           ((uintptr_t)ptr & ~(uintptr_t)(arena_page_size-1));
+  };
+  /// give back to the arena pages the free slots cached in the
+  /// current thread
+  static void flush_thread_cache(void);
+  /// give back to the kernel every page without used slots; return
+  /// the number of released pages
+  static unsigned release_empty_pages(void);
+  static uint64_t nb_mapped_pages(void)
+  {
+    return arena_nb_mapped_pages_.load();
+  };
+  static uint64_t nb_released_pages(void)
+  {
+    return arena_nb_released_pages_.load();
+  };
+  static uint64_t nb_large_allocations(void)
+  {
+    return arena_nb_large_alloc_.load();
+  };
+private:
+  static arena_page_st* fresh_page(unsigned scix);
+  static void refill_thread_cache(unsigned scix);
+  static void give_back_slots(unsigned scix, void*slotlist, unsigned nbslots);
+  static std::atomic<char*> arena_region_base_;
+  static std::atomic<uint64_t> arena_nb_mapped_pages_;
+  static std::atomic<uint64_t> arena_nb_released_pages_;
+  static std::atomic<uint64_t> arena_nb_large_alloc_;
+};                              // end class Rps_ZoneArena
+
 ////////////////////////////////////////////////////// quasi zones
 
 class Rps_TypedZone
@@ -2246,18 +2528,73 @@ class Rps_QuasiZone : public Rps_TypedZone
 {
   friend class Rps_GarbageCollector;
   friend class Rps_LexTokenZone;
-  // we keep each quasi-zone in the qz_zonvec
-  static std::recursive_mutex qz_mtx;
-  static std::vector<Rps_QuasiZone*> qz_zonvec;
-  static uint32_t qz_cnt;
+  /// We keep each quasi-zone in a chunked zone table, indexed by its
+  /// rank. Chunks are allocated once and never move, so the table is
+  /// read and written without any lock. Free ranks are kept in small
+  /// per-thread buffers and in a lock-free global free list, whose
+  /// links are in the chunks.
+  static constexpr unsigned qz_chunk_shift = 14;
+  static constexpr uint32_t qz_chunk_size = 1U<<qz_chunk_shift;
+  static constexpr uint32_t qz_max_chunks = 1U<<16;
+  struct qz_chunk_st
+  {
+    std::atomic<Rps_QuasiZone*> qzc_zones[qz_chunk_size];
+    std::atomic<uint32_t> qzc_nextfree[qz_chunk_size];
+  };
+  static std::atomic<qz_chunk_st*> qz_chunktab[qz_max_chunks];
+  // ranks below the top rank have been given at least once
+  static std::atomic<uint32_t> qz_toprank;
+  // the head of the free list is a rank in its low 32 bits and an ABA
+  // counter in its high 32 bits
+  static std::atomic<uint64_t> qz_freehead;
+  static std::atomic<uint32_t> qz_cnt;
+  // the meaning of the GC mark bit flips at each garbage collection,
+  // so marks are cleared at once; zones are born with the current
+  // color, so zones allocated during a collection survive it
+  static std::atomic<uint16_t> qz_markcolor;
+  // the sweep of dead zones is done lazily, chunk by chunk, after the
+  // mark phase; ranks below the sweep top rank are swept
+  static std::atomic<bool> qz_sweeping;
+  static std::atomic<uint32_t> qz_sweeptoprank;
+  static std::atomic<uint32_t> qz_sweepnextchunk;
+  static std::atomic<uint32_t> qz_sweepdonechunks;
+  static std::atomic<uint64_t> qz_nbswept;
+  // true from the start of a collection till the end of its sweep
+  static std::atomic<bool> qz_collecting;
+  // the pending sweep is after a minor collection, so keeps old zones
+  static std::atomic<bool> qz_sweepminor;
   // the cumulated amount of allocated words
   static std::atomic<uint64_t> qz_alloc_cumulw;
-  uint32_t qz_rank;             // the rank in qz_zonvec;
+  uint32_t qz_rank;             // the rank in the zone table
+  static qz_chunk_st* ensure_chunk(uint32_t chkix);
+  static void push_free_rank(uint32_t rk);
+  static uint32_t pop_free_rank(void);
+  static void refill_thread_ranks(void);
+public:
+  // ranks moved at once between a thread buffer and the table
+  static constexpr unsigned qz_thread_batch = 64;
+  /// give back to the zone table the free ranks buffered in the
+  /// current thread
+  static void flush_thread_ranks(void);
 protected:
   inline void* operator new (std::size_t siz, std::nullptr_t);
   inline void* operator new (std::size_t siz, unsigned wordgap);
   static constexpr uint16_t qz_gcmark_bit = 1;
+  // old zones survived a collection; minor collections don't trace them
+  static constexpr uint16_t qz_gcold_bit = 2;
+  // an old object is in the remembered set of the garbage collector
+  static constexpr uint16_t qz_gcremember_bit = 4;
+  // zones born during a collection or its sweep are not promoted by it
+  static constexpr uint16_t qz_gcfresh_bit = 8;
+  // a mutated object waits in the pending set of Rps_Journal
+  static constexpr uint16_t qz_journaled_bit = 16;
+  // a lazily loaded object whose contents are still in its space file
+  static constexpr uint16_t qz_unfilled_bit = 32;
 public:
+  /// every quasi-zone is given back to its Rps_ZoneArena
+  inline void operator delete (void*ptr);
+  inline void operator delete (void*ptr, std::nullptr_t);
+  inline void operator delete (void*ptr, unsigned wordgap);
   /// gives the number of machine words (8 bytes) allocated since
   /// start of process...
   static uint64_t cumulative_allocated_wordcount()
@@ -2265,12 +2602,56 @@ public:
     return qz_alloc_cumulw.load();
   };
   static void initialize(void);
+  static uint32_t nb_zones(void)
+  {
+    return qz_cnt.load(std::memory_order_relaxed);
+  };
   static inline Rps_QuasiZone*nth_zone(uint32_t rk);
   static inline Rps_QuasiZone*raw_nth_zone(uint32_t rk, Rps_GarbageCollector&);
+  /// the live zone allocated around some address, or starting at it
+  /// for the large zones outside of the arena, sorted by address
+  static Rps_QuasiZone*zone_at_address(const void*ad,
+                                       const std::vector<Rps_QuasiZone*>&largezones);
+  /// the zones allocated outside of the arena, sorted by address;
+  /// only while the agenda workers are stopped
+  static std::vector<Rps_QuasiZone*> large_zones(void);
   inline bool is_gcmarked(Rps_GarbageCollector&) const;
   inline void set_gcmark(Rps_GarbageCollector&);
+  // atomically set the GC mark, and tell if it was already set
+  inline bool test_and_set_gcmark(Rps_GarbageCollector&);
   inline void clear_gcmark(Rps_GarbageCollector&);
+  /// flip the mark color, so every zone becomes unmarked
   static void clear_all_gcmarks(Rps_GarbageCollector&);
+  /// start the lazy sweep of unmarked zones after marking
+  static void start_sweep(Rps_GarbageCollector&);
+  /// sweep at most a few chunks of the zone table, and tell if some
+  /// sweeping remains to be done
+  static bool sweep_some_chunks(unsigned nbchunks);
+  /// sweep everything still pending, and wait for other sweepers
+  static void finish_sweep(void);
+  static bool is_sweeping(void)
+  {
+    return qz_sweeping.load(std::memory_order_acquire);
+  };
+  /// true from the start of a collection till the end of its sweep
+  static bool is_collecting(void)
+  {
+    return qz_collecting.load(std::memory_order_acquire);
+  };
+  /// cumulated count of zones deleted by sweeping
+  static uint64_t nb_swept_zones(void)
+  {
+    return qz_nbswept.load(std::memory_order_relaxed);
+  };
+  /// true for dead zones waiting to be swept; weak tables (like the
+  /// object id map or the symbol table) should ignore them
+  inline bool is_awaiting_sweep(void) const;
+  /// true for zones which survived a collection
+  bool is_old_zone(void) const
+  {
+    return qz_gcinfo.load(std::memory_order_relaxed) & qz_gcold_bit;
+  };
+  /// run some GC function while new zones are allocated already marked
   inline static void run_locked_gc(Rps_GarbageCollector&, std::function<void(Rps_GarbageCollector&)>);
   inline static void every_zone(Rps_GarbageCollector&, std::function<void(Rps_GarbageCollector&, Rps_QuasiZone*)>);
   template <typename ZoneClass, class ...Args> static ZoneClass*
@@ -2969,6 +3350,225 @@ typedef Rps_TwoValues rps_applyingfun_t (Rps_CallFrame*callerframe,
 // by convention, the extern "C" applying function inside the fictuous connective _45vHaB3kVHiDzT42h0
 // would be named rpsapply_45vHaB3kVHiDzT42h0
 class Rps_Payload;
+
+/// The attributes of an object. Up to inline_max of them sit in the
+/// object itself, then up to small_max in a heap vector; both are
+/// sorted by oid of attributes. Past small_max they move into an
+/// open addressing table with linear probing, hashed on the
+/// attribute address, and come back into the vector when few enough
+/// remain. Lookups compare addresses only; for_each always gives
+/// attributes by increasing oid, as the dump wants.
+class Rps_AttrStore
+{
+public:
+  static constexpr unsigned inline_max = 2;
+  static constexpr unsigned small_max = 8;
+  struct entry_st
+  {
+    Rps_ObjectRef en_atob;
+    Rps_Value en_val;
+  };
+private:
+  entry_st as_inline[inline_max];
+  entry_st* as_heap;            // null while attributes are inline
+  uint32_t as_count;
+  uint32_t as_capacity;         // above small_max when hashed
+  bool is_hashed(void) const
+  {
+    return as_capacity > small_max;
+  };
+  const entry_st* entries(void) const
+  {
+    return as_heap?as_heap:as_inline;
+  };
+  static size_t hash_slot(const Rps_ObjectZone*atob, uint32_t capacity)
+  {
+    uint64_t h = (uint64_t)(uintptr_t)atob * 0x9e3779b97f4a7c15ULL;
+    return (size_t)(h >> 32) & (capacity-1);
+  };
+  inline const entry_st* find_entry(const Rps_ObjectZone*atob) const;
+  void put_sorted(const Rps_ObjectRef atob, const Rps_Value val);
+  void put_hashed(entry_st*table, uint32_t capacity,
+                  const Rps_ObjectRef atob, const Rps_Value val);
+  void rehash(uint32_t newcapacity);
+  void unhash(void);
+public:
+  Rps_AttrStore()
+    : as_inline(), as_heap(nullptr), as_count(0), as_capacity(inline_max) {};
+  ~Rps_AttrStore()
+  {
+    delete[] as_heap;
+  };
+  Rps_AttrStore(const Rps_AttrStore&) = delete;
+  Rps_AttrStore& operator = (const Rps_AttrStore&) = delete;
+  unsigned size(void) const
+  {
+    return as_count;
+  };
+  bool empty(void) const
+  {
+    return as_count == 0;
+  };
+  /// the value of an attribute, or else null
+  inline Rps_Value get(const Rps_ObjectRef atob) const;
+  /// adds or replaces an attribute
+  void put(const Rps_ObjectRef atob, const Rps_Value val);
+  bool erase(const Rps_ObjectRef atob);
+  void clear(void);
+  /// fun(atob,val) by increasing oid of atob, without modifying this
+  template <typename FunT> inline void for_each(FunT fun) const;
+  /// likewise, in any order
+  template <typename FunT> inline void for_each_unordered(FunT fun) const;
+};                              // end class Rps_AttrStore
+
+/// The table of every object zone by its oid, with open addressing
+/// over groups of 16 slots. Each slot keeps the 16 bytes of its oid
+/// next to the object pointer, and a separate control byte holding
+/// 7 bits of the hash, so a probe compares 16 control bytes at once
+/// (with SSE2 when available). Lookups never lock; insertions and
+/// removals are serialized by a mutex and never reuse a removed slot
+/// before the array is rebuilt, so a reader seeing a control byte
+/// always sees the oid written before it. A rebuilt array replaces
+/// the current one but the retired arrays are kept for readers still
+/// probing them; they are together smaller than the current array.
+/// A sorted vector of oids, merged on demand, serves prefix
+/// completion.
+class Rps_OidTable
+{
+public:
+  static constexpr unsigned group_width = 16;
+  static constexpr uint8_t ctrl_empty = 0x80;
+  static constexpr uint8_t ctrl_removed = 0xfe;
+private:
+  struct slot_st
+  {
+    std::atomic<uint64_t> sl_hi;
+    std::atomic<uint64_t> sl_lo;
+    std::atomic<Rps_ObjectZone*> sl_obz;
+  };
+  struct array_st
+  {
+    size_t ar_nbgroups;         // a power of two
+    size_t ar_used;             // live and removed slots
+    size_t ar_live;
+    std::unique_ptr<uint8_t[]> ar_ctrl;
+    std::unique_ptr<slot_st[]> ar_slots;
+    array_st(size_t nbgroups);
+  };
+  std::atomic<array_st*> ot_array;
+  mutable std::mutex ot_mtx;
+  /// arrays replaced by grow, freed by the next grace period
+  std::vector<std::unique_ptr<array_st>> ot_retired;
+  /// lock-free readers in flight are counted by the parity of the
+  /// epoch they started in; a grace period flips it and waits for the
+  /// previous readers
+  mutable std::atomic<uint64_t> ot_epoch;
+  mutable std::atomic<long> ot_readers[2];
+  std::mutex ot_syncmtx;
+  /// the prefix index: ot_sorted is sorted, ot_pending is not yet
+  /// merged, and some oids there could have been removed since
+  std::vector<Rps_Id> ot_sorted;
+  std::vector<Rps_Id> ot_pending;
+  size_t ot_nbremoved;
+  /// ot_pending is merged once it has that many more oids than half
+  /// of ot_sorted, even if range is never called
+  static constexpr size_t ot_merge_threshold = 4096;
+  static uint64_t mix_hash(uint64_t hi, uint64_t lo)
+  {
+    uint64_t h = hi * 0x9e3779b97f4a7c15ULL ^ (lo + (hi >> 29));
+    h ^= h >> 32;
+    h *= 0xd6e8feb86659fd93ULL;
+    h ^= h >> 32;
+    return h;
+  };
+  static uint32_t match_group(const uint8_t*ctrl, uint8_t byte);
+  static slot_st* lookup_slot(array_st*ar, uint64_t hi, uint64_t lo);
+  static void put_in_array(array_st*ar, uint64_t hi, uint64_t lo, Rps_ObjectZone*obz);
+  void grow(void);
+  void add_locked(const Rps_Id&oid, Rps_ObjectZone*obz);
+  void merge_pending_locked(void);
+public:
+  /// a zone given by lookup or insert_or_replace is not freed while
+  /// some read_guard, constructed before, is alive
+  class read_guard
+  {
+    const Rps_OidTable& rg_table;
+    uint64_t rg_epoch;
+  public:
+    read_guard(const Rps_OidTable&tbl);
+    ~read_guard();
+    read_guard(const read_guard&) = delete;
+    read_guard& operator = (const read_guard&) = delete;
+  };
+  Rps_OidTable(size_t initsize);
+  ~Rps_OidTable();
+  /// lock-free, may give a zone awaiting its sweep; should be inside
+  /// a read_guard
+  Rps_ObjectZone* lookup(const Rps_Id&oid) const;
+  /// gives the zone previously there, or null when adding
+  Rps_ObjectZone* insert_or_replace(const Rps_Id&oid, Rps_ObjectZone*obz);
+  /// if there, and only when still bound to that zone
+  bool remove(const Rps_Id&oid, const Rps_ObjectZone*obz);
+  /// adds some fresh random oid bound to obz, which may be null
+  Rps_Id fresh_random(Rps_ObjectZone*obz);
+  size_t size(void) const;
+  /// the zones, not awaiting their sweep, whose oids are between
+  /// idfirst and idlast, in increasing oid order
+  std::vector<Rps_ObjectZone*> range(const Rps_Id&idfirst, const Rps_Id&idlast);
+  /// wait till every read_guard constructed before has ended, and free
+  /// the retired arrays; zones removed before can then be freed
+  void synchronize_readers(void);
+};                              // end class Rps_OidTable
+
+/// While alive, the current thread does not stop at safepoints. Every
+/// non-object lock whose holder could enter a local frame, or wait for
+/// an object mutex, is taken with it: an agenda worker stopped while
+/// holding such a lock would block any worker waiting for it, and the
+/// safepoint barrier would never be complete. Leaf locks, e.g. of the
+/// arena or of the collector, don't need it.
+class Rps_NoSafepointGuard
+{
+public:
+  inline Rps_NoSafepointGuard();
+  inline ~Rps_NoSafepointGuard();
+  Rps_NoSafepointGuard(const Rps_NoSafepointGuard&) = delete;
+  Rps_NoSafepointGuard& operator = (const Rps_NoSafepointGuard&) = delete;
+};                              // end class Rps_NoSafepointGuard
+
+/// a lock guard for such non-object locks
+template <typename Mtx>
+class Rps_NoSafepointLock : private Rps_NoSafepointGuard
+{
+  std::lock_guard<Mtx> nsl_guard;
+public:
+  explicit Rps_NoSafepointLock(Mtx&mtx)
+    : Rps_NoSafepointGuard(), nsl_guard(mtx) {};
+};                              // end class Rps_NoSafepointLock
+
+/// The recursive mutex of every object. It knows which agenda
+/// worker thread holds it, so the garbage collector can scan an
+/// object left locked by a worker stopped at a safepoint, and a
+/// worker waiting for it still reaches safepoints.
+class Rps_ObjectMutex
+{
+  std::recursive_timed_mutex om_mtx;
+  /// the index of the agenda worker holding it, 0 when unlocked or
+  /// held by another thread
+  std::atomic<int> om_owner;
+  unsigned om_depth;            // only changed by the holding thread
+public:
+  Rps_ObjectMutex() : om_mtx(), om_owner(0), om_depth(0) {};
+  Rps_ObjectMutex(const Rps_ObjectMutex&) = delete;
+  Rps_ObjectMutex& operator = (const Rps_ObjectMutex&) = delete;
+  inline void lock(void);
+  inline bool try_lock(void);
+  inline void unlock(void);
+  int owning_worker(void) const
+  {
+    return om_owner.load(std::memory_order_acquire);
+  };
+};                              // end class Rps_ObjectMutex
+
 class Rps_ObjectZone : public Rps_ZoneValue
 {
   ///
@@ -2980,7 +3580,9 @@ public:
   };
   friend class Rps_Loader;
   friend class Rps_Dumper;
+  friend class Rps_Journal;
   friend class Rps_Payload;
+  friend class Rps_QuasiZone;
   friend class Rps_ObjectRef;
   friend class Rps_Value;
   friend Rps_ObjectZone*
@@ -2988,30 +3590,39 @@ public:
 private:
   /// fields
   const Rps_Id ob_oid;
-  mutable std::recursive_mutex ob_mtx;
+  mutable Rps_ObjectMutex ob_mtx;
   std::atomic<Rps_ObjectZone*> ob_class;
   std::atomic<Rps_ObjectZone*> ob_space;
   std::atomic<double> ob_mtime;
-  std::map<Rps_ObjectRef, Rps_Value> ob_attrs;
+  Rps_AttrStore ob_attrs;
   std::vector<Rps_Value> ob_comps;
   std::atomic<Rps_Payload*> ob_payload;
+  /// the word size and type of the payload, packed by exchange_payload
+  /// so the sweep counts payloads without locking the object
+  std::atomic<uint64_t> ob_paylstat;
   std::atomic<rps_magicgetterfun_t*> ob_magicgetterfun;
   std::atomic<rps_applyingfun_t*> ob_applyingfun;
   /// constructors
   Rps_ObjectZone(Rps_Id oid, registermode_en regmod);
   Rps_ObjectZone(void);
   ~Rps_ObjectZone();
-  static std::unordered_map<Rps_Id,Rps_ObjectZone*,Rps_Id::Hasher> ob_idmap_;
-  static std::map<Rps_Id,Rps_ObjectZone*> ob_idbucketmap_[Rps_Id::maxbuckets];
-  static std::recursive_mutex ob_idmtx_;
+  static Rps_OidTable ob_idtable_;
   static void register_objzone(Rps_ObjectZone*);
   static Rps_Id fresh_random_oid(Rps_ObjectZone*ob =nullptr);
 protected:
+  /// Every store of a zone pointer into the object goes thru one of
+  /// these setters, which run the write barrier; the callers of
+  /// store_attr and store_comp hold ob_mtx.
+  inline void store_class(Rps_ObjectZone*obzclass);
+  inline void store_space(Rps_ObjectZone*obzspace);
+  inline void store_attr(const Rps_ObjectRef obattr, const Rps_Value valattr);
+  inline void store_comp(const Rps_Value compval);
+  inline Rps_Payload* exchange_payload(Rps_Payload*newpayl);
   void loader_set_class (Rps_Loader*ld, Rps_ObjectZone*obzclass)
   {
     RPS_ASSERT(ld != nullptr);
     RPS_ASSERT(obzclass != nullptr);
-    ob_class.store(obzclass);
+    store_class(obzclass);
   };
   void loader_set_mtime (Rps_Loader*ld, double mtim)
   {
@@ -3023,14 +3634,14 @@ protected:
   {
     RPS_ASSERT(ld != nullptr);
     RPS_ASSERT(obzspace != nullptr);
-    ob_space.store(obzspace);
+    store_space(obzspace);
   };
   void loader_put_attr (Rps_Loader*ld, const Rps_ObjectRef keyatob, const Rps_Value atval)
   {
     RPS_ASSERT(ld != nullptr);
     RPS_ASSERT(keyatob);
     RPS_ASSERT(atval);
-    ob_attrs.insert({keyatob, atval});
+    store_attr(keyatob, atval);
   };
   void loader_put_magicattrgetter(Rps_Loader*ld, rps_magicgetterfun_t*mfun)
   {
@@ -3059,18 +3670,33 @@ protected:
   void loader_add_comp (Rps_Loader*ld, const Rps_Value compval)
   {
     RPS_ASSERT(ld != nullptr);
-    ob_comps.push_back(compval);
+    store_comp(compval);
   };
+  /// before replaying a journaled object over its loaded contents
+  inline void loader_clear_contents (Rps_Loader*ld);
 public:
-  std::recursive_mutex* objmtxptr(void) const
+  Rps_ObjectMutex* objmtxptr(void) const
   {
     return &ob_mtx;
   };
+  /// With --lazy-load, most objects are filled from their space file
+  /// only when first used. The accessors and mutators call this
+  /// before using the contents; it is cheap once filled.
+  inline void materialize(void) const;
+  /// The write barrier of the generational garbage collector: an old
+  /// object getting a reference to a young zone is remembered, so is
+  /// scanned by the next minor collection.
+  inline void gc_write_barrier(const Rps_ZoneValue*zv);
+  inline void gc_write_barrier(Rps_Value val);
+  inline void gc_write_barrier(Rps_ObjectRef obr);
+  /// remember an old object whose payload changes in some unknown way
+  inline void gc_remember_if_old(void);
   void put_applying_function(rps_applyingfun_t*afun);
-  void touch_now(void)
-  {
-    ob_mtime.store(rps_wallclock_real_time());
-  };
+  /// every mutator should touch the object, which also notes it for
+  /// the mutation journal
+  inline void touch_now(void);
+  /// note a change (e.g. of its payload) for the mutation journal only
+  inline void journal_mutation(void);
   std::string string_oid(void) const;
   inline Rps_Payload*get_payload(void) const;
   const std::string payload_type_name(void) const;
@@ -3136,19 +3762,23 @@ public:
   inline double get_mtime(void) const;
   inline rps_applyingfun_t*get_applyingfun(const Rps_ClosureValue&) const
   {
+    materialize();
     return ob_applyingfun.load();
   };
   inline rps_applyingfun_t* get_applying_ptrfun() const
   {
+    materialize();
     return ob_applyingfun.load();
   };
   inline void clear_payload(void);
   template<class PaylClass>
   PaylClass* put_new_plain_payload(void)
   {
-    std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+    materialize();
+    std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
     PaylClass*newpayl = Rps_QuasiZone::rps_allocate1<PaylClass>(this);
-    Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+    Rps_Payload*oldpayl = exchange_payload(newpayl);
+    touch_now();
     if (oldpayl)
       delete oldpayl;
     return newpayl;
@@ -3156,10 +3786,12 @@ public:
   template<class PaylClass, typename Arg1Class>
   PaylClass* put_new_arg1_payload(Arg1Class arg1)
   {
-    std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+    materialize();
+    std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
     PaylClass*newpayl =
       Rps_QuasiZone::rps_allocate2<PaylClass,Arg1Class>(this,arg1);
-    Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+    Rps_Payload*oldpayl = exchange_payload(newpayl);
+    touch_now();
     if (oldpayl)
       delete oldpayl;
     return newpayl;
@@ -3167,10 +3799,12 @@ public:
   template<class PaylClass, typename Arg1Class, typename Arg2Class>
   PaylClass* put_new_arg2_payload(Arg1Class arg1, Arg2Class arg2)
   {
-    std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+    materialize();
+    std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
     PaylClass*newpayl =
       Rps_QuasiZone::rps_allocate3<PaylClass,Arg1Class,Arg2Class>(this,arg1,arg2);
-    Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+    Rps_Payload*oldpayl = exchange_payload(newpayl);
+    touch_now();
     if (oldpayl)
       delete oldpayl;
     return newpayl;
@@ -3178,11 +3812,13 @@ public:
   template<class PaylClass, typename Arg1Class, typename Arg2Class, typename Arg3Class>
   PaylClass* put_new_arg3_payload(Arg1Class arg1, Arg2Class arg2, Arg3Class arg3)
   {
-    std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+    materialize();
+    std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
     PaylClass*newpayl =
       Rps_QuasiZone::rps_allocate4<PaylClass,Arg1Class,Arg2Class,Arg3Class>
       (this,arg1,arg2,arg3);
-    Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+    Rps_Payload*oldpayl = exchange_payload(newpayl);
+    touch_now();
     if (oldpayl)
       delete oldpayl;
     return newpayl;
@@ -3190,10 +3826,12 @@ public:
   template<class PaylClass, typename Arg1Class, typename Arg2Class, typename Arg3Class, typename Arg4Class>
   PaylClass* put_new_arg4_payload(Arg1Class arg1, Arg2Class arg2, Arg3Class arg3, Arg4Class arg4)
   {
-    std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+    materialize();
+    std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
     PaylClass*newpayl =
       Rps_QuasiZone::rps_allocate5<PaylClass,Arg1Class,Arg2Class,Arg3Class,Arg4Class>(this,arg1,arg2,arg3,arg4);
-    Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+    Rps_Payload*oldpayl = exchange_payload(newpayl);
+    touch_now();
     if (oldpayl)
       delete oldpayl;
     return newpayl;
@@ -3201,10 +3839,12 @@ public:
   template<class PaylClass>
   PaylClass* put_new_plain_payload_with_wordgap(unsigned wordgap)
   {
-    std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+    materialize();
+    std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
     PaylClass*newpayl =
       Rps_QuasiZone::rps_allocate_with_wordgap<PaylClass>(wordgap,this);
-    Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+    Rps_Payload*oldpayl = exchange_payload(newpayl);
+    touch_now();
     if (oldpayl)
       delete oldpayl;
     return newpayl;
@@ -3212,10 +3852,12 @@ public:
   template<class PaylClass, typename Arg1Class>
   PaylClass* put_new_arg1_payload_with_wordgap(unsigned wordgap, Arg1Class arg1)
   {
-    std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+    materialize();
+    std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
     PaylClass*newpayl =
       Rps_QuasiZone::rps_allocate_with_wordgap<PaylClass,Arg1Class>(wordgap,this,arg1);
-    Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+    Rps_Payload*oldpayl = exchange_payload(newpayl);
+    touch_now();
     if (oldpayl)
       delete oldpayl;
     return newpayl;
@@ -3223,10 +3865,12 @@ public:
   template<class PaylClass, typename Arg1Class, typename Arg2Class>
   PaylClass* put_new_arg2_payload_with_wordgap(unsigned wordgap, Arg1Class arg1, Arg2Class arg2)
   {
-    std::lock_guard<std::recursive_mutex> gu(ob_mtx);
+    materialize();
+    std::lock_guard<Rps_ObjectMutex> gu(ob_mtx);
     PaylClass*newpayl =
       Rps_QuasiZone::rps_allocate_with_wordgap<PaylClass,Arg1Class,Arg2Class>(wordgap,this,arg1,arg2);
-    Rps_Payload*oldpayl = ob_payload.exchange(newpayl);
+    Rps_Payload*oldpayl = exchange_payload(newpayl);
+    touch_now();
     if (oldpayl)
       delete oldpayl;
     return newpayl;
@@ -3298,6 +3942,24 @@ protected:
   {
     payl_owner = nullptr;
   };
+  /// every mutator storing a value inside a payload should call this
+  /// write barrier, for the generational garbage collector; it also
+  /// touches the owner
+  void gc_write_barrier(Rps_Value val) const
+  {
+    if (payl_owner)
+      {
+        payl_owner->gc_write_barrier(val);
+        payl_owner->touch_now();
+      }
+  };
+  /// every other mutator of a payload, e.g. removing something,
+  /// should touch the owner, so incremental dumps rewrite its space
+  void touch_owner(void) const
+  {
+    if (payl_owner)
+      payl_owner->touch_now();
+  };
 public:
   Rps_Payload(Rps_Type ty, Rps_ObjectZone*obz, Rps_Loader*ld)
     : Rps_Payload(ty,obz)
@@ -3642,6 +4304,9 @@ class Rps_TreeZone : public Rps_LazyHashedZoneValue
   mutable std::atomic<Rps_ObjectZone*> _treemetaob;
   Rps_ObjectRef _treeconnob;
   Rps_Value _treesons[RPS_FLEXIBLE_DIM+1];
+  /// the write barrier of metadata, which is mutable: an old tree
+  /// zone given a young metadata object is remembered
+  inline void gc_metadata_write_barrier(Rps_ObjectZone*obz);
   Rps_TreeZone(unsigned len, Rps_ObjectRef obr=nullptr)
     : Rps_LazyHashedZoneValue(treety), _treelen(len),
       _treetransient(false), _treemetatransient(false),
@@ -3713,6 +4378,7 @@ public:
   virtual void gc_mark(Rps_GarbageCollector&gc, unsigned depth) const
   {
     gc.mark_obj(_treeconnob);
+    gc.mark_obj(_treemetaob.load());
     for (auto vson: *this)
       if (vson)
         gc.mark_value(vson, depth+1);
@@ -4010,6 +4676,10 @@ protected:
   intptr_t* cfram_xtradata;
   std::atomic<Rps_CallFrameOutputSig_t*> cfram_outputter;
   std::function<void(Rps_GarbageCollector*)> cfram_marker;
+  /// the frame which was the innermost one of the current thread when
+  /// this one was made; usually cfram_prev, but not always
+  Rps_CallFrame* cfram_dynprev;
+  static thread_local Rps_ProtoCallFrame* _cfram_thread_top_;
 public:
   static constexpr unsigned _cfram_max_size_ = 1024;
   static std::atomic<int> _cfram_output_depth_;
@@ -4023,7 +4693,8 @@ public:
       cfram_clos(nullptr),
       cfram_xtradata((intptr_t*) xdata),
       cfram_outputter(nullptr),
-      cfram_marker()
+      cfram_marker(),
+      cfram_dynprev(_cfram_thread_top_)
   {
     // ensure that if some size is given, the xdata is a suitably
     // aligned pointer...
@@ -4031,6 +4702,7 @@ public:
             || (xdata != nullptr
                 && (((intptr_t)xdata & (alignof(intptr_t)-1)) == 0)));
     assert (size < _cfram_max_size_);
+    _cfram_thread_top_ = this;
   }; // end Rps_ProtoCallFrame constructor
   ~Rps_ProtoCallFrame()
   {
@@ -4045,7 +4717,19 @@ public:
     cfram_state = nullptr;
     cfram_rankstate = 0;
     cfram_clos = nullptr;
+    /// local frames are destroyed in reverse order of construction
+    _cfram_thread_top_ = cfram_dynprev;
+    cfram_dynprev = nullptr;
   }; // end Rps_ProtoCallFrame destructor
+  /// the innermost call frame of the current thread, if any
+  static Rps_CallFrame* thread_top_frame(void)
+  {
+    return _cfram_thread_top_;
+  };
+  Rps_CallFrame* dynamic_previous_frame(void) const
+  {
+    return cfram_dynprev;
+  };
   void set_outputter(std::nullptr_t)
   {
     cfram_outputter.store(nullptr);
@@ -4245,12 +4929,20 @@ public:                                                 \
   };                                                    \
   Rps_FrameAt##Lin _((Descr),(Prev));                   \
   auto& _f = *_.fieldsptr();                            \
+  Rps_Agenda::poll_safepoint();                         \
   /*end RPS_LOCALFRAME_ATBIS*/
 
 
 /// coding convention in RPS_LOCALFRAME: if the Prev-ious frame is
 /// null, use the RPS_NULL_CALL_FRAME macro... if the Descr-iptor is
 /// null, use RPS_CALL_FRAME_UNDESCRIBED
+///
+/// An agenda worker thread may be stopped for garbage collection
+/// right after entering a local frame, or while waiting for an object
+/// mutex, unless it holds some Rps_NoSafepointGuard. Values kept in
+/// C++ locals are found by scanning its stack conservatively, but
+/// values which should survive that and are kept only inside C++
+/// containers should also be in the _f fields of some frame.
 
 #define RPS_LOCALFRAME_AT(Lin,Descr,Prev,...)       \
   RPS_LOCALFRAME_ATBIS(Lin,Descr,Prev,__VA_ARGS__)
@@ -4271,6 +4963,25 @@ public:                                                 \
 
 
 
+////////////////////////////////////////////////////////////////
+////// method caches
+
+/// Method closures found by Rps_Value::closure_for_method_selector
+/// are cached in one global table shared by every call site and
+/// thread, keyed by the class and selector, and tagged with the
+/// current epoch. Any change of methods, superclass or class payload,
+/// and any sweep freeing objects, increments the epoch, which
+/// invalidates every cached entry at once.
+extern std::atomic<uint64_t> rps_method_cache_epoch; // in values_rps.cc
+
+static inline void
+rps_invalidate_method_caches(void)
+{
+  rps_method_cache_epoch.fetch_add(1, std::memory_order_acq_rel);
+} // end rps_invalidate_method_caches
+
+
+
 ////////////////////////////////////////////////////////////////
 ////// class information payload - for PaylClassInfo, objects of class
 ////// `class` _41OFI3r0S1t03qdB2E
@@ -4295,6 +5006,7 @@ class Rps_PayloadClassInfo : public Rps_Payload
   mutable std::atomic<const Rps_SetOb*> pclass_attrset;
   virtual ~Rps_PayloadClassInfo()
   {
+    rps_invalidate_method_caches();
     pclass_super = nullptr;
     pclass_methdict.clear();
     pclass_symbname = nullptr;
@@ -4336,10 +5048,13 @@ public:
   void put_superclass(Rps_ObjectRef obr)
   {
     pclass_super = obr;
+    gc_write_barrier(obr);
+    rps_invalidate_method_caches();
   };
   inline void clear_symbname(void)
   {
     pclass_symbname = nullptr;
+    touch_owner();
   };
   std::string class_name_str(void) const;
   void put_symbname(Rps_ObjectRef obr);
@@ -4363,12 +5078,20 @@ public:
   void put_own_method(Rps_ObjectRef obsel, Rps_ClosureValue clov)
   {
     if (obsel && clov && clov.is_closure())
-      pclass_methdict.insert({obsel,clov});
+      {
+        pclass_methdict.insert({obsel,clov});
+        gc_write_barrier(obsel);
+        gc_write_barrier(clov);
+        rps_invalidate_method_caches();
+      }
   };
   void remove_own_method(Rps_ObjectRef obsel)
   {
-    if (obsel)
-      pclass_methdict.erase(obsel);
+    if (obsel && pclass_methdict.erase(obsel) > 0)
+      {
+        touch_owner();
+        rps_invalidate_method_caches();
+      }
   };
 };                              // end Rps_PayloadClassInfo
 
@@ -4426,20 +5149,28 @@ public:
   void add(const Rps_ObjectZone* obelem)
   {
     if (obelem)
-      psetob.insert(Rps_ObjectRef(obelem));
+      {
+        psetob.insert(Rps_ObjectRef(obelem));
+        gc_write_barrier(Rps_ObjectRef(obelem));
+      }
   };
   void add (const Rps_ObjectRef obrelem)
   {
     if (!obrelem.is_empty())
-      psetob.insert(obrelem);
+      {
+        psetob.insert(obrelem);
+        gc_write_barrier(obrelem);
+      }
   };
   void remove(const Rps_ObjectZone* obelem)
   {
-    if (obelem) psetob.erase(Rps_ObjectRef(obelem));
+    if (obelem && psetob.erase(Rps_ObjectRef(obelem)) > 0)
+      touch_owner();
   };
   void remove (const Rps_ObjectRef obrelem)
   {
-    if (obrelem) psetob.erase(obrelem);
+    if (obrelem && psetob.erase(obrelem) > 0)
+      touch_owner();
   };
   Rps_SetValue to_set() const
   {
@@ -4514,12 +5245,18 @@ public:
   void push_back(const Rps_ObjectZone* obcomp)
   {
     if (obcomp)
-      pvectob.push_back(Rps_ObjectRef(obcomp));
+      {
+        pvectob.push_back(Rps_ObjectRef(obcomp));
+        gc_write_barrier(Rps_ObjectRef(obcomp));
+      }
   };
   void push_back (const Rps_ObjectRef obrcomp)
   {
     if (obrcomp)
-      pvectob.push_back(obrcomp);
+      {
+        pvectob.push_back(obrcomp);
+        gc_write_barrier(obrcomp);
+      }
   };
   Rps_TupleValue to_tuple() const
   {
@@ -4586,12 +5323,18 @@ public:
   void push_back(const Rps_Value val)
   {
     if (val)
-      pvectval.push_back(val);
+      {
+        pvectval.push_back(val);
+        gc_write_barrier(val);
+      }
   };
   void push_back (const Rps_ObjectRef obrcomp)
   {
     if (obrcomp)
-      pvectval.push_back(Rps_ObjectValue(obrcomp));
+      {
+        pvectval.push_back(Rps_ObjectValue(obrcomp));
+        gc_write_barrier(obrcomp);
+      }
   };
   /* make a new closure from a given connective and the values inside
      the vector payload: */
@@ -4650,14 +5393,17 @@ public:
   void set_indentation(int ind=0)
   {
     strbuf_indent = ind;
+    touch_owner();
   };
   void more_indentation(int delta)
   {
     strbuf_indent += delta;
+    touch_owner();
   };
   void less_indentation(int delta)
   {
     strbuf_indent -= delta;
+    touch_owner();
   };
   bool is_transient(void) const
   {
@@ -4666,6 +5412,7 @@ public:
   void set_transient(bool fl=true)
   {
     strbuf_transient=fl;
+    touch_owner();
   };
   virtual uint32_t wordsize(void) const
   {
@@ -4821,6 +5568,12 @@ public:
   {
     return symb_is_weak.load();
   };
+  /// a weak symbol whose owner is dead but not yet swept
+  bool is_dead_symbol(void) const
+  {
+    auto own = owner();
+    return own && own->is_awaiting_sweep();
+  };
   bool symbol_is_weak(void) const
   {
     return symb_is_weak.load();
@@ -4828,6 +5581,7 @@ public:
   void set_weak(bool f)
   {
     symb_is_weak.store(f);
+    touch_owner();
   };
   Rps_Value symbol_value(void) const
   {
@@ -4836,6 +5590,7 @@ public:
   void symbol_put_value(Rps_Value v)
   {
     symb_data.store(v.data_for_symbol(this));
+    gc_write_barrier(v);
   };
   const std::string& symbol_name(void) const
   {
@@ -4858,12 +5613,12 @@ public:
   }
   static Rps_PayloadSymbol* find_named_payload(const std::string&str)
   {
-    std::lock_guard<std::recursive_mutex> gu(symb_tablemtx);
+    Rps_NoSafepointLock<std::recursive_mutex> gu(symb_tablemtx);
     auto it = symb_table.find(str);
     if (it != symb_table.end())
       {
         auto symb = it->second;
-        if (symb)
+        if (symb && !symb->is_dead_symbol())
           return symb;
       };
     return nullptr;
@@ -4938,6 +5693,7 @@ public:
   void put_descr(Rps_Value d)
   {
     obm_descr = d;
+    gc_write_barrier(d);
   };
   void do_each_entry(Rps_CallFrame*cf, std::function<bool(Rps_CallFrame*,Rps_ObjectRef,Rps_Value,void*)> f,
                      void* clientdata=nullptr) const
@@ -5042,6 +5798,167 @@ public:
 // same as used in rps_manifest.json file
 #define RPS_PREVIOUS_MANIFEST_FORMAT "RefPerSysFormat2019A"
 #define RPS_MANIFEST_FORMAT "RefPerSysFormat2023A"
+// a manifest with that format has binary space files, see binstore_rps.cc
+#define RPS_BINARY_FORMAT "RefPerSysBinary2024A"
+
+/// The binary space files persistore/sp*-rps.bin hold the same JSON
+/// objects as the textual ones, compactly encoded: a versioned
+/// header, a table of interned oids, a table of interned member
+/// names, then one length-prefixed record per object, whose tagged
+/// values refer to oids and names by their index.
+class Rps_BinaryStoreWriter
+{
+public:
+  static constexpr char bs_magic[8] = {'R','P','S','B','I','N','1','\n'};
+  static constexpr char bs_endmagic[8] = {'R','P','S','E','N','D','1','\n'};
+  static constexpr uint32_t bs_version = 1;
+  static constexpr uint32_t bs_byteorder = 0x01020304;
+  enum bs_tag_en : uint8_t
+  {
+    BsTag_Null, BsTag_False, BsTag_True,
+    BsTag_Int,                  // zigzag varint
+    BsTag_UInt,                 // varint
+    BsTag_Double,               // 8 bytes
+    BsTag_String,               // varint length, bytes
+    BsTag_Oid,                  // varint index of interned oid
+    BsTag_Array,                // varint count, values
+    BsTag_Object,               // varint count, (name index, value) pairs
+    BsTag__Last
+  };
+  Rps_BinaryStoreWriter(Rps_Id spacid);
+  /// the object JSON should have its "oid" member
+  void add_object(Json::Value jobject);
+  void write(std::ostream&out);
+  static bool string_is_oid(const std::string&str, Rps_Id*pid);
+private:
+  void intern_value(const Json::Value&jv);
+  void encode_value(std::string&buf, const Json::Value&jv);
+  Rps_Id bw_spacid;
+  std::vector<Json::Value> bw_jsonvec;   // objects without their "oid"
+  std::vector<uint32_t> bw_recoidix;     // their oid index
+  std::unordered_map<Rps_Id,uint32_t,Rps_Id::Hasher> bw_oidmap;
+  std::vector<Rps_Id> bw_oidvec;
+  std::unordered_map<std::string,uint32_t> bw_namemap;
+  std::vector<std::string> bw_namevec;
+};                              // end Rps_BinaryStoreWriter
+
+/// Reads a binary space file in memory, usually mmap-ed; once
+/// constructed, records may be decoded concurrently.
+class Rps_BinaryStoreReader
+{
+public:
+  struct bs_record_st
+  {
+    Rps_Id br_oid;
+    size_t br_start;            // offset of the encoded object
+    size_t br_size;
+  };
+  Rps_BinaryStoreReader(const char*base, size_t size, const std::string&path);
+  Rps_Id space_id(void) const
+  {
+    return br_spacid;
+  };
+  const std::vector<bs_record_st>& records(void) const
+  {
+    return br_records;
+  };
+  /// decode a record, with its "oid" member
+  Json::Value decode_record(const bs_record_st&rec) const;
+  /// test if a record has some top level member, without decoding it
+  bool record_has_member(const bs_record_st&rec, const std::string&name) const;
+private:
+  uint64_t read_varint(const char*&pc, const char*end) const;
+  Json::Value decode_value(const char*&pc, const char*end, unsigned depth) const;
+  void skip_value(const char*&pc, const char*end, unsigned depth) const;
+  [[noreturn]] void corrupted(const char*pc, const char*why) const;
+  const char* br_base;
+  size_t br_size;
+  std::string br_path;
+  Rps_Id br_spacid;
+  std::vector<Rps_Id> br_oidvec;
+  std::vector<std::string> br_namevec;
+  std::vector<bs_record_st> br_records;
+};                              // end Rps_BinaryStoreReader
+
+/// The write-ahead mutation journal, in journal_rps.cc. Between dumps,
+/// objects touched by mutators are queued, and a committer thread
+/// periodically appends their serialized contents to
+/// persistore/journal-rps.bin as checksummed records, then fdatasync-s
+/// it once per batch. The loader replays the journal after the space
+/// files, so a crash loses at most one commit period of changes.
+class Rps_Journal
+{
+  friend class Rps_ObjectZone;
+public:
+  static constexpr const char jr_magic[] = "RPSJRN1\n";
+  static constexpr size_t jr_magic_len = 8;
+  static constexpr unsigned jr_commit_period_millis = 100;
+  static constexpr size_t jr_record_header_size = 8; // length & checksum
+  static bool active(void)
+  {
+    return jr_active_.load(std::memory_order_relaxed);
+  };
+  /// start journaling into dirpath, usually the load directory
+  static void open(const std::string&dirpath);
+  /// commit pending mutations and stop journaling
+  static void close(void);
+  /// commit now every pending mutation, and wait for its durability
+  static void flush(void);
+  /// around a dump into some directory; a successful dump makes
+  /// older journal records useless
+  static void begin_dump(const std::string&realdirpath);
+  static void end_dump(const std::string&realdirpath);
+  static void gc_mark(Rps_GarbageCollector&gc);
+  static std::string journal_path(const std::string&dirpath, bool old=false);
+  static uint32_t checksum(const char*buf, size_t len);
+  /// call fun on the body of each valid record of a journal file
+  /// content, return the length of its valid prefix
+  static size_t scan_records(const std::string&content, const std::string&path,
+                             const std::function<void(const char*body, size_t len)>&fun);
+  static void output(std::ostream&out);
+private:
+  static void add_pending(Rps_ObjectZone*obz);
+  static void committer_loop(void);
+  static void commit_batch(std::vector<Rps_ObjectZone*>&batch);
+  static void open_file(bool truncate);
+  static std::atomic<bool> jr_active_;
+  static std::mutex jr_mtx_;
+  static std::mutex jr_filemtx_; // for jr_fd_, taken after jr_mtx_
+  static std::condition_variable jr_cond_;
+  static std::vector<Rps_ObjectZone*> jr_pending_;
+  static std::vector<Rps_ObjectZone*> jr_committing_;
+  static std::string jr_dirpath_;
+  static std::thread jr_thread_;
+  static int jr_fd_;
+  static bool jr_stop_;
+  static bool jr_flushreq_;
+  static uint64_t jr_nbrecords_;
+  static uint64_t jr_nbcommits_;
+  static uint64_t jr_nbbytes_;
+};                              // end class Rps_Journal
+
+/// set by the --journal program option
+extern "C" bool rps_journal_enabled;
+/// serialize an object outside of dumps, in dump_rps.cc
+extern Json::Value rps_dump_json_for_journal(Rps_ObjectRef obr);
+
+/// set by the --dump-format program option
+extern "C" bool rps_dump_binary_format;
+/// set by the --dump-compress program option: empty for plain space
+/// files, or "zstd"; recorded as the "codec" of the manifest
+extern "C" std::string rps_dump_codec;
+/// the file name suffix of space files written with a codec, e.g. ".zst"
+extern std::string rps_codec_suffix(const std::string&codec);
+/// an output file compressed on the fly, closed by its destructor
+extern std::unique_ptr<std::ostream> rps_compressed_output_stream(const std::string&path,
+    const std::string&codec);
+/// decompress a whole buffer, e.g. a mapped space file
+extern std::string rps_decompress_buffer(const char*buf, size_t len,
+    const std::string&codec, const std::string&path);
+/// convert the space files and manifest of a directory to the other
+/// format, without loading them; for --convert-store
+extern "C" void rps_convert_store(const std::string&dirpath, bool tobinary);
+extern "C" std::string rps_convert_store_format;
 
 // the user manifest is optional, in the rps_homedir()
 // so using $REFPERSYS_HOME or $HOME
@@ -5108,10 +6025,30 @@ extern "C" bool rps_generate_cplusplus_code(Rps_CallFrame*callerframe,
 //// load and dump routines.  See files load_rps.cc and dump_rps.cc
 ////................................................................
 
-extern "C" Json::Value rps_load_string_to_json(const std::string&str, const char*filnam=nullptr, int lineno=0);
+extern "C" Json::Value rps_load_string_to_json(std::string_view str, const char*filnam=nullptr, int lineno=0);
 extern "C" std::string rps_load_json_to_string(const Json::Value&jv);
 
 extern "C" void rps_dump_into (std::string dirpath = ".", Rps_CallFrame* callframe = nullptr); // in store_rps.cc
+/// set by --background-dump: dumps postponed thru the event loop, e.g.
+/// by rps_postpone_dump, run while the agenda keeps running
+extern "C" bool rps_background_dump;
+extern void rps_start_background_dump(const std::string&dirpath);
+/// on the main thread, wait for a background dump and complete it
+extern void rps_finish_background_dump(void);
+extern bool rps_background_dump_running(void);
+extern void rps_dump_gc_mark(Rps_GarbageCollector&gc);
+/// set by --incremental-dump: only rewrite the space files whose
+/// objects changed since the previous dump (or load) of that directory
+extern "C" bool rps_dump_incremental;
+/// order independent digest of the set of objects in a space
+extern uint64_t rps_dump_space_digest_add(uint64_t digest, Rps_Id oid);
+/// called by the loader for each loaded space file
+extern void rps_dump_note_loaded_space(const std::string&dirpath, Rps_Id spacid,
+                                       size_t nbobjects, uint64_t digest,
+                                       double loadtime, bool binary,
+                                       const std::string&codec);
+/// a space changed after its load, e.g. by the journal replay
+extern void rps_dump_forget_loaded_space(const std::string&dirpath, Rps_Id spacid);
 extern "C" double rps_dump_start_elapsed_time(Rps_Dumper*);
 extern "C" double rps_dump_start_process_time(Rps_Dumper*);
 extern "C" double rps_dump_start_wallclock_time(Rps_Dumper*);
@@ -5140,8 +6077,41 @@ extern "C" bool rps_is_dumpable_value(Rps_Dumper*, const Rps_Value val);
 
 extern "C" void rps_load_from (const std::string& dirpath); // in store_rps.cc
 
+/// elapsed seconds of the phases of the last rps_load_from
+struct Rps_LoadStatistics
+{
+  double ls_mapping;            // map and index the space files
+  double ls_firstpass;          // create the objects
+  double ls_secondpass;         // fill them
+  double ls_journal;            // replay the mutation journal
+  double ls_todo;               // run the loader todo functions
+  double ls_roots;              // install roots and symbols
+  double ls_total;
+  unsigned ls_nbspaces;
+  unsigned ls_nbobjects;
+  unsigned ls_nbunfilled;       // left by --lazy-load
+};
+extern Rps_LoadStatistics rps_load_statistics;
+
+/// set by --benchmark-load, see benchmark_rps.cc
+extern "C" std::string rps_benchmark_load_spec;
+extern void rps_benchmark_load(const std::string&spec);
+/// set by --benchmark-agenda, see benchmark_rps.cc
+extern "C" std::string rps_benchmark_agenda_spec;
+extern void rps_benchmark_agenda(const std::string&spec);
+
 extern "C" void rps_load_add_todo(Rps_Loader*,const std::function<void(Rps_Loader*)>& todofun);
 
+/// set by the --lazy-load program option
+extern "C" bool rps_lazy_load;
+/// fill a lazily loaded object, see Rps_ObjectZone::materialize
+extern void rps_load_materialize(Rps_ObjectZone*obz);
+/// while some loaded objects are unfilled, they and every loaded
+/// object they might refer to are kept
+extern void rps_load_gc_mark(Rps_GarbageCollector&gc);
+/// the number of objects still unfilled by a lazy load
+extern unsigned rps_load_nb_unfilled(void);
+
 extern "C" void rps_print_types_info (void);
 
 extern "C" void rps_repl_lexer_test(void);
@@ -5257,6 +6227,23 @@ extern "C" void rps_run_agenda_mechanism(int nbjobs);
 extern "C" void rps_stop_agenda_mechanism(void);
 
 extern "C" void rps_initialize_event_loop(void);
+
+/// Watching file descriptors in the event loop, after
+/// rps_initialize_event_loop. The events are those of epoll(7) and
+/// are always edge-triggered, so the file descriptor should be
+/// non-blocking and the handler should read or write till EAGAIN.
+/// Handlers run in the event loop thread. Adding a watched or an
+/// invalid fd throws an exception.
+typedef std::function<void(Rps_CallFrame*, int/*fd*/, uint32_t/*epoll events*/)> rps_fdwatch_handler_t;
+extern void rps_event_loop_add_fd(int fd, uint32_t events, const char*explanation,
+                                  rps_fdwatch_handler_t handler);
+/// the closure is applied to the fd and the events, as tagged integers
+extern void rps_event_loop_add_fd(int fd, uint32_t events, const char*explanation,
+                                  Rps_ClosureValue closv);
+extern void rps_event_loop_modify_fd(int fd, uint32_t events);
+/// should be called before closing the fd; false if it was not watched
+extern bool rps_event_loop_remove_fd(int fd);
+extern void rps_event_loop_gc_mark(Rps_GarbageCollector&gc);
 /****
  * The agenda is a unique and central data-structure (and RefPerSys
  * object `the_agenda` with a `Rps_PayloadAgenda` payload) managing
@@ -5265,10 +6252,61 @@ extern "C" void rps_initialize_event_loop(void);
  * payload).
  ****/
 extern "C" rpsldpysig_t rpsldpy_agenda;
+
+/// An unbounded lock-free FIFO queue of tasklet objects, for many
+/// producers and consumers. Its slots are in a linked list of
+/// segments, and pushing or popping takes the index of a slot with
+/// one fetch_add. A popper faster than the matching pusher spoils
+/// the slot, so the pusher takes another index. Segments consumed by
+/// poppers are freed once no operation is in progress on the queue.
+class Rps_TaskletQueue
+{
+public:
+  static constexpr unsigned segment_size = 256;
+  Rps_TaskletQueue();
+  ~Rps_TaskletQueue();
+  void push(Rps_ObjectZone*obz);
+  Rps_ObjectZone* pop(void); // nullptr when empty
+  bool seems_empty(void) const
+  {
+    return tq_popidx.load() >= tq_pushidx.load();
+  };
+  /// in FIFO order; tasklets concurrently popped may be missed
+  void for_each(const std::function<void(Rps_ObjectZone*)>&fun) const;
+  /// the removed tasklets are skipped by later pops
+  size_t remove_if(const std::function<bool(Rps_ObjectZone*)>&pred);
+private:
+  struct segment_st
+  {
+    uint64_t sg_id;             // its slots have indexes from sg_id*segment_size
+    std::atomic<segment_st*> sg_next;
+    segment_st* sg_retired_next;
+    std::atomic<Rps_ObjectZone*> sg_slots[segment_size];
+    segment_st(uint64_t id);
+  };
+  /// markers in slots, never real object addresses
+  static inline Rps_ObjectZone* const taken_slot = (Rps_ObjectZone*)1;
+  static inline Rps_ObjectZone* const removed_slot = (Rps_ObjectZone*)2;
+  static segment_st* find_segment(segment_st*seg, uint64_t id);
+  void retire_through(uint64_t id);
+  void enter(void) const
+  {
+    tq_active.fetch_add(1);
+  };
+  void leave(void) const;
+  std::atomic<uint64_t> tq_pushidx;
+  std::atomic<uint64_t> tq_popidx;
+  std::atomic<segment_st*> tq_headseg;
+  std::atomic<segment_st*> tq_tailseg;
+  mutable std::atomic<long> tq_active;
+  mutable std::atomic<segment_st*> tq_retired;
+};                              // end class Rps_TaskletQueue
+
 class Rps_Agenda   /// all member functions are static...
 {
   friend class Rps_GarbageCollector;
   friend class Rps_PayloadAgenda;
+  friend class Rps_NoSafepointGuard;
   friend class Rps_PayloadUnixProcess;
   friend class Rps_PayloadPopenedFile;
   friend void rps_event_loop (void);
@@ -5293,9 +6331,10 @@ public:
   {
     WthrAg__None,
     WthrAg_Idle, //  the worker thread is idle
-    WthrAg_GC,   // the worker thread is garbage collecting
-    WthrAg_EndGC, // the worker thread has ended garbage collection,
-    // and will be running again on the next loop
+    WthrAg_GC,   // the worker thread is stopped at a safepoint,
+    // and collecting or helping to mark
+    WthrAg_EndGC, // no longer used: a stopped worker thread goes
+    // back to its previous state when the collection ends
     WthrAg_Run,  // the worker thread is running and allocating
     WthrAg__Last
   };
@@ -5306,26 +6345,116 @@ public:
   static void initialize(void);
   static void add_tasklet(agenda_prio_en prio, Rps_ObjectRef obtasklet);
   static Rps_ObjectRef fetch_tasklet_to_run(void);
+  /// a tasklet without obsolescence time is never obsolete
+  static bool tasklet_is_obsolete(Rps_ObjectRef obtasklet, double now);
+  static void remove_obsolete_tasklets(double now);
   static void run_agenda_worker(int ix);
+  /// Stop-the-world safepoints: a collection is requested by raising
+  /// agenda_needs_garbcoll_, which is polled, with a relaxed load, by
+  /// worker threads between tasklets and at entry of every local
+  /// frame, but not when allocating. Each worker thread reaching a safepoint
+  /// joins a counted barrier; the last one to arrive collects, the
+  /// others wait on a futex and help it to mark.
+  static inline void poll_safepoint(void);
+  static void request_garbage_collection(void);
   static void do_garbage_collect(int ix, Rps_CallFrame*callframe);
+  /// true for an object mutex held by a worker thread stopped at a
+  /// safepoint, which won't release it before the end of the
+  /// collection
+  static bool is_locked_by_stopped_worker(const Rps_ObjectMutex&mtx);
+  /// the worker index of the current thread, 0 outside of workers
+  static int worker_index(void)
+  {
+    return agenda_thread_index_;
+  };
+  /// cumulated and worst delay, from the request of a collection till
+  /// every worker thread is stopped
+  static double time_to_safepoint_seconds(void)
+  {
+    return 1.0e-9 * agenda_tts_nanosec_.load();
+  };
+  static double max_time_to_safepoint_seconds(void)
+  {
+    return 1.0e-9 * agenda_tts_max_nanosec_.load();
+  };
+  /// profiling of worker threads, e.g. for --benchmark-agenda
+  static double worker_state_seconds(int ix, workthread_state_en st);
+  static workthread_state_en worker_state(int ix)
+  {
+    RPS_ASSERT(ix>=0 && ix<=RPS_NBJOBS_MAX);
+    return agenda_work_thread_state_[ix].load();
+  };
+  static unsigned long gc_count(void)
+  {
+    return agenda_gc_count_.load();
+  };
+  /// cumulated elapsed time of collections, from the first worker
+  /// asking for it till its end
+  static double gc_stall_seconds(void)
+  {
+    return 1.0e-9 * agenda_gc_stall_nanosec_.load();
+  };
 protected:
   static void dump_scan_agenda(Rps_Dumper*du);
   static void dump_json_agenda(Rps_Dumper*du, Json::Value&jv);
+  /// wake up one parked worker thread, if any
+  static void wake_one_worker(void);
+  static void wake_all_workers(void);
 private:
+  /// only by the worker thread ix, which accounts for the time spent
+  /// in its previous state
+  static void set_worker_state(int ix, workthread_state_en st);
+  /// the worker thread waits, without spinning, till woken up or
+  /// timeout; it is not parked if some tasklet is queued
+  static void park_worker(int ix, long timeoutmillisec);
+  /// the slow path of poll_safepoint
+  static void stop_at_safepoint(void);
+  /// run by the last worker thread reaching the safepoint barrier,
+  /// or by a leaving one completing it
+  static void collect_at_safepoint(int ix, uint32_t epoch);
+  static void gc_mark_root_zone(Rps_GarbageCollector*gc, Rps_QuasiZone*qz);
+  /// when the worker thread stops running the agenda
+  static void leave_safepoints(int ix);
+  /// only for the garbage collection rendezvous and for stopping the
+  /// agenda; the tasklet queues don't need it
   static std::recursive_mutex agenda_mtx_;
   static std::condition_variable_any agenda_changed_condvar_;
   static std::atomic<unsigned long> agenda_add_counter_;
-  static std::deque<Rps_ObjectRef> agenda_fifo_[AgPrio__Last];
+  static Rps_TaskletQueue agenda_queue_[AgPrio__Last];
+  /// bit ix is set when worker thread#ix is parked
+  static std::atomic<uint32_t> agenda_parked_mask_;
+  /// the futex words of parked worker threads
+  static std::atomic<uint32_t> agenda_park_word_[RPS_NBJOBS_MAX+2];
   static std::atomic<bool> agenda_is_running_; // true when agenda is running
   static std::atomic<bool> agenda_needs_garbcoll_; // true when GC is needed
   /// the cumulated amount of allocated words at previous GC is:
   static std::atomic<uint64_t> agenda_cumulw_gc_;
-  // once a megaword has been allocated, we want to garbage collect, hence:
-  static constexpr uint64_t agenda_gc_threshold = 1<<20;
+  // when to garbage collect is decided by Rps_GcPacer
   static std::atomic<std::thread*> agenda_thread_array_[RPS_NBJOBS_MAX+2];
   static std::atomic<workthread_state_en> agenda_work_thread_state_[RPS_NBJOBS_MAX+2];
   /// the call frames below makes sense only during garbage collection....
   static std::atomic<Rps_CallFrame*> agenda_work_gc_callframe_[RPS_NBJOBS_MAX+2];
+  static std::atomic<uint64_t> agenda_state_nanosec_[RPS_NBJOBS_MAX+2][WthrAg__Last];
+  static double agenda_state_since_[RPS_NBJOBS_MAX+2]; // monotonic time
+  static workthread_state_en agenda_accounted_state_[RPS_NBJOBS_MAX+2];
+  static std::atomic<unsigned long> agenda_gc_count_;
+  static std::atomic<uint64_t> agenda_gc_stall_nanosec_;
+  /// the futex word of the safepoint barrier, set to epoch+1 when
+  /// marking starts and to epoch+2 when stopped workers are released
+  static std::atomic<uint32_t> agenda_safepoint_epoch_;
+  static std::atomic<int> agenda_nb_workers_; // taking part in the barrier
+  static std::atomic<int> agenda_gc_arrived_;
+  static std::atomic<int> agenda_gc_leader_; // index of the collecting worker
+  /// the C++ stack of a stopped worker thread, scanned conservatively
+  /// between these addresses
+  static std::atomic<const void*> agenda_worker_stack_top_[RPS_NBJOBS_MAX+2];
+  static std::atomic<const void*> agenda_worker_stack_low_[RPS_NBJOBS_MAX+2];
+  static std::atomic<uint64_t> agenda_tts_nanosec_;
+  static std::atomic<uint64_t> agenda_tts_max_nanosec_;
+  /// the worker index of the current thread, 0 outside of workers
+  static thread_local int agenda_thread_index_;
+  /// positive when the current thread should not stop at safepoints
+  static thread_local int agenda_nosafepoint_depth_;
 };                              // end class Rps_Agenda
 
 
@@ -5393,9 +6522,96 @@ public:
   {
     return tasklet_todoclos;
   };
+  void put_todo_closure(Rps_ClosureValue clos)
+  {
+    tasklet_todoclos = clos;
+    gc_write_barrier(clos);
+  };
 };  // end of Rps_PayloadTasklet
 
 
+/// The hierarchical timer wheel of the event loop, advanced on its
+/// timerfd(2). It has four levels of 64 slots with ticks of ten
+/// milliseconds, so spans about 46 hours; later timers wait in the
+/// last level and are cascaded again. Timers are intrusive doubly
+/// linked nodes of a pool, so adding and cancelling one are O(1).
+/// A tasklet timer adds its tasklet to the agenda once, or
+/// periodically. An obsolescence deadline makes the agenda forget
+/// its obsolete tasklets.
+class Rps_TimerWheel
+{
+public:
+  typedef uint64_t timer_id_t; // 0 is never a timer
+  static constexpr uint64_t tick_nanoseconds = 10*1000*1000;
+  static constexpr unsigned level_bits = 6;
+  static constexpr unsigned level_size = 1u << level_bits;
+  static constexpr unsigned nb_levels = 4;
+  enum timer_kind_en
+  {
+    TimK__None,
+    TimK_Tasklet,  // add the tasklet to the agenda
+    TimK_Obsolescence, // remove obsolete tasklets from the agenda
+  };
+  Rps_TimerWheel();
+  ~Rps_TimerWheel();
+  /// the timerfd is armed, with an absolute CLOCK_REALTIME, to the
+  /// next tick where some timer is due or should be cascaded
+  void set_timerfd(int fd);
+  /// delay and period are in seconds; a null period is for one shot
+  timer_id_t add_tasklet_timer(double delay, double period,
+                               Rps_Agenda::agenda_prio_en prio,
+                               Rps_ObjectRef obtasklet);
+  /// the wallclock time is usually some tasklet_obsoltime
+  timer_id_t add_obsolescence_deadline(double wallclocktime);
+  /// false if the timer had already run, or was cancelled
+  bool cancel(timer_id_t tid);
+  /// run every timer due at the given wallclock time; only called by
+  /// the event loop thread
+  void advance(double wallclocktime);
+  size_t size(void) const;
+  void gc_mark(Rps_GarbageCollector&gc) const;
+private:
+  static constexpr uint32_t no_node = UINT32_MAX;
+  struct node_st
+  {
+    uint32_t tn_prev;           // in its slot list
+    uint32_t tn_next;           // in its slot list, or the free list
+    uint32_t tn_gen;            // bumped when freed
+    uint8_t tn_kind;            // a timer_kind_en
+    uint8_t tn_level;
+    uint8_t tn_slot;
+    int8_t tn_prio;
+    uint64_t tn_expiry;         // in ticks
+    uint64_t tn_period;         // in ticks, 0 for one shot
+    Rps_ObjectRef tn_tasklet;
+  };
+  static uint64_t to_ticks(double wallclocktime);
+  timer_id_t add_locked(timer_kind_en kind, uint64_t expiry, uint64_t period,
+                        Rps_Agenda::agenda_prio_en prio, Rps_ObjectRef obtasklet);
+  void link_locked(uint32_t ix);
+  void unlink_locked(uint32_t ix);
+  void free_locked(uint32_t ix);
+  uint64_t next_wakeup_locked(void) const;
+  void rearm_locked(void);
+  mutable std::mutex tw_mtx;
+  int tw_timfd;
+  uint64_t tw_now;       // every timer up to that tick has run
+  uint64_t tw_armed;     // tick of the armed timerfd, or UINT64_MAX
+  size_t tw_count;
+  uint32_t tw_freelist;
+  std::vector<node_st> tw_nodes;
+  /// due tasklets, whose timers may be freed, stay here and are
+  /// marked till advance has added them to the agenda
+  std::vector<Rps_ObjectRef> tw_due;
+  uint32_t tw_heads[nb_levels][level_size];
+  uint64_t tw_occupied[nb_levels]; // bitmaps of non-empty slots
+};                              // end class Rps_TimerWheel
+
+/// the timer wheel owned by the event loop; timers can be added and
+/// cancelled from any thread, they run in the event loop thread
+extern Rps_TimerWheel& rps_event_loop_timer_wheel(void);
+
+
 typedef std::vector<std::string> rps_cppvect_of_string_t;
 
 /// the transient payload for unix processes (see PaylUnixProcess)
@@ -5548,6 +6764,8 @@ public:
 
 /// related to eventloop and agenda
 extern "C" void rps_postpone_dump(void);
+/// called by the thread of a background dump when it is done
+extern "C" void rps_postpone_dump_completion(void);
 extern "C" void rps_postpone_garbage_collection(void);
 extern "C" void rps_postpone_quit(void);
 extern "C" void rps_postpone_exit_with_dump(void);
@@ -516,8 +516,7 @@ Rps_LexTokenZone::compute_class(Rps_CallFrame*callframe) const
 void
 Rps_LexTokenZone::gc_mark(Rps_GarbageCollector&gc, unsigned depth) const
 {
-  if (is_gcmarked(gc))
-    return;
+  /// our mark was just set by Rps_Value::gc_mark, which calls us once
   if (RPS_UNLIKELY(depth > Rps_Value::max_gc_mark_depth))
     throw std::runtime_error("too deep Rps_LexTokenZone::gc_mark");
   if (lex_kind)
@@ -589,7 +588,7 @@ Rps_LexTokenZone::val_output(std::ostream&out, unsigned depth, unsigned maxdepth
       Rps_ObjectRef obr = lex_val.as_object();
       if (obr)
         {
-          std::unique_lock<std::recursive_mutex> guobr (*obr->objmtxptr());
+          std::unique_lock<Rps_ObjectMutex> guobr (*obr->objmtxptr());
           Rps_Value vname = obr->get_physical_attr(RPS_ROOT_OB(_1EBVGSfW2m200z18rx)); //name∈named_attribute
           if (auto paylvect = obr->get_dynamic_payload<Rps_PayloadVectVal>())
             {
@@ -633,7 +632,7 @@ Rps_LexTokenZone::val_output(std::ostream&out, unsigned depth, unsigned maxdepth
       Rps_ObjectRef obr = lex_val.as_object();
       if (obr)
         {
-          std::unique_lock<std::recursive_mutex> guobr (*obr->objmtxptr());
+          std::unique_lock<Rps_ObjectMutex> guobr (*obr->objmtxptr());
           if (auto paylvect = obr->get_dynamic_payload<Rps_PayloadVectVal>())
             {
               unsigned vsiz = paylvect->size();
@@ -1079,6 +1078,26 @@ rps_do_builtin_repl_command(Rps_CallFrame*callframe, Rps_ObjectRef obenvarg, con
       };
       rps_garbage_collect(&markall);
     }
+  else if (!strcmp(builtincmd, "gcstats"))
+    {
+      Rps_GcStatistics::output(std::cout);
+    }
+  else if (!strcmp(builtincmd, "gcstats_json"))
+    {
+      /// an optional file path follows, otherwise on stdout
+      const char*cp = intoksrc.curcptr();
+      while (cp && isspace(*cp))
+        cp++;
+      std::string path;
+      while (cp && *cp && !isspace(*cp))
+        path.push_back(*cp++);
+      Rps_GcStatistics::dump_json(path);
+    }
+  else if (!strcmp(builtincmd, "journal"))
+    {
+      Rps_Journal::flush();
+      Rps_Journal::output(std::cout);
+    }
   else if (!strcmp(builtincmd, "typeinfo"))
     {
       rps_print_types_info();
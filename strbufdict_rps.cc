@@ -65,8 +65,9 @@ Rps_PayloadStrBuf::append_string(const std::string&str)
 {
   if (str.empty())
     return;
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   strbuf_buffer.sputn(str.c_str(), str.size());
+  touch_owner();
 } // end Rps_PayloadStrBuf::append_string
 
 void
@@ -74,7 +75,8 @@ Rps_PayloadStrBuf::prepend_string(const std::string&str)
 {
   if (str.empty())
     return;
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
+  touch_owner();
 #warning Rps_PayloadStrBuf::prepend_string implementation is inefficient
   if (strbuf_buffer.str().empty())
     {
@@ -204,6 +206,7 @@ Rps_PayloadStrBuf::clear_buffer()
 {
 /// clear the buffer
   strbuf_buffer = std::stringbuf("");
+  touch_owner();
 } // end Rps_PayloadStrBuf::clear_buffer
 
 ////////////////////////////////////////////////////////////////
@@ -316,9 +319,12 @@ void
 Rps_PayloadStringDict::add(const std::string&str, Rps_Value val)
 {
   if (!str.empty() && !val.is_empty())
-    dict_map.insert({str,val});
-  else if (!str.empty() && !val)
-    dict_map.erase(str);
+    {
+      dict_map.insert({str,val});
+      gc_write_barrier(val);
+    }
+  else if (!str.empty() && !val && dict_map.erase(str) > 0)
+    touch_owner();
 } // end Rps_PayloadStringDict::add
 
 Rps_Value
@@ -336,13 +342,15 @@ Rps_PayloadStringDict::find(const std::string&str) const
 void
 Rps_PayloadStringDict::remove(const std::string&str)
 {
-  dict_map.erase(str);
+  if (dict_map.erase(str) > 0)
+    touch_owner();
 } // end Rps_PayloadStringDict::remove
 
 void
 Rps_PayloadStringDict::set_transient(bool transient)
 {
   dict_is_transient = transient;
+  touch_owner();
 } // end PayloadStringDict::set_transient
 
 void
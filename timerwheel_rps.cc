@@ -0,0 +1,365 @@
+/****************************************************************
+ * file timerwheel_rps.cc
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * Description:
+ *      This file is part of the Reflective Persistent System.
+ *
+ *      It has the hierarchical timer wheel of the event loop, see
+ *      class Rps_TimerWheel in refpersys.hh
+ *
+ * Author(s):
+ *      Basile Starynkevitch <basile@starynkevitch.net>
+ *      Abhishek Chakravarti <abhishek@taranjali.org>
+ *      Nimesh Neema <nimeshneema@gmail.com>
+ *
+ *      © Copyright 2019 - 2024 The Reflective Persistent System Team
+ *      team@refpersys.org & http://refpersys.org/
+ *
+ * License:
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "refpersys.hh"
+
+#include <sys/timerfd.h>
+
+extern "C" const char rps_timerwheel_gitid[];
+const char rps_timerwheel_gitid[]= RPS_GITID;
+
+extern "C" const char rps_timerwheel_date[];
+const char rps_timerwheel_date[]= __DATE__;
+
+Rps_TimerWheel::Rps_TimerWheel()
+  : tw_mtx(), tw_timfd(-1), tw_now(0), tw_armed(UINT64_MAX),
+    tw_count(0), tw_freelist(no_node), tw_nodes(), tw_due()
+{
+  for (unsigned lev=0; lev<nb_levels; lev++)
+    {
+      for (unsigned sl=0; sl<level_size; sl++)
+        tw_heads[lev][sl] = no_node;
+      tw_occupied[lev] = 0;
+    }
+} // end Rps_TimerWheel::Rps_TimerWheel
+
+Rps_TimerWheel::~Rps_TimerWheel()
+{
+  Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+  tw_nodes.clear();
+  tw_due.clear();
+  tw_count = 0;
+} // end Rps_TimerWheel::~Rps_TimerWheel
+
+uint64_t
+Rps_TimerWheel::to_ticks(double wallclocktime)
+{
+  if (wallclocktime <= 0.0)
+    return 0;
+  return (uint64_t)(wallclocktime*1.0e9) / tick_nanoseconds;
+} // end Rps_TimerWheel::to_ticks
+
+void
+Rps_TimerWheel::set_timerfd(int fd)
+{
+  Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+  tw_timfd = fd;
+  tw_armed = UINT64_MAX;
+  rearm_locked();
+} // end Rps_TimerWheel::set_timerfd
+
+/// put the node in the slot of its expiry, relative to tw_now; the
+/// level is the one whose slots are just coarse enough
+void
+Rps_TimerWheel::link_locked(uint32_t ix)
+{
+  node_st& nd = tw_nodes[ix];
+  if (nd.tn_expiry < tw_now)
+    nd.tn_expiry = tw_now;
+  uint64_t delta = nd.tn_expiry - tw_now;
+  uint64_t exp = nd.tn_expiry;
+  unsigned lev = 0;
+  while (lev+1 < nb_levels && delta >= ((uint64_t)1 << ((lev+1)*level_bits)))
+    lev++;
+  if (lev+1 == nb_levels
+      && delta >= ((uint64_t)1 << (nb_levels*level_bits)))
+    /// too far for the wheel, it will be cascaded in the last level again
+    exp = tw_now + ((uint64_t)1 << (nb_levels*level_bits)) - 1;
+  unsigned sl = (exp >> (lev*level_bits)) & (level_size-1);
+  nd.tn_level = lev;
+  nd.tn_slot = sl;
+  nd.tn_prev = no_node;
+  nd.tn_next = tw_heads[lev][sl];
+  if (nd.tn_next != no_node)
+    tw_nodes[nd.tn_next].tn_prev = ix;
+  tw_heads[lev][sl] = ix;
+  tw_occupied[lev] |= (uint64_t)1 << sl;
+} // end Rps_TimerWheel::link_locked
+
+void
+Rps_TimerWheel::unlink_locked(uint32_t ix)
+{
+  node_st& nd = tw_nodes[ix];
+  if (nd.tn_prev != no_node)
+    tw_nodes[nd.tn_prev].tn_next = nd.tn_next;
+  else
+    tw_heads[nd.tn_level][nd.tn_slot] = nd.tn_next;
+  if (nd.tn_next != no_node)
+    tw_nodes[nd.tn_next].tn_prev = nd.tn_prev;
+  if (tw_heads[nd.tn_level][nd.tn_slot] == no_node)
+    tw_occupied[nd.tn_level] &= ~((uint64_t)1 << nd.tn_slot);
+  nd.tn_prev = nd.tn_next = no_node;
+} // end Rps_TimerWheel::unlink_locked
+
+void
+Rps_TimerWheel::free_locked(uint32_t ix)
+{
+  node_st& nd = tw_nodes[ix];
+  nd.tn_kind = TimK__None;
+  nd.tn_gen++;
+  nd.tn_tasklet = nullptr;
+  nd.tn_next = tw_freelist;
+  tw_freelist = ix;
+  RPS_ASSERT(tw_count > 0);
+  tw_count--;
+} // end Rps_TimerWheel::free_locked
+
+Rps_TimerWheel::timer_id_t
+Rps_TimerWheel::add_locked(timer_kind_en kind, uint64_t expiry, uint64_t period,
+                           Rps_Agenda::agenda_prio_en prio, Rps_ObjectRef obtasklet)
+{
+  if (tw_now == 0)
+    tw_now = to_ticks(rps_wallclock_real_time());
+  uint32_t ix = tw_freelist;
+  if (ix != no_node)
+    tw_freelist = tw_nodes[ix].tn_next;
+  else
+    {
+      if (tw_nodes.size() >= no_node)
+        throw RPS_RUNTIME_ERROR_OUT("too many timers in timer wheel");
+      ix = (uint32_t) tw_nodes.size();
+      node_st nd = {};
+      nd.tn_gen = 1;
+      tw_nodes.push_back(nd);
+    }
+  node_st& nd = tw_nodes[ix];
+  nd.tn_kind = kind;
+  nd.tn_prio = (int8_t) prio;
+  /// the slot of tw_now has already run
+  nd.tn_expiry = std::max(expiry, tw_now+1);
+  nd.tn_period = period;
+  nd.tn_tasklet = obtasklet;
+  link_locked(ix);
+  tw_count++;
+  rearm_locked();
+  return ((timer_id_t)nd.tn_gen << 32) | (ix+1);
+} // end Rps_TimerWheel::add_locked
+
+Rps_TimerWheel::timer_id_t
+Rps_TimerWheel::add_tasklet_timer(double delay, double period,
+                                  Rps_Agenda::agenda_prio_en prio,
+                                  Rps_ObjectRef obtasklet)
+{
+  if (!obtasklet)
+    throw RPS_RUNTIME_ERROR_OUT("timer wheel without tasklet");
+  if ((int)prio < (int)Rps_Agenda::AgPrio_Low || (int)prio >= (int)Rps_Agenda::AgPrio__Last)
+    throw RPS_RUNTIME_ERROR_OUT("timer wheel with bad priority#" << (int)prio
+                                << " for tasklet " << obtasklet);
+  if (!(delay >= 0.0) || !(period >= 0.0))
+    throw RPS_RUNTIME_ERROR_OUT("timer wheel with bad delay " << delay
+                                << " or period " << period
+                                << " for tasklet " << obtasklet);
+  uint64_t periodticks = 0;
+  if (period > 0.0)
+    periodticks = std::max<uint64_t>(1, (uint64_t)(period*1.0e9) / tick_nanoseconds);
+  Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+  return add_locked(TimK_Tasklet, to_ticks(rps_wallclock_real_time() + delay),
+                    periodticks, prio, obtasklet);
+} // end Rps_TimerWheel::add_tasklet_timer
+
+Rps_TimerWheel::timer_id_t
+Rps_TimerWheel::add_obsolescence_deadline(double wallclocktime)
+{
+  /// the deadline tick is the first one after the obsolescence time
+  Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+  return add_locked(TimK_Obsolescence, to_ticks(wallclocktime)+1,
+                    0, Rps_Agenda::AgPrio__None, nullptr);
+} // end Rps_TimerWheel::add_obsolescence_deadline
+
+bool
+Rps_TimerWheel::cancel(timer_id_t tid)
+{
+  uint32_t ix = (uint32_t)(tid & 0xffffffff) - 1;
+  uint32_t gen = (uint32_t)(tid >> 32);
+  Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+  if (ix >= tw_nodes.size() || tw_nodes[ix].tn_gen != gen
+      || tw_nodes[ix].tn_kind == TimK__None)
+    return false;
+  unlink_locked(ix);
+  free_locked(ix);
+  return true;
+} // end Rps_TimerWheel::cancel
+
+size_t
+Rps_TimerWheel::size(void) const
+{
+  Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+  return tw_count;
+} // end Rps_TimerWheel::size
+
+void
+Rps_TimerWheel::gc_mark(Rps_GarbageCollector&gc) const
+{
+  Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+  for (const node_st& nd: tw_nodes)
+    if (nd.tn_kind == TimK_Tasklet && nd.tn_tasklet)
+      gc.mark_obj(nd.tn_tasklet);
+  for (Rps_ObjectRef obtasklet: tw_due)
+    gc.mark_obj(obtasklet);
+} // end Rps_TimerWheel::gc_mark
+
+/// the first tick after tw_now when a slot of the first level runs,
+/// or one of a further level is cascaded
+uint64_t
+Rps_TimerWheel::next_wakeup_locked(void) const
+{
+  uint64_t res = UINT64_MAX;
+  for (unsigned lev=0; lev<nb_levels; lev++)
+    {
+      uint64_t bits = tw_occupied[lev];
+      if (!bits)
+        continue;
+      unsigned shift = lev*level_bits;
+      unsigned cur = (tw_now >> shift) & (level_size-1);
+      /// rotate so that the slot after the current one is at bit 0
+      unsigned rot = (cur+1) & (level_size-1);
+      if (rot)
+        bits = (bits >> rot) | (bits << (level_size-rot));
+      uint64_t k = __builtin_ctzll(bits) + 1;
+      uint64_t tick = ((tw_now >> shift) + k) << shift;
+      if (tick < res)
+        res = tick;
+    }
+  return res;
+} // end Rps_TimerWheel::next_wakeup_locked
+
+void
+Rps_TimerWheel::rearm_locked(void)
+{
+  if (tw_timfd < 0)
+    return;
+  uint64_t next = tw_count?next_wakeup_locked():UINT64_MAX;
+  if (next == tw_armed)
+    return;
+  struct itimerspec its;
+  memset (&its, 0, sizeof(its));
+  if (next != UINT64_MAX)
+    {
+      uint64_t ns = next*tick_nanoseconds;
+      its.it_value.tv_sec = ns / 1000000000;
+      its.it_value.tv_nsec = ns % 1000000000;
+    }
+  if (timerfd_settime(tw_timfd, TFD_TIMER_ABSTIME, &its, nullptr) < 0)
+    RPS_FATALOUT("timer wheel failed to arm timerfd#" << tw_timfd
+                 << ":" << strerror(errno));
+  tw_armed = next;
+} // end Rps_TimerWheel::rearm_locked
+
+/// The wheel goes tick by tick, but jumps over ticks where nothing is
+/// to be done. The due tasklets are added to the agenda after
+/// unlocking, so their timers can be cancelled meanwhile; the event
+/// loop thread doesn't stop at safepoints, so till then they are kept
+/// in tw_due for the garbage collector.
+void
+Rps_TimerWheel::advance(double wallclocktime)
+{
+  std::vector<std::pair<Rps_Agenda::agenda_prio_en,Rps_ObjectRef>> duevect;
+  bool obsolescence = false;
+  {
+    Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+    uint64_t target = to_ticks(wallclocktime);
+    if (tw_now == 0)
+      tw_now = target;
+    while (tw_now < target)
+      {
+        uint64_t next = tw_count?next_wakeup_locked():UINT64_MAX;
+        if (next > target)
+          {
+            tw_now = target;
+            break;
+          }
+        tw_now = next;
+        /// cascade the slots of further levels starting at that tick
+        for (unsigned lev=1; lev<nb_levels; lev++)
+          {
+            if ((tw_now >> ((lev-1)*level_bits)) & (level_size-1))
+              break;
+            unsigned sl = (tw_now >> (lev*level_bits)) & (level_size-1);
+            uint32_t ix = tw_heads[lev][sl];
+            tw_heads[lev][sl] = no_node;
+            tw_occupied[lev] &= ~((uint64_t)1 << sl);
+            while (ix != no_node)
+              {
+                uint32_t nextix = tw_nodes[ix].tn_next;
+                link_locked(ix);
+                ix = nextix;
+              }
+          }
+        unsigned sl0 = tw_now & (level_size-1);
+        uint32_t ix = tw_heads[0][sl0];
+        tw_heads[0][sl0] = no_node;
+        tw_occupied[0] &= ~((uint64_t)1 << sl0);
+        while (ix != no_node)
+          {
+            node_st& nd = tw_nodes[ix];
+            uint32_t nextix = nd.tn_next;
+            if (nd.tn_expiry > tw_now)
+              link_locked(ix);
+            else
+              {
+                if (nd.tn_kind == TimK_Obsolescence)
+                  obsolescence = true;
+                else
+                  {
+                    duevect.emplace_back((Rps_Agenda::agenda_prio_en)nd.tn_prio,
+                                         nd.tn_tasklet);
+                    tw_due.push_back(nd.tn_tasklet);
+                  }
+                if (nd.tn_period > 0)
+                  {
+                    /// periods missed till the target are skipped, so
+                    /// a late event loop adds the tasklet only once
+                    nd.tn_expiry += nd.tn_period
+                                    * ((target - nd.tn_expiry) / nd.tn_period + 1);
+                    link_locked(ix);
+                  }
+                else
+                  free_locked(ix);
+              }
+            ix = nextix;
+          }
+      }
+    rearm_locked();
+  }
+  if (!duevect.empty())
+    {
+      for (auto& due: duevect)
+        Rps_Agenda::add_tasklet(due.first, due.second);
+      Rps_NoSafepointLock<std::mutex> gu(tw_mtx);
+      tw_due.clear();
+    }
+  if (obsolescence)
+    Rps_Agenda::remove_obsolete_tasklets(wallclocktime);
+} // end Rps_TimerWheel::advance
+
+//////////////////////////////////////////////////////////// end of file timerwheel_rps.cc
@@ -95,14 +95,14 @@ Rps_PayloadUnixProcess::~Rps_PayloadUnixProcess()
 void
 Rps_PayloadUnixProcess::add_process_argument(const std::string& arg)
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   _unixproc_argv.push_back(arg);
 } // end Rps_PayloadUnixProcess::add_process_argument
 
 void
 Rps_PayloadUnixProcess::forbid_core_dump(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   pid_t pid = _unixproc_pid.load();
   _unixproc_forbid_core.store(true);
   if (pid >0)
@@ -117,7 +117,7 @@ Rps_PayloadUnixProcess::forbid_core_dump(void)
 unsigned
 Rps_PayloadUnixProcess::core_megabytes_limit(unsigned newlimit)
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   pid_t pid = _unixproc_pid.load();
   _unixproc_forbid_core.store(false);
   if (pid >0)
@@ -136,7 +136,7 @@ Rps_PayloadUnixProcess::core_megabytes_limit(unsigned newlimit)
 unsigned
 Rps_PayloadUnixProcess::address_space_megabytes_limit(unsigned newlimit)
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   pid_t pid = _unixproc_pid.load();
   if (pid >0)
     {
@@ -157,7 +157,7 @@ Rps_PayloadUnixProcess::address_space_megabytes_limit(unsigned newlimit)
 unsigned
 Rps_PayloadUnixProcess::file_size_megabytes_limit(unsigned newlimit)
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   pid_t pid = _unixproc_pid.load();
   if (pid >0)
     {
@@ -178,7 +178,7 @@ Rps_PayloadUnixProcess::file_size_megabytes_limit(unsigned newlimit)
 unsigned
 Rps_PayloadUnixProcess::nofile_limit(unsigned newlimit)
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   pid_t pid = _unixproc_pid.load();
   if (pid >0)
     {
@@ -226,12 +226,16 @@ Rps_PayloadUnixProcess::gc_mark(Rps_GarbageCollector&gc) const
       RPS_ASSERT(_unixproc_closure.is_closure());
       _unixproc_closure.gc_mark(gc,1);
     }
+  if (_unixproc_inputclos)
+    _unixproc_inputclos.gc_mark(gc,1);
+  if (_unixproc_outputclos)
+    _unixproc_outputclos.gc_mark(gc,1);
 } // end Rps_PayloadUnixProcess::gc_mark
 
 const Rps_ClosureValue
 Rps_PayloadUnixProcess::get_process_closure(void) const
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   return _unixproc_closure;
 } // end Rps_PayloadUnixProcess::get_process_closure
 
@@ -240,14 +244,15 @@ void
 Rps_PayloadUnixProcess::put_process_closure(Rps_ClosureValue closv)
 {
   if (!closv || !closv.is_closure()) return;
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   _unixproc_closure = closv;
+  gc_write_barrier(closv);
 } // end Rps_PayloadUnixProcess::put_process_closure
 
 const Rps_ClosureValue
 Rps_PayloadUnixProcess::get_input_closure(void) const
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   return _unixproc_inputclos;
 } // end Rps_PayloadUnixProcess::get_input_closure
 
@@ -256,14 +261,15 @@ void
 Rps_PayloadUnixProcess::put_input_closure(Rps_ClosureValue closv)
 {
   if (!closv || !closv.is_closure()) return;
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   _unixproc_inputclos = closv;
+  gc_write_barrier(closv);
 } // end Rps_PayloadUnixProcess::put_input_closure
 
 const Rps_ClosureValue
 Rps_PayloadUnixProcess::get_output_closure(void) const
 {
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   return _unixproc_outputclos;
 } // end Rps_PayloadUnixProcess::get_output_closure
 
@@ -272,8 +278,9 @@ void
 Rps_PayloadUnixProcess::put_output_closure(Rps_ClosureValue closv)
 {
   if (!closv || !closv.is_closure()) return;
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   _unixproc_outputclos = closv;
+  gc_write_barrier(closv);
 } // end Rps_PayloadUnixProcess::put_input_closure
 
 
@@ -353,17 +360,22 @@ Rps_PayloadUnixProcess::queue_of_runnable_processes;
 void
 Rps_PayloadUnixProcess::gc_mark_active_processes(Rps_GarbageCollector&gc)
 {
-  std::lock_guard<std::mutex> gu(mtx_of_runnable_processes);
+  Rps_NoSafepointLock<std::mutex> gu(mtx_of_runnable_processes);
   /// Both set_of_runnable_processes and queue_of_runnable_processes
   /// should contain the same objects, but for sure we want to mark
-  /// both.
+  /// both. A minor collection does not scan old process objects, so
+  /// their payloads are scanned here.
   for (Rps_PayloadUnixProcess*paylup : set_of_runnable_processes)
     {
       paylup->owner()->gc_mark(gc);
+      if (gc.is_minor())
+        paylup->gc_mark(gc);
     }
   for (Rps_PayloadUnixProcess*paylup : queue_of_runnable_processes)
     {
       paylup->owner()->gc_mark(gc);
+      if (gc.is_minor())
+        paylup->gc_mark(gc);
     }
 } // end Rps_PayloadUnixProcess::gc_mark_active_processes
 
@@ -371,8 +383,8 @@ void
 Rps_PayloadUnixProcess::start_process(Rps_CallFrame*callframe)
 {
   RPS_ASSERT(!callframe || callframe->is_good_call_frame());
-  std::lock_guard<std::mutex> rungu(mtx_of_runnable_processes);
-  std::lock_guard<std::recursive_mutex> gu(*owner()->objmtxptr());
+  Rps_NoSafepointLock<std::mutex> rungu(mtx_of_runnable_processes);
+  std::lock_guard<Rps_ObjectMutex> gu(*owner()->objmtxptr());
   if (_unixproc_pid.load()>0)
     {
       RPS_WARNOUT("already running Rps_PayloadUnixProcess owned by " << owner()
@@ -388,12 +400,12 @@ void
 Rps_PayloadUnixProcess::do_on_active_process_queue(std::function<void(Rps_ObjectRef, Rps_CallFrame*,void*)> fun,
     Rps_CallFrame*callframe, void*client_data)
 {
-  std::lock_guard<std::mutex> gu(mtx_of_runnable_processes);
+  Rps_NoSafepointLock<std::mutex> gu(mtx_of_runnable_processes);
   RPS_ASSERT(!callframe || callframe->is_good_call_frame());
   for (Rps_PayloadUnixProcess*paylup : queue_of_runnable_processes)
     {
       Rps_ObjectRef obown = paylup->owner();
-      std::lock_guard<std::recursive_mutex> gu(*obown->objmtxptr());
+      std::lock_guard<Rps_ObjectMutex> gu(*obown->objmtxptr());
       fun(obown,callframe,client_data);
     }
 } // end Rps_PayloadUnixProcess::do_on_active_process_queue
@@ -162,7 +162,8 @@ rps_do_create_fifos_from_prefix(void)
                     << " git " << rps_shortgitid);
       rmatex = true;
     }
-  outfd = open(outfifo.c_str(), 0440 | O_CLOEXEC);
+  /// non-blocking, since the event loop reads it till EAGAIN
+  outfd = open(outfifo.c_str(), 0440 | O_CLOEXEC | O_NONBLOCK);
   if (outfd<0)
     RPS_FATALOUT("failed to open output FIFO " << outfifo << ":" << strerror(errno));
   if (rmatex)
@@ -822,6 +823,96 @@ rps_parse1opt (int key, char *arg, struct argp_state *state)
       rps_nbjobs = nbjobs;
     }
     return 0;
+    case RPSPROGOPT_GC_GROWTH:
+    {
+      char*end = nullptr;
+      double fact = strtod(arg, &end);
+      if (!end || *end || fact <= 1.0 || fact > 100.0)
+        RPS_FATALOUT("invalid --gc-growth=" << arg
+                     << " should be a factor between 1 and 100");
+      Rps_GcPacer::set_growth_factor(fact);
+    }
+    return 0;
+    case RPSPROGOPT_GC_SOFT_CAP:
+    {
+      char*end = nullptr;
+      long long mega = strtoll(arg, &end, 10);
+      if (!end || *end || mega < 0)
+        RPS_FATALOUT("invalid --gc-soft-cap=" << arg
+                     << " should be a number of megabytes");
+      Rps_GcPacer::set_soft_cap_words(((uint64_t)mega << 20) / sizeof(void*));
+    }
+    return 0;
+    case RPSPROGOPT_GC_CPU_BUDGET:
+    {
+      char*end = nullptr;
+      double percent = strtod(arg, &end);
+      if (!end || *end || percent <= 0.0 || percent > 100.0)
+        RPS_FATALOUT("invalid --gc-cpu-budget=" << arg
+                     << " should be a percentage");
+      Rps_GcPacer::set_cpu_budget(percent / 100.0);
+    }
+    return 0;
+    case RPSPROGOPT_DUMP_FORMAT:
+    {
+      if (!strcmp(arg, "binary"))
+        rps_dump_binary_format = true;
+      else if (!strcmp(arg, "json"))
+        rps_dump_binary_format = false;
+      else
+        RPS_FATALOUT("invalid --dump-format=" << arg
+                     << " should be json or binary");
+    }
+    return 0;
+    case RPSPROGOPT_DUMP_COMPRESS:
+    {
+      if (!strcmp(arg, "zstd"))
+        rps_dump_codec = arg;
+      else if (!strcmp(arg, "none"))
+        rps_dump_codec.clear();
+      else
+        RPS_FATALOUT("invalid --dump-compress=" << arg
+                     << " should be zstd or none");
+    }
+    return 0;
+    case RPSPROGOPT_CONVERT_STORE:
+    {
+      if (strcmp(arg, "binary") && strcmp(arg, "json"))
+        RPS_FATALOUT("invalid --convert-store=" << arg
+                     << " should be json or binary");
+      rps_convert_store_format = arg;
+    }
+    return 0;
+    case RPSPROGOPT_BACKGROUND_DUMP:
+    {
+      rps_background_dump = true;
+    }
+    return 0;
+    case RPSPROGOPT_JOURNAL:
+    {
+      rps_journal_enabled = true;
+    }
+    return 0;
+    case RPSPROGOPT_INCREMENTAL_DUMP:
+    {
+      rps_dump_incremental = true;
+    }
+    return 0;
+    case RPSPROGOPT_LAZY_LOAD:
+    {
+      rps_lazy_load = true;
+    }
+    return 0;
+    case RPSPROGOPT_BENCHMARK_LOAD:
+    {
+      rps_benchmark_load_spec = arg;
+    }
+    return 0;
+    case RPSPROGOPT_BENCHMARK_AGENDA:
+    {
+      rps_benchmark_agenda_spec = arg;
+    }
+    return 0;
     case RPSPROGOPT_PUBLISH_ME:
     {
       if (!rps_publisher_url_str.empty())
@@ -1255,7 +1346,7 @@ rps_get_plugin_cstr_argument(const Rps_Plugin*plugin)
 void
 rps_postponed_remove_file(const std::string& path)
 {
-  std::lock_guard<std::mutex> gu(rps_postponed_lock);
+  Rps_NoSafepointLock<std::mutex> gu(rps_postponed_lock);
   if (rps_postponed_removed_files_vector.empty())
     atexit(rps_schedule_files_postponed_removal);
   rps_postponed_removed_files_vector.push_back(std::string(path));
@@ -1264,7 +1355,7 @@ rps_postponed_remove_file(const std::string& path)
 void
 rps_schedule_files_postponed_removal(void)
 {
-  std::lock_guard<std::mutex> gu(rps_postponed_lock);
+  Rps_NoSafepointLock<std::mutex> gu(rps_postponed_lock);
   if (rps_postponed_removed_files_vector.empty())
     return;
   FILE* pat = popen("/bin/at now + 5 minutes", "w");
@@ -1478,7 +1569,7 @@ static std::unordered_map<Rps_Id,Rps_ObjectRef*,Rps_Id::Hasher> rps_object_globa
 void
 rps_each_root_object (const std::function<void(Rps_ObjectRef)>&fun)
 {
-  std::lock_guard<std::mutex> gu(rps_object_root_mtx);
+  Rps_NoSafepointLock<std::mutex> gu(rps_object_root_mtx);
   for (auto ob: rps_object_root_set)
     fun(ob);
 } // end rps_each_root_object
@@ -1488,7 +1579,7 @@ void
 rps_add_root_object (const Rps_ObjectRef ob)
 {
   if (!ob) return;
-  std::lock_guard<std::mutex> gu(rps_object_root_mtx);
+  Rps_NoSafepointLock<std::mutex> gu(rps_object_root_mtx);
   rps_object_root_set.insert(ob);
   {
     auto rootit = rps_object_global_root_hashtable.find(ob->oid());
@@ -1502,7 +1593,7 @@ bool
 rps_remove_root_object (const Rps_ObjectRef ob)
 {
   if (!ob) return false;
-  std::lock_guard<std::mutex> gu(rps_object_root_mtx);
+  Rps_NoSafepointLock<std::mutex> gu(rps_object_root_mtx);
   auto it = rps_object_root_set.find(ob);
   if (it == rps_object_root_set.end())
     return false;
@@ -1519,7 +1610,7 @@ void
 rps_initialize_roots_after_loading (Rps_Loader*ld)
 {
   RPS_ASSERT(ld != nullptr);
-  std::lock_guard<std::mutex> gu(rps_object_root_mtx);
+  Rps_NoSafepointLock<std::mutex> gu(rps_object_root_mtx);
   rps_object_global_root_hashtable.max_load_factor(3.5);
   rps_object_global_root_hashtable.reserve(5*rps_hardcoded_number_of_roots()/4+3);
 #define RPS_INSTALL_ROOT_OB(Oid) {    \
@@ -1539,7 +1630,7 @@ bool rps_is_root_object (const Rps_ObjectRef ob)
 {
   if (!ob)
     return false;
-  std::lock_guard<std::mutex> gu(rps_object_root_mtx);
+  Rps_NoSafepointLock<std::mutex> gu(rps_object_root_mtx);
   auto it = rps_object_root_set.find(ob);
   return it != rps_object_root_set.end();
 } // end rps_is_root_object
@@ -1549,7 +1640,7 @@ rps_set_root_objects(void)
 {
   std::set<Rps_ObjectRef> set;
 
-  std::lock_guard<std::mutex> gu(rps_object_root_mtx);
+  Rps_NoSafepointLock<std::mutex> gu(rps_object_root_mtx);
   for (Rps_ObjectRef ob: rps_object_root_set)
     set.insert(ob);
   return set;
@@ -1558,7 +1649,7 @@ rps_set_root_objects(void)
 unsigned
 rps_nb_root_objects(void)
 {
-  std::lock_guard<std::mutex> gu(rps_object_root_mtx);
+  Rps_NoSafepointLock<std::mutex> gu(rps_object_root_mtx);
   return (unsigned) rps_object_root_set.size();
 } // end rps_nb_root_objects
 
@@ -1568,7 +1659,7 @@ void
 rps_initialize_symbols_after_loading(Rps_Loader*ld)
 {
   RPS_ASSERT(ld != nullptr);
-  std::lock_guard<std::recursive_mutex> gu(Rps_PayloadSymbol::symb_tablemtx);
+  Rps_NoSafepointLock<std::recursive_mutex> gu(Rps_PayloadSymbol::symb_tablemtx);
   Rps_PayloadSymbol::symb_hardcoded_hashtable.max_load_factor(2.5);
   Rps_PayloadSymbol::symb_hardcoded_hashtable.reserve(5*rps_hardcoded_number_of_symbols()/4+3);
 #define RPS_INSTALL_NAMED_ROOT_OB(Oid,Name) {   \
@@ -118,23 +118,151 @@ fail:
 //////////////////////////////////////////////// quasi values
 
 
-std::recursive_mutex Rps_QuasiZone::qz_mtx;
-std::vector<Rps_QuasiZone*> Rps_QuasiZone::qz_zonvec(100);
-uint32_t Rps_QuasiZone::qz_cnt;
+std::atomic<Rps_QuasiZone::qz_chunk_st*> Rps_QuasiZone::qz_chunktab[Rps_QuasiZone::qz_max_chunks];
+std::atomic<uint32_t> Rps_QuasiZone::qz_toprank(1); // rank 0 is never used
+std::atomic<uint64_t> Rps_QuasiZone::qz_freehead;
+std::atomic<uint32_t> Rps_QuasiZone::qz_cnt;
+std::atomic<uint16_t> Rps_QuasiZone::qz_markcolor;
+std::atomic<bool> Rps_QuasiZone::qz_sweeping;
+std::atomic<uint32_t> Rps_QuasiZone::qz_sweeptoprank;
+std::atomic<uint32_t> Rps_QuasiZone::qz_sweepnextchunk;
+std::atomic<uint32_t> Rps_QuasiZone::qz_sweepdonechunks;
+std::atomic<uint64_t> Rps_QuasiZone::qz_nbswept;
+std::atomic<bool> Rps_QuasiZone::qz_collecting;
+std::atomic<bool> Rps_QuasiZone::qz_sweepminor;
 std::atomic<uint64_t> Rps_QuasiZone::qz_alloc_cumulw;
 
+/// the per-thread buffer of free ranks in the zone table
+struct rps_zonerank_threadbuf_st
+{
+  uint32_t ztb_ranks[2*Rps_QuasiZone::qz_thread_batch];
+  unsigned ztb_count;
+  ~rps_zonerank_threadbuf_st()
+  {
+    Rps_QuasiZone::flush_thread_ranks();
+  };
+};
+
+static thread_local rps_zonerank_threadbuf_st rps_zonerank_thrbuf;
+
 void
 Rps_QuasiZone::initialize(void)
 {
   static bool inited;
   if (inited) return;
   inited = true;
-  std::lock_guard<std::recursive_mutex> gu(qz_mtx);
-  qz_zonvec.reserve(100);
-  qz_zonvec.push_back(nullptr);
+  Rps_ZoneArena::initialize();
+  ensure_chunk(0);
 } // end Rps_QuasiZone::initialize
 
 
+/// give the chunk of given index, allocating it if needed; when two
+/// threads race to allocate the same chunk, the loser deletes its own
+Rps_QuasiZone::qz_chunk_st*
+Rps_QuasiZone::ensure_chunk(uint32_t chkix)
+{
+  if (chkix >= qz_max_chunks)
+    RPS_FATALOUT("Rps_QuasiZone zone table full with " << qz_cnt.load()
+                 << " zones");
+  qz_chunk_st*chk = qz_chunktab[chkix].load(std::memory_order_acquire);
+  if (RPS_LIKELY(chk != nullptr))
+    return chk;
+  qz_chunk_st*newchk = new qz_chunk_st;
+  for (uint32_t ix=0; ix<qz_chunk_size; ix++)
+    {
+      newchk->qzc_zones[ix].store(nullptr, std::memory_order_relaxed);
+      newchk->qzc_nextfree[ix].store(0, std::memory_order_relaxed);
+    }
+  if (qz_chunktab[chkix].compare_exchange_strong(chk, newchk,
+      std::memory_order_acq_rel))
+    return newchk;
+  delete newchk;
+  RPS_ASSERT(chk != nullptr);
+  return chk;
+} // end Rps_QuasiZone::ensure_chunk
+
+
+void
+Rps_QuasiZone::push_free_rank(uint32_t rk)
+{
+  RPS_ASSERT(rk > 0 && rk < qz_toprank.load());
+  qz_chunk_st*chk = qz_chunktab[rk>>qz_chunk_shift].load(std::memory_order_acquire);
+  RPS_ASSERT(chk != nullptr);
+  uint64_t oldhead = qz_freehead.load(std::memory_order_acquire);
+  uint64_t newhead = 0;
+  do
+    {
+      chk->qzc_nextfree[rk & (qz_chunk_size-1)]
+      .store((uint32_t)oldhead, std::memory_order_relaxed);
+      newhead = (((oldhead>>32) + 1)<<32) | rk;
+    }
+  while (!qz_freehead.compare_exchange_weak(oldhead, newhead,
+         std::memory_order_acq_rel));
+} // end Rps_QuasiZone::push_free_rank
+
+
+/// pop a rank from the global free list, or give 0 if it is empty
+uint32_t
+Rps_QuasiZone::pop_free_rank(void)
+{
+  uint64_t oldhead = qz_freehead.load(std::memory_order_acquire);
+  uint64_t newhead = 0;
+  uint32_t rk = 0;
+  do
+    {
+      rk = (uint32_t)oldhead;
+      if (rk == 0)
+        return 0;
+      qz_chunk_st*chk = qz_chunktab[rk>>qz_chunk_shift].load(std::memory_order_acquire);
+      RPS_ASSERT(chk != nullptr);
+      /// the next link could be stale, but then the ABA counter has
+      /// changed and the exchange fails
+      uint32_t nextrk = chk->qzc_nextfree[rk & (qz_chunk_size-1)]
+                        .load(std::memory_order_relaxed);
+      newhead = (((oldhead>>32) + 1)<<32) | nextrk;
+    }
+  while (!qz_freehead.compare_exchange_weak(oldhead, newhead,
+         std::memory_order_acq_rel));
+  return rk;
+} // end Rps_QuasiZone::pop_free_rank
+
+
+/// fill the empty buffer of the current thread with a batch of free
+/// ranks, taken from the free list or else above the top rank
+void
+Rps_QuasiZone::refill_thread_ranks(void)
+{
+  auto& tb = rps_zonerank_thrbuf;
+  RPS_ASSERT(tb.ztb_count == 0);
+  while (tb.ztb_count < qz_thread_batch)
+    {
+      uint32_t rk = pop_free_rank();
+      if (!rk)
+        break;
+      tb.ztb_ranks[tb.ztb_count++] = rk;
+    }
+  if (tb.ztb_count > 0)
+    return;
+  uint32_t firstrk = qz_toprank.fetch_add(qz_thread_batch);
+  uint32_t lastrk = firstrk + qz_thread_batch - 1;
+  if (RPS_UNLIKELY(lastrk < firstrk))
+    RPS_FATALOUT("Rps_QuasiZone zone table overflow at rank " << firstrk);
+  for (uint32_t chkix = firstrk>>qz_chunk_shift;
+       chkix <= (lastrk>>qz_chunk_shift); chkix++)
+    ensure_chunk(chkix);
+  /// so the lowest rank is used first
+  for (uint32_t rk = lastrk; rk >= firstrk; rk--)
+    tb.ztb_ranks[tb.ztb_count++] = rk;
+} // end Rps_QuasiZone::refill_thread_ranks
+
+
+void
+Rps_QuasiZone::flush_thread_ranks(void)
+{
+  auto& tb = rps_zonerank_thrbuf;
+  while (tb.ztb_count > 0)
+    push_free_rank(tb.ztb_ranks[--tb.ztb_count]);
+} // end Rps_QuasiZone::flush_thread_ranks
 
 
 Rps_QuasiZone::~Rps_QuasiZone()
@@ -145,55 +273,247 @@ Rps_QuasiZone::~Rps_QuasiZone()
 void
 Rps_QuasiZone::register_in_zonevec(void)
 {
-  std::lock_guard<std::recursive_mutex> gu(qz_mtx);
-  if (RPS_UNLIKELY(9 * qz_zonvec.capacity() <= 8 * qz_zonvec.size()))
+  auto& tb = rps_zonerank_thrbuf;
+  if (RPS_UNLIKELY(tb.ztb_count == 0))
+    refill_thread_ranks();
+  uint32_t rk = tb.ztb_ranks[--tb.ztb_count];
+  qz_chunk_st*chk = qz_chunktab[rk>>qz_chunk_shift].load(std::memory_order_acquire);
+  RPS_ASSERT(chk != nullptr);
+  this->qz_rank = rk;
+  /// zones are born marked with the current color, so zones born
+  /// during a garbage collection or its sweep survive it
+  if (qz_markcolor.load(std::memory_order_relaxed))
+    qz_gcinfo.fetch_or(qz_gcmark_bit);
+  else
+    qz_gcinfo.fetch_and(~qz_gcmark_bit);
+  /// they could get references to young zones without any write
+  /// barrier, so they stay young after that collection
+  if (RPS_UNLIKELY(qz_collecting.load(std::memory_order_acquire)))
+    qz_gcinfo.fetch_or(qz_gcfresh_bit);
+  chk->qzc_zones[rk & (qz_chunk_size-1)].store(this, std::memory_order_release);
+  qz_cnt.fetch_add(1, std::memory_order_relaxed);
+} // end of Rps_QuasiZone::register_in_zonevec
+
+void
+Rps_QuasiZone::unregister_in_zonevec(void)
+{
+  uint32_t rk = this->qz_rank;
+  RPS_ASSERT(rk>0 && rk < qz_toprank.load());
+  qz_chunk_st*chk = qz_chunktab[rk>>qz_chunk_shift].load(std::memory_order_acquire);
+  RPS_ASSERT(chk != nullptr);
+  RPS_ASSERT(chk->qzc_zones[rk & (qz_chunk_size-1)].load() == this);
+  chk->qzc_zones[rk & (qz_chunk_size-1)].store(nullptr, std::memory_order_release);
+  RPS_ASSERT(qz_cnt.load() > 0);
+  qz_cnt.fetch_sub(1, std::memory_order_relaxed);
+  auto& tb = rps_zonerank_thrbuf;
+  if (RPS_UNLIKELY(tb.ztb_count >= 2*qz_thread_batch))
     {
-      auto newcap = rps_prime_above(19*qz_zonvec.size()/16
-                                    + 200);
-      qz_zonvec.reserve(newcap);
+      /// give half of the buffered ranks to the global free list
+      for (unsigned ix=0; ix<qz_thread_batch; ix++)
+        push_free_rank(tb.ztb_ranks[--tb.ztb_count]);
     }
-  if (RPS_LIKELY(qz_zonvec.size() > 128))
+  tb.ztb_ranks[tb.ztb_count++] = rk;
+} // end of Rps_QuasiZone::unregister_in_zonevec
+
+/// a conservative guess, e.g. from some word of a C++ stack: the
+/// arena gives the candidate block around that address, and it is a
+/// live zone only if the zone table agrees. A large zone could still
+/// be under construction by another thread, so its size is unknown
+/// and only its start is accepted.
+Rps_QuasiZone*
+Rps_QuasiZone::zone_at_address(const void*ad,
+                               const std::vector<Rps_QuasiZone*>&largezones)
+{
+  auto blk = static_cast<const Rps_QuasiZone*>(Rps_ZoneArena::block_containing(ad));
+  if (!blk)
     {
-      uint32_t rk = 1 + Rps_Random::random_32u() % (qz_zonvec.size() - 16);
-      uint32_t endrk = rk + 24;
-      if (endrk > (uint32_t)qz_zonvec.size())
-        endrk = (uint32_t)qz_zonvec.size();
-      for (uint32_t ix= rk; ix < endrk; ix++)
-        if (qz_zonvec[ix] == nullptr)
-          {
-            qz_zonvec[ix] = this;
-            this->qz_rank = ix;
-            qz_cnt++;
-            return;
-          }
+      auto it = std::lower_bound(largezones.begin(), largezones.end(),
+                                 static_cast<const Rps_QuasiZone*>(ad));
+      if (it != largezones.end() && *it == ad)
+        return *it;
+      return nullptr;
     }
-  this->qz_rank = (uint32_t)qz_zonvec.size();
-  qz_cnt++;
-  qz_zonvec.push_back(this);
-} // end of Rps_QuasiZone::register_in_zonevec
+  Rps_QuasiZone*qz = nth_zone(blk->qz_rank);
+  if (qz != blk)
+    return nullptr;
+  return qz;
+} // end of Rps_QuasiZone::zone_at_address
+
+std::vector<Rps_QuasiZone*>
+Rps_QuasiZone::large_zones(void)
+{
+  std::vector<Rps_QuasiZone*> res;
+  uint32_t toprk = qz_toprank.load(std::memory_order_acquire);
+  for (uint32_t rk=1; rk<toprk; rk++)
+    {
+      Rps_QuasiZone*qz = nth_zone(rk);
+      if (qz && !Rps_ZoneArena::is_in_arena(qz))
+        res.push_back(qz);
+    }
+  std::sort(res.begin(), res.end());
+  return res;
+} // end of Rps_QuasiZone::large_zones
 
 void
-Rps_QuasiZone::unregister_in_zonevec(void)
+Rps_QuasiZone::clear_all_gcmarks(Rps_GarbageCollector&)
 {
-  std::lock_guard<std::recursive_mutex> gu(qz_mtx);
-  RPS_ASSERT(this->qz_rank>0
-             && this->qz_rank < (uint32_t)qz_zonvec.size());
-  RPS_ASSERT(qz_cnt>0 && qz_cnt<(uint32_t)qz_zonvec.size());
-  RPS_ASSERT(qz_zonvec[this->qz_rank] == this);
-  qz_zonvec[this->qz_rank] = nullptr;
-  qz_cnt--;
-} // end of Rps_QuasiZone::unregister_in_zonevec
+  /// every zone, including those born since the previous collection,
+  /// has the current color, so flipping it unmarks them all
+  RPS_ASSERT(!is_sweeping());
+  qz_collecting.store(true, std::memory_order_release);
+  qz_markcolor.fetch_xor(qz_gcmark_bit);
+} // end of Rps_QuasiZone::clear_all_gcmarks
+
 
 void
-Rps_QuasiZone::clear_all_gcmarks(Rps_GarbageCollector&gc)
+Rps_QuasiZone::start_sweep(Rps_GarbageCollector&gc)
+{
+  RPS_ASSERT(!is_sweeping());
+  qz_sweepminor.store(gc.is_minor());
+  qz_sweeptoprank.store(qz_toprank.load(std::memory_order_acquire));
+  qz_sweepnextchunk.store(0);
+  qz_sweepdonechunks.store(0);
+  qz_sweeping.store(true, std::memory_order_release);
+} // end Rps_QuasiZone::start_sweep
+
+
+/// Each sweeper claims a whole chunk, so no zone is deleted twice.
+/// Payloads are never marked by themselves; they are deleted by their
+/// owner object. Surviving zones are promoted to the old generation,
+/// except those born during the collection. After a minor collection,
+/// unmarked old zones are kept and given the current color. The last
+/// sweeper ending its chunk ends the sweep.
+bool
+Rps_QuasiZone::sweep_some_chunks(unsigned nbchunks)
 {
-  std::lock_guard<std::recursive_mutex> gu(qz_mtx);
-  for (Rps_QuasiZone *qz : qz_zonvec)
+  if (!is_sweeping())
+    return false;
+  uint32_t toprk = qz_sweeptoprank.load();
+  uint32_t totchunks = (toprk + qz_chunk_size - 1) >> qz_chunk_shift;
+  uint16_t color = qz_markcolor.load(std::memory_order_relaxed);
+  bool minor = qz_sweepminor.load();
+  for (unsigned cnt=0; cnt<nbchunks; cnt++)
     {
-      if (!qz) continue;
-      qz->clear_gcmark(gc);
+      uint32_t chkix = qz_sweepnextchunk.fetch_add(1);
+      if (chkix >= totchunks)
+        return false;
+      qz_chunk_st*chk = qz_chunktab[chkix].load(std::memory_order_acquire);
+      RPS_ASSERT(chk != nullptr);
+      double startime = rps_thread_cpu_time();
+      uint64_t nbdel = 0;
+      /// dead objects are unbound from their oid first, and freed
+      /// with the other dead zones after lock-free oid lookups which
+      /// could have found them are over
+      std::vector<Rps_QuasiZone*> deadvec;
+      bool deadobj = false;
+      /// live zones of this chunk, per type, for GC statistics
+      uint64_t livecount[Rps_GcStatistics::gcs_nb_types] = {};
+      uint64_t livewords[Rps_GcStatistics::gcs_nb_types] = {};
+      auto countlive = [&](Rps_Type ty, uint64_t nbwords)
+      {
+        int tyix = Rps_GcStatistics::type_index(ty);
+        if (tyix < 0)
+          return;
+        livecount[tyix]++;
+        livewords[tyix] += nbwords;
+      };
+      for (uint32_t ix=0; ix<qz_chunk_size; ix++)
+        {
+          uint32_t rk = (chkix<<qz_chunk_shift) + ix;
+          if (rk == 0)
+            continue;
+          if (rk >= toprk)
+            break;
+          Rps_QuasiZone*qz = chk->qzc_zones[ix].load(std::memory_order_acquire);
+          if (!qz)
+            continue;
+          if (qz->stored_type() <= Rps_Type::Payl__LeastRank)
+            continue;
+          uint16_t gcinf = qz->qz_gcinfo.load();
+          bool alive = false;
+          if ((gcinf & qz_gcmark_bit) == color)
+            {
+              if (gcinf & qz_gcfresh_bit)
+                qz->qz_gcinfo.fetch_and(~qz_gcfresh_bit);
+              else if (!(gcinf & qz_gcold_bit))
+                qz->qz_gcinfo.fetch_or(qz_gcold_bit);
+              alive = true;
+            }
+          else if (minor && (gcinf & qz_gcold_bit))
+            {
+              /// recolor it, or after the next flip of qz_markcolor
+              /// it would read as marked and the next major
+              /// collection would not scan it
+              if (color)
+                qz->qz_gcinfo.fetch_or(qz_gcmark_bit);
+              else
+                qz->qz_gcinfo.fetch_and(~qz_gcmark_bit);
+              alive = true;
+            }
+          if (alive)
+            {
+              countlive(qz->stored_type(), qz->wordsize());
+              /// payloads are counted thru their owner, from the
+              /// statistics word set with the payload, since a
+              /// mutator could replace and free the payload meanwhile
+              if (qz->stored_type() == Rps_Type::Object)
+                {
+                  uint64_t paylstat = static_cast<Rps_ObjectZone*>(qz)
+                                      ->ob_paylstat.load(std::memory_order_relaxed);
+                  if (paylstat)
+                    countlive((Rps_Type)(int16_t)(paylstat & 0xffff), paylstat >> 16);
+                }
+              continue;
+            }
+          if (qz->stored_type() == Rps_Type::Object)
+            {
+              auto obz = static_cast<Rps_ObjectZone*>(qz);
+              Rps_ObjectZone::ob_idtable_.remove(obz->oid(), obz);
+              deadobj = true;
+            }
+          deadvec.push_back(qz);
+        }
+      /// a dead class could be reused for a new one, so the cached
+      /// methods of its address are forgotten
+      if (deadobj)
+        {
+          Rps_ObjectZone::ob_idtable_.synchronize_readers();
+          rps_invalidate_method_caches();
+        }
+      for (Rps_QuasiZone*deadqz: deadvec)
+        {
+          delete deadqz;
+          nbdel++;
+        }
+      qz_nbswept.fetch_add(nbdel, std::memory_order_relaxed);
+      /// the deleted zones went into the caches of this thread
+      flush_thread_ranks();
+      Rps_ZoneArena::flush_thread_cache();
+      Rps_GcStatistics::add_live_zones(livecount, livewords);
+      Rps_GcStatistics::add_sweep_time(rps_thread_cpu_time() - startime);
+      if (qz_sweepdonechunks.fetch_add(1) + 1 == totchunks)
+        {
+          /// before the next collection could start
+          Rps_GcStatistics::end_sweep();
+          qz_sweeping.store(false, std::memory_order_release);
+          qz_collecting.store(false, std::memory_order_release);
+          Rps_ZoneArena::release_empty_pages();
+          return false;
+        }
     }
-} // end of Rps_QuasiZone::clear_all_gcmarks
+  return is_sweeping();
+} // end Rps_QuasiZone::sweep_some_chunks
+
+
+void
+Rps_QuasiZone::finish_sweep(void)
+{
+  while (sweep_some_chunks(1))
+    continue;
+  /// other threads may still be sweeping their last chunk
+  while (is_sweeping())
+    std::this_thread::yield();
+} // end Rps_QuasiZone::finish_sweep
 
 
 std::mutex Rps_LazyHashedZoneValue::lazy_mtxarr[Rps_LazyHashedZoneValue::lazy_nbmutexes];
@@ -627,10 +947,11 @@ Rps_Value::get_attr(Rps_CallFrame*stkf, const Rps_ObjectRef obattr) const
   if (is_object())
     {
       const Rps_ObjectZone*thisob = as_object();
+      thisob->materialize();
       std::lock_guard gu(thisob->ob_mtx);
-      auto it = thisob->ob_attrs.find(obattr);
-      if (it != thisob->ob_attrs.end())
-        return it->second;
+      Rps_Value atval = thisob->ob_attrs.get(obattr);
+      if (atval)
+        return atval;
     };
   return nullptr;
 } // end Rps_Value::get_attr
@@ -658,9 +979,73 @@ Rps_Value::compute_class(Rps_CallFrame*stkf) const
   return nullptr;
 } // end Rps_Value::compute_class
 
+std::atomic<uint64_t> rps_method_cache_epoch;
+
+/// The global method cache is direct mapped on the class and
+/// selector. Each entry is a small sequence lock: a writer makes
+/// mc_seq odd while filling it, and readers retry nothing but just
+/// miss when mc_seq was odd or changed meanwhile.
+struct rps_method_cache_entry_st
+{
+  std::atomic<uint32_t> mc_seq;
+  std::atomic<const Rps_ObjectZone*> mc_class;
+  std::atomic<const Rps_ObjectZone*> mc_selector;
+  std::atomic<const Rps_ZoneValue*> mc_closure;
+  std::atomic<uint64_t> mc_epoch;
+};
+#define RPS_METHOD_CACHE_SIZE 4096
+static rps_method_cache_entry_st rps_method_cache[RPS_METHOD_CACHE_SIZE];
+
+static inline rps_method_cache_entry_st&
+rps_method_cache_entry(const Rps_ObjectZone*obclass, const Rps_ObjectZone*obsel)
+{
+  uint64_t h = ((uint64_t)(uintptr_t)obclass * 0x9e3779b97f4a7c15ULL)
+               ^ ((uint64_t)(uintptr_t)obsel * 0xc2b2ae3d27d4eb4fULL);
+  return rps_method_cache[(h >> 40) % RPS_METHOD_CACHE_SIZE];
+} // end rps_method_cache_entry
+
+static bool
+rps_method_cache_lookup(const Rps_ObjectZone*obclass, const Rps_ObjectZone*obsel,
+                        uint64_t epoch, const Rps_ZoneValue*&closure)
+{
+  rps_method_cache_entry_st& ent = rps_method_cache_entry(obclass, obsel);
+  uint32_t seq = ent.mc_seq.load(std::memory_order_acquire);
+  if (seq & 1)
+    return false;
+  bool hit = ent.mc_class.load(std::memory_order_relaxed) == obclass
+             && ent.mc_selector.load(std::memory_order_relaxed) == obsel
+             && ent.mc_epoch.load(std::memory_order_relaxed) == epoch;
+  const Rps_ZoneValue* clos = ent.mc_closure.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (!hit || ent.mc_seq.load(std::memory_order_relaxed) != seq)
+    return false;
+  closure = clos;
+  return true;
+} // end rps_method_cache_lookup
+
+static void
+rps_method_cache_store(const Rps_ObjectZone*obclass, const Rps_ObjectZone*obsel,
+                       uint64_t epoch, const Rps_ZoneValue*closure)
+{
+  rps_method_cache_entry_st& ent = rps_method_cache_entry(obclass, obsel);
+  uint32_t seq = ent.mc_seq.load(std::memory_order_relaxed);
+  /// another thread filling that entry wins
+  if ((seq & 1)
+      || !ent.mc_seq.compare_exchange_strong(seq, seq+1, std::memory_order_acquire))
+    return;
+  std::atomic_thread_fence(std::memory_order_release);
+  ent.mc_class.store(obclass, std::memory_order_relaxed);
+  ent.mc_selector.store(obsel, std::memory_order_relaxed);
+  ent.mc_closure.store(closure, std::memory_order_relaxed);
+  ent.mc_epoch.store(epoch, std::memory_order_relaxed);
+  ent.mc_seq.store(seq+2, std::memory_order_release);
+} // end rps_method_cache_store
+
 // the below member function computes, for the current value, the
 // closure for the RefPerSys method of selector obselector. It is so
-// important that it deserves a describing symbol of its own.
+// important that it deserves a describing symbol of its own. The
+// result is looked up first in the global method cache, and only
+// then along the superclasses.
 Rps_ClosureValue
 Rps_Value::closure_for_method_selector(Rps_CallFrame*callerframe, Rps_ObjectRef obselectorarg) const
 {
@@ -675,6 +1060,20 @@ Rps_Value::closure_for_method_selector(Rps_CallFrame*callerframe, Rps_ObjectRef
   _f.val = Rps_Value(*this);
   _f.obselect = obselectorarg;
   _f.obcurclass = _f.val.compute_class(&_);
+  /// the epoch is read before the lookup, so a method change
+  /// happening meanwhile makes the cached result stale
+  const uint64_t epoch = rps_method_cache_epoch.load(std::memory_order_acquire);
+  const Rps_ObjectZone* obinitclass = _f.obcurclass.optr();
+  const Rps_ObjectZone* obsel = _f.obselect.optr();
+  const Rps_ZoneValue* cachedclos = nullptr;
+  if (obinitclass && rps_method_cache_lookup(obinitclass, obsel, epoch, cachedclos))
+    return cachedclos?Rps_ClosureValue(Rps_Value(cachedclos)):Rps_ClosureValue(nullptr);
+  auto found = [&](Rps_ClosureValue clos) -> Rps_ClosureValue
+  {
+    const Rps_ZoneValue* closzv = clos?clos.to_ptr():nullptr;
+    rps_method_cache_store(obinitclass, obsel, epoch, closzv);
+    return clos;
+  };
   int loopcount = 0;
   RPS_DEBUG_LOG(MSGSEND, "closure_for_method_selector start val=" << _f.val
                 << " obcurclass=" << _f.obcurclass
@@ -693,7 +1092,7 @@ Rps_Value::closure_for_method_selector(Rps_CallFrame*callerframe, Rps_ObjectRef
             RPS_FATALOUT("value @" << (void*)_f.val.unsafe_wptr()
                          << " of type#" << (int)(_f.val.to_ptr()?_f.val.to_ptr()->stored_type():Rps_Type::None) << " has no class");
         }
-      std::lock_guard<std::recursive_mutex> gucurclass(*(_f.obcurclass->objmtxptr()));
+      std::lock_guard<Rps_ObjectMutex> gucurclass(*(_f.obcurclass->objmtxptr()));
       if (_f.obcurclass == RPS_ROOT_OB(_6XLY6QfcDre02922jz) // the topmost `value` class ends the loop
          )
         {
@@ -707,9 +1106,9 @@ Rps_Value::closure_for_method_selector(Rps_CallFrame*callerframe, Rps_ObjectRef
           _f.closval = valclasspayl->get_own_method(_f.obselect);
           RPS_DEBUG_LOG(MSGSEND, "closure_for_method_selector!value closval=" << _f.closval);
           if (_f.closval && _f.closval.is_closure()) // should be always true! But we need to check
-            return _f.closval;
+            return found(_f.closval);
           else
-            return Rps_ClosureValue(nullptr);
+            return found(Rps_ClosureValue(nullptr));
         }
       /// usual common case:
       if (_f.obcurclass->get_class() == RPS_ROOT_OB(_41OFI3r0S1t03qdB2E) // the `class` class
@@ -722,7 +1121,7 @@ Rps_Value::closure_for_method_selector(Rps_CallFrame*callerframe, Rps_ObjectRef
           _f.closval = valclasspayl->get_own_method(_f.obselect);
           RPS_DEBUG_LOG(MSGSEND, "closure_for_method_selector!class closval=" << _f.closval);
           if (_f.closval && _f.closval.is_closure()) // should be always true! But we need to check
-            return _f.closval;
+            return found(_f.closval);
           else
             {
               _f.obcurclass = valclasspayl->superclass();
@@ -739,7 +1138,7 @@ Rps_Value::closure_for_method_selector(Rps_CallFrame*callerframe, Rps_ObjectRef
           _f.closval = valclasspayl->get_own_method(_f.obselect);
           RPS_DEBUG_LOG(MSGSEND, "closure_for_method_selector!sub-class closval=" << _f.closval);
           if (_f.closval && _f.closval.is_closure()) // should be always true! But we need to check
-            return _f.closval;
+            return found(_f.closval);
           else
             {
               _f.obcurclass = valclasspayl->superclass();